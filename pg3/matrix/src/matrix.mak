@@ -5,6 +5,7 @@
 # History : 2003.01.27 file created
 #           2006.07.20 adapted to Visual Studio 8
 #           2016.04.20 completed dependencies on header files
+#           2016.05.16 benchmark program matbench added
 #-----------------------------------------------------------------------
 THISDIR  = ..\..\matrix\src
 UTILDIR  = ..\..\util\src
@@ -46,6 +47,12 @@ eigen.exe:    $(OBJ3_O) eigen.obj matrix.mak
 match.exe:    $(OBJ4_O) match.obj matrix.mak
 	$(LD) $(LDFLAGS) $(OBJ4_O) match.obj  $(LIBS) /out:$@
 
+matbench.exe: matbench.obj matrix.mak
+	$(LD) $(LDFLAGS) matbench.obj $(LIBS) /out:$@
+
+bench:        matbench.exe
+	matbench.exe 4096
+
 #-----------------------------------------------------------------------
 # Main Programs
 #-----------------------------------------------------------------------
@@ -70,6 +77,9 @@ match.obj:    matrix.h match.c matrix.mak
 matrix1.obj:  matrix.h matrix1.c matrix.mak
 	$(CC) $(CFLAGS) $(INCS) matrix1.c /Fo$@
 
+matbench.obj: matrix.h matrix1.c matrix.mak
+	$(CC) $(CFLAGS) $(INCS) /D MATRIX_MAIN matrix1.c /Fo$@
+
 mat_rdwr.obj: $(UTILDIR)\tabread.h
 mat_rdwr.obj: matrix.h matrix1.c matrix.mak
 	$(CC) $(CFLAGS) $(INCS) /D MAT_RDWR matrix1.c /Fo$@
@@ -105,7 +115,7 @@ install:
 # Clean up
 #-----------------------------------------------------------------------
 localclean:
-	-@erase /Q *~ *.obj *.idb *.pch $(PRGS)
+	-@erase /Q *~ *.obj *.idb *.pch $(PRGS) matbench.exe
 
 clean:
 	$(MAKE) /f matrix.mak localclean
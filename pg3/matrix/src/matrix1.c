@@ -34,11 +34,18 @@
             2013.08.09 adapted to higher compiler warning level
             2013.08.13 adapted to preprocessor definition of DIMID
             2015.07.30 functions vec_[abs]max() and mat_emul() added
+            2016.05.14 field of table reader fetched after each read
+            2016.05.16 mat_transp() and mat_mul() processed in blocks
+            2016.05.16 main function added for benchmarking (matbench)
+            2016.05.16 bug in assertion of mat_sub() fixed (bounds)
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <limits.h>
 #include <float.h>
 #include <assert.h>
+#ifdef MATRIX_MAIN
+#include <time.h>
+#endif
 #include "matrix.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -53,6 +60,10 @@
 
 /* --- sizes --- */
 #define BLKSIZE    256          /* block size for matrices */
+#define TRPBLK      32          /* block size for transposition */
+#define MULROWS      4          /* rows    of a multiplication tile */
+#define MULCOLS    256          /* columns of a multiplication block */
+#define MULDEPTH   128          /* depth   of a multiplication block */
 
 /* --- error functions --- */
 #define VECERR(c,v) { if (*v) { free(*v);       *v = NULL; } return c; }
@@ -318,9 +329,9 @@ int vec_read (double *vec, DIMID n, TABREAD *tread)
   char  *s, *e;                 /* field read, end pointer */
 
   assert(vec && tread && (n > 0)); /* check the function arguments */
-  s = trd_field(tread);         /* get the read buffer */
   do {                          /* vector element read loop */
     d = trd_read(tread);        /* read the next vector element */
+    s = trd_field(tread);       /* and get the field read */
     if  (d <= TRD_ERR)  return E_FREAD;
     if ((d <= TRD_EOF) && (i <= 0) && !*s) return 1;
     vec[i++] = strtod(s, &e);   /* convert and store the value read */
@@ -341,9 +352,9 @@ int vec_readx (double **vec, DIMID *n, TABREAD *tread)
 
   assert(vec && n && tread);    /* check the function arguments */
   k = i = 0; *vec = NULL;       /* initialize the index variables */
-  s = trd_field(tread);         /* and get the read buffer */
   do {                          /* vector element read loop */
     d = trd_read(tread);        /* read the next vector element */
+    s = trd_field(tread);       /* and get the field read */
     if (d <= TRD_ERR) VECERR(E_FREAD, vec);
     if ((d <= TRD_EOF) && (i <= 0) && !*s) return 1;
     if (i >= k) {               /* if the current vector is full */
@@ -1209,6 +1220,7 @@ double mat_mulvdv (const MATRIX *mat, const double *vec)
 
 MATRIX* mat_transp (MATRIX *res, const MATRIX *mat)
 {                               /* --- transpose a matrix */
+  DIMID  rb, cb, re, ce;        /* block boundaries */
   DIMID  row, col;              /* loop variables */
   double *s, *d;                /* to traverse the matrix rows */
   double t;                     /* exchange buffer */
@@ -1217,17 +1229,32 @@ MATRIX* mat_transp (MATRIX *res, const MATRIX *mat)
   &&    (res->rowcnt == mat->colcnt)
   &&    (res->colcnt == mat->rowcnt));
   if (res == mat) {             /* if the result is id. to the matrix */
-    for (row = mat->rowcnt -1; --row >= 0; ) {
-      for (s = res->els[row] +(col = mat->colcnt); --col > row; ) {
-        d = res->els[col] +row; /* traverse the columns of the row */
-        t = *--s; *s = *d; *d = t;
-      }                         /* exchange elements so that they */
-    } }                         /* are mirrored at the diagonal */
+    for (rb = 0; rb < mat->rowcnt; rb += TRPBLK) {
+      re = (rb+TRPBLK < mat->rowcnt) ? rb+TRPBLK : mat->rowcnt;
+      for (cb = rb; cb < mat->colcnt; cb += TRPBLK) {
+        ce = (cb+TRPBLK < mat->colcnt) ? cb+TRPBLK : mat->colcnt;
+        for (row = rb; row < re; row++) {
+          s = res->els[row];    /* traverse the rows of the block */
+          for (col = (cb > row) ? cb : row+1; col < ce; col++) {
+            d = res->els[col] +row;
+            t = s[col]; s[col] = *d; *d = t;
+          }                     /* exchange elements so that they */
+        }                       /* are mirrored at the diagonal */
+      }                         /* (blocks above the diagonal are */
+    } }                         /* exchanged with those below it) */
   else {                        /* if source and destination differ */
-    for (col = mat->colcnt; --col >= 0; )
-      for (s = res->els[col] +(row = mat->rowcnt); --row >= 0; )
-        *--s = mat->els[row][col];
-  }                             /* transpose the source columns */
+    for (rb = 0; rb < mat->rowcnt; rb += TRPBLK) {
+      re = (rb+TRPBLK < mat->rowcnt) ? rb+TRPBLK : mat->rowcnt;
+      for (cb = 0; cb < mat->colcnt; cb += TRPBLK) {
+        ce = (cb+TRPBLK < mat->colcnt) ? cb+TRPBLK : mat->colcnt;
+        for (col = cb; col < ce; col++) {
+          d = res->els[col];    /* traverse the columns of the block */
+          for (row = rb; row < re; row++)
+            d[row] = mat->els[row][col];
+        }                       /* transpose the source block by */
+      }                         /* block, so that both the source */
+    }                           /* and the destination rows of a */
+  }                             /* block stay in the cache */
   return res;                   /* return the transposed matrix */
 }  /* mat_transp() */
 
@@ -1370,58 +1397,105 @@ MATRIX* mat_addx (MATRIX *res, const MATRIX *A,
 
 /*--------------------------------------------------------------------*/
 
+static void mulblk (double *const *C, DIMID off, double *const *A,
+                    double *const *B, DIMID m, DIMID k, DIMID n)
+{                               /* --- multiply matrices in blocks */
+  DIMID  i, j, l;               /* loop variables */
+  DIMID  jb, je, lb, le;        /* block boundaries */
+  double *c0, *c1, *c2, *c3;    /* to traverse the result rows */
+  double t0, t1, t2, t3, x;     /* elements of matrix A and B */
+  double *b;                    /* to traverse the rows of matrix B */
+
+  for (i = 0; i < m; i++)       /* initialize the result */
+    memset(C[i] +off, 0, (size_t)n *sizeof(double));
+  for (lb = 0; lb < k; lb += MULDEPTH) {
+    le = (lb+MULDEPTH < k) ? lb+MULDEPTH : k;
+    for (jb = 0; jb < n; jb += MULCOLS) {
+      je = (jb+MULCOLS < n) ? jb+MULCOLS : n;
+      for (i = 0; i+MULROWS <= m; i += MULROWS) {
+        c0 = C[i  ] +off; c1 = C[i+1] +off;
+        c2 = C[i+2] +off; c3 = C[i+3] +off;
+        for (l = lb; l < le; l++) {
+          t0 = A[i][l];   t1 = A[i+1][l];
+          t2 = A[i+2][l]; t3 = A[i+3][l];
+          b  = B[l];             /* traverse a tile of four rows */
+          for (j = jb; j < je; j++) {
+            x = b[j];           /* (each element of matrix B */
+            c0[j] += t0 *x; c1[j] += t1 *x;  /* is loaded once */
+            c2[j] += t2 *x; c3[j] += t3 *x;  /* for four rows) */
+          }                     /* add the row of matrix B, */
+        }                       /* weighted with the elements */
+      }                         /* of the rows of matrix A */
+      for ( ; i < m; i++) {     /* traverse the remaining rows */
+        c0 = C[i] +off;         /* (less than a full tile) */
+        for (l = lb; l < le; l++) {
+          t0 = A[i][l]; b = B[l];
+          for (j = jb; j < je; j++) c0[j] += t0 *b[j];
+        }                       /* the block of matrix B (depth */
+      }                         /* times columns) is reused by all */
+    }                           /* rows of matrix A, so that it */
+  }                             /* is loaded only once into the */
+}  /* mulblk() */               /* cache for the whole matrix A */
+
+/*--------------------------------------------------------------------*/
+
 MATRIX* mat_mul (MATRIX *res, const MATRIX *A, const MATRIX *B)
 {                               /* --- multiply two matrices */
-  DIMID        row, col, i;     /* loop variables */
-  const double *sa, *sb;        /* to traverse the source      rows */
-  double       *d;              /* to traverse the destination rows */
-  double       *b;              /* to traverse the buffer */
-  double       t;               /* temporary buffer */
+  DIMID  row, col, i, n, w;     /* loop variables, panel size */
+  double **p;                   /* row pointers of a panel buffer */
+  double *b;                    /* to traverse the buffer */
 
   assert(res && A && B          /* check the function arguments */
   &&    (A->colcnt   == B->rowcnt)
   &&    (res->rowcnt == A->rowcnt)
   &&    (res->colcnt == B->colcnt));
   if      (res == A) {          /* if matrix A is id. to the result, */
-    b = res->buf;               /* get the (row) buffer of matrix A */
-    for (row = res->rowcnt; --row >= 0; ) {
-      d = res->els[row];        /* traverse the rows of matrix A */
-      for (col = A->colcnt; --col >= 0; ) {
-        b[col] = d[col];        /* buffer the current row of matrix A */
-        d[col] = 0;             /* (because it will be overwritten) */
-      }                         /* and initialize a row of the result */
-      for (i = B->rowcnt; --i >= 0; ) {
-        t = b[i]; sb = B->els[i];
-        for (col = B->colcnt; --col >= 0; )
-          d[col] += t *sb[col]; /* multiply the row of matrix A */
-      }                         /* with the matrix B and store the */
-    } }                         /* result in the row of matrix A */
+    n = A->colcnt;              /* get the panel size (rows of A) */
+    w = (MULDEPTH < A->rowcnt) ? MULDEPTH : A->rowcnt;
+    p = (double**)malloc((size_t)w *sizeof(double*)
+                        +(size_t)w *(size_t)n *sizeof(double));
+    if (!p) { p = &res->buf; w = 1; }
+    else {                      /* if no panel buffer is available, */
+      b = (double*)(p+w);       /* use the (row) buffer of matrix A, */
+      for (i = 0; i < w; i++) { p[i] = b; b += n; }
+    }                           /* otherwise organize the buffer */
+    for (row = 0; row < A->rowcnt; row += w) {
+      if (row+w > A->rowcnt) w = A->rowcnt -row;
+      for (i = 0; i < w; i++)   /* buffer a panel of rows of A */
+        memcpy(p[i], A->els[row+i], (size_t)n *sizeof(double));
+      mulblk(res->els +row, 0, p, B->els, w, n, n);
+    }                           /* multiply the panel with matrix B */
+    if (p != &res->buf) free(p); }  /* and store it in matrix A */
   else if (res == B) {          /* if matrix B is id. to the result, */
-    b = res->buf;               /* get the (row) buffer of matrix B */
-    for (col = B->colcnt; --col >= 0; ) {
-      for (i = B->rowcnt; --i >= 0; )
-        b[i] = B->els[i][col];  /* buffer the column of matrix B */
-      for (row = A->rowcnt; --row >= 0; ) {
-        sa = A->els[row];       /* traverse the rows of matrix A */
-        d  = res->els[row]+col; /* get the element to compute */
-        *d = 0;                 /* and initialize the result */
-        for (i = A->colcnt; --i >= 0; )
-          *d += sa[i] *b[i];    /* multiply the matrix A with the */
+    n = B->rowcnt;              /* get the panel size (cols. of B) */
+    w = (MULCOLS < B->colcnt) ? MULCOLS : B->colcnt;
+    p = (double**)malloc((size_t)n *sizeof(double*)
+                        +(size_t)n *(size_t)w *sizeof(double));
+    if (!p) {                   /* if no panel buffer is available */
+      b = res->buf;             /* get the (col.) buffer of matrix B */
+      for (col = B->colcnt; --col >= 0; ) {
+        for (i = B->rowcnt; --i >= 0; )
+          b[i] = B->els[i][col];/* buffer the column of matrix B */
+        for (row = A->rowcnt; --row >= 0; ) {
+          res->els[row][col] = 0;
+          for (i = A->colcnt; --i >= 0; )
+            res->els[row][col] += A->els[row][i] *b[i];
+        }                       /* multiply the matrix A with the */
       }                         /* column of matrix B and store the */
-    } }                         /* result in the column of matrix B */
-  else {                        /* if the result differs from both */
-    for (row = A->rowcnt; --row >= 0; ) {
-      sa = A->els[row];         /* traverse the rows    of matrix A */
-      d  = res->els[row];       /* traverse the columns of matrix B */
-      for (col = B->colcnt; --col >= 0; )
-        d[col] = 0;             /* initialize the result */
-      for (i = B->rowcnt; --i >= 0; ) {
-        t = sa[i]; sb = B->els[i];
-        for (col = B->colcnt; --col >= 0; )
-          d[col] += t *sb[col]; /* multiply the row of matrix A with */
-      }                         /* the matrix B and store the result */
-    }                           /* in the corr. row of the matrix res */
-  }
+      return res;               /* result in the column of matrix B */
+    }
+    b = (double*)(p+n);         /* organize the panel buffer */
+    for (i = 0; i < n; i++) { p[i] = b; b += w; }
+    for (col = 0; col < B->colcnt; col += w) {
+      if (col+w > B->colcnt) w = B->colcnt -col;
+      for (i = 0; i < n; i++)   /* buffer a panel of columns of B */
+        memcpy(p[i], B->els[i] +col, (size_t)w *sizeof(double));
+      mulblk(res->els, col, A->els, p, A->rowcnt, n, w);
+    }                           /* multiply matrix A with the panel */
+    free(p); }                  /* and store it in matrix B */
+  else                          /* if the result differs from both */
+    mulblk(res->els, 0, A->els, B->els, A->rowcnt, A->colcnt,
+           B->colcnt);          /* multiply the matrices directly */
   return res;                   /* return the resulting matrix */
 }  /* mat_mul() */
 
@@ -1464,8 +1538,8 @@ MATRIX* mat_sub (MATRIX *res, const MATRIX *mat, DIMID row, DIMID col)
   double *d; const double *s;   /* to traverse the matrix rows */
 
   assert(res && mat             /* check the function arguments */
-  &&    (row >= 0) && (row < mat->rowcnt -res->rowcnt)
-  &&    (col >= 0) && (row < mat->colcnt -res->colcnt));
+  &&    (row >= 0) && (row <= mat->rowcnt -res->rowcnt)
+  &&    (col >= 0) && (col <= mat->colcnt -res->colcnt));
   for (i = res->rowcnt; --i >= 0; ) {
     s = mat->els[i +row] +col; d = res->els[i];
     for (k = res->colcnt; --k >= 0; ) d[k] = s[k];
@@ -1608,3 +1682,129 @@ int mat_readx (MATRIX **mat, TABREAD *tread, DIMID rowcnt, DIMID colcnt)
 }  /* mat_readx() */
 
 #endif
+
+/*----------------------------------------------------------------------
+  Main Function for Benchmarking
+----------------------------------------------------------------------*/
+#ifdef MATRIX_MAIN
+
+static void oldtransp (MATRIX *res, const MATRIX *mat)
+{                               /* --- transpose a matrix (old code) */
+  DIMID row, col;               /* loop variables */
+  double *s;                    /* to traverse the matrix rows */
+
+  for (col = mat->colcnt; --col >= 0; )
+    for (s = res->els[col] +(row = mat->rowcnt); --row >= 0; )
+      *--s = mat->els[row][col];
+}  /* oldtransp() */            /* transpose the source columns */
+
+/*--------------------------------------------------------------------*/
+
+static void oldmul (MATRIX *res, const MATRIX *A, const MATRIX *B)
+{                               /* --- multiply matrices (old code) */
+  DIMID        row, col, i;     /* loop variables */
+  const double *sa, *sb;        /* to traverse the source rows */
+  double       *d;              /* to traverse the destination rows */
+  double       t;               /* temporary buffer */
+
+  for (row = A->rowcnt; --row >= 0; ) {
+    sa = A->els[row];           /* traverse the rows    of matrix A */
+    d  = res->els[row];         /* traverse the columns of matrix B */
+    for (col = B->colcnt; --col >= 0; )
+      d[col] = 0;               /* initialize the result */
+    for (i = B->rowcnt; --i >= 0; ) {
+      t = sa[i]; sb = B->els[i];
+      for (col = B->colcnt; --col >= 0; )
+        d[col] += t *sb[col];   /* multiply the row of matrix A with */
+    }                           /* the matrix B and store the result */
+  }                             /* in the corr. row of the matrix res */
+}  /* oldmul() */
+
+/*--------------------------------------------------------------------*/
+
+static double maxdiff (const MATRIX *A, const MATRIX *B)
+{                               /* --- maximal element difference */
+  DIMID  row, col;              /* loop variables */
+  double d, m = 0;              /* element difference, maximum */
+
+  for (row = A->rowcnt; --row >= 0; ) {
+    for (col = A->colcnt; --col >= 0; ) {
+      d = fabs(A->els[row][col] -B->els[row][col]);
+      if (d > m) m = d;         /* traverse the matrix elements */
+    }                           /* and determine the maximal */
+  }                             /* absolute difference */
+  return m;                     /* return the maximal difference */
+}  /* maxdiff() */
+
+/*--------------------------------------------------------------------*/
+
+static double mtime (MATRIX *res, const MATRIX *A, const MATRIX *B,
+                     int old)
+{                               /* --- time a matrix operation */
+  int     i, n;                 /* loop variable, repetitions */
+  clock_t t;                    /* timer for measurements */
+
+  for (n = 1; 1; n += n) {      /* double repetitions until the */
+    t = clock();                /* time is long enough to measure */
+    for (i = 0; i < n; i++) {   /* execute the operation n times */
+      if      (!B) { if (old) oldtransp(res, A);
+                     else     mat_transp(res, A); }
+      else if (old) oldmul(res, A, B);
+      else          mat_mul(res, A, B);
+    }
+    t = clock() -t;             /* measure the execution time */
+    if ((t >= CLOCKS_PER_SEC/10) || (n >= 1 << 20)) break;
+  }                             /* (at least 0.1 seconds) */
+  return (double)t /(double)CLOCKS_PER_SEC /(double)n;
+}  /* mtime() */                /* return the time per operation */
+
+/*--------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                               /* --- compare matrix kernels */
+  DIMID  n, max = 1024;         /* matrix size, maximal size */
+  DIMID  row, col;              /* loop variables */
+  double o, t, e;               /* execution times, deviation */
+  MATRIX *A, *B, *C, *D;        /* matrices to process */
+
+  if ((argc > 1) && (strcmp(argv[1], "-h") == 0)) {
+    printf("usage: %s [maxsize]\n", argv[0]);
+    printf("compare blocked matrix kernels to simple loops\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+  if (argc > 1) max = (DIMID)strtol(argv[1], NULL, 0);
+  srand(1);                     /* get the maximal matrix size */
+  printf("op     size     old [s]     new [s]  speedup  max. diff.\n");
+  for (n = 16; n <= max; n += n) {
+    A = mat_create(n, n); B = mat_create(n, n);
+    C = mat_create(n, n); D = mat_create(n, n);
+    if (!A || !B || !C || !D) {
+      printf("not enough memory\n"); return -1; }
+    for (row = 0; row < n; row++) {
+      for (col = 0; col < n; col++) {
+        A->els[row][col] = (double)rand()/RAND_MAX -0.5;
+        B->els[row][col] = (double)rand()/RAND_MAX -0.5;
+      }                         /* fill the matrices */
+    }                           /* with random numbers */
+    o = mtime(C, A, NULL, 1);
+    t = mtime(D, A, NULL, 0);
+    e = maxdiff(C, D);          /* compare the transposition */
+    mat_copy(D, A); mat_transp(D, D);
+    if (maxdiff(C, D) > e) e = maxdiff(C, D);
+    printf("transp %4"DIMID_FMT" %11.6f %11.6f %8.2f %11.4g\n",
+           n, o, t, o/t, e);    /* print the transposition results */
+    o = mtime(C, A, B, 1);      /* compare the multiplication */
+    t = mtime(D, A, B, 0);      /* (including in-place variants) */
+    e = maxdiff(C, D);
+    mat_copy(D, A); mat_mul(D, D, B);
+    if (maxdiff(C, D) > e) e = maxdiff(C, D);
+    mat_copy(D, B); mat_mul(D, A, D);
+    if (maxdiff(C, D) > e) e = maxdiff(C, D);
+    printf("mul    %4"DIMID_FMT" %11.6f %11.6f %8.2f %11.4g\n",
+           n, o, t, o/t, e);    /* print the multiplication results */
+    mat_delete(A); mat_delete(B); mat_delete(C); mat_delete(D);
+  }                             /* delete the matrices */
+  return 0;                     /* return 'ok' */
+}  /* main() */
+
+#endif
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+if [[ "$1" == "-h" ]]; then
+  echo "usage: fltbench.sh [epochs [units [bindir]]]"
+  echo "compare double and single precision versions of mlpt/mlpx"
+  echo "(build the single precision versions with 'make floats')"
+  echo "epochs  number of training epochs  (default: 5000)"
+  echo "units   number of hidden units     (default: 3)"
+  echo "bindir  directory of the programs  (default: ../src)"
+  exit
+fi
+
+epochs=${1:-5000}
+units=${2:-3}
+bin=${3:-../src}
+
+printf "%-6s %-7s %12s %14s %8s\n" data version sse errors time
+for data in iris wine; do
+  for v in "" f fd; do
+    if [[ ! -x $bin/mlpt$v ]]; then continue; fi
+    beg=`date +%s%N`
+    sse=`$bin/mlpt$v -c$units -S1 -e$epochs $data.dom $data.tab \
+         fltbench.net 2>&1 | \
+         gawk '/^writing/ { s = substr($0, index($0, "[sse: ")+6);
+                            sub(/[],].*/, "", s); print s }'`
+    end=`date +%s%N`
+    err=`$bin/mlpx$v fltbench.net $data.tab 2>&1 | \
+         gawk '($2 ~ "error[(]s[)]") { print $1, $3 }'`
+    case "$v" in
+      f)  name=float;;
+      fd) name=float+d;;
+      *)  name=double;;
+    esac
+    printf "%-6s %-7s %12s %14s %7.2fs\n" $data $name "$sse" "$err" \
+      `gawk -v b=$beg -v e=$end 'BEGIN { print (e-b)/1e9 }'`
+  done
+done
+rm -f fltbench.net
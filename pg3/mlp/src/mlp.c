@@ -32,7 +32,25 @@
             2013.06.12 bug in function mlp_desc() fixed (ranges)
             2013.08.28 bug in function mlp_parse() fixed (duplicate nst)
             2014.10.07 bug in function mlp_parse() fixed (missing nst)
+            2016.05.02 block/batch execution functions added
+            2016.05.04 block/batch backpropagation function added
+            2016.05.06 shadow networks added (for parallel training)
+            2016.05.09 vectorized activation functions (module mlpvec)
+            2016.05.11 single precision version added (MLP_FLOAT)
+            2016.05.12 binary network files added (mlp_binsave() etc.)
+            2016.05.14 execution contexts added (MLPCTX, mlp_execc() etc.)
+            2016.05.15 block inputs/targets from column-major tables
+            2016.05.16 sparse inputs added (mlp_execs(), mlp_bkprops())
+            2016.05.16 fused branch-free weight update functions added
+            2016.05.16 functions mlp_clone() and mlp_wgtcopy() added
+            2016.05.16 function mlp_normcopy() added (copy scaling)
+            2016.05.16 Jacobian based sensitivity functions added
+            2016.05.16 no weight vector allocated for shadow networks
 ----------------------------------------------------------------------*/
+#if !defined _WIN32 && !defined MLP_NOMMAP
+#define MLP_MMAP                /* map binary weights into memory */
+#define _POSIX_C_SOURCE 200112L /* needed for fileno() and mmap() */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,7 +58,11 @@
 #include <float.h>
 #include <math.h>
 #include <assert.h>
+#ifdef MLP_MMAP
+#include <sys/mman.h>
+#endif
 #include "mlp.h"
+#include "mlpvec.h"
 #ifdef STORAGE
 #include "storage.h"
 #endif
@@ -49,33 +71,33 @@
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
 /* --- activation function and its derivative --- */
-#ifdef MLP_TABFN                /* if to use a tabulated function */
-#define TABSIZE     1024        /* size of interpolation table */
-#define TABMAX      16.0        /* maximum (absolute) argument value */
-#define TABSCALE    (TABSIZE/TABMAX)
-#endif                          /* scale factor for table indices */
+/* The activation function and its derivative are applied to whole  */
+/* vectors of unit outputs with the vectorized kernels of mlpvec.c,  */
+/* which deviate from the libm based computation (ACTFN) by less     */
+/* than MV_MAXERR (absolute), see mlpvec.c for details.              */
+/* If MLP_FLOAT is defined, the single precision kernels are used,    */
+/* which deviate by less than MV_MAXERRF.                            */
+#ifdef MLP_FLOAT                /* single precision kernels */
+#define MV(k)       mv_##k##f
+#else                           /* double precision kernels */
+#define MV(k)       mv_##k
+#endif
 
 #ifndef MLP_TANH                /* default: logistic function */
-#define MACTFN(x)   (1/(1 +exp(-(x))))
-#ifdef MLP_TABFN                /* tabulated function */
-#define ACTFN(x)    logistic(x)
-#else                           /* direct computation */
-#define ACTFN(x)    MACTFN(x)
-#endif
+#define ACTFN(x)    (1/(1 +exp(-(x))))
+#define ACTVEC(x,n) MV(logistic)(x, n)
 #define DERIV(x)    ((x)*(1-(x)))
+#define DERVEC(e,y,n,r)  MV(dlogistic)(e, y, n, r)
 #define ACTMIN       0.0        /* minimal and maximal value */
 #define ACTMAX       1.0        /* of the activation function */
 #define ACTMID       0.5        /* middle value */
 #define MLP_LRATE    0.2
 
 #else                           /* alternative: tangens hyperbolicus */
-#define MACTFN(x)   (2/(1 +exp(-2*(x))) -1)
-#ifdef MLP_TABFN                /* tabulated function */
-#define ACTFN(x)    tanh(x)
-#else                           /* direct computation */
-#define ACTFN(x)    MACTFN(x)
-#endif
+#define ACTFN(x)    (2/(1 +exp(-2*(x))) -1)
+#define ACTVEC(x,n) MV(tanh)(x, n)
 #define DERIV(x)    ((1+(x))*(1-(x)))
+#define DERVEC(e,y,n,r)  MV(dtanh)(e, y, n, r)
 #define ACTMIN      -1.0        /* minimal and maximal value */
 #define ACTMAX       1.0        /* of the activation function */
 #define ACTMID       0.0        /* middle value */
@@ -84,6 +106,20 @@
 
 #define NAMELEN     255         /* maximum target name length */
 
+#ifdef MLP_FLOAT                /* format for the connection weights */
+#define WGTFMT      "%+.9g"     /* (enough digits to read them back */
+#else                           /* without loss of precision) */
+#define WGTFMT      "%+.16g"
+#endif
+
+/* --- binary network files --- */
+#define BIN_CHUNK   1024        /* number of weights per read chunk */
+
+/* --- block computations --- */
+#define BLK_IN      256         /* number of inputs per block (L1) */
+#define ACC(x)      ((MLPACC)(x))   /* convert to accumulator type */
+#define ADD(y,s)    ((y) = (MLPVAL)((y) +(s)))  /* add partial sum */
+
 /* --- error codes --- */
 #define E_ATTEXP    (-16)       /* attribute expected */
 #define E_UNKATT    (-17)       /* unknown attribute */
@@ -109,48 +145,6 @@ static const char *msgs[] = {   /* error messages */
 };
 #endif
 
-/*----------------------------------------------------------------------
-  Global Variables
-----------------------------------------------------------------------*/
-#ifdef MLP_TABFN
-static double acttab[TABSIZE+1];/* tabulated activation function */
-static int    init = 0;         /* whether table is initialized */
-#endif
-
-/*----------------------------------------------------------------------
-  Activation Function
-----------------------------------------------------------------------*/
-#ifdef MLP_TABFN
-#ifndef MLP_TANH
-
-static double logistic (double x)
-{                               /* --- table-based logistic function */
-  int    i;                     /* table index */
-  double y = fabs(x);           /* argument of tabulated function */
-
-  if (y >= TABMAX)              /* if beyond the table range, */
-    return (x > 0) ? 1 : 0;     /* return asymptotic values */
-  i = (int)(y *= TABSCALE);     /* otherwise compute the table index */
-  y = acttab[i] + (y-i) * (acttab[i+1] -acttab[i]);
-  return (x < 0) ? 1-y : y;     /* interpolate between table values */
-}  /* logistic() */
-
-#else /*--------------------------------------------------------------*/
-
-static double tanh (double x)
-{                               /* --- table-based tanh function */
-  int    i;                     /* table index */
-  double y = fabs(x);           /* argument of tabulated function */
-
-  if (y >= TABMAX)              /* if beyond the table range, */
-    return (x > 0) ? 1 : -1;    /* return asymptotic values */
-  i = (int)(y *= TABSCALE);     /* otherwise compute the table index */
-  y = acttab[i] + (y-i) * (acttab[i+1] -acttab[i]);
-  return (x < 0) ? -y : y;      /* interpolate between table values */
-}  /* tanh() */
-
-#endif  /* #ifndef MLP_TANH */
-#endif  /* #ifdef MLP_TABFN */
 /*----------------------------------------------------------------------
   Weight Update Functions
 ----------------------------------------------------------------------*/
@@ -158,9 +152,9 @@ static double tanh (double x)
 static void standard (MLP *mlp)
 {                               /* --- standard backpropagation */
   DIMID  i;                     /* loop variable */
-  double *w, *c, *g;            /* to traverse the vectors */
-  double lrate  = mlp->lrate;   /* learning rate */
-  double moment = mlp->moment;  /* momentum coefficient */
+  MLPVAL *w, *c, *g;            /* to traverse the vectors */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
+  MLPVAL moment = (MLPVAL)mlp->moment;  /* momentum coefficient */
 
   w = mlp->wgts;                /* get the necessary vectors and */
   g = mlp->grds;                /* traverse the connection weights */
@@ -179,8 +173,12 @@ static void standard (MLP *mlp)
 static void adaptive (MLP *mlp)
 {                               /* --- super self-adaptive backprop. */
   DIMID  i;                     /* loop variable */
-  double *w, *c, *g, *p;        /* to traverse the vectors */
-  double t;                     /* temporary buffer */
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL t;                     /* temporary buffer */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* growth    factor */
+  MLPVAL shrink = (MLPVAL)mlp->shrink;  /* shrinkage factor */
+  MLPVAL minchg = (MLPVAL)mlp->minchg;  /* minimal change */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
 
   w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
   g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
@@ -189,12 +187,12 @@ static void adaptive (MLP *mlp)
     else if (g[i] < 0) t = -p[i];
     else               t =  0;  /* check directions of the changes */
     if      (t > 0) {           /* if gradients have the same sign, */
-      c[i] *= mlp->growth;      /* increase the step width */
-      if (c[i] > mlp->maxchg) c[i] = mlp->maxchg;
+      c[i] *= growth;           /* increase the step width */
+      if (c[i] > maxchg) c[i] = maxchg;
       p[i] = g[i]; }            /* note the current gradient */
     else if (t < 0) {           /* if gradients have opposite signs, */
-      c[i] *= mlp->shrink;      /* decrease the step width */
-      if (c[i] < mlp->minchg) c[i] = mlp->minchg;
+      c[i] *= shrink;           /* decrease the step width */
+      if (c[i] < minchg) c[i] = minchg;
       p[i] = 0; }               /* suppress a change in the next step */
     else {                      /* if one gradient is zero, */
       p[i] = g[i]; }            /* only note the current gradient */
@@ -208,8 +206,12 @@ static void adaptive (MLP *mlp)
 static void resilient (MLP *mlp)
 {                               /* --- resilient backpropagation */
   DIMID  i;                     /* loop variable */
-  double *w, *c, *g, *p;        /* to traverse the vectors */
-  double t;                     /* temporary buffer */
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL t;                     /* temporary buffer */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* growth    factor */
+  MLPVAL shrink = (MLPVAL)mlp->shrink;  /* shrinkage factor */
+  MLPVAL minchg = (MLPVAL)mlp->minchg;  /* minimal change */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
 
   w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
   g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
@@ -218,12 +220,12 @@ static void resilient (MLP *mlp)
     else if (g[i] < 0) t = -p[i];
     else               t =  0;  /* check directions of the changes */
     if      (t > 0) {           /* if gradients have the same sign, */
-      c[i] *= mlp->growth;      /* increase the update value */
-      if (c[i] > mlp->maxchg) c[i] = mlp->maxchg;
+      c[i] *= growth;           /* increase the update value */
+      if (c[i] > maxchg) c[i] = maxchg;
       p[i] = g[i]; }            /* note the current gradient */
     else if (t < 0) {           /* if gradients have opposite signs, */
-      c[i] *= mlp->shrink;      /* decrease the update value */
-      if (c[i] < mlp->minchg) c[i] = mlp->minchg;
+      c[i] *= shrink;           /* decrease the update value */
+      if (c[i] < minchg) c[i] = minchg;
       p[i] = 0; }               /* suppress a change in the next step */
     else {                      /* if one gradient is zero, */
       p[i] = g[i]; }            /* only note the current gradient */
@@ -238,12 +240,14 @@ static void resilient (MLP *mlp)
 static void quick (MLP *mlp)
 {                               /* --- quick backpropagation */
   DIMID  i;                     /* loop variable */
-  double *w, *c, *g, *p;        /* to traverse the vectors */
-  double lrate = mlp->lrate;    /* learning rate */
-  double m;                     /* maximal fraction of new derivative */
-  double t;                     /* temporary buffer */
-
-  m = mlp->growth /(mlp->growth +1);
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* maximal growth factor */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
+  MLPVAL m;                     /* maximal fraction of new derivative */
+  MLPVAL t;                     /* temporary buffer */
+
+  m = (MLPVAL)(mlp->growth /(mlp->growth +1));
   w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
   g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
   for (i = 0; i < mlp->wgtcnt; i++) {
@@ -254,20 +258,20 @@ static void quick (MLP *mlp)
       if (g[i] < m *p[i])       /* compute the factor for a jump */
         c[i] *= g[i] /t;        /* to the minimum (apex of parabola) */
       else                      /* if the growth factor would become */
-        c[i] *= mlp->growth;    /* too large, use the maximal factor */
+        c[i] *= growth;         /* too large, use the maximal factor */
       if (g[i] > 0)             /* if steps are in the same dir., */
         c[i] -= lrate *g[i]; }  /* add a normal backpropagation step */
     else if (p[i] < 0) {        /* if previous gradient was negative */
       if (g[i] > m *p[i])       /* compute the factor for a jump */
         c[i] *= g[i] /t;        /* to the minimum (apex of parabola) */
       else                      /* if the growth factor would become */
-        c[i] *= mlp->growth;    /* too large, use the maximal factor */
+        c[i] *= growth;         /* too large, use the maximal factor */
       if (g[i] < 0)             /* if steps are in the same dir., */
         c[i] -= lrate *g[i]; }  /* add a normal backpropagation step */
     else                        /* if this is the first update, */
       c[i] = -lrate *g[i];      /* do a normal backpropagation step */
-    if      (c[i] >  mlp->maxchg) c[i] =  mlp->maxchg;  /* clamp the */
-    else if (c[i] < -mlp->maxchg) c[i] = -mlp->maxchg;  /* change */
+    if      (c[i] >  maxchg) c[i] =  maxchg;  /* clamp the */
+    else if (c[i] < -maxchg) c[i] = -maxchg;  /* change */
     w[i] += c[i];               /* adapt the connection weight, */
     p[i] = g[i]; g[i] = 0;      /* note the gradient and clear it */
   }                             /* for the next step */
@@ -278,8 +282,8 @@ static void quick (MLP *mlp)
 static void manhattan (MLP *mlp)
 {                               /* --- Manhattan training */
   DIMID  i;                     /* loop variable */
-  double *w, *g;                /* to traverse the vectors */
-  double lrate  = mlp->lrate;   /* learning rate */
+  MLPVAL *w, *g;                /* to traverse the vectors */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
 
   w = mlp->wgts;                /* get the necessary vectors and */
   g = mlp->grds;                /* traverse the connection weights */
@@ -290,35 +294,347 @@ static void manhattan (MLP *mlp)
   }                             /* and clear the gradient */
 }  /* manhattan() */            /* for the next step */
 
+/*----------------------------------------------------------------------
+  Fused Weight Update Functions
+----------------------------------------------------------------------*/
+/* The following functions combine weight decay, the weight update   */
+/* and clearing the gradients in one pass over the vectors. Branches */
+/* on the signs of the gradients are replaced by conditional         */
+/* expressions that are evaluated for all elements, so that the      */
+/* compiler can vectorize the loops (using masks/blends). The        */
+/* arithmetic operations and their order are the same as in the      */
+/* functions above, so that the results are bit-identical (weight    */
+/* decay is always applied, as multiplying with 1 changes nothing).  */
+
+static void fstandard (MLP *mlp)
+{                               /* --- standard backpropagation */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *w, *c, *g;            /* to traverse the vectors */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
+  MLPVAL moment = (MLPVAL)mlp->moment;  /* momentum coefficient */
+  MLPVAL decay  = (MLPVAL)mlp->decay;   /* weight decay factor */
+
+  w = mlp->wgts;                /* get the necessary vectors and */
+  g = mlp->grds;                /* traverse the connection weights */
+  if (moment <= 0)              /* if standard backpropagation */
+    for (i = 0; i < mlp->wgtcnt; i++) {
+      w[i] = w[i] *decay -lrate *g[i]; g[i] = 0; }
+  else {                        /* if backpropagation with momentum */
+    c = mlp->chgs;              /* get the vector of old changes */
+    for (i = 0; i < mlp->wgtcnt; i++) {
+      w[i] = w[i] *decay +(c[i] = moment *c[i] - lrate *g[i]);
+      g[i] = 0;                 /* update the connection weights */
+    }                           /* and clear the gradients */
+  }
+}  /* fstandard() */
+
+/*--------------------------------------------------------------------*/
+
+static void fadaptive (MLP *mlp)
+{                               /* --- super self-adaptive backprop. */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL wi, ci, gi, pi;        /* current vector elements */
+  MLPVAL t, x, y;               /* temporary buffers */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* growth    factor */
+  MLPVAL shrink = (MLPVAL)mlp->shrink;  /* shrinkage factor */
+  MLPVAL minchg = (MLPVAL)mlp->minchg;  /* minimal change */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
+  MLPVAL decay  = (MLPVAL)mlp->decay;   /* weight decay factor */
+
+  w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
+  g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
+  for (i = 0; i < mlp->wgtcnt; i++) {
+    wi = w[i]; ci = c[i]; gi = g[i]; pi = p[i];
+    t  = (gi > 0) ? pi : (gi < 0) ? -pi : 0;
+    x  = ci *growth; x = (x > maxchg) ? maxchg : x;
+    y  = ci *shrink; y = (y < minchg) ? minchg : y;
+    ci = (t > 0) ? x : (t < 0) ? y : ci;
+    c[i] = ci;                  /* compute the new step width */
+    p[i] = (t < 0) ? 0 : gi;    /* and note the current gradient */
+    w[i] = wi *decay -ci *gi;   /* update the connection weight */
+    g[i] = 0;                   /* and clear the gradient */
+  }                             /* for the next step */
+}  /* fadaptive() */
+
+/*--------------------------------------------------------------------*/
+
+static void fresilient (MLP *mlp)
+{                               /* --- resilient backpropagation */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL wi, ci, gi, pi;        /* current vector elements */
+  MLPVAL t, x, y;               /* temporary buffers */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* growth    factor */
+  MLPVAL shrink = (MLPVAL)mlp->shrink;  /* shrinkage factor */
+  MLPVAL minchg = (MLPVAL)mlp->minchg;  /* minimal change */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
+  MLPVAL decay  = (MLPVAL)mlp->decay;   /* weight decay factor */
+
+  w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
+  g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
+  for (i = 0; i < mlp->wgtcnt; i++) {
+    wi = w[i]; ci = c[i]; gi = g[i]; pi = p[i];
+    t  = (gi > 0) ? pi : (gi < 0) ? -pi : 0;
+    x  = ci *growth; x = (x > maxchg) ? maxchg : x;
+    y  = ci *shrink; y = (y < minchg) ? minchg : y;
+    ci = (t > 0) ? x : (t < 0) ? y : ci;
+    c[i] = ci;                  /* compute the new update value */
+    p[i] = (t < 0) ? 0 : gi;    /* and note the current gradient */
+    x  = (gi > 0) ? ci : (gi < 0) ? -ci : 0;
+    w[i] = wi *decay -x;        /* update the weight (sign only) */
+    g[i] = 0;                   /* (w - (-c) is identical to w + c) */
+  }                             /* and clear the gradient */
+}  /* fresilient() */
+
+/*--------------------------------------------------------------------*/
+
+static void fquick (MLP *mlp)
+{                               /* --- quick backpropagation */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *w, *c, *g, *p;        /* to traverse the vectors */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
+  MLPVAL growth = (MLPVAL)mlp->growth;  /* maximal growth factor */
+  MLPVAL maxchg = (MLPVAL)mlp->maxchg;  /* maximal change */
+  MLPVAL decay  = (MLPVAL)mlp->decay;   /* weight decay factor */
+  MLPVAL m;                     /* maximal fraction of new derivative */
+  MLPVAL wi, ci, gi, pi;        /* current vector elements */
+  MLPVAL t, a, f, u, v, x, y, z;/* temporary buffers */
+
+  m = (MLPVAL)(mlp->growth /(mlp->growth +1));
+  w = mlp->wgts; c = mlp->chgs; /* get the necessary vectors and */
+  g = mlp->grds; p = mlp->bufs; /* traverse the connection weights */
+  for (i = 0; i < mlp->wgtcnt; i++) {
+    wi = w[i]; ci = c[i]; gi = g[i]; pi = p[i];
+    t  = pi -gi;                /* compute the change of the gradient */
+    a  = -lrate *gi;            /* and a normal backpropagation step */
+    x  = ci *(gi /t);           /* compute a jump to the minimum */
+    y  = ci *growth;            /* and a step with maximal growth */
+    z  = m *pi;                 /* (all operations are executed, */
+    u  = (gi < z) ? x : y;      /* only the results are selected) */
+    v  = (gi > z) ? x : y;      /* choose between jump and growth */
+    f  = (pi > 0) ? u : v;      /* depending on the prev. gradient */
+    x  = f -lrate *gi;          /* add a backpropagation step */
+    u  = (gi > 0) ? x : f;      /* if the steps are */
+    v  = (gi < 0) ? x : f;      /* in the same direction */
+    x  = (pi > 0) ? u : (pi < 0) ? v : a;
+    x  = (t *ci >= 0)  ? a : x; /* use a normal step if the */
+    x  = (x >  maxchg) ?  maxchg : x;   /* parabola opens */
+    x  = (x < -maxchg) ? -maxchg : x;   /* downwards and */
+    c[i] = x;                   /* clamp the weight change */
+    w[i] = wi *decay +x;        /* adapt the connection weight, */
+    p[i] = gi; g[i] = 0;        /* note the gradient and clear it */
+  }                             /* for the next step */
+}  /* fquick() */
+
+/*--------------------------------------------------------------------*/
+
+static void fmanhattan (MLP *mlp)
+{                               /* --- Manhattan training */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *w, *g;                /* to traverse the vectors */
+  MLPVAL x, y;                  /* temporary buffers */
+  MLPVAL lrate  = (MLPVAL)mlp->lrate;   /* learning rate */
+  MLPVAL decay  = (MLPVAL)mlp->decay;   /* weight decay factor */
+
+  w = mlp->wgts;                /* get the necessary vectors and */
+  g = mlp->grds;                /* traverse the connection weights */
+  for (i = 0; i < mlp->wgtcnt; i++) {
+    x = g[i];                   /* decay the weight and */
+    y = (x > 0) ? lrate : (x < 0) ? -lrate : 0;
+    w[i] = w[i] *decay -y;      /* (w - (-r) is identical to w + r) */
+    g[i] = 0;                   /* update the connection weights */
+  }                             /* and clear the gradient */
+}  /* fmanhattan() */           /* for the next step */
+
 /*--------------------------------------------------------------------*/
 
 static UPDATEFN *updatefn[] = {
+  /* MLP_STANDARD   0 */  fstandard,
+  /* MLP_ADPATIVE   1 */  fadaptive,
+  /* MLP_RESILIENT  2 */  fresilient,
+  /* MLP_QUICK      3 */  fquick,
+  /* MLP_MANHATTAN  4 */  fmanhattan,
+};                              /* list of weight update functions */
+
+static UPDATEFN *scalarfn[] = {
   /* MLP_STANDARD   0 */  standard,
   /* MLP_ADPATIVE   1 */  adaptive,
   /* MLP_RESILIENT  2 */  resilient,
   /* MLP_QUICK      3 */  quick,
   /* MLP_MANHATTAN  4 */  manhattan,
-};                              /* list of weight update functions */
+};                              /* list of scalar update functions */
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static void norm (NSTATS *nst, const double *vec, MLPVAL *res)
+{                               /* --- normalize an input vector */
+  DIMID i;                      /* loop variable */
+
+  for (i = 0; i < nst_dim(nst); i++)
+    res[i] = (MLPVAL)(nst_factor(nst, i) *(vec[i] -nst_offset(nst, i)));
+}  /* norm() */                 /* (same as nst_norm(), but to MLPVAL) */
+
+/*--------------------------------------------------------------------*/
+
+static void exec (MLP *mlp, MLPVAL *const *vecs, double *scos,
+                  int sparse)
+{                               /* --- execute multilayer perceptron */
+  int      l;                   /* loop variable  for layers */
+  DIMID    k, n;                /* loop variables for weights */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  MLPVAL   *wgt;                /* to traverse the weight vectors */
+  MLPVAL   *x, *y;              /* inputs and outputs of a layer */
+  MLPACC   net;                 /* sum of weighted inputs */
+
+  layer = mlp->layers;          /* traverse the network layers */
+  for (l = 0; l < mlp->lyrcnt-1; l++, layer++) {
+    x = vecs[l]; y = vecs[l+1]; /* get the layer inputs and outputs */
+    for (k = layer->outcnt; --k >= 0; ) {
+      wgt = layer->wgts[k];     /* traverse the units of the layer */
+      net = wgt[layer->incnt];  /* and sum the weighted inputs */
+      if (sparse && (l <= 0)) { /* if sparse network input */
+        for (n = mlp->spcnt; --n >= 0; )
+          net += (MLPACC)mlp->spvals[n] *wgt[mlp->spidx[n]]; }
+      else {                    /* if dense input vector */
+        for (n = layer->incnt; --n >= 0; )
+          net += (MLPACC)x[n] *wgt[n];
+      }                         /* (only the listed inputs of */
+      y[k] = (MLPVAL)net;       /* a sparse input are non-zero) */
+    }                           /* and compute the activations */
+    ACTVEC(y, (size_t)layer->outcnt);
+  }                             /* (outputs) of the units */
+  y = vecs[mlp->lyrcnt-1];      /* apply output transformation */
+  for (k = 0; k < mlp->outcnt; k++)
+    scos[k] = y[k] *mlp->scls[k] +mlp->offs[k];
+}  /* exec() */
+
+/*--------------------------------------------------------------------*/
+
+static double sens (MLP *mlp, MLPVAL *const *vecs, MLPVAL *const *errs,
+                    DIMID unit, int mode)
+{                               /* --- analyze sensitivity on input */
+  int      l;                   /* loop variable  for layers */
+  DIMID    k, n;                /* loop variables for weights */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  MLPVAL   **w;                 /* to traverse the weight vectors */
+  MLPVAL   *e, *p, *o;          /* to traverse the sensitivity values */
+  double   s;                   /* resulting sensitivity */
+
+  layer = mlp->layers;          /* get the first hidden layer */
+  w = layer->wgts; o = vecs[1]; /* traverse the first hidden layer */
+  e = errs[0];                  /* and compute sensitivity values */
+  for (k = layer->outcnt; --k >= 0; )
+    e[k] = w[k][unit] *DERIV(o[k]);
+  for (l = 1; l < mlp->lyrcnt-1; l++) {
+    p = e; ++layer;             /* traverse the remaining layers */
+    e = memset(errs[l], 0, (size_t)layer->outcnt *sizeof(MLPVAL));
+    w = layer->wgts; o = vecs[l+1];   /* clear the sens. values */
+    for (k = layer->outcnt; --k >= 0; ) {
+      for (n = layer->incnt; --n >= 0; )
+        e[k] += w[k][n] *p[n];  /* aggregate the sensitivity values */
+      e[k] *= DERIV(o[k]);      /* of the preceding layer and */
+    }                           /* compute the sensitivity values */
+  }                             /* of the next layer */
+  for (k = mlp->outcnt; --k >= 0; )    /* compute the absolute */
+    e[k] = (MLPVAL)fabs(e[k] *mlp->scls[k]); /* sensitivities */
+  k = mlp->outcnt; s = 0;       /* compute sum or maximum */
+  if (mode & MLP_SUM) while (--k >= 0) { s += e[k]; }
+  else                while (--k >= 0) { if (e[k] > s) s = e[k]; }
+  return s;                     /* return the sensitivity */
+}  /* sens() */
+
+/*--------------------------------------------------------------------*/
+
+static MLPVAL* jacob (MLP *mlp, MLPVAL *const *vecs,
+                      MLPVAL *const *bufs)
+{                               /* --- compute the Jacobian matrix */
+  int      l;                   /* loop variable  for layers */
+  DIMID    i, j, k;             /* loop variables for units/weights */
+  DIMID    m, n;                /* number of units/inputs of a layer */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  MLPVAL   *w, *o;              /* weight vector, layer outputs */
+  MLPVAL   *src, *dst, *d;      /* Jacobian rows (derivatives) */
+  MLPVAL   f;                   /* derivative factor for a row */
+
+  l     = mlp->lyrcnt-2;        /* get the output layer */
+  layer = mlp->layers +l;       /* and its output values */
+  o = vecs[l+1]; n = layer->incnt; dst = bufs[0];
+  for (i = 0; i < mlp->outcnt; i++) {
+    f = (MLPVAL)(DERIV(o[i]) *mlp->scls[i]);
+    w = layer->wgts[i];         /* derivatives of the scaled outputs */
+    d = dst +(size_t)i *(size_t)n;   /* w.r.t. the layer inputs */
+    for (k = 0; k < n; k++) d[k] = f *w[k];
+  }
+  while (--l >= 0) {            /* traverse the hidden layers */
+    src = dst; dst = (dst == bufs[0]) ? bufs[1] : bufs[0];
+    --layer; o = vecs[l+1];     /* get the next layer (backwards) */
+    m = layer->outcnt; n = layer->incnt;
+    for (i = 0; i < mlp->outcnt; i++) {
+      d = dst +(size_t)i *(size_t)n;
+      memset(d, 0, (size_t)n *sizeof(MLPVAL));
+      for (k = 0; k < m; k++) { /* traverse the units of the layer */
+        f = (MLPVAL)(src[(size_t)i *(size_t)m +(size_t)k] *DERIV(o[k]));
+        if (f == 0) continue;   /* skip vanishing derivatives */
+        w = layer->wgts[k];     /* multiply the rows of the weight */
+        for (j = 0; j < n; j++) /* matrix with the derivatives */
+          d[j] += f *w[j];      /* w.r.t. the unit outputs */
+      }                         /* and sum the results */
+    }                           /* (chain rule: one matrix product */
+  }                             /* per layer, the number of rows */
+  return dst;                   /* is the number of outputs) */
+}  /* jacob() */
+
+/*--------------------------------------------------------------------*/
+
+static MLPVAL* sensv (MLP *mlp, MLPVAL *const *vecs, MLPVAL *const *bufs,
+                      int mode)
+{                               /* --- sensitivities of all inputs */
+  DIMID  i, k;                  /* loop variables */
+  MLPVAL *jac, *s, *r;          /* Jacobian, sensitivities, row */
+
+  jac = jacob(mlp, vecs, bufs); /* compute the Jacobian matrix */
+  s   = (jac == bufs[0]) ? bufs[1] : bufs[0];
+  for (k = 0; k < mlp->incnt; k++)
+    s[k] = (MLPVAL)fabs(jac[k]);/* init. with the first output */
+  for (i = 1; i < mlp->outcnt; i++) {
+    r = jac +(size_t)i *(size_t)mlp->incnt;
+    if (mode & MLP_SUM)         /* sum or take the maximum of */
+      for (k = 0; k < mlp->incnt; k++)  /* the absolute values */
+        s[k] += (MLPVAL)fabs(r[k]);     /* over the outputs */
+    else
+      for (k = 0; k < mlp->incnt; k++)
+        if ((MLPVAL)fabs(r[k]) > s[k]) s[k] = (MLPVAL)fabs(r[k]);
+  }                             /* (same as sens() for all inputs, */
+  return s;                     /* but with only one pass through */
+}  /* sensv() */                /* the network per network output) */
+
+/*--------------------------------------------------------------------*/
+
+static void getvecs (MLP *mlp, MLPVAL **vecs, MLPVAL **errs)
+{                               /* --- collect the layer vectors */
+  int l;                        /* loop variable for layers */
+
+  vecs[0] = mlp->ins;           /* the network input comes first */
+  for (l = 0; l < mlp->lyrcnt-1; l++) {
+    vecs[l+1] = mlp->layers[l].outs;
+    if (errs) errs[l] = mlp->layers[l].errs;
+  }                             /* collect the outputs and errors */
+}  /* getvecs() */              /* (sensitivities) of the layers */
 
 /*----------------------------------------------------------------------
   Main Functions
 ----------------------------------------------------------------------*/
 
-static MLP* create (int lyrcnt, DIMID *ucnts)
+static MLP* create (int lyrcnt, DIMID *ucnts, int share)
 {                               /* --- create a multilayer perceptron */
   int    l;                     /* loop variable for layers */
   DIMID  k, n;                  /* loop variable for weights, buffer */
   MLP    *mlp;                  /* created multilayer perceptron */
-  double **pp, *p, *o;          /* to traverse the allocated vectors */
-
-  #ifdef MLP_TABFN              /* if to use tabulated logistic fn. */
-  if (!_init) {                 /* if table has not been initialized */
-    for (k = TABSIZE; --k >= 0; )
-      acttab[k] = MACTFN(k *(1/TABSCALE));
-    acttab[TABSIZE] = 1;        /* precompute a table for */
-    init = 1;                   /* the activation function and */
-  }                             /* set the initialization flag */
-  #endif  /* #ifdef MLP_TABFN */
+  MLPVAL **pp, *p, *o;          /* to traverse the allocated vectors */
+  double *d;                    /* to traverse the double vectors */
 
   assert((lyrcnt >= 2)          /* check the function arguments */
   &&     (lyrcnt <= MLP_MAXLAYER) && ucnts);
@@ -331,22 +647,26 @@ static MLP* create (int lyrcnt, DIMID *ucnts)
   for (k = 0, l = lyrcnt; --l > 0; )
     k += ucnts[l];              /* determine the number of units */
   mlp->unitcnt = k +ucnts[0];   /* and allocate matrix vectors */
-  pp = (double**)malloc(4 *(size_t)k *sizeof(double*));
+  pp = (MLPVAL**)malloc(4 *(size_t)k *sizeof(MLPVAL*));
   if (!pp) { free(mlp); return NULL; }
   for (n = 0, l = lyrcnt; --l > 0; )
     n += ucnts[l] *(ucnts[l-1] +1); /* det. the number of weights */
   mlp->wgtcnt = n;                  /* and num. of inputs/outputs */
   k += mlp->incnt +mlp->outcnt;     /* and allocate number vectors */
-  p = (double*)malloc((2*(size_t)k +4*(size_t)n +6*(size_t)mlp->outcnt)
-                      *sizeof(double));
-  if (!p) { free(pp); free(mlp); return NULL; }
-  mlp->mins = p; p += mlp->outcnt;  /* set the vectors for the */
-  mlp->maxs = p; p += mlp->outcnt;  /* minimal/maximal outputs, */
-  mlp->offs = p; p += mlp->outcnt;  /* the offsets, */
-  mlp->scls = p; p += mlp->outcnt;  /* the scaling factors */
-  mlp->recs = p; p += mlp->outcnt;  /* and their reciprocals, */
-  mlp->scos = p; p += mlp->outcnt;  /* the scaled outputs, */
-  mlp->trgs = p; p += mlp->outcnt;  /* the target outputs, */
+  d = (double*)malloc((7*(size_t)mlp->outcnt +(size_t)mlp->incnt)
+                      *sizeof(double)  /* (output scaling etc.) */
+                     +(2*(size_t)k +((share) ? 3 : 4)*(size_t)n)
+                      *sizeof(MLPVAL));/* (no weights if shared) */
+  if (!d) { free(pp); free(mlp); return NULL; }
+  mlp->mins = d; d += mlp->outcnt;  /* set the vectors for the */
+  mlp->maxs = d; d += mlp->outcnt;  /* minimal/maximal outputs, */
+  mlp->offs = d; d += mlp->outcnt;  /* the offsets, */
+  mlp->scls = d; d += mlp->outcnt;  /* the scaling factors */
+  mlp->recs = d; d += mlp->outcnt;  /* and their reciprocals, */
+  mlp->scos = d; d += mlp->outcnt;  /* the scaled outputs, */
+  mlp->trgs = d; d += mlp->outcnt;  /* the target outputs, */
+  mlp->raws = d; d += mlp->incnt;   /* the raw input vector */
+  p = (MLPVAL*)d;               /* (all double vectors come first) */
   mlp->ins = o = p; p += mlp->incnt;/* and the input vector */
   lyrcnt -= 1;                  /* traverse the network layers */
   for (l = 0; l < lyrcnt; l++){ /* and init. inputs and outputs */
@@ -358,11 +678,12 @@ static MLP* create (int lyrcnt, DIMID *ucnts)
   }                             /* set the layer specific vectors */
   mlp->outs = mlp->layers[l-1].outs; /* set output and error vector */
   mlp->errs = mlp->layers[l-1].errs; /* of the network as a whole */
-  mlp->wgts = p;                /* note the weight vector */
+  mlp->wgts = (share) ? NULL : p;  /* note the weight vector */
   for (l = 0; l < lyrcnt; l++){ /* traverse the layers */
-    mlp->layers[l].wgts = pp; n = ucnts[l] +1;
+    mlp->layers[l].wgts = pp; n = (share) ? 0 : ucnts[l] +1;
     for (k = ucnts[l+1]; --k >= 0; ) { *pp++ = p; p += n; }
   }                             /* set the weight matrix lines */
+                                /* (set by the caller if shared) */
   mlp->chgs = p;                /* note the weight change vector */
   for (l = 0; l < lyrcnt; l++){ /* traverse the layers */
     mlp->layers[l].chgs = pp; n = ucnts[l] +1;
@@ -383,6 +704,19 @@ static MLP* create (int lyrcnt, DIMID *ucnts)
     mlp->maxs[k] = -INFINITY;   /* initialize the output ranges */
   }
   mlp->nst    = NULL;           /* clear the norm. statistics */
+  mlp->shadow = 0;              /* (weights etc. are not shared) */
+  mlp->map    = NULL;           /* clear the memory map */
+  mlp->mapsz  = 0;              /* (of a binary network file) */
+  mlp->binwgt = 0;              /* no binary weights are pending */
+  mlp->blkcap = 0;              /* clear the pattern blocks */
+  mlp->bins   = NULL;
+  mlp->btrgs  = mlp->bscos = mlp->braws = NULL;
+  mlp->spcnt  = 0;              /* clear the sparse input */
+  mlp->spidx  = NULL;           /* (is created on demand) */
+  mlp->spvals = NULL;
+  for (l = 0; l < lyrcnt; l++)  /* (are created on demand) */
+    mlp->layers[l].bins = mlp->layers[l].bouts
+                        = mlp->layers[l].berrs = NULL;
   mlp->method = MLP_STANDARD;   /* set default update method */
   mlp->raise  = 0.0;            /* and set default values */
   mlp->lrate  = MLP_LRATE;      /* for the learning rate */
@@ -404,7 +738,7 @@ MLP* mlp_create (int lyrcnt, DIMID *ucnts)
 {                               /* --- create a multilayer perceptron */
   MLP *mlp;                     /* created multilayer perceptron */
 
-  mlp = create(lyrcnt, ucnts);  /* create a multilayer perceptron */
+  mlp = create(lyrcnt, ucnts, 0);/* create a multilayer perceptron */
   if (!mlp) return NULL;        /* and the normalization statistics */
   mlp->nst = nst_create(ucnts[0]);
   if (!mlp->nst) { mlp_delete(mlp); return NULL; }
@@ -417,11 +751,110 @@ void mlp_delete (MLP *mlp)
 {                               /* --- delete a multilayer perceptron */
   assert(mlp);                  /* check the function arguments */
   free(mlp->mins);              /* delete the weight vectors etc., */
-  free(mlp->layers[0].wgts);    /* the weight matrix vectors and */
-  nst_delete(mlp->nst);         /* the normalization statistics */
+  free(mlp->layers[0].wgts);    /* the weight matrix vectors, */
+  if (mlp->btrgs) free(mlp->btrgs); /* the pattern blocks, */
+  if (mlp->spvals) free(mlp->spvals);  /* the sparse input, */
+  if (!mlp->shadow)             /* the normalization statistics */
+    nst_delete(mlp->nst);       /* (unless they are shared) */
+  #ifdef MLP_MMAP               /* if weights are mapped from a file, */
+  if (mlp->map) munmap(mlp->map, mlp->mapsz);  /* unmap the file */
+  #endif
   free(mlp);                    /* delete the base structure */
 }  /* mlp_delete() */
 
+/*--------------------------------------------------------------------*/
+
+static MLP* shadow (MLP *mlp, int share)
+{                               /* --- create a shadow network */
+  int    l;                     /* loop variable for layers */
+  DIMID  k;                     /* loop variable for units */
+  DIMID  ucnts[MLP_MAXLAYER];   /* number of units per layer */
+  MLP    *shd;                  /* created shadow network */
+
+  assert(mlp);                  /* check the function argument */
+  ucnts[0] = mlp->incnt;        /* collect the numbers of units */
+  for (l = 0; l < mlp->lyrcnt-1; l++)
+    ucnts[l+1] = mlp->layers[l].outcnt;
+  shd = create(mlp->lyrcnt, ucnts, share);
+  if (!shd) return NULL;        /* create a network of same structure */
+  shd->shadow = 1;              /* note the shared norm. statistics */
+  if (!share)                   /* if the weights are not shared, */
+    memcpy(shd->wgts, mlp->wgts, (size_t)mlp->wgtcnt*sizeof(MLPVAL));
+  else {                        /* copy them, otherwise share the */
+    shd->wgts = mlp->wgts;      /* weights with the original network */
+    for (l = 0; l < mlp->lyrcnt-1; l++)
+      for (k = 0; k < mlp->layers[l].outcnt; k++)
+        shd->layers[l].wgts[k] = mlp->layers[l].wgts[k];
+  }                             /* (weight matrix lines) */
+  shd->nst    = mlp->nst;       /* share the normalization statistics */
+  memcpy(shd->mins, mlp->mins, 5*(size_t)mlp->outcnt*sizeof(double));
+  #ifdef MLP_EXTFN              /* copy the output scaling */
+  shd->attset = mlp->attset;    /* share the attribute set */
+  shd->attmap = mlp->attmap;    /* and the attribute map */
+  shd->trgatt = mlp->trgatt;    /* as well as the target attribute */
+  #endif
+  shd->method = mlp->method;    /* copy the training parameters */
+  shd->raise  = mlp->raise;
+  shd->lrate  = mlp->lrate;
+  shd->moment = mlp->moment;
+  shd->growth = mlp->growth;
+  shd->shrink = mlp->shrink;
+  shd->minchg = mlp->minchg;
+  shd->maxchg = mlp->maxchg;
+  shd->decay  = mlp->decay;
+  memset(shd->grds, 0, (size_t)shd->wgtcnt *sizeof(MLPVAL));
+  return shd;                   /* clear the gradients and */
+}  /* shadow() */               /* return the created shadow */
+
+/*--------------------------------------------------------------------*/
+
+MLP* mlp_shadow (MLP *mlp)
+{ return shadow(mlp, 1); }
+
+/*--------------------------------------------------------------------*/
+
+MLP* mlp_clone (MLP *mlp)
+{ return shadow(mlp, 0); }
+
+/*--------------------------------------------------------------------*/
+
+void mlp_wgtcopy (MLP *dst, const MLP *src)
+{                               /* --- copy the connection weights */
+  assert(dst && src && (dst->wgtcnt == src->wgtcnt));
+  if (dst->wgts != src->wgts)   /* copy the weight vector */
+    memcpy(dst->wgts, src->wgts, (size_t)src->wgtcnt*sizeof(MLPVAL));
+}  /* mlp_wgtcopy() */
+
+/*--------------------------------------------------------------------*/
+
+int mlp_normcopy (MLP *dst, const MLP *src)
+{                               /* --- copy input and output scaling */
+  NSTATS *nst;                  /* clone of normalization statistics */
+
+  assert(dst && src && !dst->shadow
+  &&    (dst->incnt  == src->incnt)
+  &&    (dst->outcnt == src->outcnt));
+  nst = nst_clone(src->nst);    /* clone the normalization statistics */
+  if (!nst) return -1;          /* of the source network and */
+  nst_delete(dst->nst);         /* replace those of the destination */
+  dst->nst = nst;               /* copy the output scaling */
+  memcpy(dst->mins, src->mins, 5*(size_t)src->outcnt*sizeof(double));
+  return 0;                     /* return 'ok' */
+}  /* mlp_normcopy() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_merge (MLP *mlp, MLP *shadow)
+{                               /* --- merge gradients of a shadow */
+  DIMID  i;                     /* loop variable */
+  MLPVAL *g, *s;                /* to traverse the gradients */
+
+  assert(mlp && shadow && (shadow->wgtcnt == mlp->wgtcnt));
+  g = mlp->grds; s = shadow->grds;
+  for (i = 0; i < mlp->wgtcnt; i++) {
+    g[i] += s[i]; s[i] = 0; }   /* add the shadow gradients */
+}  /* mlp_merge() */             /* and clear them for the next run */
+
 /*--------------------------------------------------------------------*/
 #ifdef MLP_EXTFN                /* if to compile extended functions */
 
@@ -503,9 +936,9 @@ void mlp_regx (MLP *mlp, const TUPLE *tpl, int ninp)
   assert(mlp);                  /* check the function arguments */
   if (!tpl) {                   /* if to terminate registration */
     mlp_reg(mlp, NULL, NULL, 0); return; }
-  am_exec(mlp->attmap, tpl, AM_INPUTS, mlp->ins);
+  am_exec(mlp->attmap, tpl, AM_INPUTS, mlp->raws);
   am_exec(mlp->attmap, tpl, AM_TARGET, mlp->trgs);
-  mlp_reg(mlp, (ninp) ? mlp->ins : NULL, mlp->trgs, tpl_getwgt(tpl));
+  mlp_reg(mlp, (ninp) ? mlp->raws : NULL, mlp->trgs, tpl_getwgt(tpl));
 }  /* mlp_regx() */             /* register the mapped tuple */
 
 /*--------------------------------------------------------------------*/
@@ -513,8 +946,8 @@ void mlp_regx (MLP *mlp, const TUPLE *tpl, int ninp)
 void mlp_inputx (MLP *mlp, const TUPLE *tpl)
 {                               /* --- set inputs from a tuple */
   assert(mlp);                  /* check the function arguments */
-  am_exec(mlp->attmap, tpl, AM_INPUTS, mlp->ins);
-  nst_norm(mlp->nst, mlp->ins, mlp->ins);
+  am_exec(mlp->attmap, tpl, AM_INPUTS, mlp->raws);
+  norm(mlp->nst, mlp->raws, mlp->ins);
 }  /* mlp_inputx() */           /* normalize the mapped input values */
 
 /*--------------------------------------------------------------------*/
@@ -528,23 +961,23 @@ void mlp_outputx (MLP *mlp, TUPLE *tpl)
 
 /*--------------------------------------------------------------------*/
 
-void mlp_result (MLP *mlp, INST *inst, double *conf)
+static void result (MLP *mlp, const MLPVAL *outs, const double *scos,
+                    INST *inst, double *conf)
 {                               /* --- store output in an instance */
   int    t;                     /* type of attribute attribute */
   VALID  i, k;                  /* loop variables for values */
   double max, o;                /* (maximal) output value */
   double sum;                   /* sum of output values */
 
-  assert(mlp && inst);          /* check the function arguments */
   t = am_type(mlp->attmap, AM_TARGET);
   if      (t != AT_NOM) {       /* if the target is numeric */
-    o = mlp->scos[0];           /* get the scaled output */
+    o = scos[0];                /* get the scaled output */
     if (t == AT_FLT) inst->f = (DTFLT) o;
     else             inst->i = (DTINT)(o +0.5);
     if (conf) *conf = 0; }      /* no confidence measure available */
   else if (mlp->outcnt <= 1) {  /* if the target is binary */
     o = (att_valcnt(mlp->trgatt) < 2)
-      ? 0 : mlp->outs[0];       /* compare the output to 0.5 */
+      ? 0 : outs[0];            /* compare the output to 0.5 */
     if (o > ACTMID) { inst->n = 1;
       if (conf) *conf = (o -ACTMIN) * (1/(ACTMAX -ACTMIN)); }
     else            { inst->n = 0;
@@ -552,12 +985,20 @@ void mlp_result (MLP *mlp, INST *inst, double *conf)
   else {                        /* if the target is symbolic */
     sum = 0; max = -INFINITY; k = NV_NOM;
     for (i = 0; i < mlp->outcnt; i++) {
-      sum += o = mlp->outs[i];  /* get and sum the activations */
+      sum += o = outs[i];       /* get and sum the activations */
       if (o > max) { max = o; k = i; }
     }                           /* find the output with the highest */
     inst->n = k;                /* value and set the instantiation */
     if (conf) *conf = (sum > 0) ? ((max > 1) ? 1 : max) /sum : 0;
   }                             /* compute and set the confidence */
+}  /* result() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_result (MLP *mlp, INST *inst, double *conf)
+{                               /* --- store output in an instance */
+  assert(mlp && inst);          /* check the function arguments */
+  result(mlp, mlp->outs, mlp->scos, inst, conf);
 }  /* mlp_result() */
 
 #endif
@@ -570,7 +1011,7 @@ void mlp_init (MLP *mlp, double rand(void), double range)
   assert(mlp && rand && (range > 0));   /* check the function args. */
   range *= 2;                   /* compute the full range of values */
   for (i = 0; i < mlp->wgtcnt; i++)     /* init. the weights */
-    mlp->wgts[i] = range *(rand()-0.5); /* to random values */
+    mlp->wgts[i] = (MLPVAL)(range *(rand()-0.5)); /* to random values */
 }  /* mlp_init() */
 
 /*--------------------------------------------------------------------*/
@@ -582,7 +1023,7 @@ void mlp_jog (MLP *mlp, double rand(void), double range)
   assert(mlp && rand && (range > 0));   /* check the function args. */
   range *= 2;                   /* compute the full range of values */
   for (i = 0; i < mlp->wgtcnt; i++)      /* jog the weights */
-    mlp->wgts[i] += range *(rand()-0.5); /* with random values */
+    mlp->wgts[i] += (MLPVAL)(range *(rand()-0.5)); /* with random values */
 }  /* mlp_jog() */
 
 /*--------------------------------------------------------------------*/
@@ -594,14 +1035,14 @@ void mlp_setup (MLP *mlp)
   double *m, *n, *o, *r, *s;    /* to access the arrays */
 
   assert(mlp);                  /* check the function argument */
-  if ((mlp->method == MLP_RESILIENT)
-  ||  (mlp->method == MLP_ADAPTIVE)) {
+  if (((mlp->method & ~MLP_SCALAR) == MLP_RESILIENT)
+  ||  ((mlp->method & ~MLP_SCALAR) == MLP_ADAPTIVE)) {
     for (i = 0; i < mlp->wgtcnt; i++)
-      mlp->chgs[i] = mlp->lrate; }    /* initialize weight changes */
+      mlp->chgs[i] = (MLPVAL)mlp->lrate; } /* init. weight changes */
   else                          /* and clear gradients and buffers */
-    memset(mlp->chgs, 0, (size_t)mlp->wgtcnt *sizeof(double));
-  memset(mlp->grds, 0, (size_t)mlp->wgtcnt *sizeof(double));
-  memset(mlp->bufs, 0, (size_t)mlp->wgtcnt *sizeof(double));
+    memset(mlp->chgs, 0, (size_t)mlp->wgtcnt *sizeof(MLPVAL));
+  memset(mlp->grds, 0, (size_t)mlp->wgtcnt *sizeof(MLPVAL));
+  memset(mlp->bufs, 0, (size_t)mlp->wgtcnt *sizeof(MLPVAL));
   o = mlp->offs;                /* get the vectors of offsets */
   s = mlp->scls; r = mlp->recs; /* and (inverse) scaling factors */
   m = mlp->mins; n = mlp->maxs; /* as well as minimum and maximum */
@@ -619,32 +1060,205 @@ void mlp_setup (MLP *mlp)
 
 void mlp_exec (MLP *mlp, const double *ins, double *outs)
 {                               /* --- execute multilayer perceptron */
-  int      l;                   /* loop variable  for layers */
-  DIMID    k, n;                /* loop variables for weights */
-  MLPLAYER *layer;              /* to traverse the network layers */
-  double   *wgt;                /* to traverse the weight vectors */
-  double   net;                 /* sum of weighted inputs */
+  MLPVAL *vecs[MLP_MAXLAYER];   /* inputs and outputs of the layers */
 
   assert(mlp);                  /* check the function arguments */
   if (ins)                      /* normalize the input vector */
-    nst_norm(mlp->nst, ins, mlp->ins);
-  layer = mlp->layers;          /* traverse the network layers */
-  for (l = mlp->lyrcnt-1; --l >= 0; ++layer) {
-    for (k = layer->outcnt; --k >= 0; ) {
-      wgt = layer->wgts[k];     /* traverse the units of the layer */
-      net = wgt[n = layer->incnt];
-      while (--n >= 0) net += layer->ins[n] *wgt[n];
-      layer->outs[k] = ACTFN(net);
-    }                           /* sum the weighted inputs and */
-  }                             /* compute the activation (output) */
-  for (k = 0; k < mlp->outcnt; k++) /* apply output transformation */
-    mlp->scos[k] = mlp->outs[k] *mlp->scls[k] +mlp->offs[k];
+    norm(mlp->nst, ins, mlp->ins);
+  getvecs(mlp, vecs, NULL);     /* execute the network */
+  exec(mlp, vecs, mlp->scos, 0);/* with its own vectors */
   if (outs)                     /* copy outputs to result vector */
     memcpy(outs, mlp->scos, (size_t)mlp->outcnt *sizeof(double));
 }  /* mlp_exec() */
 
 /*--------------------------------------------------------------------*/
 
+int mlp_blksize (MLP *mlp, DIMID n)
+{                               /* --- set size of pattern blocks */
+  int      l;                   /* loop variable for layers */
+  size_t   z;                   /* size of the block buffers */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  double   *d;                  /* to traverse the double blocks */
+  MLPVAL   *p;                  /* to traverse the block buffers */
+
+  assert(mlp && (n >= 0));      /* check the function arguments */
+  if (n <= mlp->blkcap) return 0;  /* check for sufficient capacity */
+  z = (size_t)mlp->incnt;       /* sum the sizes of the unit vectors */
+  for (l = 0; l < mlp->lyrcnt-1; l++)
+    z += 2*(size_t)mlp->layers[l].outcnt;
+  d = (double*)malloc((size_t)n *((2*(size_t)mlp->outcnt
+                                   +(size_t)mlp->incnt) *sizeof(double)
+                                  +z *sizeof(MLPVAL)));
+  if (!d) return -1;            /* allocate the block buffers */
+  if (mlp->btrgs) free(mlp->btrgs); /* (old contents are lost) */
+  mlp->blkcap = n;              /* note the new block capacity */
+  mlp->btrgs  = d; d += (size_t)n *(size_t)mlp->outcnt;
+  mlp->bscos  = d; d += (size_t)n *(size_t)mlp->outcnt;
+  mlp->braws  = d; d += (size_t)n *(size_t)mlp->incnt;
+  mlp->bins   = p = (MLPVAL*)d; p += (size_t)n *(size_t)mlp->incnt;
+  layer = mlp->layers;          /* traverse the network layers */
+  for (l = 0; l < mlp->lyrcnt-1; l++, layer++) {
+    layer->bins  = (l > 0) ? (layer-1)->bouts : mlp->bins;
+    layer->bouts = p; p += (size_t)n *(size_t)layer->outcnt;
+    layer->berrs = p; p += (size_t)n *(size_t)layer->outcnt;
+  }                             /* set the layer specific blocks */
+  return 0;                     /* return 'ok' */
+}  /* mlp_blksize() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_inputb (MLP *mlp, DIMID i, const double *ins)
+{                               /* --- set inputs of a block pattern */
+  assert(mlp && ins && (i >= 0) && (i < mlp->blkcap));
+  norm(mlp->nst, ins, mlp->bins +(size_t)i *(size_t)mlp->incnt);
+}  /* mlp_inputb() */           /* normalize the input values */
+
+/*--------------------------------------------------------------------*/
+#ifdef MLP_EXTFN
+
+void mlp_inputxb (MLP *mlp, DIMID i, const TUPLE *tpl)
+{                               /* --- set block inputs from a tuple */
+  assert(mlp && (i >= 0) && (i < mlp->blkcap));
+  am_exec(mlp->attmap, tpl, AM_INPUTS, mlp->raws);
+  norm(mlp->nst, mlp->raws, mlp->bins +(size_t)i *(size_t)mlp->incnt);
+}  /* mlp_inputxb() */          /* map and normalize the tuple */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+void mlp_targetb (MLP *mlp, DIMID i, const double *trgs)
+{                               /* --- set targets of a block pattern */
+  assert(mlp && trgs && (i >= 0) && (i < mlp->blkcap));
+  memcpy(mlp->btrgs +(size_t)i *(size_t)mlp->outcnt, trgs,
+         (size_t)mlp->outcnt *sizeof(double));
+}  /* mlp_targetb() */
+
+/*--------------------------------------------------------------------*/
+#ifdef MLP_EXTFN
+
+void mlp_targetxb (MLP *mlp, DIMID i, const TUPLE *tpl)
+{                               /* --- set block targets from a tuple */
+  assert(mlp && (i >= 0) && (i < mlp->blkcap));
+  am_exec(mlp->attmap, tpl, AM_TARGET,
+          mlp->btrgs +(size_t)i *(size_t)mlp->outcnt);
+}  /* mlp_targetxb() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_inputcb (MLP *mlp, TABCOL *tc, const TPLID *rows, DIMID n)
+{                               /* --- set block inputs from columns */
+  DIMID  i;                     /* loop variable for patterns */
+  size_t k;                     /* number of inputs */
+
+  assert(mlp && tc && rows && (n >= 0) && (n <= mlp->blkcap));
+  k = (size_t)mlp->incnt;       /* map the table columns */
+  am_execc(mlp->attmap, tc, rows, (TPLID)n, AM_INPUTS, mlp->braws, k);
+  for (i = 0; i < n; i++)       /* normalize the mapped inputs */
+    norm(mlp->nst, mlp->braws +(size_t)i *k, mlp->bins +(size_t)i *k);
+}  /* mlp_inputcb() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_targetcb (MLP *mlp, TABCOL *tc, const TPLID *rows, DIMID n)
+{                               /* --- set block targets from columns */
+  assert(mlp && tc && rows && (n >= 0) && (n <= mlp->blkcap));
+  am_execc(mlp->attmap, tc, rows, (TPLID)n, AM_TARGET,
+           mlp->btrgs, (size_t)mlp->outcnt);
+}  /* mlp_targetcb() */
+
+#endif
+/*--------------------------------------------------------------------*/
+
+static void netblk (const MLPLAYER *layer, const MLPVAL *x, DIMID n,
+                    MLPVAL *y)
+{                               /* --- compute block of net inputs */
+  DIMID        i, k, j;         /* loop variables */
+  DIMID        b, e;            /* range of inputs of current block */
+  DIMID        in, out;         /* number of inputs and outputs */
+  const MLPVAL *x0, *x1, *x2, *x3;  /* to traverse the inputs */
+  const MLPVAL *w0, *w1;        /* to traverse the weights */
+  MLPVAL       *y0;             /* to traverse the net inputs */
+  MLPACC       s00, s01, s10, s11, s20, s21, s30, s31;
+
+  in = layer->incnt; out = layer->outcnt;
+  for (y0 = y, i = 0; i < n; i++, y0 += out)
+    for (k = 0; k < out; k++)   /* initialize the net inputs */
+      y0[k] = layer->wgts[k][in];  /* with the bias values */
+  for (b = 0; b < in; b = e) {  /* traverse blocks of inputs */
+    e = (in -b > BLK_IN) ? b +BLK_IN : in;
+    for (i = 0; i+3 < n; i += 4) {  /* traverse groups of 4 patterns */
+      x0 = x +(size_t)i *(size_t)in; x1 = x0 +in;
+      x2 = x1 +in; x3 = x2 +in; y0 = y +(size_t)i *(size_t)out;
+      for (k = 0; k+1 < out; k += 2) {  /* traverse pairs of units */
+        w0 = layer->wgts[k]; w1 = layer->wgts[k+1];
+        s00 = s01 = s10 = s11 = s20 = s21 = s30 = s31 = 0;
+        for (j = b; j < e; j++) {   /* 4x2 register block */
+          s00 += ACC(x0[j]) *w0[j]; s01 += ACC(x0[j]) *w1[j];
+          s10 += ACC(x1[j]) *w0[j]; s11 += ACC(x1[j]) *w1[j];
+          s20 += ACC(x2[j]) *w0[j]; s21 += ACC(x2[j]) *w1[j];
+          s30 += ACC(x3[j]) *w0[j]; s31 += ACC(x3[j]) *w1[j];
+        }                       /* compute the partial net inputs */
+        ADD(y0[k],       s00); ADD(y0[k+1],       s01);
+        ADD(y0[k+out],   s10); ADD(y0[k+1+out],   s11);
+        ADD(y0[k+2*out], s20); ADD(y0[k+1+2*out], s21);
+        ADD(y0[k+3*out], s30); ADD(y0[k+1+3*out], s31);
+      }                         /* add them to the net inputs */
+      if (k < out) {            /* if there is an odd unit left */
+        w0 = layer->wgts[k]; s00 = s10 = s20 = s30 = 0;
+        for (j = b; j < e; j++) {
+          s00 += ACC(x0[j]) *w0[j]; s10 += ACC(x1[j]) *w0[j];
+          s20 += ACC(x2[j]) *w0[j]; s30 += ACC(x3[j]) *w0[j];
+        }                       /* compute the partial net inputs */
+        ADD(y0[k],       s00); ADD(y0[k+out],   s10);
+        ADD(y0[k+2*out], s20); ADD(y0[k+3*out], s30);
+      }                         /* add them to the net inputs */
+    }
+    for ( ; i < n; i++) {       /* traverse the remaining patterns */
+      x0 = x +(size_t)i *(size_t)in; y0 = y +(size_t)i *(size_t)out;
+      for (k = 0; k < out; k++) {
+        w0 = layer->wgts[k];    /* traverse the units and */
+        for (s00 = 0, j = b; j < e; j++)
+          s00 += ACC(x0[j]) *w0[j]; /* compute the partial net input */
+        ADD(y0[k], s00);        /* and add it to the net input */
+      }
+    }
+  }
+}  /* netblk() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_execb (MLP *mlp, const double *ins, DIMID n, double *outs)
+{                               /* --- execute for a pattern block */
+  int      l;                   /* loop variable for layers */
+  DIMID    i, k;                /* loop variables for patterns/units */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  MLPVAL   *o;                  /* to traverse the outputs */
+  double   *s;                  /* to traverse the scaled outputs */
+
+  assert(mlp                    /* check the function arguments */
+  &&    (n >= 0) && (n <= mlp->blkcap));
+  if (ins) {                    /* if input patterns are given */
+    for (i = 0; i < n; i++)     /* normalize the input vectors */
+      norm(mlp->nst, ins +(size_t)i *(size_t)mlp->incnt,
+               mlp->bins +(size_t)i *(size_t)mlp->incnt);
+  }                             /* (otherwise block is already set) */
+  layer = mlp->layers;          /* traverse the network layers */
+  for (l = mlp->lyrcnt-1; --l >= 0; ++layer) {
+    netblk(layer, layer->bins, n, layer->bouts);
+    ACTVEC(layer->bouts, (size_t)n *(size_t)layer->outcnt);
+  }                             /* compute the net inputs and */
+                                /* the activations (outputs) */
+  o = (layer-1)->bouts;         /* get the output block */
+  for (s = mlp->bscos, i = 0; i < n; i++) {
+    for (k = 0; k < mlp->outcnt; k++) /* apply output transformation */
+      *s++ = *o++ *mlp->scls[k] +mlp->offs[k];
+  }                             /* copy outputs to result vector */
+  if (outs) memcpy(outs, mlp->bscos,
+                   (size_t)n *(size_t)mlp->outcnt *sizeof(double));
+}  /* mlp_execb() */
+
+/*--------------------------------------------------------------------*/
+
 double mlp_error (MLP *mlp, const double *trgs)
 {                               /* --- compute sum of squared errors */
   DIMID  k;                     /* loop variable */
@@ -653,7 +1267,7 @@ double mlp_error (MLP *mlp, const double *trgs)
   assert(mlp);                  /* check the function arguments */
   if (!trgs) trgs = mlp->trgs;  /* if not targets, use intern. vector */
   for (k = 0; k < mlp->outcnt; k++) {
-    mlp->errs[k] = mlp->recs[k] *(d = trgs[k] -mlp->scos[k]);
+    mlp->errs[k] = (MLPVAL)(mlp->recs[k] *(d = trgs[k] -mlp->scos[k]));
     sse += d*d;                 /* compute the output errors */
   }                             /* (target - scaled computed output) */
   return sse;                   /* return sum of squared errors */
@@ -661,22 +1275,22 @@ double mlp_error (MLP *mlp, const double *trgs)
 
 /*--------------------------------------------------------------------*/
 
-double mlp_bkprop (MLP *mlp, const double *trgs)
+static double bkprop (MLP *mlp, const double *trgs, int sparse)
 {                               /* --- backpropagate errors */
   int      l;                   /* loop variable  for layers */
   DIMID    k, n;                /* loop variables for weights */
   MLPLAYER *layer;              /* to traverse the network layers */
-  double   *w, *g;              /* to traverse the weights/gradients */
-  double   *e;                  /* to traverse the errors */
-  double   delta;               /* temporary buffer */
+  MLPVAL   *w, *g;              /* to traverse the weights/gradients */
+  MLPVAL   *e;                  /* to traverse the errors */
+  MLPVAL   delta;               /* temporary buffer */
   double   sse;                 /* sum of squared errors */
-  double   raise = mlp->raise;  /* raise value for derivative */
+  MLPVAL   raise = (MLPVAL)mlp->raise;  /* raise value for derivative */
 
   assert(mlp);                  /* check the function arguments */
   sse = mlp_error(mlp, trgs);   /* compute sum of squared errors */
   for (l = mlp->lyrcnt-2; --l >= 0; ) {
     memset(mlp->layers[l].errs, 0,
-          (size_t)mlp->layers[l].outcnt *sizeof(double));
+          (size_t)mlp->layers[l].outcnt *sizeof(MLPVAL));
   }                             /* clear the backpropagated errors */
   for (l = mlp->lyrcnt-1; --l >  0; ) {
     layer = mlp->layers +l;     /* traverse the units of each layer */
@@ -696,61 +1310,263 @@ double mlp_bkprop (MLP *mlp, const double *trgs)
   for (k = 0; k < layer->outcnt; k++) {
     delta = layer->errs[k] * (DERIV(layer->outs[k]) +raise);
     g     = layer->grds[k];     /* first process the offset gradient */
-    g[n = layer->incnt] -= delta;
-    while (--n >= 0)            /* then process the weight gradients */
-      g[n] -= layer->ins[n] * delta;
-  }                             /* (but do no backpropagation) */
+    g[layer->incnt] -= delta;   /* then process the weight gradients */
+    if (sparse) {               /* if sparse network input */
+      for (n = mlp->spcnt; --n >= 0; )
+        g[mlp->spidx[n]] -= mlp->spvals[n] * delta; }
+    else {                      /* if dense input vector */
+      for (n = layer->incnt; --n >= 0; )
+        g[n] -= layer->ins[n] * delta;
+    }                           /* (gradients of zero inputs */
+  }                             /* are not changed, no backprop.) */
   return sse;                   /* return sum of squared errors */
+}  /* bkprop() */
+
+/*--------------------------------------------------------------------*/
+
+double mlp_bkprop (MLP *mlp, const double *trgs)
+{                               /* --- backpropagate errors */
+  assert(mlp);                  /* check the function arguments */
+  return bkprop(mlp, trgs, 0);  /* backpropagate with dense input */
 }  /* mlp_bkprop() */
 
 /*--------------------------------------------------------------------*/
 
+static void grdblk (MLPLAYER *layer, const MLPVAL *d, DIMID n)
+{                               /* --- aggregate block of gradients */
+  DIMID        i, k, j;         /* loop variables */
+  DIMID        b, e;            /* range of inputs of current block */
+  DIMID        in, out;         /* number of inputs and outputs */
+  const MLPVAL *x;              /* to traverse the inputs */
+  MLPVAL       *g0, *g1;        /* to traverse the gradients */
+  MLPVAL       d0, d1;          /* deltas of the current units */
+
+  in = layer->incnt; out = layer->outcnt;
+  for (k = 0; k < out; k++) {   /* traverse the units */
+    g0 = layer->grds[k];        /* and process the offset gradients */
+    for (i = 0; i < n; i++)
+      g0[in] -= d[(size_t)i *(size_t)out +(size_t)k];
+  }
+  for (b = 0; b < in; b = e) {  /* traverse blocks of inputs */
+    e = (in -b > BLK_IN) ? b +BLK_IN : in;
+    for (k = 0; k+1 < out; k += 2) {  /* traverse pairs of units */
+      g0 = layer->grds[k]; g1 = layer->grds[k+1];
+      for (i = 0; i < n; i++) { /* traverse the block patterns */
+        x  = layer->bins +(size_t)i *(size_t)in;
+        d0 = d[(size_t)i*(size_t)out +(size_t)k];
+        d1 = d[(size_t)i*(size_t)out +(size_t)k+1];
+        for (j = b; j < e; j++) {
+          g0[j] -= x[j] *d0; g1[j] -= x[j] *d1; }
+      }                         /* process the weight gradients */
+    }                           /* (deltas^T x inputs) */
+    if (k < out) {              /* if there is an odd unit left */
+      g0 = layer->grds[k];      /* get its gradient vector */
+      for (i = 0; i < n; i++) { /* traverse the block patterns */
+        x  = layer->bins +(size_t)i *(size_t)in;
+        d0 = d[(size_t)i*(size_t)out +(size_t)k];
+        for (j = b; j < e; j++) g0[j] -= x[j] *d0;
+      }                         /* process the weight gradients */
+    }
+  }
+}  /* grdblk() */
+
+/*--------------------------------------------------------------------*/
+
+static void errblk (const MLPLAYER *layer, const MLPVAL *d, DIMID n,
+                    MLPVAL *errs)
+{                               /* --- backpropagate block of errors */
+  DIMID        i, k, j;         /* loop variables */
+  DIMID        in, out;         /* number of inputs and outputs */
+  const MLPVAL *w0, *w1, *w2, *w3;  /* to traverse the weights */
+  const MLPVAL *dp;             /* deltas of the current pattern */
+  MLPVAL       *e;              /* to traverse the errors */
+
+  in = layer->incnt; out = layer->outcnt;
+  for (i = 0; i < n; i++) {     /* traverse the block patterns */
+    e  = errs +(size_t)i *(size_t)in;
+    dp = d    +(size_t)i *(size_t)out;
+    for (k = 0; k+3 < out; k += 4) {  /* traverse groups of 4 units */
+      w0 = layer->wgts[k];   w1 = layer->wgts[k+1];
+      w2 = layer->wgts[k+2]; w3 = layer->wgts[k+3];
+      for (j = 0; j < in; j++)  /* propagate the errors back */
+        e[j] += w0[j] *dp[k]   +w1[j] *dp[k+1]
+              + w2[j] *dp[k+2] +w3[j] *dp[k+3];
+    }                           /* (deltas x weights) */
+    for ( ; k < out; k++) {     /* traverse the remaining units */
+      w0 = layer->wgts[k];
+      for (j = 0; j < in; j++) e[j] += w0[j] *dp[k];
+    }                           /* propagate the errors back */
+  }                             /* to the preceding layer */
+}  /* errblk() */
+
+/*--------------------------------------------------------------------*/
+
+double mlp_bkpropb (MLP *mlp, const double *trgs, DIMID n)
+{                               /* --- backpropagate block of errors */
+  int      l;                   /* loop variable for layers */
+  DIMID    i, k;                /* loop variables for patterns/units */
+  MLPLAYER *layer;              /* to traverse the network layers */
+  MLPVAL   *e;                  /* to traverse the errors */
+  const double *s;              /* to traverse the scaled outputs */
+  double   d;                   /* difference to target */
+  double   sse = 0;             /* sum of squared errors */
+  MLPVAL   raise = (MLPVAL)mlp->raise;  /* raise value for derivative */
+
+  assert(mlp                    /* check the function arguments */
+  &&    (n >= 0) && (n <= mlp->blkcap));
+  if (!trgs) trgs = mlp->btrgs; /* if no targets, use intern. block */
+  layer = mlp->layers +mlp->lyrcnt-2;
+  e = layer->berrs; s = mlp->bscos;
+  for (i = 0; i < n; i++) {     /* traverse the block patterns */
+    for (k = 0; k < mlp->outcnt; k++) {
+      *e++ = (MLPVAL)(mlp->recs[k] *(d = *trgs++ -*s++));
+      sse += d*d;               /* compute the output errors */
+    }                           /* (target - scaled computed output) */
+  }                             /* and the sum of squared errors */
+  for (l = mlp->lyrcnt-2; --l >= 0; )
+    memset(mlp->layers[l].berrs, 0, (size_t)n
+           *(size_t)mlp->layers[l].outcnt *sizeof(MLPVAL));
+  for (l = mlp->lyrcnt-1; --l >= 0; layer--) {
+    DERVEC(layer->berrs, layer->bouts,
+           (size_t)n *(size_t)layer->outcnt, raise);
+    grdblk(layer, layer->berrs, n);     /* aggregate the gradients */
+    if (l > 0)                  /* propagate the errors back */
+      errblk(layer, layer->berrs, n, (layer-1)->berrs);
+  }                             /* (but not from first hidden layer) */
+  return sse;                   /* return sum of squared errors */
+}  /* mlp_bkpropb() */
+
+/*--------------------------------------------------------------------*/
+
+int mlp_sparse (MLP *mlp)
+{                               /* --- create sparse input vectors */
+  DIMID  n;                     /* number of values (rounded) */
+  MLPVAL *p;                    /* allocated value vector */
+
+  assert(mlp);                  /* check the function argument */
+  if (mlp->spvals) return 0;    /* check for existing vectors */
+  n = (mlp->incnt +1) & ~(DIMID)1; /* (keep the indices aligned) */
+  p = (MLPVAL*)malloc((size_t)n *sizeof(MLPVAL)
+                     +(size_t)mlp->incnt *sizeof(DIMID));
+  if (!p) return -1;            /* allocate the sparse input */
+  mlp->spvals = p;              /* and set the value vector */
+  mlp->spidx  = (DIMID*)(p +n); /* and the index vector */
+  mlp->spcnt  = 0;              /* (no inputs are set yet) */
+  return 0;                     /* return 'ok' */
+}  /* mlp_sparse() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_execs (MLP *mlp, const DIMID *idx, const double *ins,
+                DIMID n, double *outs)
+{                               /* --- execute with sparse input */
+  DIMID  i;                     /* input index */
+  MLPVAL *vecs[MLP_MAXLAYER];   /* inputs and outputs of the layers */
+
+  assert(mlp && mlp->spvals && (n >= 0) && (n <= mlp->incnt));
+  if (idx) {                    /* if a sparse input is given */
+    assert(ins);                /* store and normalize it */
+    for (mlp->spcnt = n; --n >= 0; ) {
+      mlp->spidx [n] = i = idx[n];
+      mlp->spvals[n] = (MLPVAL)(nst_factor(mlp->nst, i)
+                              *(ins[n] -nst_offset(mlp->nst, i)));
+    }                           /* (offsets of unlisted inputs */
+  }                             /* must be zero, see mlp.h) */
+  getvecs(mlp, vecs, NULL);     /* execute the network */
+  exec(mlp, vecs, mlp->scos, 1);/* with the sparse input */
+  if (outs)                     /* copy outputs to result vector */
+    memcpy(outs, mlp->scos, (size_t)mlp->outcnt *sizeof(double));
+}  /* mlp_execs() */
+
+/*--------------------------------------------------------------------*/
+
+double mlp_bkprops (MLP *mlp, const double *trgs)
+{                               /* --- backpropagate errors */
+  assert(mlp && mlp->spvals);   /* check the function arguments */
+  return bkprop(mlp, trgs, 1);  /* backpropagate with sparse input */
+}  /* mlp_bkprops() */          /* (set by mlp_execs/mlp_inputxs) */
+
+/*--------------------------------------------------------------------*/
+#ifdef MLP_EXTFN
+
+int mlp_sparsex (MLP *mlp)
+{                               /* --- set up sparse (tuple) input */
+  ATTID    i, k;                /* loop variables for attributes */
+  DIMID    j, u;                /* input index, loop variable */
+  ATTMAP   *map;                /* attribute map of the network */
+  MLPLAYER *layer;              /* first layer of the network */
+  MLPVAL   *w;                  /* to traverse the weight vectors */
+  double   f, o;                /* input scaling factor and offset */
+
+  assert(mlp && mlp->attmap);   /* check the function argument */
+  map   = mlp->attmap;          /* get the attribute map */
+  layer = mlp->layers;          /* and the first layer */
+  for (i = am_attcnt(map) -((am_outcnt(map) > 0) ? 1 : 0); --i >= 0; ) {
+    if ((am_type(map, i) != AT_NOM) || (am_cnt(map, i) < 2))
+      continue;                 /* skip non 1-in-n coded attributes */
+    for (k = am_cnt(map, i); --k >= 0; ) {
+      j = am_off(map, i) +k;    /* traverse the 1-in-n inputs */
+      f = nst_factor(mlp->nst, j);
+      o = nst_offset(mlp->nst, j);
+      if ((f == 1.0) && (o == 0.0)) continue;
+      for (u = layer->outcnt; --u >= 0; ) {
+        w = layer->wgts[u];     /* fold the input scaling */
+        w[layer->incnt] -= (MLPVAL)(w[j] *f *o);
+        w[j]             = (MLPVAL)(w[j] *f);
+      }                         /* into weights and bias, so that */
+      nst_scale(mlp->nst, j, 0.0, 1.0);  /* the network function */
+    }                           /* is not changed, but zero inputs */
+  }                             /* remain zero after normalization */
+  return mlp_sparse(mlp);       /* create the sparse input */
+}  /* mlp_sparsex() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_inputxs (MLP *mlp, const TUPLE *tpl)
+{                               /* --- set sparse input from a tuple */
+  DIMID i, n;                   /* loop variable, number of elements */
+
+  assert(mlp && mlp->spvals);   /* check the function arguments */
+  n = am_execs(mlp->attmap, tpl, AM_INPUTS, mlp->spidx, mlp->raws);
+  for (mlp->spcnt = n; --n >= 0; ) {
+    i = mlp->spidx[n];          /* normalize the listed inputs */
+    mlp->spvals[n] = (MLPVAL)(nst_factor(mlp->nst, i)
+                            *(mlp->raws[n] -nst_offset(mlp->nst, i)));
+  }                             /* (execute the network afterwards */
+}  /* mlp_inputxs() */          /* with mlp_execs(mlp, NULL, ...)) */
+
+#endif  /* #ifdef MLP_EXTFN */
+/*--------------------------------------------------------------------*/
+
 void mlp_update (MLP *mlp)
 {                               /* --- update connection weights */
-  DIMID k;                      /* loop variable */
+  DIMID  k;                     /* loop variable */
+  MLPVAL decay;                 /* weight decay factor */
 
   assert(mlp);                  /* check the function argument */
-  if (mlp->decay != 1.0)        /* if weight decay is requested */
+  if (!(mlp->method & MLP_SCALAR)) {
+    updatefn[mlp->method](mlp); /* call the fused update function */
+    return;                     /* (decay, update and clearing */
+  }                             /* the gradients in one pass) */
+  if (mlp->decay != 1.0) {      /* if weight decay is requested */
+    decay = (MLPVAL)mlp->decay; /* get the decay factor and */
     for (k = 0; k < mlp->wgtcnt; k++)
-      mlp->wgts[k] *= mlp->decay; /* reduce all connection weights */
-  updatefn[mlp->method](mlp);   /* call the weight update function */
+      mlp->wgts[k] *= decay;    /* reduce all connection weights */
+  }                             /* call the scalar update function */
+  scalarfn[mlp->method & ~MLP_SCALAR](mlp);
 }  /* mlp_update() */
 
 /*--------------------------------------------------------------------*/
 
 double mlp_sens (MLP *mlp, DIMID unit, int mode)
 {                               /* --- analyze sensitivity on input */
-  int      l;                   /* loop variable  for layers */
-  DIMID    k, n;                /* loop variables for weights */
-  MLPLAYER *layer;              /* to traverse the network layers */
-  double   **w;                 /* to traverse the weight vectors */
-  double   *e, *p;              /* to traverse the sensitivity values */
-  double   s;                   /* resulting sensitivity */
+  MLPVAL *vecs[MLP_MAXLAYER];   /* inputs and outputs of the layers */
+  MLPVAL *errs[MLP_MAXLAYER];   /* sensitivity values of the layers */
 
   assert(mlp                    /* check the function arguments */
   &&    (unit >= 0) && (unit < mlp->incnt));
-  layer = mlp->layers;          /* get the first hidden layer */
-  w     = layer->wgts;          /* traverse the first hidden layer */
-  e     = layer->errs;          /* and compute sensitivity values */
-  for (k = layer->outcnt; --k >= 0; )
-    e[k] = w[k][unit] *DERIV(layer->outs[k]);
-  for (l = mlp->lyrcnt-2; --l >= 0; ) {
-    p = e; ++layer;             /* traverse the remaining layers */
-    e = memset(layer->errs, 0, (size_t)layer->outcnt *sizeof(double));
-    w = layer->wgts;            /* clear the sensitivity values */
-    for (k = layer->outcnt; --k >= 0; ) {
-      for (n = layer->incnt; --n >= 0; )
-        e[k] += w[k][n] *p[n];  /* aggregate the sensitivity values */
-      e[k] *= DERIV(layer->outs[k]);  /* of the preceding layer and */
-    }                           /* compute the sensitivity values */
-  }                             /* of the next layer */
-  p = mlp->scls;                /* traverse the output units */
-  for (k = mlp->outcnt; --k >= 0; )
-    e[k] = fabs(e[k] *p[k]);    /* compute absolute sensitivity value */
-  k = mlp->outcnt; s = 0;       /* compute sum or maximum */
-  if (mode & MLP_SUM) while (--k >= 0) { s += e[k]; }
-  else                while (--k >= 0) { if (e[k] > s) s = e[k]; }
-  return s;                     /* return the sensitivity */
+  getvecs(mlp, vecs, errs);     /* compute the sensitivity */
+  return sens(mlp, vecs, errs, unit, mode);
 }  /* mlp_sens() */
 
 /*--------------------------------------------------------------------*/
@@ -775,6 +1591,161 @@ double mlp_sensx (MLP *mlp, DIMID col, int mode)
   return s;                     /* for the inputs and return it */
 }  /* mlp_sensx() */
 
+#endif
+/*----------------------------------------------------------------------
+  Execution Context Functions
+----------------------------------------------------------------------*/
+
+MLPCTX* mlp_ctxcreate (MLP *mlp)
+{                               /* --- create an execution context */
+  int    l;                     /* loop variable for layers */
+  size_t n;                     /* number of activations/errors */
+  size_t m;                     /* size of a Jacobian buffer */
+  MLPCTX *ctx;                  /* created execution context */
+  double *d;                    /* to traverse the double vectors */
+  MLPVAL *p;                    /* to traverse the unit vectors */
+
+  assert(mlp);                  /* check the function argument */
+  for (n = m = 0, l = 0; l < mlp->lyrcnt-1; l++) {
+    n += (size_t)mlp->layers[l].outcnt;
+    if ((size_t)mlp->layers[l].incnt > m)
+      m = (size_t)mlp->layers[l].incnt;
+  }                             /* get the widest layer input */
+  m *= (size_t)mlp->outcnt;     /* and the Jacobian buffer size */
+  ctx = (MLPCTX*)malloc(sizeof(MLPCTX)
+                       +((size_t)mlp->outcnt +(size_t)mlp->incnt)
+                        *sizeof(double)  /* (outputs, raw inputs) */
+                       +((size_t)mlp->incnt +2*n +2*m) *sizeof(MLPVAL));
+  if (!ctx) return NULL;        /* allocate the base structure */
+  ctx->mlp  = mlp;              /* and the vectors in one block */
+  d = (double*)(ctx+1);         /* note the underlying network */
+  ctx->scos = d; d += mlp->outcnt;  /* set the scaled outputs */
+  ctx->raws = d; d += mlp->incnt;   /* and the raw input vector */
+  p = (MLPVAL*)d;               /* (all double vectors come first) */
+  ctx->vecs[0] = p; p += mlp->incnt;
+  for (l = 0; l < mlp->lyrcnt-1; l++) {
+    ctx->vecs[l+1] = p; p += mlp->layers[l].outcnt;
+    ctx->errs[l]   = p; p += mlp->layers[l].outcnt;
+  }                             /* set the layer specific vectors */
+  ctx->jacs[0] = p; p += m;     /* set the buffers for computing */
+  ctx->jacs[1] = p;             /* the Jacobian matrix */
+  return ctx;                   /* return the created context */
+}  /* mlp_ctxcreate() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_ctxdelete (MLPCTX *ctx)
+{                               /* --- delete an execution context */
+  assert(ctx);                  /* check the function argument */
+  free(ctx);                    /* delete the base structure */
+}  /* mlp_ctxdelete() */        /* (vectors are in the same block) */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_execc (MLPCTX *ctx, const double *ins, double *outs)
+{                               /* --- execute in a context */
+  assert(ctx);                  /* check the function arguments */
+  if (ins)                      /* normalize the input vector */
+    norm(ctx->mlp->nst, ins, ctx->vecs[0]);
+  exec(ctx->mlp, ctx->vecs, ctx->scos, 0);
+  if (outs)                     /* copy outputs to result vector */
+    memcpy(outs, ctx->scos, (size_t)ctx->mlp->outcnt *sizeof(double));
+}  /* mlp_execc() */
+
+/*--------------------------------------------------------------------*/
+
+double mlp_sensc (MLPCTX *ctx, DIMID unit, int mode)
+{                               /* --- analyze sensitivity on input */
+  assert(ctx                    /* check the function arguments */
+  &&    (unit >= 0) && (unit < ctx->mlp->incnt));
+  return sens(ctx->mlp, ctx->vecs, ctx->errs, unit, mode);
+}  /* mlp_sensc() */
+
+/*--------------------------------------------------------------------*/
+
+const MLPVAL* mlp_jacobc (MLPCTX *ctx)
+{                               /* --- compute the Jacobian matrix */
+  assert(ctx);                  /* check the function argument */
+  return jacob(ctx->mlp, ctx->vecs, ctx->jacs);
+}  /* mlp_jacobc() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_sensvc (MLPCTX *ctx, double *sens, int mode)
+{                               /* --- sensitivities of all inputs */
+  DIMID  k;                     /* loop variable */
+  MLPVAL *s;                    /* sensitivities of the input units */
+
+  assert(ctx && sens);          /* check the function arguments */
+  s = sensv(ctx->mlp, ctx->vecs, ctx->jacs, mode);
+  for (k = 0; k < ctx->mlp->incnt; k++)
+    sens[k] += (double)s[k];    /* add the sensitivities */
+}  /* mlp_sensvc() */
+
+/*--------------------------------------------------------------------*/
+#ifdef MLP_EXTFN
+
+void mlp_inputxc (MLPCTX *ctx, const TUPLE *tpl)
+{                               /* --- set inputs from a tuple */
+  assert(ctx);                  /* check the function arguments */
+  am_exec(ctx->mlp->attmap, tpl, AM_INPUTS, ctx->raws);
+  norm(ctx->mlp->nst, ctx->raws, ctx->vecs[0]);
+}  /* mlp_inputxc() */          /* normalize the mapped input values */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_resultc (MLPCTX *ctx, INST *inst, double *conf)
+{                               /* --- store output in an instance */
+  assert(ctx && inst);          /* check the function arguments */
+  result(ctx->mlp, ctx->vecs[ctx->mlp->lyrcnt-1], ctx->scos, inst, conf);
+}  /* mlp_resultc() */
+
+/*--------------------------------------------------------------------*/
+
+double mlp_sensxc (MLPCTX *ctx, DIMID col, int mode)
+{                               /* --- analyze sensitivity on input */
+  DIMID  cnt, off;              /* loop variable, offset */
+  double s, t;                  /* sensitivity value, buffer */
+
+  assert(ctx                    /* check the function arguments */
+  &&    (col >= 0) && (col < am_attcnt(ctx->mlp->attmap)));
+  cnt = am_cnt(ctx->mlp->attmap, col);
+  off = am_off(ctx->mlp->attmap, col);
+  if (cnt <= 2)                 /* if there is only one unit */
+    return mlp_sensc(ctx, off, mode);
+  for (s = 0; --cnt >= 0; ) {   /* traverse the inputs */
+    t = mlp_sensc(ctx, off +cnt, mode);
+    if (mode & MLP_SUMIN) s += t;
+    else if (t > s)       s  = t;
+  }                             /* sum/take maximum of sensitivity */
+  return s;                     /* for the inputs and return it */
+}  /* mlp_sensxc() */
+
+/*--------------------------------------------------------------------*/
+
+void mlp_sensvxc (MLPCTX *ctx, double *sens, int mode)
+{                               /* --- sensitivities of all inputs */
+  ATTID  c;                     /* loop variable for attributes */
+  DIMID  cnt, off;              /* number of units, offset */
+  MLPVAL *s;                    /* sensitivities of the input units */
+  double t, u;                  /* sensitivity value, buffer */
+
+  assert(ctx && sens);          /* check the function arguments */
+  s = sensv(ctx->mlp, ctx->vecs, ctx->jacs, mode);
+  for (c = 0; c < am_attcnt(ctx->mlp->attmap); c++) {
+    if (c == mlp_trgid(ctx->mlp)) continue;
+    cnt = am_cnt(ctx->mlp->attmap, c);
+    off = am_off(ctx->mlp->attmap, c);
+    if (cnt <= 2) { sens[c] += (double)s[off]; continue; }
+    for (t = 0; --cnt >= 0; ) { /* traverse the inputs */
+      u = (double)s[off +cnt];  /* of the attribute */
+      if (mode & MLP_SUMIN) t += u;
+      else if (u > t)       t  = u;
+    }                           /* sum/take maximum of sensitivity */
+    sens[c] += t;               /* for the inputs and add it */
+  }                             /* (same as mlp_sensxc() for all */
+}  /* mlp_sensvxc() */          /* attributes except the target) */
+
 #endif
 /*--------------------------------------------------------------------*/
 
@@ -783,7 +1754,7 @@ int mlp_desc (MLP *mlp, FILE *file, int mode, int maxlen)
   int      l;                   /* loop variable  for layers */
   DIMID    k, n;                /* loop variables for weights */
   int      len, i;              /* loop variables for comments */
-  double   **wgts;              /* to traverse the weight vectors */
+  MLPVAL   **wgts;              /* to traverse the weight vectors */
   char     *indent = "";        /* indentation string */
   #ifdef MLP_EXTFN
   char     buf[AS_MAXLEN+1];    /* output buffer for target name */
@@ -822,7 +1793,9 @@ int mlp_desc (MLP *mlp, FILE *file, int mode, int maxlen)
 
   /* --- print list of weight vectors --- */
   fprintf(file, "%sweights  = ", indent);
-  for (l = 0; l < mlp->lyrcnt-1; l++) {   /* traverse the layers */
+  if (mode & MLP_BINWGTS)       /* if weights are stored in binary */
+    fputs("binary", file);      /* form, only print a placeholder */
+  else for (l = 0; l < mlp->lyrcnt-1; l++) { /* traverse the layers */
     if (l > 0) fprintf(file, ",\n%s           ", indent);
     fputc('{', file);           /* start a layer description */
     wgts = mlp->layers[l].wgts; /* traverse the units in a layer */
@@ -830,8 +1803,8 @@ int mlp_desc (MLP *mlp, FILE *file, int mode, int maxlen)
       if (k > 0) fprintf(file, ",\n%s            ", indent);
       fputs("{ ", file);        /* print the connection weights */
       for (n = 0; n < mlp->layers[l].incnt; n++)
-        fprintf(file, "%+.16g, ", wgts[k][n]);
-      fprintf(file, "%+.16g }", wgts[k][n]);
+        fprintf(file, WGTFMT", ", wgts[k][n]);
+      fprintf(file, WGTFMT" }", wgts[k][n]);
     }                           /* print the bias value */
     fputc('}', file);           /* terminate the layer description */
   }                             /* if not last layer, start new line */
@@ -865,6 +1838,147 @@ int mlp_desc (MLP *mlp, FILE *file, int mode, int maxlen)
   return ferror(file);          /* return write error status */
 }  /* mlp_desc() */
 
+/*----------------------------------------------------------------------
+  Binary Network Files
+------------------------------------------------------------------------
+  A binary network file consists of a header (type MLPBIN, 64 bytes),
+  the connection weights in the order of mlp->wgts (starting at offset
+  wgtoff, which is a multiple of 64) and a normal text description of
+  the network (starting at offset txtoff and extending to the end of
+  the file), in which the weights are replaced by "weights = binary;".
+  The text part is read with the normal parse functions, after which
+  the weights are mapped into memory (if the file has the byte order
+  and value size of the executing program) or read and converted.
+  mlp_binwgts() should be called after every parse, with bin = NULL
+  if no binary header was found, so that a text description that
+  refers to binary weights, but lacks them, is rejected (and vice
+  versa), instead of leaving all weights at zero.
+----------------------------------------------------------------------*/
+
+int mlp_binsave (MLP *mlp, FILE *file)
+{                               /* --- write binary header/weights */
+  MLPBIN bin;                   /* binary network file header */
+
+  assert(mlp && file);          /* check the function arguments */
+  memset(&bin, 0, sizeof(bin)); /* clear the header and fill it */
+  memcpy(bin.magic, MLP_BINMAGIC, sizeof(bin.magic));
+  bin.version = MLP_BINVER;
+  bin.endian  = MLP_BINTAG;
+  bin.valsize = (uint32_t)sizeof(MLPVAL);
+  bin.lyrcnt  = (uint32_t)mlp->lyrcnt;
+  bin.wgtcnt  = (uint64_t)mlp->wgtcnt;
+  bin.wgtoff  = (uint64_t)sizeof(MLPBIN);
+  bin.txtoff  = bin.wgtoff +bin.wgtcnt *bin.valsize;
+  if ((fwrite(&bin, sizeof(bin), 1, file) != 1)
+  ||  (fwrite(mlp->wgts, sizeof(MLPVAL), (size_t)mlp->wgtcnt, file)
+       != (size_t)mlp->wgtcnt))
+    return -1;                  /* write header and weights */
+  return ferror(file);          /* (the caller writes the text part */
+}  /* mlp_binsave() */          /* with mlp_desc() and MLP_BINWGTS) */
+
+/*--------------------------------------------------------------------*/
+
+static uint32_t swap32 (uint32_t x)
+{                               /* --- swap bytes of a 32 bit value */
+  return ((x & 0x000000ffu) << 24) | ((x & 0x0000ff00u) <<  8)
+       | ((x & 0x00ff0000u) >>  8) | ((x & 0xff000000u) >> 24);
+}  /* swap32() */
+
+/*--------------------------------------------------------------------*/
+
+static uint64_t swap64 (uint64_t x)
+{                               /* --- swap bytes of a 64 bit value */
+  return ((uint64_t)swap32((uint32_t)x) << 32)
+       |  (uint64_t)swap32((uint32_t)(x >> 32));
+}  /* swap64() */
+
+/*--------------------------------------------------------------------*/
+
+int mlp_binchk (FILE *file, MLPBIN *bin)
+{                               /* --- check for a binary network file */
+  assert(file && bin);          /* check the function arguments */
+  if ((fread(bin, sizeof(MLPBIN), 1, file) != 1)
+  ||  (memcmp(bin->magic, MLP_BINMAGIC, sizeof(bin->magic)) != 0)) {
+    clearerr(file);             /* if no binary header can be read, */
+    return (fseek(file, 0, SEEK_SET) != 0) ? -1 : 0;
+  }                             /* go back to the start of the file */
+  if (bin->endian != MLP_BINTAG) {  /* if other byte order, */
+    bin->version = swap32(bin->version);   /* swap the bytes */
+    bin->valsize = swap32(bin->valsize);   /* of the header fields */
+    bin->lyrcnt  = swap32(bin->lyrcnt);    /* (except the tag, which */
+    bin->wgtcnt  = swap64(bin->wgtcnt);    /* indicates the need */
+    bin->wgtoff  = swap64(bin->wgtoff);    /* to swap the weights) */
+    bin->txtoff  = swap64(bin->txtoff);
+    if (swap32(bin->endian) != MLP_BINTAG) return -1;
+  }                             /* check the endianness tag */
+  if ((bin->version < 1) || (bin->version > MLP_BINVER)
+  ||  ((bin->valsize != sizeof(float)) && (bin->valsize != sizeof(double)))
+  ||  (bin->txtoff != bin->wgtoff +bin->wgtcnt *bin->valsize))
+    return -1;                  /* check the header fields */
+  if (fseek(file, (long)bin->txtoff, SEEK_SET) != 0)
+    return -1;                  /* skip header and weights */
+  return 1;                     /* return 'binary file' */
+}  /* mlp_binchk() */
+
+/*--------------------------------------------------------------------*/
+
+int mlp_binwgts (MLP *mlp, FILE *file, const MLPBIN *bin)
+{                               /* --- get weights from binary file */
+  int      l;                   /* loop variable for layers */
+  DIMID    i, k, n;             /* loop variables for weights */
+  size_t   z;                   /* size of a weight in the file */
+  MLPVAL   *w;                  /* to traverse the weights */
+  unsigned char buf[BIN_CHUNK*sizeof(double)];
+  unsigned char *b, t;          /* read buffer and exchange buffer */
+  float    f;                   /* buffer for a single  precision value */
+  double   d;                   /* buffer for a double precision value */
+
+  assert(mlp && file);          /* check the function arguments */
+  if (!bin)                     /* if there is no binary header, */
+    return (mlp->binwgt) ? -1 : 0;  /* no weights may be pending */
+  if (!mlp->binwgt) return -1;  /* check for pending weights */
+  mlp->binwgt = 0;              /* (the text must refer to them) */
+  if ((bin->wgtcnt != (uint64_t)mlp->wgtcnt)
+  ||  (bin->lyrcnt != (uint32_t)mlp->lyrcnt))
+    return -1;                  /* check the network structure */
+  #ifdef MLP_MMAP               /* if memory mapping is possible */
+  if ((bin->endian  == MLP_BINTAG)
+  &&  (bin->valsize == sizeof(MLPVAL))) {
+    mlp->mapsz = (size_t)bin->txtoff;
+    mlp->map   = mmap(NULL, mlp->mapsz, PROT_READ|PROT_WRITE,
+                      MAP_PRIVATE, fileno(file), 0);
+    if (mlp->map != MAP_FAILED){/* map the file (copy on write) */
+      w = mlp->wgts = (MLPVAL*)((char*)mlp->map +bin->wgtoff);
+      for (l = 0; l < mlp->lyrcnt-1; l++) {
+        n = mlp->layers[l].incnt +1;  /* traverse the layers and */
+        for (k = 0; k < mlp->layers[l].outcnt; k++) {
+          mlp->layers[l].wgts[k] = w; w += n; }
+      }                         /* set the weight matrix lines */
+      return 0;                 /* to the mapped weights and */
+    }                           /* return 'ok' */
+    mlp->map = NULL; mlp->mapsz = 0;
+  }                             /* on failure read the weights */
+  #endif
+  if (fseek(file, (long)bin->wgtoff, SEEK_SET) != 0)
+    return -1;                  /* go to the start of the weights */
+  z = (size_t)bin->valsize;     /* get the size of a weight */
+  for (i = 0; i < mlp->wgtcnt; i += k) {
+    k = (mlp->wgtcnt -i > BIN_CHUNK) ? BIN_CHUNK : mlp->wgtcnt -i;
+    if (fread(buf, z, (size_t)k, file) != (size_t)k)
+      return -1;                /* read a chunk of weights */
+    for (b = buf, n = 0; n < k; n++, b += z) {
+      if (bin->endian != MLP_BINTAG) {
+        for (l = 0; l < (int)z/2; l++) {
+          t = b[l]; b[l] = b[z-1-(size_t)l]; b[z-1-(size_t)l] = t; }
+      }                         /* swap the bytes if necessary */
+      if (z == sizeof(float)) { memcpy(&f, b, z); d = f; }
+      else                    { memcpy(&d, b, z); }
+      mlp->wgts[i+n] = (MLPVAL)d;
+    }                           /* convert the weight */
+  }                             /* to the value type of the network */
+  return 0;                     /* return 'ok' */
+}  /* mlp_binwgts() */
+
 /*--------------------------------------------------------------------*/
 #ifdef MLP_PARSE
 
@@ -921,7 +2035,7 @@ static int getwgts (MLP *mlp, SCANNER *scan)
   int      l;                   /* loop variable  for layers */
   DIMID    k, n;                /* loop variables for weights */
   MLPLAYER *layer;              /* to traverse the network layers */
-  double   **wp, *w;            /* to traverse the weights */
+  MLPVAL   **wp, *w;            /* to traverse the weights */
 
   assert(mlp && scan);          /* check the function arguments */
   if ((scn_token(scan) != T_ID) /* check for 'weights' */
@@ -929,6 +2043,14 @@ static int getwgts (MLP *mlp, SCANNER *scan)
     SCN_ERROR(scan, E_STREXP, "weights");
   SCN_NEXT(scan);               /* consume 'weights' */
   SCN_CHAR(scan, '=');          /* consume '=' */
+  if ((scn_token(scan) == T_ID) /* if weights are in binary form */
+  &&  (strcmp(scn_value(scan), "binary") == 0)) {
+    SCN_NEXT(scan);             /* consume 'binary' */
+    SCN_CHAR(scan, ';');        /* consume ';' */
+    memset(mlp->wgts, 0, (size_t)mlp->wgtcnt *sizeof(MLPVAL));
+    mlp->binwgt = 1;            /* clear the weights (they are */
+    return 0;                   /* set with mlp_binwgts()) */
+  }
   layer = mlp->layers;          /* traverse the network layers */
   for (l = mlp->lyrcnt-1; --l >= 0; layer++) {
     SCN_CHAR(scan, '{');        /* consume '{' */
@@ -938,7 +2060,7 @@ static int getwgts (MLP *mlp, SCANNER *scan)
       w = *wp++;                /* traverse the inputs of a unit */
       for (n = layer->incnt +1; --n >= 0; ) {
         if (scn_token(scan) != T_NUM) SCN_ERROR(scan, E_NUMEXP);
-        *w++ = strtod(scn_value(scan), NULL);
+        *w++ = (MLPVAL)strtod(scn_value(scan), NULL);
         SCN_NEXT(scan);         /* get the connection weight */
         if (n > 0) { SCN_CHAR(scan, ','); }
       }                         /* if not bis value, consume ',' */
@@ -996,7 +2118,7 @@ MLP* mlp_parse (SCANNER *scan)
   scn_first(scan);              /* set messages, get first token */
   lyrcnt = getucnts(scan, ucnts, 0, 0);
   if (lyrcnt < 0) return NULL;  /* get the number of units per layer */
-  mlp = create(lyrcnt, ucnts);  /* create a multilayer perceptron */
+  mlp = create(lyrcnt, ucnts, 0);/* create a multilayer perceptron */
   if (!mlp) return NULL;
   if ((getscls(mlp, scan) != 0)    /* read input scalings, */
   ||  (getwgts(mlp, scan) != 0)    /* the connection weights, */
@@ -1059,7 +2181,7 @@ MLP* mlp_parsex (SCANNER *scan, ATTMAP *attmap)
   if (lyrcnt < 0) return NULL;  /* get the number of units per layer*/
   ucnts[0]        = am_incnt (attmap);
   ucnts[lyrcnt-1] = am_outcnt(attmap);
-  mlp = create(lyrcnt, ucnts);  /* create a multilayer perceptron */
+  mlp = create(lyrcnt, ucnts, 0);/* create a multilayer perceptron */
   if (!mlp) { scn_error(scan, E_NOMEM); return NULL; }
   mlp->attset = am_attset(attmap);
   mlp->attmap = attmap;         /* note the attribute set and map */
@@ -16,10 +16,25 @@
             2004.08.11 adapted to new module attmap
             2004.08.12 adapted to new module parse
             2013.08.13 adapted to definition of type DIMID in matrix.h
+            2016.05.02 block/batch execution functions added
+            2016.05.04 block/batch backpropagation function added
+            2016.05.06 shadow networks added (for parallel training)
+            2016.05.09 vectorized activation functions (module mlpvec)
+            2016.05.11 single precision version added (MLP_FLOAT)
+            2016.05.12 binary network files added (mlp_binsave() etc.)
+            2016.05.14 execution contexts added (MLPCTX, mlp_execc() etc.)
+            2016.05.15 block inputs/targets from column-major tables
+            2016.05.16 sparse inputs added (mlp_execs(), mlp_bkprops())
+            2016.05.16 flag MLP_SCALAR added (scalar weight update)
+            2016.05.16 functions mlp_clone() and mlp_wgtcopy() added
+            2016.05.16 function mlp_normcopy() added (copy scaling)
+            2016.05.16 Jacobian based sensitivity functions added
+            2016.05.16 mlp_binwgts() checks for missing binary weights
 ----------------------------------------------------------------------*/
 #ifndef __MLP__
 #define __MLP__
 #include <stdio.h>
+#include <stdint.h>
 #include "matrix.h"
 #ifdef MLP_PARSE
 #ifndef NST_PARSE
@@ -47,6 +62,25 @@
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
 #define MLP_MAXLAYER   32       /* maximum number of layers */
+#define MLP_BLKSIZE   256       /* default number of patterns/block */
+
+/* --- value types --- */
+/* With MLP_FLOAT defined, weights, activations, errors and gradients */
+/* are stored in single precision, which halves the memory traffic    */
+/* and doubles the SIMD width. The sums of weighted inputs are then   */
+/* also computed in single precision, unless MLP_DBLACC is defined.   */
+/* Interface vectors (inputs, targets, outputs) are always double.    */
+#ifdef MLP_FLOAT                /* if to use single precision */
+#define MLPVAL      float       /* type of weights, activations etc. */
+#ifdef MLP_DBLACC               /* if to accumulate in double prec. */
+#define MLPACC      double      /* type of sums of weighted inputs */
+#else
+#define MLPACC      float
+#endif
+#else                           /* if to use double precision */
+#define MLPVAL      double
+#define MLPACC      double
+#endif
 
 /* --- training methods --- */
 #define MLP_STANDARD    0       /* standard backpropagation */
@@ -54,6 +88,7 @@
 #define MLP_RESILIENT   2       /* resilient backpropagation */
 #define MLP_QUICK       3       /* quick backpropagation */
 #define MLP_MANHATTAN   4       /* Manhattan training */
+#define MLP_SCALAR   0x10       /* flag: scalar update (validation) */
 
 /* --- sensitivity modes --- */
 #define MLP_MAX         0       /* determine maximal output change */
@@ -64,20 +99,41 @@
 /* --- description modes --- */
 #define MLP_TITLE     0x0001    /* print a title (as a comment) */
 #define MLP_INFO      0x0002    /* print add. info. (as a comment) */
+#define MLP_BINWGTS   0x0004    /* weights are stored in binary form */
+
+/* --- binary network files --- */
+#define MLP_BINMAGIC  "\177MLPBIN\n"  /* magic number (8 bytes) */
+#define MLP_BINVER      1       /* version of the binary format */
+#define MLP_BINTAG    0x01020304/* endianness tag (native order) */
 
 /*----------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------*/
+typedef struct {                /* --- binary network file header --- */
+  char     magic[8];            /* magic number (MLP_BINMAGIC) */
+  uint32_t version;             /* version of the file format */
+  uint32_t endian;              /* endianness tag (MLP_BINTAG) */
+  uint32_t valsize;             /* size of a weight (4 or 8 bytes) */
+  uint32_t lyrcnt;              /* number of layers */
+  uint64_t wgtcnt;              /* number of connection weights */
+  uint64_t wgtoff;              /* file offset of the weights */
+  uint64_t txtoff;              /* file offset of the description */
+  uint64_t rsvd[2];             /* reserved (pad to 64 bytes) */
+} MLPBIN;                       /* (binary network file header) */
+
 typedef struct {                /* --- an MLP layer --- */
   DIMID    incnt;               /* number of inputs */
   DIMID    outcnt;              /* number of outputs/units */
-  double   **wgts;              /* matrix of connection weights */
-  double   **chgs;              /* matrix of weight changes */
-  double   **grds;              /* matrix of (aggregated) gradients */
-  double   **bufs;              /* matrix of buffers */
-  double   *ins;                /* vector of inputs */
-  double   *outs;               /* vector of outputs */
-  double   *errs;               /* (backpropagated) errors */
+  MLPVAL   **wgts;              /* matrix of connection weights */
+  MLPVAL   **chgs;              /* matrix of weight changes */
+  MLPVAL   **grds;              /* matrix of (aggregated) gradients */
+  MLPVAL   **bufs;              /* matrix of buffers */
+  MLPVAL   *ins;                /* vector of inputs */
+  MLPVAL   *outs;               /* vector of outputs */
+  MLPVAL   *errs;               /* (backpropagated) errors */
+  MLPVAL   *bins;               /* block of inputs  (batch mode) */
+  MLPVAL   *bouts;              /* block of outputs (batch mode) */
+  MLPVAL   *berrs;              /* block of errors  (batch mode) */
   void     *rsvd;               /* reserved (alignment) */
 } MLPLAYER;                     /* (MLP layer) */
 
@@ -87,8 +143,8 @@ typedef struct {                /* --- a multilayer perceptron --- */
   DIMID    outcnt;              /* number of outputs */
   DIMID    unitcnt;             /* number of units */
   DIMID    wgtcnt;              /* number of weights */
-  double   *ins;                /* vector of inputs */
-  double   *outs;               /* vector of (computed) outputs */
+  MLPVAL   *ins;                /* vector of (normalized) inputs */
+  MLPVAL   *outs;               /* vector of (computed) outputs */
   double   *mins;               /* vector of minimal output values */
   double   *maxs;               /* vector of maximal output values */
   double   *offs;               /* offsets for output scaling */
@@ -96,12 +152,25 @@ typedef struct {                /* --- a multilayer perceptron --- */
   double   *recs;               /* and their reciprocal values */
   double   *scos;               /* vector of (scaled) outputs */
   double   *trgs;               /* vector of (target) outputs */
-  double   *errs;               /* vector of output errors */
-  double   *wgts;               /* vector of all connection weights */
-  double   *chgs;               /* vector of all weight changes */
-  double   *grds;               /* vector of all gradients */
-  double   *bufs;               /* vector of all buffers */
+  double   *raws;               /* vector of raw (mapped) inputs */
+  MLPVAL   *errs;               /* vector of output errors */
+  MLPVAL   *wgts;               /* vector of all connection weights */
+  MLPVAL   *chgs;               /* vector of all weight changes */
+  MLPVAL   *grds;               /* vector of all gradients */
+  MLPVAL   *bufs;               /* vector of all buffers */
   NSTATS   *nst;                /* input normalization statistics */
+  int      shadow;              /* whether weights etc. are shared */
+  void     *map;                /* memory map of a binary file */
+  size_t   mapsz;               /* size of the memory map */
+  int      binwgt;              /* whether binary weights are pending */
+  DIMID    blkcap;              /* capacity of the pattern blocks */
+  MLPVAL   *bins;               /* block of (normalized) inputs */
+  double   *btrgs;              /* block of (target) outputs */
+  double   *bscos;              /* block of (scaled) outputs */
+  double   *braws;              /* block of raw (mapped) inputs */
+  DIMID    spcnt;               /* number of sparse input elements */
+  DIMID    *spidx;              /* indices of sparse input elements */
+  MLPVAL   *spvals;             /* values  of sparse input elements */
   #ifdef MLP_EXTFN
   ATTSET   *attset;             /* underlying attribute set */
   ATTMAP   *attmap;             /* attribute map for numeric coding */
@@ -119,11 +188,59 @@ typedef struct {                /* --- a multilayer perceptron --- */
   MLPLAYER layers[1];           /* layers of the network */
 } MLP;                          /* (multilayer perceptron) */
 
+/* A sparse input lists only the non-zero (normalized) inputs of a    */
+/* pattern as pairs of an input index and a value. The first layer is */
+/* then executed and its gradients are aggregated only for the listed */
+/* inputs, so that the costs of 1-in-n coded nominal attributes are   */
+/* independent of their numbers of values. Inputs that are not listed */
+/* are taken to be zero after normalization, hence their offsets must */
+/* be zero. mlp_sparsex() ensures this for 1-in-n coded inputs by     */
+/* folding their scaling into the first layer weights and biases.     */
+/* This does not change the network function, but training adapts a  */
+/* different parametrization (unscaled inputs) and the sparse kernels */
+/* sum in a different order, so trained networks are not identical   */
+/* to those trained with dense input (except for online training on  */
+/* inputs that need no scaling, e.g. with mlpt -q -k1).               */
+
+/* A clone is a shadow network with its own copy of the connection    */
+/* weights (created by mlp_clone(), refreshed by mlp_wgtcopy()), so   */
+/* that it can be executed while the original network is trained      */
+/* further, for example, to evaluate a snapshot of the weights on     */
+/* validation data.                                                   */
+
+/* An execution context holds the vectors that are written when a     */
+/* network is executed (inputs, activations, outputs, sensitivities), */
+/* so that one network can be executed by several threads at the same */
+/* time, each with its own context. The network itself is only read.  */
+typedef struct {                /* --- MLP execution context --- */
+  MLP      *mlp;                /* underlying network (read only) */
+  double   *scos;               /* vector of (scaled) outputs */
+  double   *raws;               /* vector of raw (mapped) inputs */
+  MLPVAL   *vecs[MLP_MAXLAYER]; /* inputs and outputs of the layers */
+  MLPVAL   *errs[MLP_MAXLAYER]; /* sensitivity values of the layers */
+  MLPVAL   *jacs[2];            /* buffers for the Jacobian matrix */
+} MLPCTX;                       /* (MLP execution context) */
+
+/* mlp_jacobc() computes the derivatives of all (scaled) outputs      */
+/* w.r.t. all (normalized) inputs for the pattern last executed in a  */
+/* context, with one matrix product per layer (from the output layer  */
+/* backwards), and returns them as an outcnt x incnt matrix (rows:    */
+/* outputs), which is valid until the next call. mlp_sensvc() and     */
+/* mlp_sensvxc() add the sensitivities of all input units (or input   */
+/* attributes, except the target) to a vector; this is much faster    */
+/* than calling mlp_sensc() or mlp_sensxc() for each input, as the    */
+/* network is traversed only once instead of once per input.          */
+
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 extern MLP*    mlp_create  (int lyrcnt, DIMID *ucnts);
 extern void    mlp_delete  (MLP *mlp);
+extern MLP*    mlp_shadow  (MLP *mlp);
+extern void    mlp_merge   (MLP *mlp, MLP *shadow);
+extern MLP*    mlp_clone   (MLP *mlp);
+extern void    mlp_wgtcopy (MLP *dst, const MLP *src);
+extern int     mlp_normcopy(MLP *dst, const MLP *src);
 #ifdef MLP_EXTFN
 extern MLP*    mlp_createx (ATTMAP *attmap, int lyrcnt, DIMID *ucnts);
 extern void    mlp_deletex (MLP *mlp, int delas);
@@ -164,19 +281,62 @@ extern void    mlp_outputx (MLP *mlp, TUPLE *tpl);
 extern void    mlp_result  (MLP *mlp, INST *inst, double *conf);
 #endif
 
+extern int     mlp_blksize (MLP *mlp, DIMID n);
+extern DIMID   mlp_blkcap  (const MLP *mlp);
+extern void    mlp_inputb  (MLP *mlp, DIMID i, const double *ins);
+extern void    mlp_targetb (MLP *mlp, DIMID i, const double *trgs);
+extern double  mlp_outputb (const MLP *mlp, DIMID i, DIMID unit);
+#ifdef MLP_EXTFN
+extern void    mlp_inputxb (MLP *mlp, DIMID i, const TUPLE *tpl);
+extern void    mlp_targetxb(MLP *mlp, DIMID i, const TUPLE *tpl);
+extern void    mlp_inputcb (MLP *mlp, TABCOL *tc,
+                            const TPLID *rows, DIMID n);
+extern void    mlp_targetcb(MLP *mlp, TABCOL *tc,
+                            const TPLID *rows, DIMID n);
+#endif
+
 extern void    mlp_init    (MLP *mlp, double rand(void), double range);
 extern void    mlp_jog     (MLP *mlp, double rand(void), double range);
 extern void    mlp_setup   (MLP *mlp);
 extern void    mlp_exec    (MLP *mlp, const double *ins, double *outs);
+extern void    mlp_execb   (MLP *mlp, const double *ins, DIMID n,
+                            double *outs);
 extern double  mlp_error   (MLP *mlp, const double *trgs);
 extern double  mlp_bkprop  (MLP *mlp, const double *trgs);
+extern double  mlp_bkpropb (MLP *mlp, const double *trgs, DIMID n);
+extern int     mlp_sparse  (MLP *mlp);
+extern void    mlp_execs   (MLP *mlp, const DIMID *idx,
+                            const double *ins, DIMID n, double *outs);
+extern double  mlp_bkprops (MLP *mlp, const double *trgs);
+#ifdef MLP_EXTFN
+extern int     mlp_sparsex (MLP *mlp);
+extern void    mlp_inputxs (MLP *mlp, const TUPLE *tpl);
+#endif
 extern void    mlp_update  (MLP *mlp);
 extern double  mlp_sens    (MLP *mlp, DIMID unit, int mode);
 #ifdef MLP_EXTFN
 extern double  mlp_sensx   (MLP *mlp, DIMID col, int mode);
 #endif
 
+extern MLPCTX* mlp_ctxcreate(MLP *mlp);
+extern void    mlp_ctxdelete(MLPCTX *ctx);
+extern MLP*    mlp_ctxnet  (MLPCTX *ctx);
+extern void    mlp_execc   (MLPCTX *ctx, const double *ins, double *outs);
+extern double  mlp_outputc (const MLPCTX *ctx, DIMID unit);
+extern double  mlp_sensc   (MLPCTX *ctx, DIMID unit, int mode);
+extern const MLPVAL* mlp_jacobc (MLPCTX *ctx);
+extern void    mlp_sensvc  (MLPCTX *ctx, double *sens, int mode);
+#ifdef MLP_EXTFN
+extern void    mlp_inputxc (MLPCTX *ctx, const TUPLE *tpl);
+extern void    mlp_resultc (MLPCTX *ctx, INST *inst, double *conf);
+extern double  mlp_sensxc  (MLPCTX *ctx, DIMID col, int mode);
+extern void    mlp_sensvxc (MLPCTX *ctx, double *sens, int mode);
+#endif
+
 extern int     mlp_desc    (MLP *mlp, FILE *file, int mode, int maxlen);
+extern int     mlp_binsave (MLP *mlp, FILE *file);
+extern int     mlp_binchk  (FILE *file, MLPBIN *bin);
+extern int     mlp_binwgts (MLP *mlp, FILE *file, const MLPBIN *bin);
 #ifdef MLP_PARSE
 extern MLP*    mlp_parse   (SCANNER *scan);
 #ifdef MLP_EXTFN
@@ -211,8 +371,13 @@ extern MLP*    mlp_parsex  (SCANNER *scan, ATTMAP *attmap);
                                         * ((v) -(n)->exps[i]))
 #define mlp_target(n,i,v)  ((n)->trgs[i] = (v))
 #define mlp_output(n,i)    ((n)->scos[i])
+#define mlp_blkcap(n)      ((n)->blkcap)
+#define mlp_outputb(n,i,u) ((n)->bscos[(i)*(n)->outcnt +(u)])
 #ifdef MLP_EXTFN
 #define mlp_targetx(n,t)   am_exec((n)->attmap, t, AM_TARGET, (n)->trgs)
 #endif
 
+#define mlp_ctxnet(c)      ((c)->mlp)
+#define mlp_outputc(c,i)   ((c)->scos[i])
+
 #endif
@@ -6,6 +6,16 @@
 #           2006.07.20 adapted to Visual Studio 8
 #           2007.03.16 special matrix versions removed
 #           2016.04.20 completed dependencies on header files
+#           2016.05.06 module thread added (parallel training)
+#           2016.05.09 module mlpvec added (vectorized kernels)
+#           2016.05.11 single precision versions added (floats)
+#           2016.05.12 program mlpc added (binary network files)
+#           2016.05.13 module thread added to mlpx (pipelined execution)
+#           2016.05.15 module tabcol added to mlpt (column-major table)
+#           2016.05.16 module thread added to mlps (parallel sensitivity)
+#           2016.05.16 module tmstat added (phase timing reports)
+#           2016.05.16 program mlpbench added (kernel benchmarks)
+#           2016.05.16 external module memsys added (tuples and values)
 #-----------------------------------------------------------------------
 THISDIR  = ..\..\mlp\src
 UTILDIR  = ..\..\util\src
@@ -22,26 +32,42 @@ LDFLAGS  = /nologo /subsystem:console /incremental:no
 LIBS     = 
 
 HDRS_1   = $(UTILDIR)\nstats.h     $(UTILDIR)\scanner.h    \
-           $(MATDIR)\matrix.h
+           $(UTILDIR)\memsys.h     $(MATDIR)\matrix.h
 HDRS_2   = $(HDRS_1)               $(UTILDIR)\fntypes.h    \
            $(TABLEDIR)\attset.h    $(TABLEDIR)\attmap.h    \
-           $(TABLEDIR)\table.h
+           $(TABLEDIR)\table.h     $(TABLEDIR)\tabcol.h
 HDRS     = $(HDRS_2)               $(UTILDIR)\error.h      \
            $(UTILDIR)\tabread.h    $(UTILDIR)\tabwrite.h mlp.h
-OBJS     = $(UTILDIR)\arrays.obj   $(UTILDIR)\escape.obj   \
+OBJS_0   = $(UTILDIR)\arrays.obj   $(UTILDIR)\escape.obj   \
            $(UTILDIR)\tabread.obj  $(UTILDIR)\tabwrite.obj \
            $(UTILDIR)\scanner.obj  $(UTILDIR)\nst_pars.obj \
-           $(UTILDIR)\random.obj   $(MATDIR)\mat_rdwr.obj  \
+           $(UTILDIR)\random.obj   $(UTILDIR)\memsys.obj   \
+           $(MATDIR)\mat_rdwr.obj  \
            $(TABLEDIR)\attset1.obj $(TABLEDIR)\attset2.obj \
            $(TABLEDIR)\attset3.obj $(TABLEDIR)\attmap.obj  \
-           mlp_ext.obj
+           mlpvec.obj
+OBJS     = $(OBJS_0)               mlp_ext.obj
 MLPT_O   = $(OBJS)                 $(UTILDIR)\params.obj   \
-           $(TABLEDIR)\table1.obj  $(TABLEDIR)\tab2ro.obj mlpt.obj
-MLPX_O   = $(OBJS)\
+           $(UTILDIR)\thread.obj   $(UTILDIR)\tmstat.obj   \
+           $(TABLEDIR)\table1.obj  $(TABLEDIR)\tabcol.obj mlpt.obj
+MLPX_O   = $(OBJS)                 $(UTILDIR)\thread.obj   \
+           $(UTILDIR)\tmstat.obj   \
            $(TABLEDIR)\table1.obj  $(TABLEDIR)\tab2ro.obj mlpx.obj
-MLPS_O   = $(OBJS) mlps.obj
+MLPS_O   = $(OBJS)                 $(UTILDIR)\thread.obj   \
+           $(UTILDIR)\tmstat.obj   mlps.obj
+MLPC_O   = $(OBJS) mlpc.obj
+BENCH_O  = $(OBJS)                 $(UTILDIR)\tmstat.obj   \
+           $(TABLEDIR)\table1.obj  $(TABLEDIR)\tab2ro.obj mlpbench.obj
 
-PRGS     = mlpt.exe mlpx.exe mlps.exe
+MLPTF_O  = $(OBJS_0)               $(UTILDIR)\params.obj   \
+           $(UTILDIR)\thread.obj   $(UTILDIR)\tmstat.obj   \
+           $(TABLEDIR)\table1.obj  $(TABLEDIR)\tabcol.obj mlptf.obj
+MLPXF_O  = $(OBJS_0)               $(UTILDIR)\thread.obj   \
+           $(UTILDIR)\tmstat.obj   \
+           $(TABLEDIR)\table1.obj  $(TABLEDIR)\tab2ro.obj mlpxf.obj
+
+PRGS     = mlpt.exe mlpx.exe mlps.exe mlpc.exe
+FPRGS    = mlptf.exe mlpxf.exe mlptfd.exe mlpxfd.exe
 
 #-----------------------------------------------------------------------
 # Build Programs
@@ -57,32 +83,96 @@ mlpx.exe:     $(MLPX_O)  mlp.mak
 mlps.exe:     $(MLPS_O)  mlp.mak
 	$(LD) $(LDFLAGS) $(MLPS_O) $(LIBS) /out:$@
 
+mlpc.exe:     $(MLPC_O)  mlp.mak
+	$(LD) $(LDFLAGS) $(MLPC_O) $(LIBS) /out:$@
+
+#-----------------------------------------------------------------------
+# Benchmarks
+#-----------------------------------------------------------------------
+bench:        mlpbench.exe
+
+mlpbench.exe: $(BENCH_O) mlp.mak
+	$(LD) $(LDFLAGS) $(BENCH_O) $(LIBS) /out:$@
+
+#-----------------------------------------------------------------------
+# Single Precision Versions
+#-----------------------------------------------------------------------
+floats:       $(FPRGS)
+
+mlptf.exe:    $(MLPTF_O) mlp_extf.obj  mlp.mak
+	$(LD) $(LDFLAGS) $(MLPTF_O) mlp_extf.obj  $(LIBS) /out:$@
+
+mlpxf.exe:    $(MLPXF_O) mlp_extf.obj  mlp.mak
+	$(LD) $(LDFLAGS) $(MLPXF_O) mlp_extf.obj  $(LIBS) /out:$@
+
+mlptfd.exe:   $(MLPTF_O) mlp_extfd.obj mlp.mak
+	$(LD) $(LDFLAGS) $(MLPTF_O) mlp_extfd.obj $(LIBS) /out:$@
+
+mlpxfd.exe:   $(MLPXF_O) mlp_extfd.obj mlp.mak
+	$(LD) $(LDFLAGS) $(MLPXF_O) mlp_extfd.obj $(LIBS) /out:$@
+
 #-----------------------------------------------------------------------
 # Main Programs
 #-----------------------------------------------------------------------
 mlpt.obj:     $(HDRS) $(UTILDIR)\random.h $(UTILDIR)\params.h
+mlpt.obj:     $(UTILDIR)\thread.h $(UTILDIR)\arrays.h
+mlpt.obj:     $(UTILDIR)\tmstat.h
 mlpt.obj:     mlpt.c mlp.mak
 	$(CC) $(CFLAGS) $(INCS) mlpt.c /Fo$@
 
-mlpx.obj:     $(HDRS)
+mlpx.obj:     $(HDRS) $(UTILDIR)\thread.h $(UTILDIR)\tmstat.h
 mlpx.obj:     mlpx.c mlp.mak
 	$(CC) $(CFLAGS) $(INCS) mlpx.c /Fo$@
 
-mlps.obj:     $(HDRS)
+mlps.obj:     $(HDRS) $(UTILDIR)\thread.h $(UTILDIR)\tmstat.h
 mlps.obj:     mlps.c mlp.mak
 	$(CC) $(CFLAGS) $(INCS) mlps.c /Fo$@
 
+mlpc.obj:     $(HDRS)
+mlpc.obj:     mlpc.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) mlpc.c /Fo$@
+
+mlpbench.obj: $(HDRS) $(UTILDIR)\random.h $(UTILDIR)\tmstat.h
+mlpbench.obj: mlpbench.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) mlpbench.c /Fo$@
+
+mlptf.obj:    $(HDRS) $(UTILDIR)\random.h $(UTILDIR)\params.h
+mlptf.obj:    $(UTILDIR)\thread.h $(UTILDIR)\arrays.h
+mlptf.obj:    $(UTILDIR)\tmstat.h
+mlptf.obj:    mlpt.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) /D MLP_FLOAT mlpt.c /Fo$@
+
+mlpxf.obj:    $(HDRS) $(UTILDIR)\thread.h $(UTILDIR)\tmstat.h
+mlpxf.obj:    mlpx.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) /D MLP_FLOAT mlpx.c /Fo$@
+
 #-----------------------------------------------------------------------
 # Multilayer Perceptron Management
 #-----------------------------------------------------------------------
 mlp.obj:      $(HDRS_1)
-mlp.obj:      mlp.h mlp.c mlp.mak
+mlp.obj:      mlp.h mlpvec.h mlp.c mlp.mak
 	$(CC) $(CFLAGS) $(INCS) /D MLP_PARSE mlp.c /Fo$@
 
 mlp_ext.obj:  $(HDRS_2)
-mlp_ext.obj:  mlp.h mlp.c mlp.mak
+mlp_ext.obj:  mlp.h mlpvec.h mlp.c mlp.mak
 	$(CC) $(CFLAGS) $(INCS) /D MLP_PARSE /D MLP_EXTFN mlp.c /Fo$@
 
+mlp_extf.obj: $(HDRS_2)
+mlp_extf.obj: mlp.h mlpvec.h mlp.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) /D MLP_PARSE /D MLP_EXTFN /D MLP_FLOAT \
+              mlp.c /Fo$@
+
+mlp_extfd.obj: $(HDRS_2)
+mlp_extfd.obj: mlp.h mlpvec.h mlp.c mlp.mak
+	$(CC) $(CFLAGS) $(INCS) /D MLP_PARSE /D MLP_EXTFN /D MLP_FLOAT \
+              /D MLP_DBLACC mlp.c /Fo$@
+
+#-----------------------------------------------------------------------
+# Vectorized Kernels
+#-----------------------------------------------------------------------
+mlpvec.obj:   mlpvec.h mlpvec.c mlp.mak
+	$(CC) $(CFLAGS) mlpvec.c /Fo$@
+
 #-----------------------------------------------------------------------
 # External Modules
 #-----------------------------------------------------------------------
@@ -118,6 +208,18 @@ $(UTILDIR)\params.obj:
 	cd $(UTILDIR)
 	$(MAKE) /f util.mak params.obj
 	cd $(THISDIR)
+$(UTILDIR)\thread.obj:
+	cd $(UTILDIR)
+	$(MAKE) /f util.mak thread.obj
+	cd $(THISDIR)
+$(UTILDIR)\tmstat.obj:
+	cd $(UTILDIR)
+	$(MAKE) /f util.mak tmstat.obj
+	cd $(THISDIR)
+$(UTILDIR)\memsys.obj:
+	cd $(UTILDIR)
+	$(MAKE) /f util.mak memsys.obj
+	cd $(THISDIR)
 $(MATDIR)\mat_rdwr.obj:
 	cd $(MATDIR)
 	$(MAKE) /f matrix.mak mat_rdwr.obj
@@ -150,6 +252,10 @@ $(TABLEDIR)\tab2ro.obj:
 	cd $(TABLEDIR)
 	$(MAKE) /f table.mak tab2ro.obj
 	cd $(THISDIR)
+$(TABLEDIR)\tabcol.obj:
+	cd $(TABLEDIR)
+	$(MAKE) /f table.mak tabcol.obj
+	cd $(THISDIR)
 
 #-----------------------------------------------------------------------
 # Install
@@ -171,4 +277,4 @@ clean:
 	cd $(THISDIR)
 
 localclean:
-	-@erase /Q *~ *.obj *.idb *.pch $(PRGS)
+	-@erase /Q *~ *.obj *.idb *.pch $(PRGS) $(FPRGS) mlpbench.exe
@@ -0,0 +1,431 @@
+/*----------------------------------------------------------------------
+  File    : mlpbench.c
+  Contents: benchmark for multilayer perceptron kernels
+  Author  : Christian Borgelt
+  History : 2016.05.16 file created
+            2016.05.16 table reading with and without memory systems
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifndef AS_READ
+#define AS_READ
+#endif
+#include "attset.h"
+#ifndef TAB_READ
+#define TAB_READ
+#endif
+#include "table.h"
+#include "mlp.h"
+#include "random.h"
+#include "tmstat.h"
+#include "error.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "mlpbench"
+#define DESCRIPTION "benchmark for multilayer perceptron kernels"
+#define VERSION     "version 1.0 (2016.05.16)         " \
+                    "(c) 2016        Christian Borgelt"
+
+/* --- error codes --- */
+/* error codes 0 to -5 defined in attset.h */
+#define E_OPTION     (-6)       /* unknown option */
+#define E_OPTARG     (-7)       /* missing option argument */
+#define E_ARGCNT     (-8)       /* wrong number of arguments */
+#define E_UNITCNT    (-9)       /* invalid number of units */
+#define E_LAYERS    (-10)       /* invalid hidden layer description */
+#define E_PATCNT    (-11)       /* invalid number of patterns */
+
+#define MAXREPS     64          /* maximal number of repetitions */
+#define MTHCNT      5           /* number of update methods */
+#define TPLBLK      1024        /* number of tuples per memory block */
+#define VALBLK      4096        /* size of value memory blocks */
+
+#define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {   /* error messages */
+  /* E_NONE      0 */  "no error",
+  /* E_NOMEM    -1 */  "not enough memory",
+  /* E_FOPEN    -2 */  "cannot open file %s",
+  /* E_FREAD    -3 */  "read error on file %s",
+  /* E_FWRITE   -4 */  "write error on file %s",
+  /* E_STDIN    -5 */  "double assignment of standard input",
+  /* E_OPTION   -6 */  "unknown option -%c",
+  /* E_OPTARG   -7 */  "missing option argument",
+  /* E_ARGCNT   -8 */  "wrong number of arguments",
+  /* E_UNITCNT  -9 */  "invalid number of units %"DIMID_FMT,
+  /* E_LAYERS  -10 */  "invalid hidden layer description %s",
+  /* E_PATCNT  -11 */  "invalid number of patterns %"DIMID_FMT,
+  /*           -12 */  "unknown error",
+};
+
+static const char *mthnames[MTHCNT] = {  /* names of update methods */
+  "bkprop", "supersab", "rprop", "quick", "manhattan" };
+static const int   methods [MTHCNT] = {  /* update method codes */
+  MLP_STANDARD, MLP_ADAPTIVE, MLP_RESILIENT, MLP_QUICK, MLP_MANHATTAN };
+static const char *memnames[2]      = {  /* names of memory modes */
+  "tab_read:heap", "tab_read:memsys" };
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static CCHAR   *prgname;        /* program name for error messages */
+static MLP     *mlp    = NULL;  /* multilayer perceptron */
+static double  *pats   = NULL;  /* synthetic training patterns */
+static ATTSET  *attset = NULL;  /* attribute set (table reading) */
+static TABLE   *table  = NULL;  /* table (table reading) */
+static TABREAD *tread  = NULL;  /* table reader */
+static FILE    *out    = NULL;  /* output file */
+static double  ovh     = 0;     /* overhead of a clock query pair */
+static double  times[MAXREPS];  /* execution times of repetitions */
+
+/*----------------------------------------------------------------------
+  Main Functions
+----------------------------------------------------------------------*/
+
+#ifndef NDEBUG                  /* if debug version */
+  #undef  CLEANUP               /* clean up memory and close files */
+  #define CLEANUP \
+  if (tread)  trd_delete(tread, 1); \
+  if (table)  tab_delete(table, 0); \
+  if (attset) as_delete(attset);    \
+  if (pats)   free(pats);           \
+  if (mlp)    mlp_delete(mlp);      \
+  if (out && (out != stdout)) fclose(out);
+#endif
+
+GENERROR(error, exit)           /* generic error reporting function */
+
+/*--------------------------------------------------------------------*/
+
+static int dblcmp (const void *p1, const void *p2)
+{                               /* --- compare two doubles */
+  double a = *(const double*)p1, b = *(const double*)p2;
+  return (a < b) ? -1 : (a > b) ? +1 : 0;
+}  /* dblcmp() */
+
+/*--------------------------------------------------------------------*/
+
+static double clkovh (void)
+{                               /* --- measure clock query overhead */
+  int    i;                     /* loop variable */
+  double t, s[MAXREPS];         /* times of clock query pairs */
+
+  for (i = 0; i < MAXREPS; i++) {
+    t = tms_clock();            /* measure the time between */
+    s[i] = tms_clock() -t;      /* two consecutive clock queries */
+  }
+  qsort(s, MAXREPS, sizeof(double), dblcmp);
+  return s[MAXREPS/2];          /* return the median overhead */
+}  /* clkovh() */
+
+/*--------------------------------------------------------------------*/
+
+static double heapmem (void)
+{                               /* --- get size of used heap memory */
+  #if defined __GLIBC__ && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+  return (double)mallinfo2().uordblks;
+  #else                         /* if the heap can be inspected, */
+  return -1;                    /* return the allocated bytes, */
+  #endif                        /* otherwise return a failure */
+}  /* heapmem() */
+
+/*--------------------------------------------------------------------*/
+
+static void result (const char *kernel, const char *net, DIMID wgts,
+                    double items, int reps)
+{                               /* --- print a benchmark result */
+  int    i;                     /* loop variable */
+  double mean, var, med, d;     /* statistics of the times */
+
+  for (mean = 0, i = 0; i < reps; i++)
+    mean += times[i];           /* compute the mean time */
+  mean /= (double)reps;         /* of the repetitions */
+  for (var = 0, i = 0; i < reps; i++) {
+    d = times[i] -mean; var += d*d; }
+  var = (reps > 1) ? var /(double)(reps-1) : 0;
+  qsort(times, (size_t)reps, sizeof(double), dblcmp);
+  med = (reps & 1) ? times[reps/2]
+      : 0.5 *(times[reps/2-1] +times[reps/2]);
+  fprintf(out, "%-16s %-20s %8"DIMID_FMT" %8.0f", kernel, net,
+          wgts, items);         /* print the kernel and network */
+  fprintf(out, " %11.4e %11.4e %11.4e %11.4e %10.2f\n",
+          med, mean, var, times[0], (items > 0) ? 1e9*med/items : 0);
+}  /* result() */               /* print the time statistics */
+
+/*--------------------------------------------------------------------*/
+
+static void bench (DIMID *ucnts, int lyrcnt, DIMID n,
+                   int reps, unsigned int seed)
+{                               /* --- benchmark a network */
+  int    i, k, r;               /* loop variables */
+  DIMID  p;                     /* loop variable for patterns */
+  DIMID  x, o, dim;             /* numbers of inputs and outputs */
+  double *pat;                  /* to traverse the patterns */
+  double t, s;                  /* for time measurements */
+  char   net[64];               /* description of the network */
+  char   kernel[32];            /* name of the benchmarked kernel */
+
+  for (k = 0, i = 0; (i < lyrcnt) && (k < 48); i++)
+    k += sprintf(net +k, (i > 0) ? "-%"DIMID_FMT : "%"DIMID_FMT,
+                 ucnts[i]);     /* describe the network structure */
+  mlp = mlp_create(lyrcnt, ucnts);
+  if (!mlp) error(E_NOMEM);     /* create a multilayer perceptron */
+  x = ucnts[0]; o = ucnts[lyrcnt-1]; dim = x+o;
+  rseed(seed);                  /* init. the random number generator */
+  pats = (double*)malloc((size_t)n *(size_t)dim *sizeof(double));
+  if (!pats) error(E_NOMEM);    /* create the pattern buffer */
+  for (pat = pats, p = 0; p < n; p++) {
+    for (i = 0; i < x; i++) *pat++ = 2*drand() -1;
+    for (i = 0; i < o; i++) *pat++ = (drand() < 0.5) ? 0 : 1;
+  }                             /* generate random patterns */
+  mlp_init(mlp, drand, 1.0);    /* (inputs in [-1,1], binary targets) */
+  mlp_setup(mlp);               /* initialize the weights and */
+                                /* set the network up for training */
+  /* --- forward pass --- */
+  for (r = -1; r < reps; r++) { /* (first repetition is a warm-up) */
+    t = tms_clock();            /* execute the network */
+    for (p = 0; p < n; p++)     /* for all patterns */
+      mlp_exec(mlp, pats +(size_t)p *(size_t)dim, NULL);
+    if (r >= 0) times[r] = tms_clock() -t;
+  }
+  result("exec", net, mlp_wgtcnt(mlp), (double)n, reps);
+
+  /* --- backpropagation --- */
+  for (r = -1; r < reps; r++) { /* traverse the repetitions */
+    for (s = 0, p = 0; p < n; p++) {
+      pat = pats +(size_t)p *(size_t)dim;
+      mlp_exec(mlp, pat, NULL); /* execute the network (not timed) */
+      t = tms_clock();          /* and backpropagate the errors */
+      mlp_bkprop(mlp, pat +x);  /* (time only the backpropagation) */
+      s += tms_clock() -t -ovh;
+    }
+    if (r >= 0) times[r] = s;   /* note the accumulated time */
+  }
+  result("bkprop", net, mlp_wgtcnt(mlp), (double)n, reps);
+
+  /* --- weight updates --- */
+  for (k = 0; k < 2*MTHCNT; k++) {
+    rseed(seed);                /* start all methods from */
+    mlp_init(mlp, drand, 1.0);  /* the same initial weights */
+    mlp_method(mlp, methods[k % MTHCNT] | ((k < MTHCNT) ? 0:MLP_SCALAR));
+    mlp_setup(mlp);             /* set the update method */
+    for (r = -1; r < reps; r++) {
+      for (s = 0, p = 0; p < n; p++) {
+        pat = pats +(size_t)p *(size_t)dim;
+        mlp_exec(mlp, pat, NULL);   /* compute gradients (not timed) */
+        mlp_bkprop(mlp, pat +x);    /* and update the weights */
+        t = tms_clock();        /* (time only the update) */
+        mlp_update(mlp);
+        s += tms_clock() -t -ovh;
+      }
+      if (r >= 0) times[r] = s; /* note the accumulated time */
+    }
+    sprintf(kernel, "%s:%s", (k < MTHCNT) ? "update" : "scalar",
+            mthnames[k % MTHCNT]);
+    result(kernel, net, mlp_wgtcnt(mlp), (double)n, reps);
+  }
+
+  free(pats);   pats = NULL;    /* delete the patterns */
+  mlp_delete(mlp); mlp = NULL;  /* and the network */
+}  /* bench() */
+
+/*--------------------------------------------------------------------*/
+
+static void rdbench (CCHAR *fn_tab, int reps)
+{                               /* --- benchmark reading a table */
+  int    m, r, k;               /* loop variables, error code */
+  double t;                     /* for time measurements */
+  double n = 0;                 /* number of read tuples */
+  double b, mem[2];             /* sizes of used heap memory */
+  CCHAR  *name;                 /* base name of the table file */
+
+  name = strrchr(fn_tab, '/');  /* get the base name of the file */
+  name = (name) ? name+1 : fn_tab;
+  for (m = 0; m < 2; m++) {     /* traverse the memory modes */
+    for (r = -1; r < reps; r++) {   /* (first rep. is a warm-up) */
+      tread = trd_create();     /* create a table reader */
+      if (!tread) error(E_NOMEM);   /* with default characters */
+      trd_allchs(tread, NULL, NULL, NULL, "", NULL);
+      b = heapmem();            /* note the used heap memory */
+      attset = as_create("domains", att_delete);
+      if (!attset) error(E_NOMEM);  /* create an attribute set */
+      table  = tab_create("table", attset, tpl_delete);
+      if (!table)  error(E_NOMEM);  /* and a table to read into */
+      if (m > 0) {              /* if to use memory systems, */
+        as_valmem (attset, VALBLK);   /* set them up for the */
+        tab_tplmem(table,  TPLBLK);   /* values and the tuples */
+      }
+      t = tms_clock();          /* open and read the table file */
+      if (trd_open(tread, NULL, fn_tab) != 0)
+        error(E_FOPEN, trd_name(tread));
+      k = tab_read(table, tread, AS_ATT);
+      if (k < 0) error(-k, tab_errmsg(table, NULL, 0));
+      trd_close(tread);         /* read and close the table file */
+      if (r >= 0) times[r] = tms_clock() -t;
+      mem[m] = (b < 0) ? -1 : heapmem() -b;
+      n = (double)tab_tplcnt(table);
+      tab_delete(table, 0); table  = NULL;
+      as_delete(attset);    attset = NULL;
+      trd_delete(tread, 1); tread  = NULL;
+    }                           /* delete the table and reader */
+    result(memnames[m], name, 0, n, reps);
+  }                             /* print the time statistics */
+  if (mem[0] < 0) {             /* if the heap cannot be inspected */
+    fprintf(out, "# %s: heap memory not available\n", name); return; }
+  fprintf(out, "# %s: heap %.0f bytes (%.1f/tuple),"
+               " memsys %.0f bytes (%.1f/tuple), ratio %.3f\n",
+          name, mem[0], (n > 0) ? mem[0]/n : 0,
+                mem[1], (n > 0) ? mem[1]/n : 0,
+          (mem[0] > 0) ? mem[1]/mem[0] : 0);
+}  /* rdbench() */
+
+/*--------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                               /* --- main function */
+  int     i, k = 0;             /* loop variables, buffers */
+  char    *s, *e;               /* to traverse options and layers */
+  CCHAR   **optarg = NULL;      /* option argument */
+  CCHAR   *fn_out  = NULL;      /* name of output file */
+  CCHAR   *hidden  = "8,32,128,32:32,32:32:32";  /* hidden layers */
+  DIMID   incnt    = 16;        /* number of input  units */
+  DIMID   outcnt   = 4;         /* number of output units */
+  DIMID   n        = 1000;      /* number of patterns */
+  int     reps     = 9;         /* number of repetitions */
+  long    seed     = 1;         /* seed for random numbers */
+  int     lyrcnt;               /* number of layers */
+  DIMID   ucnts[MLP_MAXLAYER];  /* number of units per layer */
+  int     tabcnt   = 1;         /* end index of table file names */
+  clock_t t;                    /* for time measurements */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+
+  /* --- print startup/usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", argv[0], DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument is given */
+    printf("usage: %s [options] outfile [tabfile ...]\n", argv[0]);
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-i#      number of input  units                 "
+                    "(default: %"DIMID_FMT")\n", incnt);
+    printf("-o#      number of output units                 "
+                    "(default: %"DIMID_FMT")\n", outcnt);
+    printf("-c#      hidden layers of benchmarked networks  "
+                    "(default: %s)\n", hidden);
+    printf("         (networks separated by ',', layers by ':', "
+                    "0: no hidden layer)\n");
+    printf("-n#      number of synthetic patterns           "
+                    "(default: %"DIMID_FMT")\n", n);
+    printf("-r#      number of repetitions                  "
+                    "(default: %d)\n", reps);
+    printf("-s#      seed for random number generator       "
+                    "(default: %ld)\n", seed);
+    printf("outfile  file to write the benchmark results to "
+                    "(\"-\": stdout)\n");
+    printf("tabfile  table file(s) to benchmark reading on "
+                    "(optional)\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  for (i = 1; i < argc; i++) {  /* traverse arguments */
+    s = argv[i];                /* get option argument */
+    if (optarg) { *optarg = s; optarg = NULL; continue; }
+    if ((*s == '-') && *++s) {  /* -- if argument is an option */
+      while (1) {               /* traverse characters */
+        switch (*s++) {         /* evaluate option */
+          case 'i': incnt  = (DIMID)strtol(s, &s, 0); break;
+          case 'o': outcnt = (DIMID)strtol(s, &s, 0); break;
+          case 'c': optarg = &hidden;                 break;
+          case 'n': n      = (DIMID)strtol(s, &s, 0); break;
+          case 'r': reps   = (int)  strtol(s, &s, 0); break;
+          case 's': seed   =        strtol(s, &s, 0); break;
+          default : error(E_OPTION, *--s);            break;
+        }                       /* set option variables */
+        if (!*s) break;         /* if at end of string, abort loop */
+        if (optarg) { *optarg = s; optarg = NULL; break; }
+      } }                       /* get option argument */
+    else {                      /* -- if argument is no option */
+      if (k++ <= 0) fn_out = s; /* note the output file name */
+      else argv[tabcnt++] = s;  /* and collect the table file names */
+    }                           /* at the front of the argument */
+  }                             /* vector (already evaluated) */
+  if (optarg) error(E_OPTARG);  /* check option argument */
+  if (k < 1)  error(E_ARGCNT);  /* check the number of arguments */
+  if (incnt  <= 0) error(E_UNITCNT, incnt);
+  if (outcnt <= 0) error(E_UNITCNT, outcnt);
+  if (n      <= 0) error(E_PATCNT,  n);
+  if (reps < 1)       reps = 1; /* check the number of units */
+  if (reps > MAXREPS) reps = MAXREPS;  /* and patterns and */
+  fputc('\n', stderr);          /* the number of repetitions */
+
+  /* --- open the output file --- */
+  if (strcmp(fn_out, "-") == 0) fn_out = "";
+  if (*fn_out) { out = fopen(fn_out, "w"); }
+  else         { out = stdout; fn_out = "<stdout>"; }
+  if (!out) error(E_FOPEN, fn_out);
+  ovh = clkovh();               /* measure the clock overhead */
+  fprintf(out, "# %s %s", PRGNAME, VERSION);
+  fprintf(out, "\n# %s precision, %"DIMID_FMT" pattern(s),"
+               " %d repetition(s), seed %ld, clock overhead %.1fns\n",
+          (sizeof(MLPVAL) == sizeof(float)) ? "single" : "double",
+          n, reps, seed, 1e9*ovh);
+  fprintf(out, "%-16s %-20s %8s %8s %11s %11s %11s %11s %10s\n",
+          "# kernel", "network", "weights", "items", "median[s]",
+          "mean[s]", "var[s^2]", "min[s]", "ns/item");
+
+  /* --- benchmark the networks --- */
+  for (s = (char*)hidden; *s; ) {
+    t = clock();                /* start the timer */
+    ucnts[0] = incnt;           /* traverse the network descriptions */
+    for (lyrcnt = 1; 1; ) {     /* parse the hidden layers */
+      ucnts[lyrcnt] = (DIMID)strtol(s, &e, 0);
+      if ((e == s) || (ucnts[lyrcnt] < 0)) error(E_LAYERS, hidden);
+      if (ucnts[lyrcnt] > 0) lyrcnt++;
+      if (lyrcnt >= MLP_MAXLAYER) error(E_LAYERS, hidden);
+      s = e; if (*s != ':') break; s++;
+    }                           /* (a zero denotes no hidden layer) */
+    if (*s && (*s++ != ',')) error(E_LAYERS, hidden);
+    ucnts[lyrcnt++] = outcnt;   /* add the output layer */
+    fprintf(stderr, "benchmarking network ... ");
+    bench(ucnts, lyrcnt, n, reps, (unsigned int)seed);
+    fprintf(stderr, "[%d layer(s)] done [%.2fs].\n", lyrcnt,
+            SEC_SINCE(t));
+  }                             /* benchmark the network kernels */
+
+  /* --- benchmark reading tables --- */
+  for (i = 1; i < tabcnt; i++) {
+    t = clock();                /* traverse the table files */
+    fprintf(stderr, "reading %s ... ", argv[i]);
+    rdbench(argv[i], reps);     /* benchmark reading a table file */
+    fprintf(stderr, "done [%.2fs].\n", SEC_SINCE(t));
+  }
+
+  /* --- close the output file --- */
+  if (((out == stdout) ? fflush(out) : fclose(out)) != 0)
+    error(E_FWRITE, fn_out);    /* close the output file */
+  out = NULL;                   /* and clear the variable */
+
+  /* --- clean up --- */
+  #ifdef STORAGE                /* if storage debugging */
+  showmem("at end of program"); /* check memory usage */
+  #endif
+  return 0;                     /* return 'ok' */
+}  /* main() */
@@ -0,0 +1,221 @@
+/*----------------------------------------------------------------------
+  File    : mlpc.c
+  Contents: multilayer perceptron file conversion (text <-> binary)
+  Author  : Christian Borgelt
+  History : 2016.05.12 file created from file mlps.c
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#ifndef AS_DESC
+#define AS_DESC
+#endif
+#ifndef AS_PARSE
+#define AS_PARSE
+#endif
+#include "attset.h"
+#ifndef MLP_PARSE
+#define MLP_PARSE
+#endif
+#ifndef MLP_EXTFN
+#define MLP_EXTFN
+#endif
+#include "mlp.h"
+#include "error.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "mlpc"
+#define DESCRIPTION "multilayer perceptron file conversion"
+#define VERSION     "version 1.0 (2016.05.12)         " \
+                    "(c) 2016        Christian Borgelt"
+
+/* --- error codes --- */
+/* error codes 0 to -5 defined in attset.h */
+#define E_OPTION     (-6)       /* unknown option */
+#define E_OPTARG     (-7)       /* missing option argument */
+#define E_ARGCNT     (-8)       /* wrong number of arguments */
+#define E_PARSE      (-9)       /* parse errors on input file */
+#define E_BINARY    (-10)       /* invalid binary network file */
+
+#define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {   /* error messages */
+  /* E_NONE      0 */  "no error",
+  /* E_NOMEM    -1 */  "not enough memory",
+  /* E_FOPEN    -2 */  "cannot open file %s",
+  /* E_FREAD    -3 */  "read error on file %s",
+  /* E_FWRITE   -4 */  "write error on file %s",
+  /* E_STDIN    -5 */  "double assignment of standard input",
+  /* E_OPTION   -6 */  "unknown option -%c",
+  /* E_OPTARG   -7 */  "missing option argument",
+  /* E_ARGCNT   -8 */  "wrong number of arguments",
+  /* E_PARSE    -9 */  "parse error(s) on file %s",
+  /* E_BINARY  -10 */  "invalid binary network file %s",
+  /*           -11 */  "unknown error",
+};
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static CCHAR   *prgname;        /* program name for error messages */
+static SCANNER *scan   = NULL;  /* scanner (multilayer perceptron) */
+static ATTSET  *attset = NULL;  /* attribute set */
+static ATTMAP  *attmap = NULL;  /* attribute map */
+static MLP     *mlp    = NULL;  /* multilayer perceptron */
+static FILE    *out    = NULL;  /* output file */
+
+/*----------------------------------------------------------------------
+  Main Functions
+----------------------------------------------------------------------*/
+
+#ifndef NDEBUG                  /* if debug version */
+  #undef  CLEANUP               /* clean up memory and close files */
+  #define CLEANUP \
+  if (mlp)    mlp_deletex(mlp,  0); \
+  if (attmap) am_delete(attmap, 0); \
+  if (attset) as_delete(attset);    \
+  if (scan)   scn_delete(scan,  1); \
+  if (out && (out != stdout)) fclose(out);
+#endif
+
+GENERROR(error, exit)           /* generic error reporting function */
+
+/*--------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                               /* --- main function */
+  int     i, k = 0;             /* loop variables, buffers */
+  char    *s;                   /* to traverse options */
+  CCHAR   **optarg = NULL;      /* option argument */
+  CCHAR   *fn_in   = NULL;      /* name of input  network file */
+  CCHAR   *fn_out  = NULL;      /* name of output network file */
+  int     matinp   =  0;        /* flag for numerical matrix input */
+  int     bin      =  0;        /* flag for binary input  file */
+  int     bout     = -1;        /* flag for binary output file */
+  int     maxlen   =  0;        /* maximal output line length */
+  MLPBIN  hdr;                  /* header of binary network file */
+  clock_t t;                    /* for time measurements */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+
+  /* --- print startup/usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", argv[0], DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument is given */
+    printf("usage: %s [options] infile outfile\n", argv[0]);
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-b       write a binary file "
+                    "(default: if input is a text file)\n");
+    printf("-t       write a text   file "
+                    "(default: if input is a binary file)\n");
+    printf("-l#      output line length                     "
+                    "(default: no limit)\n");
+    printf("infile   file to read neural network from "
+                    "(text or binary)\n");
+    printf("outfile  file to write neural network to\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  for (i = 1; i < argc; i++) {  /* traverse arguments */
+    s = argv[i];                /* get option argument */
+    if (optarg) { *optarg = s; optarg = NULL; continue; }
+    if ((*s == '-') && *++s) {  /* -- if argument is an option */
+      while (1) {               /* traverse characters */
+        switch (*s++) {         /* evaluate option */
+          case 'b': bout   = 1;                        break;
+          case 't': bout   = 0;                        break;
+          case 'l': maxlen = (int)strtol(s, &s, 0);    break;
+          default : error(E_OPTION, *--s);             break;
+        }                       /* set option variables */
+        if (!*s) break;         /* if at end of string, abort loop */
+        if (optarg) { *optarg = s; optarg = NULL; break; }
+      } }                       /* get option argument */
+    else {                      /* -- if argument is no option */
+      switch (k++) {            /* evaluate non-option */
+        case  0: fn_in  = s;      break;
+        case  1: fn_out = s;      break;
+        default: error(E_ARGCNT); break;
+      }                         /* note filenames */
+    }
+  }
+  if (optarg) error(E_OPTARG);  /* check option argument */
+  if (k != 2) error(E_ARGCNT);  /* and the number of arguments */
+  fputc('\n', stderr);          /* terminate the startup message */
+
+  /* --- read multilayer perceptron --- */
+  scan = scn_create();          /* create a scanner */
+  if (!scan) error(E_NOMEM);    /* for the multilayer perceptron */
+  t = clock();                  /* start timer, open input file */
+  if (scn_open(scan, NULL, fn_in) != 0)
+    error(E_FOPEN, scn_name(scan));
+  fprintf(stderr, "reading %s ... ", scn_name(scan));
+  if (fn_in && *fn_in) {        /* if not reading from stdin, */
+    bin = mlp_binchk(scn_file(scan), &hdr);  /* check for binary */
+    if (bin < 0) error(E_BINARY, scn_name(scan));
+  }                             /* (skip header and weights) */
+  matinp = (scn_first(scan) == T_ID)
+        && (strcmp(scn_value(scan), "dom") != 0);
+  if (matinp)                   /* if matrix version */
+    mlp = mlp_parse(scan);      /* parse the input network */
+  else {                        /* if table version */
+    attset = as_create("domains", att_delete);
+    if (!attset) error(E_NOMEM);      /* create an attribute set */
+    if (as_parse(attset, scan, AT_ALL, 1) != 0)
+      error(E_PARSE, scn_name(scan)); /* parse domain descriptions */
+    attmap = am_create(attset, 0, 1.0);
+    if (!attmap) error(E_NOMEM);/* create an attribute map */
+    mlp = mlp_parsex(scan, attmap);
+  }                             /* parse the multilayer perceptron */
+  if (!mlp || !scn_eof(scan, 1)) error(E_PARSE, scn_name(scan));
+  if (mlp_binwgts(mlp, scn_file(scan), (bin) ? &hdr : NULL) != 0)
+    error(E_BINARY, scn_name(scan));  /* get the binary weights */
+  scn_delete(scan, 1);          /* delete the scanner and */
+  scan = NULL;                  /* print a log message */
+  fprintf(stderr, "[%"DIMID_FMT" unit(s),", mlp_unitcnt(mlp));
+  fprintf(stderr, " %"DIMID_FMT" weight(s), %s]", mlp_wgtcnt(mlp),
+                  (bin) ? "binary" : "text");
+  fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+  if (bout < 0) bout = !bin;    /* by default convert to other form */
+
+  /* --- write multilayer perceptron --- */
+  t = clock();                  /* start timer, open output file */
+  if (fn_out && (strcmp(fn_out, "-") == 0)) fn_out = "";
+  if (fn_out && *fn_out) { out = fopen(fn_out, (bout) ? "wb" : "w"); }
+  else                   { out = stdout; fn_out = "<stdout>"; }
+  fprintf(stderr, "writing %s ... ", fn_out);
+  if (!out) error(E_FOPEN, fn_out);
+  if (bout && (mlp_binsave(mlp, out) != 0))
+    error(E_FWRITE, fn_out);    /* write header and weights */
+  if (!matinp) {                /* if table version */
+    if (as_desc(attset, out, AS_TITLE|AS_IVALS, maxlen) != 0)
+      error(E_FWRITE, fn_out);  /* describe attribute domains */
+    fprintf(out, "\n");         /* leave one line empty */
+  }
+  if (mlp_desc(mlp, out, MLP_TITLE|MLP_INFO |(bout ? MLP_BINWGTS : 0),
+               maxlen) != 0)    /* describe the multilayer perceptron */
+    error(E_FWRITE, fn_out);    /* (without weights if binary) */
+  if (((out == stdout) ? fflush(out) : fclose(out)) != 0)
+    error(E_FWRITE, fn_out);    /* close the output file */
+  out = NULL;                   /* print a success message */
+  fprintf(stderr, "[%s] done [%.2fs].\n", (bout) ? "binary" : "text",
+                  SEC_SINCE(t));
+
+  /* --- clean up --- */
+  CLEANUP;                      /* clean up memory and close files */
+  SHOWMEM;                      /* show (final) memory usage */
+  return 0;                     /* return 'ok' */
+}  /* main() */
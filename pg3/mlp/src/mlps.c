@@ -11,6 +11,10 @@
             2011.12.15 processing without table reading improved
             2013.08.12 adapted to definitions ATTID, VALID, TPLID etc.
             2014.10.24 changed from LGPL license to MIT license
+            2016.05.12 binary network files detected automatically
+            2016.05.16 option -t# added (parallel sensitivity analysis)
+            2016.05.16 options -Q#, -K# added (phase timing report)
+            2016.05.16 -t# <= 0 means one thread per processor
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -44,6 +48,8 @@
 #define MLP_EXTFN
 #endif
 #include "mlp.h"
+#include "thread.h"
+#include "tmstat.h"
 #include "error.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -65,16 +71,45 @@
 #define E_PARSE      (-9)       /* parse errors on input file */
 #define E_PATCNT    (-10)       /* no pattern found */
 #define E_PATSIZE   (-11)       /* invalid pattern size */
+#define E_BINARY    (-12)       /* invalid binary network file */
+#define E_THREAD    (-13)       /* cannot create threads */
 
 #define INPUT       "input"
 #define HIDDEN      "hidden"
 #define OUTPUT      "output"
 
+#define BATCHSIZE   1024        /* number of patterns per batch */
+
+/* --- timed phases --- */
+#define PH_READ      0          /* reading the input files */
+#define PH_ENCODE    1          /* encoding the patterns */
+#define PH_FORWARD   2          /* forward pass (execution) */
+#define PH_JACOBIAN  3          /* Jacobian and sensitivities */
+#define PH_OUTPUT    4          /* writing the sensitivities */
+#define PH_CNT       5          /* number of timed phases */
+
 #define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
 
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- sensitivity job for threads --- */
+  int     thcnt;                /* number of threads in team */
+  int     ext;                  /* flag for attribute sensitivities */
+  int     mode;                 /* sensitivity aggregation mode */
+  DIMID   dim;                  /* number of values per pattern */
+  DIMID   cnt;                  /* number of sensitivity values */
+  DIMID   n;                    /* number of patterns in batch */
+  int     timed;                /* flag for timing the phases */
+  double  secs[THR_MAXCNT][2];  /* forward/Jacobian times */
+} SENSJOB;                      /* (sensitivity job) */
+
 /*----------------------------------------------------------------------
   Constants
 ----------------------------------------------------------------------*/
+static const char *const phases[PH_CNT] = {  /* names of phases */
+  "read", "encode", "forward", "jacobian", "output" };
+
 static const char *errmsgs[] = {   /* error messages */
   /* E_NONE      0 */  "no error",
   /* E_NOMEM    -1 */  "not enough memory",
@@ -88,7 +123,9 @@ static const char *errmsgs[] = {   /* error messages */
   /* E_PARSE    -9 */  "parse error(s) on file %s",
   /* E_PATCNT  -10 */  "no pattern in file %s",
   /* E_PATSIZE -11 */  "invalid pattern size %"DIMID_FMT,
-  /*           -12 */  "unknown error",
+  /* E_BINARY  -12 */  "invalid binary network file %s",
+  /* E_THREAD  -13 */  "cannot create %d thread(s)",
+  /*           -14 */  "unknown error",
 };
 
 /*----------------------------------------------------------------------
@@ -102,20 +139,40 @@ static ATTMAP  *attmap = NULL;  /* attribute map */
 static MLP     *mlp    = NULL;  /* multilayer perceptron */
 static FILE    *out    = NULL;  /* output file */
 static double  *sens   = NULL;  /* sensitivity values */
+static double  *pats   = NULL;  /* batch of patterns/input vectors */
+static THRTEAM *team   = NULL;  /* team of worker threads */
+static MLPCTX  *ctxs[THR_MAXCNT];  /* execution contexts for threads */
+static TMSTAT  *tms    = NULL;  /* phase timing statistics */
+static FILE    *rep    = NULL;  /* timing report file */
 
 /*----------------------------------------------------------------------
   Main Functions
 ----------------------------------------------------------------------*/
 
+static void delthr (void)
+{                               /* --- delete threads and contexts */
+  int i;                        /* loop variable */
+
+  if (team) { thr_delete(team); team = NULL; }
+  for (i = 0; i < THR_MAXCNT; i++) {
+    if (ctxs[i]) { mlp_ctxdelete(ctxs[i]); ctxs[i] = NULL; } }
+}  /* delthr() */               /* delete the execution contexts */
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG                  /* if debug version */
   #undef  CLEANUP               /* clean up memory and close files */
   #define CLEANUP \
+  delthr();                         \
+  if (pats)   free(pats);           \
   if (sens)   free(sens);           \
   if (mlp)    mlp_deletex(mlp,  0); \
   if (attmap) am_delete(attmap, 0); \
   if (attset) as_delete(attset);    \
   if (tread)  trd_delete(tread, 1); \
   if (scan)   scn_delete(scan,  1); \
+  if (tms)    tms_delete(tms);      \
+  if (rep && (rep != stdout)) fclose(rep); \
   if (out && (out != stdout)) fclose(out);
 #endif
 
@@ -123,6 +180,66 @@ GENERROR(error, exit)           /* generic error reporting function */
 
 /*--------------------------------------------------------------------*/
 
+static void senspats (void *data, int id)
+{                               /* --- sensitivities of a batch part */
+  SENSJOB *job = (SENSJOB*)data;/* sensitivity job to execute */
+  MLPCTX  *ctx = ctxs[id];      /* execution context of the thread */
+  double  *acc;                 /* sensitivity sums of the thread */
+  DIMID   i, e;                 /* range of patterns to process */
+  double  t[3] = { 0, 0, 0 };   /* for time measurements */
+
+  acc = sens +(size_t)id *(size_t)job->cnt;
+  i = (DIMID)(((size_t)job->n *(size_t) id)    /(size_t)job->thcnt);
+  e = (DIMID)(((size_t)job->n *(size_t)(id+1)) /(size_t)job->thcnt);
+  for ( ; i < e; i++) {         /* traverse the thread's patterns */
+    if (job->timed) t[0] = tms_clock();
+    mlp_execc(ctx, pats +(size_t)i *(size_t)job->dim, NULL);
+    if (job->timed) t[1] = tms_clock();
+    if (job->ext) mlp_sensvxc(ctx, acc, job->mode);
+    else          mlp_sensvc (ctx, acc, job->mode);
+    if (!job->timed) continue;  /* execute the network and add */
+    t[2] = tms_clock();         /* the sensitivities of all inputs */
+    job->secs[id][0] += t[1] -t[0];
+    job->secs[id][1] += t[2] -t[1];
+  }                             /* sum the busy times of the thread */
+}  /* senspats() */
+
+/*--------------------------------------------------------------------*/
+
+static void batch (SENSJOB *job)
+{                               /* --- process a batch of patterns */
+  int i;                        /* loop variable */
+
+  if (!tms) { thr_run(team, senspats, job); return; }
+  TMS_END(tms);                 /* (the threads time their phases) */
+  memset(job->secs, 0, (size_t)job->thcnt *sizeof(job->secs[0]));
+  thr_run(team, senspats, job); /* compute the sensitivities */
+  for (i = 0; i < job->thcnt; i++) {
+    tms_add(tms, PH_FORWARD,  job->secs[i][0]);
+    tms_add(tms, PH_JACOBIAN, job->secs[i][1]);
+  }                             /* sum the busy times of the threads */
+}  /* batch() */
+
+/*--------------------------------------------------------------------*/
+
+/* Per pattern, the forward pass needs about 2 operations per weight */
+/* (multiply and add) and the Jacobian matrix about 2 operations per */
+/* weight and output unit (one matrix product per layer). Activation */
+/* functions and the aggregation are not counted (estimate only).    */
+
+static int report (double pats, double wgts, double outs)
+{                               /* --- write the timing report */
+  int r;                        /* result of writing the report */
+
+  tms_count(tms, pats, 2*wgts*(1+outs)*pats);
+  r = tms_report(tms);          /* write report for the whole run */
+  if ((rep != stdout) && (fclose(rep) != 0)) r = -1;
+  rep = NULL;                   /* close the report file */
+  return r;                     /* return the write result */
+}  /* report() */
+
+/*--------------------------------------------------------------------*/
+
 int main (int argc, char *argv[])
 {                               /* --- main function */
   int     i, k = 0;             /* loop variables, buffers */
@@ -132,20 +249,26 @@ int main (int argc, char *argv[])
   CCHAR   *fn_mlp  = NULL;      /* name of network file */
   CCHAR   *fn_tab  = NULL;      /* name of input pattern file */
   CCHAR   *fn_out  = NULL;      /* name of output file */
+  CCHAR   *fn_rep  = NULL;      /* name of timing report file */
   CCHAR   *blanks  = NULL;      /* blank   characters */
   CCHAR   *fldseps = NULL;      /* field   separators */
   CCHAR   *recseps = NULL;      /* record  separators */
   CCHAR   *comment = NULL;      /* comment characters */
   int     matinp   =  0;        /* flag for numerical matrix input */
+  int     bin      =  0;        /* flag for binary network file */
+  MLPBIN  hdr;                  /* header of binary network file */
   int     mode     = AS_ATT|AS_NOXATT;    /* table file read flags */
   DIMID   dim      = -1;        /* data point/pattern dimension */
   int     magg     = MLP_MAX;   /* mode for sensitivity aggregation */
   int     norm     = 1;         /* normalize sensitivity */
   int     digs     = 6;         /* significant digits for sensitivity */
+  int     thcnt    = 1;         /* number of threads */
+  int     repmode  = TMS_JSON;  /* mode for the timing report */
+  SENSJOB job;                  /* sensitivity job for threads */
   double  *pat;                 /* to traverse the patterns */
-  TPLID   n;                    /* number of data tuples */
+  TPLID   n = 0;                /* number of data tuples */
   DIMID   x, o, c;              /* number of dimensions/fields */
-  DIMID   p = 0;                /* number of patterns */
+  DIMID   p = 0, b;             /* number of patterns, batch size */
   double  w;                    /* weight of data tuples, buffer */
   clock_t t;                    /* for time measurements */
 
@@ -168,6 +291,15 @@ int main (int argc, char *argv[])
                     "(do not divide by number of patterns)\n");
     printf("-o#      significant digits for sensitivity     "
                     "(default: %d)\n", digs);
+    printf("-t#      number of threads                      "
+                    "(default: %d)\n", thcnt);
+    printf("         (<= 0: one per processor)\n");
+    printf("-Q#      file to write a timing report to       "
+                    "(default: none)\n");
+    printf("-K#      timing report mode                     "
+                    "(default: %d)\n", repmode);
+    printf("         (0: JSON, 1: CSV; phase times, patterns "
+                    "and flops per second)\n");
     printf("-r#      record  separators                     "
                     "(default: \"\\n\")\n");
     printf("-f#      field   separators                     "
@@ -176,7 +308,8 @@ int main (int argc, char *argv[])
                     "(default: \" \\t\\r\")\n");
     printf("-C#      comment characters                     "
                     "(default: \"#\")\n");
-    printf("mlpfile  file to read neural network from\n");
+    printf("mlpfile  file to read neural network from "
+                    "(text or binary)\n");
     printf("-d       use default header "
                     "(attribute names = field numbers)\n");
     printf("-h       read table header  "
@@ -199,6 +332,9 @@ int main (int argc, char *argv[])
           case 's': magg  |= MLP_SUM;      break;
           case 'i': magg  |= MLP_SUMIN;    break;
           case 'n': norm   = 0;            break;
+          case 't': thcnt = (int)strtol(s, &s, 0); break;
+          case 'Q': optarg = &fn_rep;      break;
+          case 'K': repmode = (int)strtol(s, &s, 0); break;
           case 'r': optarg = &recseps;     break;
           case 'f': optarg = &fldseps;     break;
           case 'b': optarg = &blanks;      break;
@@ -228,15 +364,28 @@ int main (int argc, char *argv[])
   if  (!fn_mlp || !*fn_mlp) i++;
   if  (!fn_tab || !*fn_tab) i++;
   if (i > 1) error(E_STDIN);    /* stdin must not be used twice */
+  if (fn_rep) {                 /* if to write a timing report */
+    if (strcmp(fn_rep, "-") == 0) fn_rep = "";
+    if (*fn_rep) { rep = fopen(fn_rep, "w"); }
+    else         { rep = stdout; fn_rep = "<stdout>"; }
+    if (!rep) error(E_FOPEN, fn_rep);
+    tms = tms_create(PRGNAME, phases, PH_CNT, rep, repmode &TMS_CSV);
+    if (!tms) error(E_NOMEM);   /* create the timing statistics */
+  }                             /* (there are no epochs to report) */
   fputc('\n', stderr);          /* terminate the startup message */
 
   /* --- read multilayer perceptron --- */
+  TMS_BEG(tms, PH_READ);        /* time reading the network */
   scan = scn_create();          /* create a scanner */
   if (!scan) error(E_NOMEM);    /* for the multilayer perceptron */
   t = clock();                  /* start timer, open input file */
   if (scn_open(scan, NULL, fn_mlp) != 0)
     error(E_FOPEN, scn_name(scan));
   fprintf(stderr, "reading %s ... ", scn_name(scan));
+  if (fn_mlp && *fn_mlp) {      /* if not reading from stdin, */
+    bin = mlp_binchk(scn_file(scan), &hdr);  /* check for binary */
+    if (bin < 0) error(E_BINARY, scn_name(scan));
+  }                             /* (skip header and weights) */
   matinp = (scn_first(scan) == T_ID)
         && (strcmp(scn_value(scan), "dom") != 0);
   if (matinp)                   /* if matrix version */
@@ -251,15 +400,33 @@ int main (int argc, char *argv[])
     mlp = mlp_parsex(scan, attmap);
   }                             /* parse the multilayer perceptron */
   if (!mlp || !scn_eof(scan, 1)) error(E_PARSE, scn_name(scan));
+  if (mlp_binwgts(mlp, scn_file(scan), (bin) ? &hdr : NULL) != 0)
+    error(E_BINARY, scn_name(scan));  /* get the binary weights */
   scn_delete(scan, 1);          /* delete the scanner and */
   scan = NULL;                  /* print a log message */
   fprintf(stderr, "[%"DIMID_FMT" unit(s),",   mlp_unitcnt(mlp));
   fprintf(stderr, " %"DIMID_FMT" weight(s)]", mlp_wgtcnt(mlp));
   fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+  TMS_END(tms);                 /* end the reading phase */
   mlp_setup(mlp);               /* set network up for execution */
 
+  /* --- create threads and contexts --- */
+  if (thcnt <= 0) thcnt = thr_cpucnt();  /* get number of threads */
+  if (thcnt > THR_MAXCNT) thcnt = THR_MAXCNT;
+  team = thr_create(thcnt);     /* create a team of worker threads */
+  if (!team) error(E_THREAD, thcnt);  /* (none for one thread) */
+  for (i = 0; i < thcnt; i++) { /* create an execution context */
+    ctxs[i] = mlp_ctxcreate(mlp);      /* for each thread */
+    if (!ctxs[i]) error(E_NOMEM);
+  }                             /* (a context holds the Jacobian) */
+  job.thcnt = thcnt;            /* initialize the sensitivity job */
+  job.mode  = magg;             /* (the patterns of a batch are */
+  job.n     = 0;                /* distributed over the threads) */
+  job.timed = (tms != NULL);    /* note whether to time the phases */
+
   if (matinp) {                 /* if matrix version */
     /* --- process patterns --- */
+    TMS_BEG(tms, PH_READ);      /* time reading the input file */
     tread = trd_create();       /* create a table reader and */
     if (!tread) error(E_NOMEM); /* set the separator characters */
     trd_allchs(tread, recseps, fldseps, blanks, "", comment);
@@ -270,19 +437,29 @@ int main (int argc, char *argv[])
     w = 0;                      /* read the first pattern */
     k = vec_readx(&pat, &dim, tread);
     if (k) error(k, TRD_INFO(tread));
+    pats = pat;                 /* note the pattern buffer */
     x = mlp_incnt(mlp);         /* get the number of inputs */
     o = mlp_outcnt(mlp);        /* and outputs of the network */
     if ((dim != x) && (dim != x+o))
       error(E_PATSIZE, dim);    /* check the pattern size */
-    sens = (double*)calloc((size_t)x, sizeof(double));
+    pat = (double*)realloc(pats, (size_t)BATCHSIZE *(size_t)dim
+                                *sizeof(double));
+    if (!pat) error(E_NOMEM);   /* enlarge the buffer to a batch */
+    pats = pat;                 /* of patterns (BATCHSIZE patterns) */
+    sens = (double*)calloc((size_t)thcnt *(size_t)x, sizeof(double));
     if (!sens) error(E_NOMEM);  /* create a vector of sensitivities */
-    for (p = 0; k == 0; p++) {  /* pattern read loop */
-      mlp_exec(mlp, pat, NULL); /* execute the multilayer perceptron */
-      for (c = 0; c < x; c++)   /* and compute sensitivity values */
-        sens[c] += mlp_sens(mlp, c, magg);
-      k = vec_read(pat, dim, tread);
-    }                           /* read the next pattern */
-    if (k < 0) error(k, TRD_INFO(tread));
+    job.ext = 0; job.dim = dim; /* (one vector per thread) */
+    job.cnt = x;                /* set the pattern parameters */
+    for (p = 0, b = 1; k == 0; b = 0) {
+      TMS_BEG(tms, PH_READ);    /* (reading is a timed phase) */
+      for ( ; b < BATCHSIZE; b++) {
+        k = vec_read(pats +(size_t)b *(size_t)dim, dim, tread);
+        if (k != 0) break;      /* read the next patterns */
+      }                         /* until the batch is full */
+      if (k < 0) error(k, TRD_INFO(tread));
+      job.n = b; p += b;        /* compute the sensitivities */
+      batch(&job);              /* for the patterns of the batch */
+    }
     trd_delete(tread, 1);       /* close the input file and */
     tread = NULL;               /* delete the table reader */
     fprintf(stderr, "[%"DIMID_FMT" pattern(s)]", p);
@@ -290,6 +467,7 @@ int main (int argc, char *argv[])
 
   else {                        /* if table version */
     /* --- read table header --- */
+    TMS_BEG(tms, PH_READ);      /* time reading the input files */
     tread = trd_create();       /* create a table reader and */
     if (!tread) error(E_NOMEM); /* set the separator characters */
     trd_allchs(tread, recseps, fldseps, blanks, "", comment);
@@ -313,22 +491,32 @@ int main (int argc, char *argv[])
     fprintf(stderr, "reading %s ... ", trd_name(tread));
     x = as_attcnt(attset);      /* get the number of attributes */
     o = mlp_trgid(mlp);         /* and the target attribute id */
-    sens = (double*)calloc((size_t)x, sizeof(double));
+    sens = (double*)calloc((size_t)thcnt *(size_t)x, sizeof(double));
     if (!sens) error(E_NOMEM);  /* create a vector of sensitivities */
+    job.ext = 1; job.cnt = x;   /* (one vector per thread) */
+    job.dim = mlp_incnt(mlp);   /* set the pattern parameters */
+    pats = (double*)malloc((size_t)BATCHSIZE *(size_t)job.dim
+                          *sizeof(double));
+    if (!pats) error(E_NOMEM);  /* create a buffer for a batch */
     k = as_read(attset, tread, mode); /* read/generate table header */
     if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
     i = mode; mode = (mode & ~(AS_DFLT|AS_ATT)) | AS_INST;
     if (i & AS_ATT)             /* if not done yet, read first tuple */
       k = as_read(attset, tread, mode);
-    for (w = 0, n = 0; k == 0; n++) {
-      mlp_inputx(mlp, NULL);    /* set the pattern from a tuple, */
-      mlp_exec(mlp,NULL,NULL);  /* execute multilayer perceptron, */
-      w += as_getwgt(attset);   /* sum the tuple weights and */
-      for (c = 0; c < x; c++)   /* compute sensitivity values */
-        if (c != o) sens[c] += mlp_sensx(mlp, c, magg);
+    for (w = 0, n = 0, b = 0; k == 0; n++) {
+      TMS_BEG(tms, PH_ENCODE);
+      am_exec(attmap, NULL, AM_INPUTS, pats +(size_t)b *(size_t)job.dim);
+      w += as_getwgt(attset);   /* map the tuple to the inputs and */
+      if (++b >= BATCHSIZE) {   /* sum the tuple weights */
+        job.n = b; b = 0;       /* if the batch is full, compute */
+        batch(&job);            /* the sensitivity values */
+      }
+      TMS_BEG(tms, PH_READ);    /* try to read the next tuple */
       k = as_read(attset, tread, mode);
-    }                           /* try to read the next tuple */
+    }
     if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
+    job.n = b;                  /* process the last batch */
+    batch(&job);
     trd_delete(tread, 1);       /* delete the table reader */
     tread = NULL;               /* and clear the variable */
     fprintf(stderr, "[%"ATTID_FMT" attribute(s),", as_attcnt(attset)+1);
@@ -336,9 +524,14 @@ int main (int argc, char *argv[])
     if (w != (double)n) fprintf(stderr, "/%g", w);
     fprintf(stderr, " tuple(s)] done [%.2fs].\n", SEC_SINCE(t));
   }                             /* if (matinp) .. else .. */
+  for (i = 1; i < thcnt; i++)   /* sum the sensitivities */
+    for (c = 0; c < x; c++)     /* computed by the threads */
+      sens[c] += sens[(size_t)i *(size_t)x +(size_t)c];
+  delthr();                     /* delete threads and contexts */
 
   /* --- print results --- */
   t = clock();                  /* start timer, open output file */
+  TMS_BEG(tms, PH_OUTPUT);      /* (writing is a timed phase) */
   if (fn_out && (strcmp(fn_out, "-") == 0)) fn_out = "";
   if (fn_out && *fn_out) { out = fopen(fn_out, "w"); }
   else                   { out = stdout; fn_out = "<stdout>"; }
@@ -367,10 +560,18 @@ int main (int argc, char *argv[])
   }
   if (((out == stdout) ? fflush(out) : fclose(out)) != 0)
     error(E_FWRITE, fn_out);    /* close the output file */
+  out = NULL;                   /* and clear the variable */
+  TMS_END(tms);                 /* end the output phase */
   if (matinp) fprintf(stderr, "[%"DIMID_FMT" input(s)]",     x);
   else        fprintf(stderr, "[%"DIMID_FMT" attribute(s)]", x-1);
   fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
 
+  /* --- write timing report --- */
+  if (tms && (report((matinp) ? (double)p : (double)n,
+                     (double)mlp_wgtcnt(mlp),
+                     (double)mlp_outcnt(mlp)) != 0))
+    error(E_FWRITE, fn_rep);    /* write the report for the run */
+
   /* --- clean up --- */
   CLEANUP;                      /* clean up memory and close files */
   SHOWMEM;                      /* show (final) memory usage */
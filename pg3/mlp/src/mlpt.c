@@ -21,6 +21,20 @@
             2013.08.29 adapted to new function as_target()
             2014.10.07 bug in handling option -q fixed (input norm.)
             2014.10.24 changed from LGPL license to MIT license
+            2016.05.04 training with blocks of patterns if update > 1
+            2016.05.06 option -p# added (parallel training with threads)
+            2016.05.15 training patterns stored in a column-major table
+            2016.05.15 option -N added (encode table once into a matrix)
+            2016.05.16 option -Z added (sparse input for nominal atts.)
+            2016.05.16 training table read with threads if -p# is given
+            2016.05.16 option -V added (scalar weight update, validation)
+            2016.05.16 options -F, -H, -I, -L added (early stopping)
+            2016.05.16 option -X# added (parallel cross-validation)
+            2016.05.16 options -G#, -R# added (hyperparameter sweep)
+            2016.05.16 -G# rejected with -M and -X# (no silent drop)
+            2016.05.16 input networks with binary weights rejected
+            2016.05.16 options -Q#, -K# added (phase timing report)
+            2016.05.16 -p# used the same way for all training modes
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -55,8 +69,11 @@
 #define MLP_PARSE
 #endif
 #include "mlp.h"
+#include "arrays.h"
 #include "random.h"
 #include "params.h"
+#include "thread.h"
+#include "tmstat.h"
 #include "error.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -87,16 +104,113 @@
 #define E_LPARAM    (-18)       /* invalid learning parameter */
 #define E_MOMENT    (-19)       /* invalid momentum coefficient */
 #define E_EPOCHS    (-20)       /* invalid number of epochs */
+#define E_THREAD    (-21)       /* cannot create threads */
+#define E_FOLDS     (-22)       /* invalid number of folds */
+#define E_GRID      (-23)       /* invalid sweep specification */
+#define E_SWEEP     (-24)       /* option not usable with a sweep */
 
 #define INPUT       "input"
 #define HIDDEN      "hidden"
 #define OUTPUT      "output"
 
+#define SWP_MAXVAL  32          /* maximum number of values per param. */
+
+/* --- timed phases --- */
+#define PH_READ      0          /* reading the input files */
+#define PH_ENCODE    1          /* encoding the patterns */
+#define PH_SHUFFLE   2          /* shuffling the patterns */
+#define PH_FORWARD   3          /* forward pass (execution) */
+#define PH_BKPROP    4          /* backpropagation of the errors */
+#define PH_UPDATE    5          /* update of the connection weights */
+#define PH_OUTPUT    6          /* writing the network */
+#define PH_CNT       7          /* number of timed phases */
+
 #define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
 
 /*----------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------*/
+typedef struct {                /* --- training job for threads --- */
+  int     matinp;               /* flag for numerical matrix input */
+  DIMID   incnt;                /* number of input units */
+  TPLID   beg;                  /* index of first training pattern */
+  TPLID   cnt;                  /* number of training patterns */
+  double  sse[THR_MAXCNT];      /* sums of squared errors per thread */
+  int     timed;                /* flag for timing the phases */
+  double  secs[THR_MAXCNT][3];  /* encode/forward/backprop. times */
+} TRNJOB;                       /* (training job) */
+
+typedef struct {                /* --- validation job --- */
+  MLP     *net;                 /* snapshot network to evaluate */
+  DIMID   incnt;                /* number of input units */
+  int     mis;                  /* flag for misclassification error */
+  DIMID   epoch;                /* epoch of the evaluated snapshot */
+  double  sse;                  /* sum of squared errors */
+  double  err;                  /* number of misclassifications */
+  DIMID   best;                 /* epoch of the best snapshot */
+  double  min;                  /* error of the best snapshot */
+  DIMID   bad;                  /* validations without improvement */
+} VALJOB;                       /* (validation job) */
+
+typedef struct {                /* --- cross-validation fold --- */
+  MLP     *mlp;                 /* network trained on the fold */
+  TUPLE   *tpl;                 /* tuple view of the fold */
+  RNG     *rng;                 /* random number generator */
+  TABCOL  *tab;                 /* table with the test tuples */
+  TPLID   *tst;                 /* positions of the test tuples */
+  TPLID   tstcnt;               /* number of test tuples */
+  TPLID   *trn;                 /* positions of the training tuples */
+  TPLID   trncnt;               /* number of training tuples */
+  DIMID   epochs;               /* number of epochs trained */
+  double  sse;                  /* sse on the training tuples */
+  double  tsse;                 /* sse on the test tuples */
+  double  terr;                 /* misclassifications on test tuples */
+} XVFOLD;                       /* (cross-validation fold) */
+
+typedef struct {                /* --- cross-validation job --- */
+  int     cnt;                  /* number of folds */
+  XVFOLD  *folds;               /* folds to train and evaluate */
+  DIMID   incnt;                /* number of input units */
+  DIMID   epochs;               /* maximum number of epochs */
+  DIMID   update;               /* number of patterns between updates */
+  int     shuffle;              /* flag for shuffling the patterns */
+  int     sparse;               /* flag for sparse input */
+  double  term;                 /* maximum sse for termination */
+} XVJOB;                        /* (cross-validation job) */
+
+typedef struct {                /* --- hyperparameter grid --- */
+  int     ccnt;                 /* number of hidden layer specs. */
+  int     lyrcnts[SWP_MAXVAL];  /* numbers of layers */
+  DIMID   ucnts[SWP_MAXVAL][MLP_MAXLAYER]; /* units per layer */
+  int     acnt;                 /* number of update methods */
+  int     methods[SWP_MAXVAL];  /* update methods */
+  int     tcnt;                 /* number of learning rates */
+  double  lrates[SWP_MAXVAL];   /* learning rates */
+  int     mcnt;                 /* number of momentum coefficients */
+  double  moments[SWP_MAXVAL];  /* momentum coefficients */
+  int     ycnt;                 /* number of weight decay factors */
+  double  decays[SWP_MAXVAL];   /* weight decay factors */
+} SWGRID;                       /* (hyperparameter grid) */
+
+typedef struct {                /* --- sweep candidate --- */
+  XVFOLD  fold;                 /* network, tuples and results */
+  int     lyrcnt;               /* number of layers */
+  DIMID   *ucnts;               /* number of units per layer */
+  int     method;               /* update method */
+  double  lrate;                /* learning rate */
+  double  moment;               /* momentum coefficient */
+  double  decay;                /* weight decay factor */
+  double  err;                  /* validation error for ranking */
+} SWCAND;                       /* (sweep candidate) */
+
+typedef struct {                /* --- hyperparameter sweep job --- */
+  XVJOB   xv;                   /* training parameters */
+  int     mis;                  /* flag for misclassification error */
+  int     cnt;                  /* number of candidates */
+  SWCAND  *cands;               /* candidates to train and evaluate */
+  TPLID   *bufs[THR_MAXCNT];    /* training positions per thread */
+} SWJOB;                        /* (hyperparameter sweep job) */
+
 typedef struct {                /* --- mode information --- */
   int  code;                    /* code        of update mode */
   char *name;                   /* name        of update mode */
@@ -128,7 +242,11 @@ static const char *errmsgs[] = {   /* error messages */
   /* E_LPARAM  -18 */  "invalid learning parameter %g",
   /* E_MOMENT  -19 */  "invalid momentum coefficient %g",
   /* E_EPOCHS  -20 */  "invalid number of epochs %"DIMID_FMT,
-  /*           -21 */  "unknown error",
+  /* E_THREAD  -21 */  "cannot create %d thread(s)",
+  /* E_FOLDS   -22 */  "invalid number of folds %d",
+  /* E_GRID    -23 */  "invalid sweep specification %s",
+  /* E_SWEEP   -24 */  "option -%c cannot be combined with -G",
+  /*           -25 */  "unknown error",
 };
 
 static const MODEINFO updtab[] = {    /* table of update methods */
@@ -140,6 +258,10 @@ static const MODEINFO updtab[] = {    /* table of update methods */
   { -1,            NULL,        NULL  /* sentinel */                  },
 };
 
+static const char *const phases[PH_CNT] = {  /* names of phases */
+  "read", "encode", "shuffle", "forward", "backprop", "update", "output"
+};
+
 /*----------------------------------------------------------------------
   Global Variables
 ----------------------------------------------------------------------*/
@@ -148,25 +270,90 @@ static SCANNER *scan   = NULL;  /* scanner (for domain descriptions) */
 static ATTSET  *attset = NULL;  /* attribute set */
 static ATTMAP  *attmap = NULL;  /* attribute map */
 static TABREAD *tread  = NULL;  /* table reader */
-static TABLE   *table  = NULL;  /* table  of training patterns */
+static TABCOL  *table  = NULL;  /* table  of training patterns */
 static MATRIX  *matrix = NULL;  /* matrix of training patterns */
 static MLP     *mlp    = NULL;  /* multilayer perceptron */
+static THRTEAM *team   = NULL;  /* team of worker threads */
+static MLP     *shds[THR_MAXCNT];  /* shadow networks for threads */
+static TABCOL  *valid  = NULL;  /* table  of validation patterns */
+static MATRIX  *vmat   = NULL;  /* matrix of validation patterns */
+static THRTEAM *vteam  = NULL;  /* thread for the validation */
+static MLP     *snaps[2] = { NULL, NULL };  /* snapshot networks */
+static XVFOLD  *folds  = NULL;  /* cross-validation folds */
+static int     fldcnt  = 0;     /* number of cross-validation folds */
+static SWJOB   swjob;          /* hyperparameter sweep job */
 static FILE    *out    = NULL;  /* network output file */
+static TMSTAT  *tms    = NULL;  /* phase timing statistics */
+static FILE    *rep    = NULL;  /* timing report file */
 
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
 
+static void delthr (void)
+{                               /* --- delete threads and shadows */
+  int i;                        /* loop variable */
+
+  if (team) { thr_delete(team); team = NULL; }
+  for (i = 1; i < THR_MAXCNT; i++) {
+    if (shds[i]) { mlp_delete(shds[i]); shds[i] = NULL; } }
+}  /* delthr() */               /* delete the shadow networks */
+
+/*--------------------------------------------------------------------*/
+
+static void delfolds (void)
+{                               /* --- delete cross-validation folds */
+  int i;                        /* loop variable */
+
+  if (!folds) return;           /* check for cross-validation folds */
+  for (i = 0; i < fldcnt; i++) {/* traverse the folds */
+    if (folds[i].mlp) mlp_delete(folds[i].mlp);
+    if (folds[i].tpl) tpl_delete(folds[i].tpl);
+    if (folds[i].rng) rng_delete(folds[i].rng);
+    if (folds[i].tst) free(folds[i].tst);
+  }                             /* delete networks, views etc. */
+  free(folds); folds = NULL;    /* delete the fold array */
+}  /* delfolds() */
+
+/*--------------------------------------------------------------------*/
+
+static void delcands (void)
+{                               /* --- delete sweep candidates */
+  int i;                        /* loop variable */
+
+  for (i = 0; i < THR_MAXCNT; i++) {
+    if (swjob.bufs[i]) { free(swjob.bufs[i]); swjob.bufs[i] = NULL; } }
+  if (!swjob.cands) return;     /* delete the position buffers */
+  for (i = 0; i < swjob.cnt; i++) {
+    if (swjob.cands[i].fold.mlp) mlp_delete(swjob.cands[i].fold.mlp);
+    if (swjob.cands[i].fold.tpl) tpl_delete(swjob.cands[i].fold.tpl);
+    if (swjob.cands[i].fold.rng) rng_delete(swjob.cands[i].fold.rng);
+  }                             /* delete networks, views etc. */
+  free(swjob.cands); swjob.cands = NULL;
+}  /* delcands() */              /* delete the candidate array */
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG
   #undef  CLEANUP               /* clean up memory and close files */
   #define CLEANUP \
+  if (vteam)  thr_delete(vteam);    \
+  if (snaps[0]) mlp_delete(snaps[0]); \
+  if (snaps[1]) mlp_delete(snaps[1]); \
+  if (vmat)   mat_delete(vmat);     \
+  if (valid)  tc_delete(valid, 0);  \
+  delfolds();                       \
+  delcands();                       \
+  delthr();                         \
   if (mlp)    mlp_deletex(mlp, 0);  \
   if (matrix) mat_delete(matrix);   \
-  if (table)  tab_delete(table, 0); \
+  if (table)  tc_delete(table, 0);  \
   if (attmap) am_delete(attmap, 0); \
   if (attset) as_delete(attset);    \
   if (tread)  trd_delete(tread, 1); \
   if (scan)   scn_delete(scan,  1); \
+  if (tms)    tms_delete(tms);      \
+  if (rep && (rep != stdout)) fclose(rep); \
   if (out && (out != stdout)) fclose(out);
 #endif
 
@@ -209,22 +396,69 @@ static int getucnts (DIMID *ucnts, char *s, char **end)
 
 /*--------------------------------------------------------------------*/
 
-static double geterr (MLP *mlp, TABLE *table, double *err)
+static int getgrid (SWGRID *grid, const char *spec)
+{                               /* --- get a hyperparameter grid */
+  int  i, n;                    /* loop variable, number of values */
+  int  par;                     /* parameter letter */
+  char *s, *e;                  /* to traverse the specification */
+
+  assert(grid && spec);         /* check the function arguments */
+  for (s = (char*)spec; *s; ) { /* traverse the parameter lists */
+    par = *s++; n = 0;          /* get the parameter letter */
+    do {                        /* traverse the parameter values */
+      if (n >= SWP_MAXVAL) return -1;
+      switch (par) {            /* evaluate the parameter letter */
+        case 'c': if ((s[0] == '0') && (!s[1] || (s[1] == ',')
+                  ||  (s[1] == '/'))) { i = 2; e = s+1; }
+                  else if ((i = getucnts(grid->ucnts[n], s, &e)) < 0)
+                    return -1;  /* "0": no hidden layer */
+                  grid->lyrcnts[n] = i;                  break;
+        case 'a': for (e = s; *e && (*e != ',') && (*e != '/'); e++)
+                    ;           /* find the end of the method name */
+                  for (i = 0; updtab[i].name; i++)
+                    if ((strncmp(updtab[i].name, s, (size_t)(e-s)) == 0)
+                    &&  (updtab[i].name[e-s] == 0)) break;
+                  if (!updtab[i].name) return -1;
+                  grid->methods[n] = i;                  break;
+        case 't': grid->lrates [n] = strtod(s, &e);      break;
+        case 'm': grid->moments[n] = strtod(s, &e);      break;
+        case 'y': grid->decays [n] = strtod(s, &e);      break;
+        default : return -1;                             break;
+      }                         /* get the next parameter value */
+      if (e == s) return -1;    /* check for a valid value */
+      n++; s = e;               /* count the value and */
+    } while (*s++ == ',');      /* consume the separator */
+    switch (par) {              /* note the number of values */
+      case 'c': grid->ccnt = n; break;
+      case 'a': grid->acnt = n; break;
+      case 't': grid->tcnt = n; break;
+      case 'm': grid->mcnt = n; break;
+      default : grid->ycnt = n; break;
+    }                           /* (a '/' separates the parameters) */
+    if (s[-1] == 0) break;      /* if at the end of the spec., abort */
+    if (s[-1] != '/') return -1;
+  }                             /* check the parameter separator */
+  return 0;                     /* return 'ok' */
+}  /* getgrid() */
+
+/*--------------------------------------------------------------------*/
+
+static double geterrx (MLP *mlp, TABCOL *table, const TPLID *ids,
+                       TPLID cnt, TUPLE *tpl, double *err)
 {                               /* --- determine network error */
   TPLID  i;                     /* loop variable for tuples */
   ATTID  trgid;                 /* target identifier */
   VALID  k;                     /* buffer for target value */
   int    type;                  /* type of the target attribute */
-  TUPLE  *tpl;                  /* to traverse the tuples */
   WEIGHT wgt;                   /* tuple weight */
   double sse;                   /* sum of (squared) errors */
   INST   res;                   /* target value and network result */
 
-  assert(mlp && table && err);  /* check the function arguments */
+  assert(mlp && table && tpl && err); /* check the function args. */
   trgid = mlp_trgid(mlp);       /* get the target att. and its type */
   type  = att_type(mlp_trgatt(mlp));
-  for (*err = sse = 0.0, i = tab_tplcnt(table); --i >= 0; ) {
-    tpl = tab_tpl(table, i);    /* traverse the training patterns */
+  for (*err = sse = 0.0, i = cnt; --i >= 0; ) {
+    tc_tplx(table, (ids) ? ids[i] : i, tpl); /* get next pattern */
     mlp_inputx(mlp, tpl);       /* present the pattern to the network */
     mlp_exec(mlp, NULL, NULL);  /* execute the neural network */
     mlp_targetx(mlp, tpl);      /* set the target output value */
@@ -236,7 +470,244 @@ static double geterr (MLP *mlp, TABLE *table, double *err)
     if (!isnone(k) && (k != res.n)) *err += wgt;
   }                             /* sum the misclassifications */
   return sse;                   /* return the sum of squared errors */
-}  /* geterr() */
+}  /* geterrx() */              /* (tuples in ids or all tuples) */
+
+/*--------------------------------------------------------------------*/
+
+static double geterr (MLP *mlp, TABCOL *table, double *err)
+{ return geterrx(mlp, table, NULL, tc_tplcnt(table), tc_buf(table),err); }
+
+/*--------------------------------------------------------------------*/
+
+static void train (void *data, int id)
+{                               /* --- train on a part of a job */
+  TRNJOB *job = (TRNJOB*)data;  /* training job to execute */
+  MLP    *net = shds[id];       /* (shadow) network of the thread */
+  int    cnt;                   /* number of threads */
+  TPLID  k, end;                /* range of training patterns */
+  DIMID  b, j;                  /* block size, loop variable */
+  double *pat;                  /* to traverse the training patterns */
+  double sse = 0;               /* sum of squared errors */
+  TPLID  rows[MLP_BLKSIZE];     /* rows of the block patterns */
+  double t[4] = { 0, 0, 0, 0 }; /* for time measurements */
+
+  if (job->timed)               /* clear the phase times */
+    job->secs[id][0] = job->secs[id][1] = job->secs[id][2] = 0;
+  cnt = thr_cnt(team);          /* get the pattern range of thread */
+  k   = job->beg +(TPLID)(((double)job->cnt *id)    /cnt);
+  end = job->beg +(TPLID)(((double)job->cnt *(id+1))/cnt);
+  for ( ; k < end; k += (TPLID)b) {
+    b = (end-k < MLP_BLKSIZE) ? (DIMID)(end-k) : MLP_BLKSIZE;
+    if (job->timed) t[0] = tms_clock();
+    for (j = 0; j < b; j++) {   /* traverse the block patterns */
+      if (job->matinp) {        /* if matrix version */
+        pat = mat_row(matrix, (DIMID)k+j);
+        mlp_inputb (net, j, pat);
+        mlp_targetb(net, j, pat +job->incnt); }
+      else                      /* if table version, */
+        rows[j] = tc_row(table, k+j);  /* collect the rows */
+    }                           /* set inputs and targets */
+    if (!job->matinp) {         /* map the table columns */
+      mlp_inputcb (net, table, rows, b);
+      mlp_targetcb(net, table, rows, b);
+    }
+    if (job->timed) t[1] = tms_clock();
+    mlp_execb(net, NULL, b, NULL);    /* execute the network */
+    if (job->timed) t[2] = tms_clock();
+    sse += mlp_bkpropb(net, NULL, b); /* and backpropagate */
+    if (!job->timed) continue;  /* if to time the phases */
+    t[3] = tms_clock();         /* sum the busy times of the thread */
+    job->secs[id][0] += t[1] -t[0];
+    job->secs[id][1] += t[2] -t[1];
+    job->secs[id][2] += t[3] -t[2];
+  }
+  job->sse[id] = sse;           /* note the sum of squared errors */
+}  /* train() */
+
+/*--------------------------------------------------------------------*/
+
+/* Per pattern, the forward pass needs about 2 operations per weight */
+/* (multiply and add), backpropagation about 4 (error propagation   */
+/* and gradient), and each weight update about 4 more. Activation   */
+/* functions and input scaling are not counted (estimate only).     */
+
+static int epoch (double wgts)
+{                               /* --- close an epoch of timing */
+  double n = tms_pats(tms);     /* number of training patterns */
+
+  tms_count(tms, 0, wgts *(6*n +4*tms_calls(tms, PH_UPDATE)));
+  return tms_epoch(tms);        /* estimate the floating point ops. */
+}  /* epoch() */
+
+/*--------------------------------------------------------------------*/
+
+static int report (void)
+{                               /* --- write the timing report */
+  int r;                        /* result of writing the report */
+
+  r = tms_report(tms);          /* write report for the whole run */
+  if ((rep != stdout) && (fclose(rep) != 0)) r = -1;
+  rep = NULL;                   /* close the report file */
+  return r;                     /* return the write result */
+}  /* report() */
+
+/*--------------------------------------------------------------------*/
+
+static void validate (void *data, int id)
+{                               /* --- evaluate a weight snapshot */
+  VALJOB *job = (VALJOB*)data;  /* validation job to execute */
+  MLP    *net = job->net;       /* snapshot network to evaluate */
+  DIMID  p;                     /* loop variable for patterns */
+  double *pat;                  /* to traverse the patterns */
+
+  if (!vmat) {                  /* if table version */
+    job->sse = geterr(net, valid, &job->err); return; }
+  for (job->sse = 0, p = mat_rowcnt(vmat); --p >= 0; ) {
+    pat = mat_row(vmat, p);     /* traverse the validation patterns */
+    mlp_exec(net, pat, NULL);   /* and execute the neural network */
+    job->sse += mlp_error(net, pat +job->incnt);
+  }                             /* sum the squared errors */
+  job->err = job->sse;          /* (no misclassifications for */
+}  /* validate() */             /* the matrix version) */
+
+/*--------------------------------------------------------------------*/
+
+static void valchk (VALJOB *job)
+{                               /* --- check a validation result */
+  MLP    *net;                  /* exchange buffer for snapshots */
+  double err;                   /* validation error of the snapshot */
+
+  err = (job->mis) ? job->err : job->sse;
+  if (err >= job->min) {        /* if the error did not improve, */
+    job->bad++; return; }       /* count the validation as bad */
+  job->min  = err;              /* note the new minimal error */
+  job->best = job->epoch;       /* and the epoch of the snapshot */
+  job->bad  = 0;                /* and keep the snapshot network */
+  net = snaps[1]; snaps[1] = snaps[0]; snaps[0] = net;
+}  /* valchk() */               /* (the old best one is reused) */
+
+/*--------------------------------------------------------------------*/
+
+static void xvtrain (XVJOB *job, XVFOLD *fold)
+{                               /* --- train a cross-validation fold */
+  MLP    *net = fold->mlp;      /* network of the fold */
+  TUPLE  *tpl = fold->tpl;      /* tuple view of the fold */
+  TPLID  n, i, r;               /* loop variables, row buffer */
+  DIMID  e, u, b, j;            /* epoch, counter, block size */
+  double *pat;                  /* to traverse the (encoded) patterns */
+  double sse = 0;               /* sum of squared errors */
+  TPLID  rows[MLP_BLKSIZE];     /* rows of the block patterns */
+
+  u = job->update;              /* init. the update counter */
+  for (e = 0; e < job->epochs; e++) {
+    if (job->shuffle) {         /* if to shuffle the patterns */
+      for (n = fold->trncnt; --n > 0; ) {
+        i = (TPLID)((double)(n+1) *rng_dbl(fold->rng));
+        if (i > n) i = n;       /* compute a random index and */
+        r = fold->trn[i]; fold->trn[i] = fold->trn[n]; fold->trn[n] = r;
+      }                         /* exchange the training positions */
+    }                           /* (the table itself is not changed) */
+    n = fold->trncnt;           /* get the number of patterns */
+    if (job->sparse) {          /* if to use sparse inputs */
+      for (sse = 0; --n >= 0; ) {
+        tc_tplx(table, fold->trn[n], tpl);
+        mlp_inputxs(net, tpl);  /* traverse the patterns */
+        mlp_execs(net, NULL, NULL, 0, NULL); /* execute network */
+        mlp_targetx(net, tpl);  /* set the target output values */
+        sse += mlp_bkprops(net, NULL); /* and backpropagate */
+        if ((job->update > 0) && (--u <= 0)) {
+          u = job->update; mlp_update(net); }
+      } }                       /* update after 'update' patterns */
+    else if (matrix && (job->update == 1)) {
+      for (sse = 0; --n >= 0; ) {
+        pat = mat_row(matrix, (DIMID)fold->trn[n]);
+        mlp_exec(net, pat, NULL);     /* traverse the patterns and */
+        sse += mlp_bkprop(net, pat +job->incnt); /* execute network */
+        mlp_update(net);        /* update the connection weights */
+      } }                       /* after each (encoded) pattern */
+    else if (job->update == 1){ /* if to update after each pattern */
+      for (sse = 0; --n >= 0; ) {
+        tc_tplx(table, fold->trn[n], tpl);
+        mlp_inputx(net, tpl);   /* traverse the patterns */
+        mlp_exec(net,NULL,NULL);/* execute the neural network */
+        mlp_targetx(net, tpl);  /* set the target output values */
+        sse += mlp_bkprop(net, NULL);  /* and backpropagate */
+        mlp_update(net);        /* update the connection weights */
+      } }                       /* after each pattern */
+    else {                      /* if to process blocks of patterns */
+      for (sse = 0; n > 0; n -= (TPLID)b) {
+        b = (n < MLP_BLKSIZE) ? (DIMID)n : MLP_BLKSIZE;
+        if ((job->update > 0) && (u < b)) b = u;
+        for (j = 0; j < b; j++) {     /* traverse the block patterns */
+          i = fold->trn[n-1-(TPLID)j];
+          if (!matrix) { rows[j] = tc_row(table, i); continue; }
+          pat = mat_row(matrix, (DIMID)i);
+          mlp_inputb (net, j, pat);   /* collect the rows or set */
+          mlp_targetb(net, j, pat +job->incnt);
+        }                       /* inputs and targets (encoded) */
+        if (!matrix) {          /* map the table columns */
+          mlp_inputcb (net, table, rows, b);
+          mlp_targetcb(net, table, rows, b);
+        }
+        mlp_execb(net, NULL, b, NULL);   /* execute the network */
+        sse += mlp_bkpropb(net, NULL, b);/* and backpropagate */
+        if ((job->update > 0) && ((u -= b) <= 0)) {
+          u = job->update; mlp_update(net); }
+      }                         /* update after 'update' patterns */
+    }
+    if (sse <= job->term) break;/* if error is small enough, abort */
+    if (job->update <= 0)       /* if no number of patterns is given, */
+      mlp_update(net);          /* update once in each epoch */
+  }
+  fold->epochs = e;             /* note the number of epochs and */
+  fold->sse    = sse;           /* the sse on the training patterns */
+  fold->tsse   = geterrx(net, fold->tab, fold->tst, fold->tstcnt, tpl,
+                         &fold->terr);
+}  /* xvtrain() */              /* evaluate on the test patterns */
+
+/*--------------------------------------------------------------------*/
+
+static void xval (void *data, int id)
+{                               /* --- train folds on a thread */
+  XVJOB *job = (XVJOB*)data;    /* cross-validation job to execute */
+  int   i;                      /* loop variable for folds */
+
+  for (i = id; i < job->cnt; i += thr_cnt(team))
+    xvtrain(job, job->folds +i);/* train every thr_cnt(team)-th fold */
+}  /* xval() */                 /* (folds are independent) */
+
+/*--------------------------------------------------------------------*/
+
+static void sweep (void *data, int id)
+{                               /* --- train candidates on a thread */
+  SWJOB  *job = (SWJOB*)data;   /* sweep job to execute */
+  SWCAND *c;                    /* to traverse the candidates */
+  TPLID  *trn;                  /* training positions of the thread */
+  TPLID  r;                     /* loop variable for positions */
+  int    i;                     /* loop variable for candidates */
+
+  trn = job->bufs[id];          /* get the position buffer */
+  for (i = id; i < job->cnt; i += thr_cnt(team)) {
+    c = job->cands +i;          /* traverse the candidates */
+    for (r = 0; r < c->fold.trncnt; r++) trn[r] = r;
+    c->fold.trn = trn;          /* start from the same order */
+    xvtrain(&job->xv, &c->fold);/* train the candidate network */
+    c->fold.trn = NULL;         /* and evaluate it */
+    c->err = (job->mis) ? c->fold.terr : c->fold.tsse;
+  }                             /* get the error for the ranking */
+}  /* sweep() */
+
+/*--------------------------------------------------------------------*/
+
+static int candcmp (const void *p1, const void *p2, void *data)
+{                               /* --- compare sweep candidates */
+  const SWCAND *a = (const SWCAND*)p1;
+  const SWCAND *b = (const SWCAND*)p2;
+
+  if (a->err < b->err) return -1;  /* compare the validation errors */
+  if (a->err > b->err) return +1;  /* and in case of a tie */
+  return (a < b) ? -1 : (a > b) ? +1 : 0;
+}  /* candcmp() */              /* the candidate indices */
 
 /*--------------------------------------------------------------------*/
 
@@ -250,6 +721,8 @@ int main (int argc, char *argv[])
   CCHAR   *fn_tab  = NULL;      /* name of table file */
   CCHAR   *fn_mlp  = NULL;      /* name of output network file */
   CCHAR   *fn_inp  = NULL;      /* name of input  network file */
+  CCHAR   *fn_val  = NULL;      /* name of validation table file */
+  CCHAR   *fn_rep  = NULL;      /* name of timing report file */
   CCHAR   *recseps = NULL;      /* record  separators */
   CCHAR   *fldseps = NULL;      /* field   separators */
   CCHAR   *blanks  = NULL;      /* blank   characters */
@@ -258,6 +731,9 @@ int main (int argc, char *argv[])
   CCHAR   *upname  = "bkprop";  /* name of update/learning method */
   int     method   = 0;         /* code of update/learning method */
   int     matinp   = 0;         /* flag for numerical matrix input */
+  int     encode   = 0;         /* flag for encoding table as matrix */
+  int     sparse   = 0;         /* flag for sparse (1-in-n) input */
+  int     scalar   = 0;         /* flag for scalar weight update */
   int     mode     = AS_ATT|AS_NOXATT|AS_NONULL;/* table read mode */
   int     lyrcnt   = 2;         /* number of layers */
   DIMID   incnt    = 0;         /* number of input  units */
@@ -276,7 +752,17 @@ int main (int argc, char *argv[])
   DIMID   update   = 1,    u;   /* number of patterns between updates */
   DIMID   verbose  = 0,    v;   /* flag for verbose output */
   int     shuffle  = 1;         /* shuffle pattern set */
+  int     thcnt    = 1;         /* number of threads for training */
+  int     xfolds   = 0;         /* number of cross-validation folds */
+  int     given    = 0;         /* flag for a given input network */
+  CCHAR   *swspec  = NULL;      /* hyperparameter sweep specification */
+  int     rndcnt   = 0;         /* number of random sweep candidates */
   double  term     = 0.0;       /* maximum sse for termination */
+  double  hold     = 0.0;       /* fraction held out for validation */
+  DIMID   valint   = 1,   vc;   /* number of epochs between valid. */
+  DIMID   patience = 10;        /* number of validations w/o improv. */
+  int     vpend    = 0;         /* whether a validation is running */
+  VALJOB  vjob;                 /* validation job for thread */
   double  raise    = 0.0;       /* raise value for derivative */
   double  moment   = 0.0;       /* momentum coefficient */
   double  growth   = 1.2;       /* growth factor for learning rate */
@@ -287,15 +773,27 @@ int main (int argc, char *argv[])
   double  jog      = 0.0;       /* range for weight jogging */
   int     maxlen   = 0;         /* maximal output line length */
   int     sse4nom  = 1;         /* use sse for nominal target */
+  int     repmode  = TMS_JSON;  /* mode for the timing report */
   long    seed;                 /* seed for random numbers */
   double  *pat;                 /* to traverse the training patterns */
+  MATRIX  *mat;                 /* buffer for a pattern matrix */
   TUPLE   *tpl;                 /* to traverse the training patterns */
+  TPLID   rows[MLP_BLKSIZE];    /* rows of the block patterns */
   double  err;                  /* number of misclassifications */
   double  sse;                  /* sum of (squared) errors */
   ATTID   trgid;                /* id of the target column */
   ATTID   m, c;                 /* number of attributes */
-  TPLID   n, r;                 /* number of data tuples */
-  DIMID   p;                    /* number of patterns */
+  TPLID   n, r, nv;             /* number of data tuples */
+  TRNJOB  job;                  /* training job for threads */
+  XVJOB   xjob;                 /* cross-validation job */
+  TPLID   *pos, x;              /* tuple positions for the folds */
+  TPLID   *cnts;                /* class counters for stratification */
+  VALID   z;                    /* number of target values */
+  double  terr, tsse, twgt;     /* aggregate test errors and weight */
+  SWGRID  grid;                 /* hyperparameter grid */
+  SWCAND  *cand, **rank;        /* sweep candidates, ranking */
+  int     *idx, h;              /* indices of grid points, buffer */
+  DIMID   p, b, j;              /* number of patterns, block size */
   double  w;                    /* weight of data tuples */
   clock_t t;                    /* for time measurements */
 
@@ -341,21 +839,77 @@ int main (int argc, char *argv[])
                     "(default: %g)\n", raise);
     printf("-y#      weight decay factor                    "
                     "(default: %g)\n", decay);
+    printf("-V       scalar weight update (for validation)  "
+                    "(default: fused)\n");
     printf("-j#      range for weight jogging               "
                     "(default: %g)\n", jog);
     printf("-s       do not shuffle patterns                "
                     "(default: once per epoch)\n");
+    printf("-N       encode table once into a matrix        "
+                    "(default: map tuples)\n");
+    printf("-Z       sparse input for nominal attributes    "
+                    "(default: dense 1-in-n)\n");
+    printf("         (only single-threaded, -N is ignored; "
+                    "may change training results,\n"
+           "         as the input scaling is folded into the weights "
+                    "and sums are\n"
+           "         computed in a different order)\n");
     printf("-e#      maximum number of update epochs        "
                     "(default: %"DIMID_FMT")\n", epochs);
     printf("-k#      patterns between two updates           "
                     "(default: %"DIMID_FMT")\n", update);
+    printf("-p#      number of threads for training         "
+                    "(default: %d)\n", thcnt);
+    printf("         (<= 0: one per processor; used for training "
+                    "with -k0 or -k# with\n"
+           "         # > 1, for reading the training table, -X# and "
+                    "-G#)\n");
     printf("-T#      error for termination                  "
                     "(default: %g)\n", term);
     printf("-E       use misclassification error            "
                     "(default: sse)\n");
+    printf("-X#      number of cross-validation folds       "
+                    "(default: none)\n");
+    printf("         (table version only; the folds are trained in "
+                    "parallel with -p#\n"
+           "         threads, at most one per fold; mlpfile is "
+                    "optional)\n");
+    printf("-G#      hyperparameter sweep specification     "
+                    "(default: none)\n");
+    printf("         (e.g. c4,8:4/abkprop,rprop/t0.1,0.2/m0,0.5/y0: "
+                    "lists of values for\n"
+           "         the options -c, -a, -t, -m and -y separated by "
+                    "'/', c0: no hidden\n"
+           "         layer; the candidates are trained in parallel "
+                    "with -p# threads\n"
+           "         and ranked by their validation error; "
+                    "table version only,\n"
+           "         not with -X#)\n");
+    printf("-R#      number of random sweep candidates      "
+                    "(default: all)\n");
+    printf("-F#      file with validation patterns          "
+                    "(default: none)\n");
+    printf("-H#      fraction of patterns for validation    "
+                    "(default: %g)\n", hold);
+    printf("         (0.2 if -G# is given without -F# or -H#)\n");
+    printf("-I#      epochs between two validations         "
+                    "(default: %"DIMID_FMT")\n", valint);
+    printf("-L#      validations without improvement        "
+                    "(default: %"DIMID_FMT")\n", patience);
+    printf("         (stop training if reached, 0: do not stop "
+                    "early; the network\n"
+           "         with the smallest validation error is "
+                    "written in any case)\n");
     printf("-l#      output line length                     "
                     "(default: no limit)\n");
     printf("-P#      verbose output (print sse every # epochs)\n");
+    printf("-Q#      file to write a timing report to       "
+                    "(default: none)\n");
+    printf("-K#      timing report mode                     "
+                    "(default: %d)\n", repmode);
+    printf("         (0: JSON, 1: CSV, +2: one report per epoch; "
+                    "phase times, patterns\n"
+           "         and flops per second, see also mlpx and mlps)\n");
     printf("-r#      record  separators                     "
                     "(default: \"\\n\")\n");
     printf("-f#      field   separators                     "
@@ -378,7 +932,7 @@ int main (int argc, char *argv[])
     return 0;                   /* print a usage message */
   }                             /* and abort the program */
 
-  /* remaining option characters: n p u v A B D F-L N O Q R V W X Y Z */
+  /* remaining option characters: n u v A B D J O W Y */
 
   /* --- evaluate arguments --- */
   seed = (long)time(NULL);      /* and get a default seed value */
@@ -405,13 +959,26 @@ int main (int argc, char *argv[])
           case 'i': raise   =        strtod(s, &s);      break;
           case 'y': decay   =        strtod(s, &s);      break;
           case 'j': jog     =        strtod(s, &s);      break;
+          case 'V': scalar  = MLP_SCALAR;                break;
           case 's': shuffle = 0;                         break;
+          case 'N': encode  = 1;                         break;
+          case 'Z': sparse  = 1;                         break;
           case 'e': epochs  = (DIMID)strtol(s, &s, 0);   break;
           case 'k': update  = (DIMID)strtol(s, &s, 0);   break;
+          case 'p': thcnt   = (int)  strtol(s, &s, 0);   break;
           case 'T': term    =        strtod(s, &s);      break;
           case 'E': sse4nom = 0;                         break;
+          case 'F': optarg  = &fn_val;                   break;
+          case 'H': hold    =        strtod(s, &s);      break;
+          case 'I': valint  = (DIMID)strtol(s, &s, 0);   break;
+          case 'L': patience= (DIMID)strtol(s, &s, 0);   break;
+          case 'X': xfolds  = (int)  strtol(s, &s, 0);   break;
+          case 'G': optarg  = &swspec;                   break;
+          case 'R': rndcnt  = (int)  strtol(s, &s, 0);   break;
           case 'l': maxlen  = (int)  strtol(s, &s, 0);   break;
           case 'P': verbose = (int)  strtol(s, &s, 0);   break;
+          case 'Q': optarg  = &fn_rep;                   break;
+          case 'K': repmode = (int)  strtol(s, &s, 0);   break;
           case 'r': optarg  = &recseps;                  break;
           case 'f': optarg  = &fldseps;                  break;
           case 'b': optarg  = &blanks;                   break;
@@ -433,6 +1000,16 @@ int main (int argc, char *argv[])
     }
   }
   if (optarg) error(E_OPTARG);  /* check option argument */
+  if (thcnt <= 0) thcnt = thr_cpucnt();  /* get number of threads */
+  if (matinp) sparse = 0;       /* sparse input needs a table */
+  if (matinp) xfolds = 0;       /* and so does cross-validation */
+  if (swspec && matinp)         /* a hyperparameter sweep needs */
+    error(E_SWEEP, 'M');        /* a table and cannot be combined */
+  if (swspec && (xfolds != 0))  /* with a cross-validation */
+    error(E_SWEEP, 'X');
+  if (swspec && !sparse) encode = 1;   /* encode patterns once */
+  if (swspec && !fn_val && (hold <= 0)) hold = 0.2;
+  if (sparse) encode = 0;       /* and is not encoded as a matrix */
   if (matinp) {                 /* if matrix version */
     if ((k != 2) && (k != 3))   /* check the number */
       error(E_ARGCNT);          /* of arguments */
@@ -442,7 +1019,8 @@ int main (int argc, char *argv[])
     if ((!fn_tab || !*fn_tab) && (fn_inp && !*fn_inp))
       error(E_STDIN); }         /* stdin must not be used twice */
   else {                        /* if table version */
-    if (k != 3) error(E_ARGCNT);/* check number of arguments */
+    if ((k != 3) && ((k != 2) || (xfolds <= 0)))
+      error(E_ARGCNT);          /* check number of arguments */
     if (fn_hdr && (strcmp(fn_hdr, "-") == 0))
       fn_hdr = "";              /* convert "-" to "" */
     i = ( fn_hdr && !*fn_hdr) ? 1 : 0;
@@ -466,9 +1044,26 @@ int main (int argc, char *argv[])
   if ((moment < 0) || (moment >= 1)) error(E_MOMENT, moment);
   if ((decay  < 0) || (decay  >= 1)) error(E_LPARAM, decay);
   if (epochs  < 0) error(E_EPOCHS, epochs);
+  if ((xfolds < 0) || (xfolds == 1)) error(E_FOLDS, xfolds);
+  memset(&grid, 0, sizeof(grid));
+  if (swspec && (getgrid(&grid, swspec) != 0)) error(E_GRID, swspec);
+  if (valint  < 1) error(E_EPOCHS, valint);
+  if (patience < 0) error(E_EPOCHS, patience);
+  if ((hold   < 0) || (hold   >= 1)) error(E_LPARAM, hold);
+  if (fn_val && !*fn_val) error(E_STDIN);
+  if (fn_val) hold = 0;         /* a validation file takes precedence */
   rseed((unsigned)seed);        /* init. the random number generator */
+  if (fn_rep) {                 /* if to write a timing report */
+    if (strcmp(fn_rep, "-") == 0) fn_rep = "";
+    if (*fn_rep) { rep = fopen(fn_rep, "w"); }
+    else         { rep = stdout; fn_rep = "<stdout>"; }
+    if (!rep) error(E_FOPEN, fn_rep);
+    tms = tms_create(PRGNAME, phases, PH_CNT, rep, repmode);
+    if (!tms) error(E_NOMEM);   /* create the timing statistics */
+  }                             /* (measure phases, count patterns) */
   fputc('\n', stderr);          /* terminate the startup message */
 
+  TMS_BEG(tms, PH_READ);        /* time reading the input files */
   if (matinp) {                 /* if matrix version */
     /* --- parse multilayer perceptron --- */
     if (k <= 2) m = -1;         /* if no input, clear att. counter */
@@ -480,7 +1075,9 @@ int main (int argc, char *argv[])
         error(E_FOPEN, scn_name(scan));
       fprintf(stderr, "reading %s ... ", scn_name(scan));
       mlp = mlp_parse(scan);    /* parse the input network */
-      if (!mlp || !scn_eof(scan, 1)) error(E_PARSE, scn_name(scan));
+      if (!mlp || !scn_eof(scan, 1)
+      ||  (mlp_binwgts(mlp, scn_file(scan), NULL) != 0))
+        error(E_PARSE, scn_name(scan)); /* (no binary weights) */
       scn_delete(scan, 1);      /* delete the scanner */
       scan   = NULL;            /* and clear the variable */
       incnt  = mlp_incnt(mlp);  /* get number of input */
@@ -511,7 +1108,44 @@ int main (int argc, char *argv[])
     if (m <= 0) error(E_ATTCNT);/* check for at least one attribute */
     if (p <= 0) error(E_TPLCNT);/* check for at least one pattern */
 
+    /* --- get validation patterns --- */
+    if (fn_val) {               /* if a validation file is given */
+      tread = trd_create();     /* create a table reader and */
+      if (!tread) error(E_NOMEM);  /* set the separator characters */
+      trd_allchs(tread, recseps, fldseps, blanks, "", comment);
+      t = clock();              /* start timer, open input file */
+      if (trd_open(tread, NULL, fn_val) != 0)
+        error(E_FOPEN, trd_name(tread));
+      fprintf(stderr, "reading %s ... ", trd_name(tread));
+      k = mat_readx(&vmat, tread, 0, m);
+      if (k) error(k, TRD_INFO(tread));
+      trd_delete(tread, 1);     /* read the validation patterns, */
+      tread = NULL;             /* then close the input file */
+      fprintf(stderr, "[%"DIMID_FMT" pattern(s)]", mat_rowcnt(vmat));
+      fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+      if (mat_rowcnt(vmat) <= 0) error(E_TPLCNT); }
+    else if (hold > 0) {        /* if to hold out validation patterns */
+      TMS_BEG(tms, PH_SHUFFLE); /* (time the split like a shuffle) */
+      t = clock();              /* start the timer, print message */
+      fprintf(stderr, "splitting patterns ... ");
+      nv = (TPLID)(hold *(double)p +0.5);
+      if (nv <= 0) nv = 1;      /* get the number of valid. patterns */
+      if (nv >= (TPLID)p) error(E_TPLCNT);
+      mat_shuffle(matrix, drand);  /* shuffle the patterns and */
+      vmat = mat_create((DIMID)nv, m);   /* copy the last ones */
+      if (!vmat) error(E_NOMEM);   /* to the validation matrix */
+      mat_sub(vmat, matrix, p -(DIMID)nv, 0);
+      mat = mat_create(p -(DIMID)nv, m);
+      if (!mat) error(E_NOMEM); /* copy the remaining patterns */
+      mat_sub(mat, matrix, 0, 0);  /* to a new training matrix */
+      mat_delete(matrix); matrix = mat;
+      p = mat_rowcnt(matrix);   /* get the new number of patterns */
+      fprintf(stderr, "[%"DIMID_FMT"/%"TPLID_FMT" pattern(s)]", p, nv);
+      fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+    }                           /* print a success message */
+
     /* --- create multilayer perceptron --- */
+    TMS_END(tms);               /* (creation is not a timed phase) */
     if (!mlp) {                 /* if no input network is given */
       t = clock();              /* start the timer, print message */
       fprintf(stderr, "creating network ... ");
@@ -563,7 +1197,10 @@ int main (int argc, char *argv[])
       if (!attmap) error(E_NOMEM);    /* create an attribute map */
       am_target(attmap, trgid);       /* and set the target att. */
       mlp = mlp_parsex(scan, attmap); /* parse the neural network */
-      if (!mlp || !scn_eof(scan, 1)) error(E_PARSE, scn_name(scan));
+      given = 1;                /* and note that it is given */
+      if (!mlp || !scn_eof(scan, 1)
+      ||  (mlp_binwgts(mlp, scn_file(scan), NULL) != 0))
+        error(E_PARSE, scn_name(scan)); /* (no binary weights) */
       fprintf(stderr, "[%"DIMID_FMT" units,",   mlp_unitcnt(mlp));
       fprintf(stderr, " %"DIMID_FMT" weights]", mlp_wgtcnt(mlp));
     }                           /* print a success message */
@@ -595,22 +1232,61 @@ int main (int argc, char *argv[])
     if (trd_open(tread, NULL, fn_tab) != 0)
       error(E_FOPEN, trd_name(tread));
     fprintf(stderr, "reading %s ... ", trd_name(tread));
-    table = tab_create("table", attset, tpl_delete);
-    if (!table) error(E_NOMEM); /* create a data table */
-    k = tab_read(table, tread, mode);
-    if (k < 0) error(-k, tab_errmsg(table, NULL, 0));
+    table = tc_create(attset);  /* create a column-major table */
+    if (!table) error(E_NOMEM); /* and read the training patterns */
+    k = (thcnt != 1) ? tc_readp(table, tread, mode, thcnt)
+                     : tc_read (table, tread, mode);
+    if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
     trd_delete(tread, 1);       /* read the table body and */
     tread = NULL;               /* delete the table reader */
-    m = tab_colcnt(table);      /* get the number of attributes */
-    n = tab_tplcnt(table);      /* and the number of data tuples */
-    w = tab_tplwgt(table);      /* and print a success message */
+    m = tc_colcnt(table);       /* get the number of attributes */
+    n = tc_tplcnt(table);       /* and the number of data tuples */
+    w = tc_tplwgt(table);       /* and print a success message */
     fprintf(stderr, "[%"ATTID_FMT" attribute(s),", m);
     fprintf(stderr, " %"TPLID_FMT, n);
     if (w != (double)n) fprintf(stderr, "/%g", w);
     fprintf(stderr, " tuple(s)] done [%.2fs].\n", SEC_SINCE(t));
     if (n <= 0) error(E_TPLCNT);
 
+    /* --- get validation patterns --- */
+    if (fn_val) {               /* if a validation file is given */
+      tread = trd_create();     /* create a table reader and */
+      if (!tread) error(E_NOMEM);  /* set the separator characters */
+      trd_allchs(tread, recseps, fldseps, blanks, "", comment);
+      t = clock();              /* start timer, open input file */
+      if (trd_open(tread, NULL, fn_val) != 0)
+        error(E_FOPEN, trd_name(tread));
+      fprintf(stderr, "reading %s ... ", trd_name(tread));
+      valid = tc_create(attset);/* create a column-major table */
+      if (!valid) error(E_NOMEM);  /* and read the valid. patterns */
+      k = (thcnt != 1) ? tc_readp(valid, tread, mode, thcnt)
+                       : tc_read (valid, tread, mode);
+      if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
+      trd_delete(tread, 1);     /* read the table body and */
+      tread = NULL;             /* delete the table reader */
+      nv = tc_tplcnt(valid);    /* get the number of tuples */
+      fprintf(stderr, "[%"TPLID_FMT" tuple(s)]", nv);
+      fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+      if (nv <= 0) error(E_TPLCNT); }
+    else if (hold > 0) {        /* if to hold out validation tuples */
+      TMS_BEG(tms, PH_SHUFFLE); /* (time the split like a shuffle) */
+      t = clock();              /* start the timer, print message */
+      fprintf(stderr, "splitting tuples ... ");
+      nv = (TPLID)(hold *(double)n +0.5);
+      if (nv <= 0) nv = 1;      /* get the number of valid. tuples */
+      if (nv >= n) error(E_TPLCNT);
+      tc_shuffle(table, 0, TPLID_MAX, drand);
+      valid = tc_create(attset);/* shuffle the tuples and move */
+      if (!valid                /* the last ones to a valid. table */
+      ||  (tc_tplcut(valid, table, n-nv, nv) != 0))
+        error(E_NOMEM);         /* (the training table is compacted) */
+      n = tc_tplcnt(table);     /* get the new number of tuples */
+      fprintf(stderr, "[%"TPLID_FMT"/%"TPLID_FMT" tuple(s)]", n, nv);
+      fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+    }                           /* print a success message */
+
     /* --- create multilayer perceptron --- */
+    TMS_END(tms);               /* (creation is not a timed phase) */
     if (!mlp) {                 /* if no input network is given */
       t = clock();              /* start the timer, print message */
       fprintf(stderr, "creating network ... ");
@@ -621,7 +1297,7 @@ int main (int argc, char *argv[])
       if (!mlp) error(E_NOMEM); /* create a multilayer perceptron */
       mlp_init(mlp,drand,range);/* initialize the connection weights */
       for (r = 0; r < n; r++)   /* determine the ranges of values */
-        mlp_regx(mlp, tab_tpl(table, r), norm);
+        mlp_regx(mlp, tc_tpl(table, r), norm);
       mlp_regx(mlp, NULL, norm);/* compute the scaling parameters */
       if (expand != 1)          /* expand the output value ranges */
         for (c = 0; c < outcnt; c++) mlp_expand(mlp, c, expand);
@@ -631,10 +1307,281 @@ int main (int argc, char *argv[])
     }                           /* print a success message */
   }                             /* if (matinp) .. else .. */
 
+  /* --- set up sparse input --- */
+  if (sparse && (mlp_sparsex(mlp) != 0))
+    error(E_NOMEM);             /* fold 1-in-n scaling into weights */
+
+  /* --- cross-validate multilayer perceptron --- */
+  if (xfolds > 0) {             /* if to do a cross-validation */
+    t = clock();                /* start the timer, print message */
+    fprintf(stderr, "cross-validating network ... ");
+    n = tc_tplcnt(table);       /* get the number of tuples */
+    if (xfolds > n) error(E_FOLDS, xfolds);
+    trgid = mlp_trgid(mlp);     /* and the number of target values */
+    z   = (att_type(mlp_trgatt(mlp)) == AT_NOM)
+        ? att_valcnt(mlp_trgatt(mlp)) : 0;
+    pos = (TPLID*)malloc((size_t)(2*n+z+1) *sizeof(TPLID));
+    if (!pos) error(E_NOMEM);   /* create a position array */
+    for (r = 0; r < n; r++) pos[r] = r;
+    for (r = n; --r > 0; ) {    /* shuffle the tuple positions */
+      nv = (TPLID)((double)(r+1) *drand());
+      if (nv > r) nv = r;       /* compute a random index and */
+      x = pos[nv]; pos[nv] = pos[r]; pos[r] = x;
+    }                           /* exchange the positions */
+    if (z > 0) {                /* if the target is nominal, */
+      cnts = pos +2*n;          /* sort the positions by class */
+      memset(cnts, 0, (size_t)(z+1) *sizeof(TPLID));
+      for (r = 0; r < n; r++) { /* count the tuples per class */
+        i = tc_colval(table, pos[r], trgid)->n;
+        cnts[((i < 0) || (i >= z)) ? z : i]++;
+      }                         /* (null values are counted last) */
+      for (nv = 0, i = 0; i <= z; i++) {
+        r = cnts[i]; cnts[i] = nv; nv += r; }
+      for (r = 0; r < n; r++) { /* compute the class offsets */
+        i = tc_colval(table, pos[r], trgid)->n;
+        pos[n +cnts[((i < 0) || (i >= z)) ? z : i]++] = pos[r];
+      }                         /* (stable counting sort, so that */
+      memcpy(pos, pos+n, (size_t)n *sizeof(TPLID));
+    }                           /* assigning the tuples round robin */
+    folds = (XVFOLD*)calloc((size_t)xfolds, sizeof(XVFOLD));
+    if (!folds) error(E_NOMEM); /* gives stratified folds) */
+    fldcnt = xfolds;            /* create the cross-validation folds */
+    for (i = 0; i < xfolds; i++) {
+      folds[i].tst = (TPLID*)malloc((size_t)n *sizeof(TPLID));
+      if (!folds[i].tst) error(E_NOMEM);
+      folds[i].trn = folds[i].tst +(n -i +xfolds -1) /xfolds;
+      for (r = 0; r < n; r++) { /* split the positions into */
+        if (r % xfolds == i) folds[i].tst[folds[i].tstcnt++] = pos[r];
+        else                 folds[i].trn[folds[i].trncnt++] = pos[r];
+      }                         /* test and training positions */
+      folds[i].tab = table;     /* note the table of the tuples */
+      folds[i].tpl = tpl_create(attset, 0);
+      folds[i].rng = rng_create((unsigned)urand());
+      if (!folds[i].tpl || !folds[i].rng) error(E_NOMEM);
+      if (given)                /* if an input network is given, */
+        folds[i].mlp = mlp_clone(mlp);   /* start from its weights */
+      else {                    /* if no input network is given */
+        folds[i].mlp = mlp_createx(attmap, lyrcnt, ucnts);
+        if (!folds[i].mlp) error(E_NOMEM);
+        mlp_init(folds[i].mlp, drand, range);
+        for (r = 0; r < folds[i].trncnt; r++)
+          mlp_regx(folds[i].mlp, tc_tplx(table, folds[i].trn[r],
+                                         folds[i].tpl), norm);
+        mlp_regx(folds[i].mlp, NULL, norm);
+        if (expand != 1)        /* register the training tuples */
+          for (c = 0; c < outcnt; c++)
+            mlp_expand(folds[i].mlp, c, expand);
+      }                         /* (the test tuples are not used) */
+      if (!folds[i].mlp || (sparse && (mlp_sparsex(folds[i].mlp) != 0)))
+        error(E_NOMEM);         /* set up sparse input */
+      mlp_method (folds[i].mlp, method|scalar);
+      mlp_raise  (folds[i].mlp, raise);
+      mlp_lrate  (folds[i].mlp, lrate);
+      mlp_factors(folds[i].mlp, growth, shrink);
+      mlp_limits (folds[i].mlp, minchg, maxchg);
+      mlp_moment (folds[i].mlp, moment);
+      mlp_decay  (folds[i].mlp, decay);
+      mlp_setup  (folds[i].mlp);/* set the training parameters */
+      if ((update != 1) && !sparse
+      &&  (mlp_blksize(folds[i].mlp, MLP_BLKSIZE) != 0))
+        error(E_NOMEM);         /* create buffers for blocks */
+    }                           /* of training patterns */
+    free(pos);                  /* delete the position array */
+    xjob.cnt     = xfolds;      /* set up the cross-validation job */
+    xjob.folds   = folds;
+    xjob.incnt   = incnt;
+    xjob.epochs  = epochs;
+    xjob.update  = update;
+    xjob.shuffle = shuffle;
+    xjob.sparse  = sparse;
+    xjob.term    = term;
+    i = (thcnt > xfolds) ? xfolds : thcnt;
+    team = thr_create(i);       /* create a team of worker threads */
+    if (!team) error(E_THREAD, i);  /* and train the folds */
+    thr_run(team, xval, &xjob); /* (each fold on one thread) */
+    thr_delete(team); team = NULL;
+    fprintf(stderr, "[%d fold(s)]", xfolds);
+    fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+    fprintf(stderr, "fold  train   test  epochs"
+                    "   train sse    test sse  test errors\n");
+    for (terr = tsse = twgt = 0, i = 0; i < xfolds; i++) {
+      fprintf(stderr, "%4d %6"TPLID_FMT" %6"TPLID_FMT" %7"DIMID_FMT,
+              i, folds[i].trncnt, folds[i].tstcnt, folds[i].epochs);
+      fprintf(stderr, " %11g %11g", folds[i].sse, folds[i].tsse);
+      if (z > 0) fprintf(stderr, " %12g", folds[i].terr);
+      fprintf(stderr, "\n");   /* print the fold results */
+      tsse += folds[i].tsse;    /* and sum the test errors */
+      terr += folds[i].terr;    /* and the tuple weights */
+      for (r = 0; r < folds[i].tstcnt; r++)
+        twgt += tc_getwgt(table, folds[i].tst[r]);
+    }
+    fprintf(stderr, " all %6s %6"TPLID_FMT" %7s %11s %11g",
+            "", n, "", "", tsse);
+    if (z > 0) fprintf(stderr, " %12g (%.2f%%)", terr,
+                       (twgt > 0) ? 100*terr/twgt : 0.0);
+    fprintf(stderr, "\n");     /* print the aggregate results */
+    delfolds();                 /* delete the folds and */
+    if (!fn_mlp) {              /* if no network is to be written, */
+      if (tms && (report() != 0)) error(E_FWRITE, fn_rep);
+      CLEANUP;                  /* clean up memory and close files */
+      SHOWMEM;                  /* show (final) memory usage */
+      return 0;                 /* return 'ok' */
+    }                           /* (only cross-validation) */
+  }
+
+  /* --- encode training patterns --- */
+  if (!matinp && encode) {      /* if to encode the table */
+    t = clock();                /* start the timer, print message */
+    TMS_BEG(tms, PH_ENCODE);    /* (encoding is a timed phase) */
+    fprintf(stderr, "encoding patterns ... ");
+    incnt  = mlp_incnt(mlp);    /* get the number of inputs */
+    outcnt = mlp_outcnt(mlp);   /* and the number of outputs */
+    n      = tc_tplcnt(table);  /* and create a pattern matrix */
+    matrix = mat_create((DIMID)n, incnt +outcnt);
+    if (!matrix) error(E_NOMEM);
+    for (r = 0; r < n; r += (TPLID)b) {
+      b = (n-r < MLP_BLKSIZE) ? (DIMID)(n-r) : MLP_BLKSIZE;
+      for (j = 0; j < b; j++)   /* collect the rows of a block */
+        rows[j] = tc_row(table, r+(TPLID)j);
+      pat = mat_row(matrix, (DIMID)r); /* (matrix rows are contiguous) */
+      am_execc(attmap, table, rows, (TPLID)b, AM_INPUTS,
+               pat,        (size_t)(incnt +outcnt));
+      am_execc(attmap, table, rows, (TPLID)b, AM_TARGET,
+               pat +incnt, (size_t)(incnt +outcnt));
+    }                           /* map inputs and targets once */
+    TMS_END(tms);               /* end the encoding phase */
+    fprintf(stderr, "[%"TPLID_FMT" x %"DIMID_FMT"]", n, incnt +outcnt);
+    fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+  }                             /* (shuffling the matrix only permutes */
+                                /* row pointers, like tc_shuffle()) */
+
+  /* --- sweep hyperparameters --- */
+  if (swspec) {                 /* if to sweep hyperparameters */
+    t = clock();                /* start the timer, print message */
+    fprintf(stderr, "sweeping hyperparameters ... ");
+    if (grid.ccnt <= 0) {       /* fill missing parameter lists */
+      grid.ccnt = 1; grid.lyrcnts[0] = lyrcnt;     /* with the values */
+      memcpy(grid.ucnts[0], ucnts, sizeof(ucnts)); /* of the options */
+    }
+    if (grid.acnt <= 0) { grid.acnt = 1; grid.methods[0] = method; }
+    if (grid.tcnt <= 0) { grid.tcnt = 1; grid.lrates [0] = lrate;  }
+    if (grid.mcnt <= 0) { grid.mcnt = 1; grid.moments[0] = moment; }
+    if (grid.ycnt <= 0) { grid.ycnt = 1; grid.decays [0] = decay;  }
+    k = grid.ccnt *grid.acnt *grid.tcnt *grid.mcnt *grid.ycnt;
+    idx = (int*)malloc((size_t)k *sizeof(int));
+    if (!idx) error(E_NOMEM);   /* create an index array */
+    for (i = 0; i < k; i++) idx[i] = i;
+    if ((rndcnt > 0) && (rndcnt < k)) {
+      for (i = 0; i < rndcnt; i++) {  /* draw random grid points */
+        j = (DIMID)((double)(k-i) *drand());
+        if (j >= (DIMID)(k-i)) j = (DIMID)(k-i-1);
+        h = idx[i+(int)j]; idx[i+(int)j] = idx[i]; idx[i] = h;
+      }                         /* (partial Fisher-Yates shuffle) */
+      k = rndcnt;               /* and reduce the number of */
+    }                           /* candidates to the drawn ones */
+    swjob.cands = (SWCAND*)calloc((size_t)k, sizeof(SWCAND));
+    if (!swjob.cands) error(E_NOMEM);
+    swjob.cnt = k;              /* create the candidates */
+    n = tc_tplcnt(table);       /* get the number of training tuples */
+    for (i = 0; i < k; i++) {   /* traverse the candidates */
+      cand = swjob.cands +i;    /* decode the grid point index */
+      j = (DIMID)idx[i];        /* into the parameter values */
+      cand->lyrcnt = grid.lyrcnts[j % grid.ccnt];
+      cand->ucnts  = grid.ucnts  [j % grid.ccnt]; j /= grid.ccnt;
+      cand->method = grid.methods[j % grid.acnt]; j /= grid.acnt;
+      cand->lrate  = grid.lrates [j % grid.tcnt]; j /= grid.tcnt;
+      cand->moment = grid.moments[j % grid.mcnt]; j /= grid.mcnt;
+      cand->decay  = grid.decays [j % grid.ycnt];
+      if ((cand->lrate  <= 0) || (cand->moment < 0) || (cand->moment >= 1)
+      ||  (cand->decay  <  0) || (cand->decay >= 1))
+        error(E_GRID, swspec);  /* check the parameter values */
+      cand->fold.tab    = valid;/* evaluate on the validation table */
+      cand->fold.tstcnt = tc_tplcnt(valid);
+      cand->fold.trncnt = n;    /* train on all training tuples */
+      cand->fold.tpl    = tpl_create(attset, 0);
+      cand->fold.rng    = rng_create((unsigned)urand());
+      if (!cand->fold.tpl || !cand->fold.rng) error(E_NOMEM);
+      if (given) {              /* if an input network is given, */
+        cand->fold.mlp = mlp_clone(mlp);   /* start from its weights */
+        if (!cand->fold.mlp) error(E_NOMEM); }
+      else {                    /* if no input network is given */
+        cand->fold.mlp = mlp_createx(attmap, cand->lyrcnt, cand->ucnts);
+        if (!cand->fold.mlp || (mlp_normcopy(cand->fold.mlp, mlp) != 0))
+          error(E_NOMEM);       /* create a network and copy the */
+        mlp_init(cand->fold.mlp, drand, range);  /* input scaling */
+      }                         /* (the data is not registered again) */
+      if (sparse && (mlp_sparsex(cand->fold.mlp) != 0))
+        error(E_NOMEM);         /* set up sparse input */
+      mlp_method (cand->fold.mlp, cand->method|scalar);
+      mlp_raise  (cand->fold.mlp, raise);
+      mlp_lrate  (cand->fold.mlp, cand->lrate);
+      mlp_factors(cand->fold.mlp, growth, shrink);
+      mlp_limits (cand->fold.mlp, minchg, maxchg);
+      mlp_moment (cand->fold.mlp, cand->moment);
+      mlp_decay  (cand->fold.mlp, cand->decay);
+      mlp_setup  (cand->fold.mlp);    /* set the training parameters */
+      if ((update != 1) && !sparse
+      &&  (mlp_blksize(cand->fold.mlp, MLP_BLKSIZE) != 0))
+        error(E_NOMEM);         /* create buffers for blocks */
+    }                           /* of training patterns */
+    free(idx);                  /* delete the index array */
+    swjob.xv.incnt   = mlp_incnt(mlp);
+    swjob.xv.epochs  = epochs;  /* set up the sweep job */
+    swjob.xv.update  = update;
+    swjob.xv.shuffle = shuffle;
+    swjob.xv.sparse  = sparse;
+    swjob.xv.term    = term;
+    swjob.mis = !sse4nom && (att_type(mlp_trgatt(mlp)) == AT_NOM);
+    i = (thcnt > k) ? k : thcnt;/* get the number of threads */
+    team = thr_create(i);       /* and create a team of threads */
+    if (!team) error(E_THREAD, i);
+    for (i = 0; i < thr_cnt(team); i++) {
+      swjob.bufs[i] = (TPLID*)malloc((size_t)n *sizeof(TPLID));
+      if (!swjob.bufs[i]) error(E_NOMEM);
+    }                           /* create the position buffers */
+    thr_run(team, sweep, &swjob);  /* train the candidates */
+    thr_delete(team); team = NULL; /* (in parallel, read-only data) */
+    fprintf(stderr, "[%d candidate(s)]", k);
+    fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+    rank = (SWCAND**)malloc((size_t)k *sizeof(SWCAND*));
+    if (!rank) error(E_NOMEM);  /* rank the candidates */
+    for (i = 0; i < k; i++) rank[i] = swjob.cands +i;
+    ptr_qsort(rank, (size_t)k, +1, candcmp, NULL);
+    fprintf(stderr, "rank  units       method     lrate  moment"
+                    "   decay  epochs   valid sse  valid errors\n");
+    for (i = 0; i < k; i++) {   /* print the ranking */
+      cand = rank[i];           /* of the candidates */
+      fprintf(stderr, "%4d  ", i+1);
+      if (given) fprintf(stderr, "%-10s", "(input)");
+      else {                    /* print the hidden units */
+        for (h = 0, j = 1; j < cand->lyrcnt-1; j++)
+          h += fprintf(stderr, (j > 1) ? ":%"DIMID_FMT : "%"DIMID_FMT,
+                       cand->ucnts[j]);
+        if (j <= 1) h = fprintf(stderr, "0");
+        fprintf(stderr, "%*s", (h < 10) ? 10-h : 0, "");
+      }                         /* pad to a fixed width */
+      fprintf(stderr, "  %-9s %7g %7g %7g %7"DIMID_FMT" %11g",
+              updtab[cand->method].name, cand->lrate, cand->moment,
+              cand->decay, cand->fold.epochs, cand->fold.tsse);
+      if (att_type(mlp_trgatt(mlp)) == AT_NOM)
+        fprintf(stderr, " %13g", cand->fold.terr);
+      fprintf(stderr, "\n");   /* print the parameters, */
+    }                           /* the number of epochs and */
+    cand = rank[0];             /* the validation errors */
+    free(rank);                 /* get the best candidate */
+    if (given) mlp_wgtcopy(mlp, cand->fold.mlp);
+    else { mlp_delete(mlp); mlp = cand->fold.mlp; cand->fold.mlp = NULL; }
+    delcands();                 /* replace the network by the best */
+    tc_delete(valid, 0);        /* delete the candidates and the */
+    valid  = NULL;              /* validation patterns, which are */
+    epochs = 0;                 /* not needed anymore (the best */
+  }                             /* network is already trained) */
+
   /* --- train multilayer perceptron --- */
   t = clock();                  /* start the timer */
-  fprintf(stderr, "training network ... ");
-  mlp_method (mlp, method);     /* set the weight update method, */
+  if (!swspec)                  /* (after a sweep the best network */
+    fprintf(stderr, "training network ... ");  /* is already trained) */
+  mlp_method (mlp, method|scalar); /* set the update method, */
   mlp_raise  (mlp, raise);      /* the derivative raise value, */
   mlp_lrate  (mlp, lrate);      /* the learning rate, */
   mlp_factors(mlp, growth, shrink); /* the growth and shrink factors, */
@@ -643,30 +1590,151 @@ int main (int argc, char *argv[])
   mlp_decay  (mlp, decay);      /* and the weight decay factor */
   mlp_setup  (mlp);             /* set up network for training */
   u = update; v = 0;            /* and initialize the counters */
+  if ((update != 1) && !sparse  /* if to update after several patt., */
+  &&  (mlp_blksize(mlp, MLP_BLKSIZE) != 0))  /* create buffers for */
+    error(E_NOMEM);             /* blocks of training patterns */
+  if ((update != 1) && !sparse && (thcnt != 1)) {
+    team = thr_create(thcnt);   /* create a team of worker threads */
+    if (!team) error(E_THREAD, thcnt);
+    shds[0] = mlp;              /* the network itself serves thread 0 */
+    for (i = 1; i < thr_cnt(team); i++) {
+      shds[i] = mlp_shadow(mlp);/* create shadow networks that share */
+      if (!shds[i] || (mlp_blksize(shds[i], MLP_BLKSIZE) != 0))
+        error(E_NOMEM);         /* the connection weights, but have */
+    }                           /* their own gradients and buffers */
+    if (thr_cnt(team) <= 1) delthr();
+  }                             /* (only one processor: no threads) */
+  job.matinp = (matrix != NULL);/* note the input mode and */
+  job.incnt  = incnt;           /* the number of input units */
+  job.timed  = (tms != NULL);   /* and whether to time the phases */
+  if (valid || vmat) {          /* if validation patterns are given */
+    vteam = thr_create(2);      /* create a thread for the validation */
+    if (!vteam) error(E_THREAD, 2);
+    for (i = 0; i < 2; i++) {   /* create networks for snapshots */
+      snaps[i] = mlp_clone(mlp);/* of the connection weights */
+      if (!snaps[i]) error(E_NOMEM);
+    }                           /* (validated and best snapshot) */
+    vjob.incnt = incnt;         /* initialize the validation job */
+    vjob.mis   = !vmat && !sse4nom && (att_type(mlp_trgatt(mlp))==AT_NOM);
+    vjob.epoch = vjob.best = -1;
+    vjob.min   = INFINITY;
+    vjob.bad   = 0;
+  }
+  vc = valint;                  /* init. the validation counter */
+  if (tms) tms_mark(tms);       /* start the first timed epoch */
   for (e = 0; e < epochs; e++){ /* do "epochs" epochs of training */
-    if (matinp) {               /* if matrix version */
-      if (shuffle)              /* shuffle the training patterns */
-        mat_shuffle(matrix, drand);
-      for (sse = 0, p = mat_rowcnt(matrix); --p >= 0; ) {
-        pat = mat_row(matrix, p);  /* traverse the training patterns */
-        mlp_exec(mlp, pat, NULL);  /* execute the neural network and */
-        sse += mlp_bkprop(mlp, pat +incnt);    /* do error backprop. */
-        if ((update > 0) && (--u <= 0)) {
-          u = update; mlp_update(mlp); }
+    if (tms && (tms_pats(tms) > 0) && (epoch(mlp_wgtcnt(mlp)) != 0))
+      error(E_FWRITE, fn_rep);  /* report the previous epoch */
+    if (team) {                 /* if to train with several threads */
+      if (shuffle) {            /* shuffle the training patterns */
+        TMS_BEG(tms, PH_SHUFFLE);
+        if (matrix) mat_shuffle(matrix, drand);
+        else        tc_shuffle(table, 0, TPLID_MAX, drand);
+      }                         /* get the number of patterns */
+      n = (matrix) ? (TPLID)mat_rowcnt(matrix) : tc_tplcnt(table);
+      for (sse = 0; n > 0; n -= job.cnt) {
+        job.cnt = ((update > 0) && (u < n)) ? (TPLID)u : n;
+        job.beg = n -job.cnt;   /* get the patterns up to next update */
+        TMS_END(tms);           /* (the threads time their phases) */
+        thr_run(team, train, &job);  /* and process them in parallel */
+        TMS_BEG(tms, PH_BKPROP);
+        for (i = 0; i < thr_cnt(team); i++) {
+          if (i > 0) mlp_merge(mlp, shds[i]);
+          sse += job.sse[i];    /* merge the gradients and errors */
+          if (!tms) continue;   /* in a fixed order (deterministic) */
+          tms_add(tms, PH_ENCODE,  job.secs[i][0]);
+          tms_add(tms, PH_FORWARD, job.secs[i][1]);
+          tms_add(tms, PH_BKPROP,  job.secs[i][2]);
+        }                       /* sum the busy times of the threads */
+        if ((update > 0) && ((u -= (DIMID)job.cnt) <= 0)) {
+          TMS_BEG(tms, PH_UPDATE); u = update; mlp_update(mlp); }
       } }                       /* update after 'update' patterns */
+    else if (matrix) {          /* if matrix version (or encoded) */
+      if (shuffle) {            /* shuffle the training patterns */
+        TMS_BEG(tms, PH_SHUFFLE); mat_shuffle(matrix, drand); }
+      p = mat_rowcnt(matrix);   /* get the number of patterns */
+      if (update == 1) {        /* if to update after each pattern */
+        for (sse = 0; --p >= 0; ) {
+          pat = mat_row(matrix, p);   /* traverse the patterns */
+          TMS_BEG(tms, PH_FORWARD);
+          mlp_exec(mlp, pat, NULL);   /* execute the neural network */
+          TMS_BEG(tms, PH_BKPROP);
+          sse += mlp_bkprop(mlp, pat +incnt);  /* and backpropagate */
+          TMS_BEG(tms, PH_UPDATE);
+          mlp_update(mlp);      /* update the connection weights */
+        } }                     /* after each pattern */
+      else {                    /* if to process blocks of patterns */
+        for (sse = 0; p > 0; p -= b) {
+          b = (p < MLP_BLKSIZE) ? p : MLP_BLKSIZE;
+          if ((update > 0) && (u < b)) b = u;
+          TMS_BEG(tms, PH_ENCODE);
+          for (j = 0; j < b; j++) {   /* traverse the block patterns */
+            pat = mat_row(matrix, p-1-j);
+            mlp_inputb (mlp, j, pat);
+            mlp_targetb(mlp, j, pat +incnt);
+          }                     /* set inputs and targets */
+          TMS_BEG(tms, PH_FORWARD);
+          mlp_execb(mlp, NULL, b, NULL);   /* execute the network */
+          TMS_BEG(tms, PH_BKPROP);
+          sse += mlp_bkpropb(mlp, NULL, b);/* and backpropagate */
+          if ((update > 0) && ((u -= b) <= 0)) {
+            TMS_BEG(tms, PH_UPDATE); u = update; mlp_update(mlp); }
+        }                       /* update after 'update' patterns */
+      } }
     else {                      /* if table version */
-      if (shuffle)              /* shuffle the training patterns */
-        tab_shuffle(table, 0, TPLID_MAX, drand);
-      for (sse = 0, n = tab_tplcnt(table); --n >= 0; ) {
-        tpl = tab_tpl(table,n); /* traverse the training patterns */
-        mlp_inputx(mlp, tpl);   /* and enter them into the network */
-        mlp_exec(mlp,NULL,NULL);/* execute the neural network */
-        mlp_targetx(mlp, tpl);  /* set the target output value and */
-        sse += mlp_bkprop(mlp, NULL);  /* do error backpropagation */
-        if ((update > 0) && (--u <= 0)) {
-          u = update; mlp_update(mlp); }
-      }                         /* update after 'update' patterns */
+      if (shuffle) {            /* shuffle the training patterns */
+        TMS_BEG(tms, PH_SHUFFLE); tc_shuffle(table, 0, TPLID_MAX, drand); }
+      n = tc_tplcnt(table);     /* get the number of patterns */
+      if (sparse) {             /* if to use sparse inputs */
+        for (sse = 0; --n >= 0; ) {
+          tpl = tc_tpl(table, n);   /* traverse the patterns */
+          TMS_BEG(tms, PH_ENCODE);
+          mlp_inputxs(mlp, tpl);    /* and enter them into the net */
+          TMS_BEG(tms, PH_FORWARD);
+          mlp_execs(mlp, NULL, NULL, 0, NULL);   /* execute network */
+          TMS_BEG(tms, PH_ENCODE);
+          mlp_targetx(mlp, tpl);    /* set the target output values */
+          TMS_BEG(tms, PH_BKPROP);
+          sse += mlp_bkprops(mlp, NULL); /* and backpropagate */
+          if ((update > 0) && (--u <= 0)) {
+            TMS_BEG(tms, PH_UPDATE); u = update; mlp_update(mlp); }
+        } }                     /* update after 'update' patterns */
+      else if (update == 1) {   /* if to update after each pattern */
+        for (sse = 0; --n >= 0; ) {
+          tpl = tc_tpl(table, n);   /* traverse the patterns */
+          TMS_BEG(tms, PH_ENCODE);
+          mlp_inputx(mlp, tpl);     /* and enter them into the net */
+          TMS_BEG(tms, PH_FORWARD);
+          mlp_exec(mlp,NULL,NULL);  /* execute the neural network */
+          TMS_BEG(tms, PH_ENCODE);
+          mlp_targetx(mlp, tpl);    /* set the target output values */
+          TMS_BEG(tms, PH_BKPROP);
+          sse += mlp_bkprop(mlp, NULL);  /* and backpropagate */
+          TMS_BEG(tms, PH_UPDATE);
+          mlp_update(mlp);      /* update the connection weights */
+        } }                     /* after each pattern */
+      else {                    /* if to process blocks of patterns */
+        for (sse = 0; n > 0; n -= (TPLID)b) {
+          b = (n < MLP_BLKSIZE) ? (DIMID)n : MLP_BLKSIZE;
+          if ((update > 0) && (u < b)) b = u;
+          TMS_BEG(tms, PH_ENCODE);
+          for (j = 0; j < b; j++)     /* collect the rows */
+            rows[j] = tc_row(table, n-1-(TPLID)j);
+          mlp_inputcb (mlp, table, rows, b);
+          mlp_targetcb(mlp, table, rows, b);
+          TMS_BEG(tms, PH_FORWARD);
+          mlp_execb(mlp, NULL, b, NULL);   /* execute the network */
+          TMS_BEG(tms, PH_BKPROP);
+          sse += mlp_bkpropb(mlp, NULL, b);/* and backpropagate */
+          if ((update > 0) && ((u -= b) <= 0)) {
+            TMS_BEG(tms, PH_UPDATE); u = update; mlp_update(mlp); }
+        }                       /* update after 'update' patterns */
+      }
     }                           /* if (matinp) .. else .. */
+    TMS_END(tms);               /* end the last training phase */
+    if (tms)                    /* count the training patterns */
+      tms_count(tms, (matrix) ? (double)mat_rowcnt(matrix)
+                              : (double)tc_tplcnt(table), 0);
     if ((term >= 0)             /* if termination error set or */
     || (verbose && (--v <= 0))){/* if a verbose output is requested */
       if (matinp && !sse4nom)   /* compute the misclassifications */
@@ -676,15 +1744,47 @@ int main (int argc, char *argv[])
         fprintf(stderr, "%15g\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b", sse);
       v = verbose;              /* print sum of (squared) errors */
     }                           /* every 'verbose' epochs */
-    if (update <= 0)            /* if no number of patterns is given, */
-      mlp_update(mlp);          /* update once in each epoch */
+    if (update <= 0) {          /* if no number of patterns is given, */
+      TMS_BEG(tms, PH_UPDATE);  /* update once in each epoch */
+      mlp_update(mlp); TMS_END(tms);
+    }
     if (jog > 0)                /* if a range for weight jogging */
       mlp_jog(mlp, drand, jog); /* is given, jog the weights */
+    if (!vteam || (--vc > 0))   /* if not to validate in this epoch, */
+      continue;                 /* continue with the next epoch */
+    vc = valint;                /* reinit. the validation counter */
+    if (vpend) {                /* if a validation is running, */
+      thr_wait(vteam); vpend = 0; /* wait for it to finish */
+      valchk(&vjob);            /* and check whether the snapshot */
+    }                           /* is better than the best one */
+    if ((patience > 0) && (vjob.bad >= patience)) {
+      e++; break; }             /* if no improvement, stop training */
+    mlp_wgtcopy(snaps[0], mlp); /* take a snapshot of the weights */
+    vjob.net   = snaps[0];      /* and evaluate it in the background */
+    vjob.epoch = e+1;           /* on the validation patterns, */
+    thr_start(vteam, validate, &vjob); /* while the training */
+    vpend = 1;                  /* continues with the next epochs */
   }
+  if (tms && (tms_pats(tms) > 0) && (epoch(mlp_wgtcnt(mlp)) != 0))
+    error(E_FWRITE, fn_rep);    /* report the last epoch */
   if (verbose)                  /* clear verbose error output */
     fprintf(stderr, "               \b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+  if (vteam) {                  /* if validation patterns are given */
+    if (vpend) {                /* if a validation is running, */
+      thr_wait(vteam); vpend = 0; /* wait for it to finish */
+      valchk(&vjob);            /* and check the snapshot */
+    }
+    if (vjob.epoch != e) {      /* if the final weights are not */
+      mlp_wgtcopy(snaps[0], mlp);  /* validated yet, evaluate them */
+      vjob.net   = snaps[0];    /* (in the calling thread) */
+      vjob.epoch = e;
+      validate(&vjob, 0); valchk(&vjob);
+    }                           /* restore the best snapshot */
+    mlp_wgtcopy(mlp, snaps[1]); /* of the connection weights */
+  }
 
   /* --- compute sse of trained network --- */
+  TMS_BEG(tms, PH_FORWARD);     /* (execution is a timed phase) */
   if (matinp) {                 /* if matrix version */
     for (sse = err = 0, p = mat_rowcnt(matrix); --p >= 0; ) {
       pat = mat_row(matrix, p); /* traverse the training patterns */
@@ -694,11 +1794,18 @@ int main (int argc, char *argv[])
   else {                        /* if table version */
     sse = geterr(mlp, table, &err);
   }                             /* compute the number of errors */
-  fprintf(stderr, "[%"DIMID_FMT" epoch(s)]", e);
-  fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+  TMS_END(tms);                 /* end the execution phase */
+  if (!swspec) {                /* if a network was trained */
+    fprintf(stderr, "[%"DIMID_FMT" epoch(s)", e);
+    if (vteam)                  /* report the best snapshot */
+      fprintf(stderr, ", best: %"DIMID_FMT" (%s: %g)", vjob.best,
+              (vjob.mis) ? "valid. errors" : "valid. sse", vjob.min);
+    fprintf(stderr, "] done [%.2fs].\n", SEC_SINCE(t));
+  }
 
   /* --- describe multilayer perceptron --- */
   t = clock();                  /* start timer, open output file */
+  TMS_BEG(tms, PH_OUTPUT);      /* (writing is a timed phase) */
   if (fn_mlp && (strcmp(fn_mlp, "-") == 0)) fn_mlp = "";
   if (fn_mlp && *fn_mlp) { out = fopen(fn_mlp, "w"); }
   else                   { out = stdout; fn_mlp = "<stdout>"; }
@@ -714,11 +1821,16 @@ int main (int argc, char *argv[])
   if (out && (((out == stdout) ? fflush(out) : fclose(out)) != 0))
     error(E_FWRITE, fn_mlp);    /* close the output file and */
   out = NULL;                   /* print a success message */
+  TMS_END(tms);                 /* end the output phase */
   fprintf(stderr, "[sse: %g", sse);
   if (!matinp && (att_type(mlp_trgatt(mlp)) == AT_NOM))
     fprintf(stderr, ", %g error(s)", err);
   fprintf(stderr, "] done [%.2fs].\n", SEC_SINCE(t));
 
+  /* --- write timing report --- */
+  if (tms && (report() != 0))   /* write the report for the run */
+    error(E_FWRITE, fn_rep);    /* (and close the report file) */
+
   /* --- clean up --- */
   CLEANUP;                      /* clean up memory and close files */
   SHOWMEM;                      /* show (final) memory usage */
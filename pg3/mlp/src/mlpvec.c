@@ -0,0 +1,214 @@
+/*----------------------------------------------------------------------
+  File    : mlpvec.c
+  Contents: vectorized kernels for multilayer perceptrons
+  Author  : Christian Borgelt
+  History : 2016.05.09 file created (activation functions)
+            2016.05.11 single precision versions added
+----------------------------------------------------------------------*/
+#include <string.h>
+#include <stdint.h>
+#include "mlpvec.h"
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+/* The kernels are written as simple, branch-free loops, which the   */
+/* compiler vectorizes. With GCC on x86 processors several versions   */
+/* (AVX-512, AVX2 and the SSE2 baseline) are compiled and the best    */
+/* one for the executing processor is selected at load time.          */
+#if defined __GNUC__ && !defined __clang__ && !defined MV_NOCLONES \
+&&  (__GNUC__ >= 6) && (defined __x86_64__ || defined __i386__)
+#define MV_CLONES   __attribute__((target_clones("avx512f","avx2",\
+                                                 "default")))
+#else                           /* if runtime dispatch is possible, */
+#define MV_CLONES               /* compile several versions */
+#endif                          /* of the kernel functions */
+
+/* --- exponential function --- */
+#define EXPMAX      708.0       /* maximal argument of exp() */
+#define LOG2E       1.4426950408889634074   /* 1/ln(2) */
+#define LN2HI       6.93145751953125e-1     /* ln(2), high part */
+#define LN2LO       1.42860682030941723212e-6 /* ln(2), low part */
+#define SHIFTER     6755399441055744.0      /* 1.5 * 2^52 */
+
+#define EXPMAXF     87.0f       /* maximal argument of expf() */
+#define LOG2EF      1.44269504f /* 1/ln(2) */
+#define LN2HIF      0.693359375f       /* ln(2), high part */
+#define LN2LOF      (-2.12194440e-4f)  /* ln(2), low part */
+#define SHIFTERF    12582912.0f /* 1.5 * 2^23 */
+
+/* Exponential function: the argument is reduced to r = x -k*ln(2)  */
+/* with |r| <= ln(2)/2 (Cody-Waite reduction), exp(r) is computed    */
+/* with a Taylor polynomial of degree 13 (truncation error < 2e-16)  */
+/* and the result is scaled by 2^k by constructing the exponent bits. */
+/* Arguments are clamped to [-708,708], so the result is a normal     */
+/* number; this changes logistic/tanh values by less than 1e-307.     */
+/* The single precision version uses a polynomial of degree 7 (trunc. */
+/* error < 6e-9) and clamps the argument to [-87,87] (change < 2e-38).*/
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static inline double expk (double x)
+{                               /* --- exponential function (kernel) */
+  double   d, k, r, p;          /* shifted argument, exponent, poly. */
+  uint64_t b;                   /* bit representation of 2^k */
+
+  x = (x >  EXPMAX) ?  EXPMAX : x;  /* clamp the argument */
+  x = (x < -EXPMAX) ? -EXPMAX : x;  /* to the normal range */
+  d = x *LOG2E +SHIFTER;        /* round x/ln(2) to an integer */
+  k = d -SHIFTER;               /* (low bits of d contain k) */
+  r = (x -k *LN2HI) -k *LN2LO;  /* reduce the argument */
+  p =      1.0/6227020800.0;    /* evaluate Taylor polynomial */
+  p = p*r +1.0/479001600.0;     /* of degree 13 (Horner scheme) */
+  p = p*r +1.0/39916800.0;
+  p = p*r +1.0/3628800.0;
+  p = p*r +1.0/362880.0;
+  p = p*r +1.0/40320.0;
+  p = p*r +1.0/5040.0;
+  p = p*r +1.0/720.0;
+  p = p*r +1.0/120.0;
+  p = p*r +1.0/24.0;
+  p = p*r +1.0/6.0;
+  p = p*r +0.5;
+  p = p*r +1.0;
+  p = p*r +1.0;
+  memcpy(&b, &d, sizeof(b));    /* get the bits of the shifted value */
+  b = (b +1023) << 52;          /* and build 2^k from them */
+  memcpy(&d, &b, sizeof(d));    /* (the shift removes the offset) */
+  return p *d;                  /* return exp(r) *2^k */
+}  /* expk() */
+
+/*--------------------------------------------------------------------*/
+
+static inline float expkf (float x)
+{                               /* --- exponential function (kernel) */
+  float    d, k, r, p;          /* shifted argument, exponent, poly. */
+  uint32_t b;                   /* bit representation of 2^k */
+
+  x = (x >  EXPMAXF) ?  EXPMAXF : x;  /* clamp the argument */
+  x = (x < -EXPMAXF) ? -EXPMAXF : x;  /* to the normal range */
+  d = x *LOG2EF +SHIFTERF;      /* round x/ln(2) to an integer */
+  k = d -SHIFTERF;              /* (low bits of d contain k) */
+  r = (x -k *LN2HIF) -k *LN2LOF;/* reduce the argument */
+  p =      1.0f/5040.0f;        /* evaluate Taylor polynomial */
+  p = p*r +1.0f/720.0f;         /* of degree 7 (Horner scheme) */
+  p = p*r +1.0f/120.0f;
+  p = p*r +1.0f/24.0f;
+  p = p*r +1.0f/6.0f;
+  p = p*r +0.5f;
+  p = p*r +1.0f;
+  p = p*r +1.0f;
+  memcpy(&b, &d, sizeof(b));    /* get the bits of the shifted value */
+  b = (b +127) << 23;           /* and build 2^k from them */
+  memcpy(&d, &b, sizeof(d));    /* (the shift removes the offset) */
+  return p *d;                  /* return exp(r) *2^k */
+}  /* expkf() */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+
+const char* mv_isa (void)
+{                               /* --- get instruction set in use */
+  #if defined __GNUC__ && !defined __clang__ && !defined MV_NOCLONES \
+  &&  (__GNUC__ >= 6) && (defined __x86_64__ || defined __i386__)
+  __builtin_cpu_init();         /* check the processor features */
+  if (__builtin_cpu_supports("avx512f")) return "avx512f";
+  if (__builtin_cpu_supports("avx2"))    return "avx2";
+  return "sse2";                /* return the selected version */
+  #else                         /* (same order as target_clones) */
+  return "generic";             /* no runtime dispatch */
+  #endif
+}  /* mv_isa() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_exp (double *x, size_t n)
+{                               /* --- exponential function */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = expk(x[i]);
+}  /* mv_exp() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_logistic (double *x, size_t n)
+{                               /* --- logistic function */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = 1/(1 +expk(-x[i]));
+}  /* mv_logistic() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_tanh (double *x, size_t n)
+{                               /* --- tangens hyperbolicus */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = 2/(1 +expk(-2*x[i])) -1;
+}  /* mv_tanh() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_dlogistic (double *e, const double *y, size_t n, double raise)
+{                               /* --- multiply with logistic deriv. */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) e[i] *= y[i]*(1-y[i]) +raise;
+}  /* mv_dlogistic() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_dtanh (double *e, const double *y, size_t n, double raise)
+{                               /* --- multiply with tanh derivative */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) e[i] *= (1+y[i])*(1-y[i]) +raise;
+}  /* mv_dtanh() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_expf (float *x, size_t n)
+{                               /* --- exponential function */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = expkf(x[i]);
+}  /* mv_expf() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_logisticf (float *x, size_t n)
+{                               /* --- logistic function */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = 1/(1 +expkf(-x[i]));
+}  /* mv_logisticf() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_tanhf (float *x, size_t n)
+{                               /* --- tangens hyperbolicus */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) x[i] = 2/(1 +expkf(-2*x[i])) -1;
+}  /* mv_tanhf() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_dlogisticf (float *e, const float *y, size_t n, float raise)
+{                               /* --- multiply with logistic deriv. */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) e[i] *= y[i]*(1-y[i]) +raise;
+}  /* mv_dlogisticf() */
+
+/*--------------------------------------------------------------------*/
+
+MV_CLONES
+void mv_dtanhf (float *e, const float *y, size_t n, float raise)
+{                               /* --- multiply with tanh derivative */
+  size_t i;                     /* loop variable */
+  for (i = 0; i < n; i++) e[i] *= (1+y[i])*(1-y[i]) +raise;
+}  /* mv_dtanhf() */
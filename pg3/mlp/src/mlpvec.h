@@ -0,0 +1,38 @@
+/*----------------------------------------------------------------------
+  File    : mlpvec.h
+  Contents: vectorized kernels for multilayer perceptrons
+  Author  : Christian Borgelt
+  History : 2016.05.09 file created (activation functions)
+            2016.05.11 single precision versions added
+----------------------------------------------------------------------*/
+#ifndef __MLPVEC__
+#define __MLPVEC__
+#include <stddef.h>
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define MV_MAXERR   1e-15       /* max. deviation from libm results */
+#define MV_MAXERRF  1e-6        /* (double and single precision) */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern const char* mv_isa       (void);
+extern void        mv_exp       (double *x, size_t n);
+extern void        mv_logistic  (double *x, size_t n);
+extern void        mv_tanh      (double *x, size_t n);
+extern void        mv_dlogistic (double *e, const double *y,
+                                 size_t n, double raise);
+extern void        mv_dtanh     (double *e, const double *y,
+                                 size_t n, double raise);
+
+extern void        mv_expf      (float  *x, size_t n);
+extern void        mv_logisticf (float  *x, size_t n);
+extern void        mv_tanhf     (float  *x, size_t n);
+extern void        mv_dlogisticf(float  *e, const float  *y,
+                                 size_t n, float  raise);
+extern void        mv_dtanhf    (float  *e, const float  *y,
+                                 size_t n, float  raise);
+
+#endif
@@ -21,6 +21,12 @@
             2013.08.20 output format changed to significant digits
             2013.08.30 missing deallocation of pattern buffer added
             2014.10.24 changed from LGPL license to MIT license
+            2016.05.02 matrix version executes blocks of patterns
+            2016.05.12 binary network files detected automatically
+            2016.05.13 aligned output without reading a table (2 passes)
+            2016.05.13 option -t# added (pipelined execution, matrices)
+            2016.05.16 options -Q#, -K# added (phase timing report)
+            2016.05.16 -t# <= 0 means one thread per processor
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,6 +60,8 @@
 #define MLP_EXTFN
 #endif
 #include "mlp.h"
+#include "thread.h"
+#include "tmstat.h"
 #include "error.h"
 #ifdef STORAGE
 #include "storage.h"
@@ -81,11 +89,22 @@
 #define E_PARSE      (-9)       /* parse errors on input file */
 #define E_PATSIZE   (-10)       /* invalid pattern size */
 #define E_OUTPUT    (-11)       /* target in input or write output */
+#define E_BINARY    (-12)       /* invalid binary network file */
+#define E_THREAD    (-13)       /* cannot create threads */
 
 #define INPUT       "input"
 #define HIDDEN      "hidden"
 #define OUTPUT      "output"
 
+#define PIPE_STAGES 3           /* read, execute, write */
+
+/* --- timed phases --- */
+#define PH_READ      0          /* reading the input files */
+#define PH_ENCODE    1          /* encoding the patterns */
+#define PH_FORWARD   2          /* forward pass (execution) */
+#define PH_OUTPUT    3          /* writing the output table */
+#define PH_CNT       4          /* number of timed phases */
+
 #define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
 
 /*----------------------------------------------------------------------
@@ -108,9 +127,31 @@ typedef struct {                /* --- prediction result --- */
   double err;                   /* error value (squared difference) */
 } RESULT;                       /* (prediction result) */
 
+typedef struct {                /* --- batch of patterns --- */
+  DIMID   n;                    /* number of patterns in batch */
+  double  *pats;                /* input patterns (dim values each) */
+  double  *outs;                /* network outputs (o values each) */
+} BATCH;                        /* (batch of patterns) */
+
+typedef struct {                /* --- pipeline job for threads --- */
+  int     thcnt;                /* number of threads in team */
+  DIMID   dim;                  /* number of values per pattern */
+  DIMID   incnt;                /* number of network inputs */
+  DIMID   outcnt;               /* number of network outputs */
+  DIMID   first;                /* number of patterns already read */
+  int     err;                  /* error code of read stage */
+  DIMID   cnt;                  /* number of processed patterns */
+  double  sse;                  /* sum of squared errors */
+  int     timed;                /* flag for timing the phases */
+  double  secs[THR_MAXCNT][PH_CNT];  /* phase times per thread */
+} PIPEJOB;                      /* (pipeline job) */
+
 /*----------------------------------------------------------------------
   Constants
 ----------------------------------------------------------------------*/
+static const char *const phases[PH_CNT] = {  /* names of phases */
+  "read", "encode", "forward", "output" };
+
 static const char *errmsgs[] = {   /* error messages */
   /* E_NONE      0 */  "no error",
   /* E_NOMEM    -1 */  "not enough memory",
@@ -124,7 +165,9 @@ static const char *errmsgs[] = {   /* error messages */
   /* E_PARSE    -9 */  "parse error(s) on file %s",
   /* E_PATSIZE -10 */  "invalid pattern size %"DIMID_FMT,
   /* E_OUTPUT  -11 */  "must have target as input or write output",
-  /*           -12 */  "unknown error",
+  /* E_BINARY  -12 */  "invalid binary network file %s",
+  /* E_THREAD  -13 */  "cannot create %d thread(s)",
+  /*           -14 */  "unknown error",
 };
 
 /*----------------------------------------------------------------------
@@ -138,6 +181,12 @@ static ATTSET   *attset = NULL; /* attribute set */
 static ATTMAP   *attmap = NULL; /* attribute map */
 static TABLE    *table  = NULL; /* data table */
 static MLP      *mlp    = NULL; /* multilayer perceptron */
+static THRTEAM  *team   = NULL; /* team of worker threads */
+static THRPIPE  *pipe   = NULL; /* pipeline of pattern batches */
+static BATCH    *bats   = NULL; /* batches of patterns (ring) */
+static MLP      *shds[THR_MAXCNT]; /* shadow networks for threads */
+static TMSTAT   *tms    = NULL; /* phase timing statistics */
+static FILE     *rep    = NULL; /* timing report file */
 static RESULT   res     = {     /* prediction result */
   NULL, AT_NOM, 0,              /* target attribute data */
   {0}, "mlp", 0, 3,             /* data for prediction column */
@@ -149,16 +198,32 @@ static RESULT   res     = {     /* prediction result */
   Main Functions
 ----------------------------------------------------------------------*/
 
+static void delthr (void)
+{                               /* --- delete threads and shadows */
+  int i;                        /* loop variable */
+
+  if (team) { thr_delete(team); team = NULL; }
+  if (pipe) { thp_delete(pipe); pipe = NULL; }
+  if (bats) { free(bats[0].pats); free(bats); bats = NULL; }
+  for (i = 1; i < THR_MAXCNT; i++) {
+    if (shds[i]) { mlp_delete(shds[i]); shds[i] = NULL; } }
+}  /* delthr() */               /* delete the shadow networks */
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG                  /* if debug version */
   #undef  CLEANUP               /* clean up memory and close files */
   #define CLEANUP \
+  delthr();                          \
   if (mlp)    mlp_deletex(mlp,   0); \
   if (attmap) am_delete(attmap,  0); \
   if (attset) as_delete(attset);     \
   if (table)  tab_delete(table,  0); \
   if (tread)  trd_delete(tread,  1); \
   if (twrite) twr_delete(twrite, 1); \
-  if (scan)   scn_delete(scan,   1);
+  if (scan)   scn_delete(scan,   1); \
+  if (tms)    tms_delete(tms);       \
+  if (rep && (rep != stdout)) fclose(rep);
 #endif
 
 GENERROR(error, exit)           /* generic error reporting function */
@@ -250,6 +315,122 @@ static void infout (ATTSET *set, TABWRITE *twrite, int mode)
 
 /*--------------------------------------------------------------------*/
 
+static void patout (const double *pat, const double *outs,
+                    DIMID dim, DIMID x, DIMID o, double *sse)
+{                               /* --- process a pattern's outputs */
+  DIMID  c;                     /* loop variable for outputs */
+  double u;                     /* difference to target value */
+
+  if (dim > x) {                /* sum the squared errors */
+    for (c = 0; c < o; c++) {   /* (difference to target values) */
+      u = pat[x+c] -outs[c]; *sse += u*u; }
+  }
+  if (!twrite) return;          /* if to write an output table */
+  for (c = 0; c < dim; c++) {   /* print the pattern elements */
+    twr_printf(twrite, "%.*g", res.dig_pred, pat[c]);
+    twr_fldsep(twrite);         /* followed by a field separator */
+  }
+  for (c = 0; c < o; c++) {     /* print the values computed */
+    if (c > 0) twr_fldsep(twrite);   /* by the network */
+    twr_printf(twrite, "%.*g", res.dig_pred, outs[c]);
+  }
+  twr_recsep(twrite);           /* terminate the record */
+}  /* patout() */
+
+/*--------------------------------------------------------------------*/
+
+static void rdpats (PIPEJOB *job)
+{                               /* --- read stage of the pipeline */
+  int   s;                      /* index of current batch */
+  int   k = 0;                  /* result of vec_read() */
+  DIMID i;                      /* number of patterns in batch */
+  double t = 0;                 /* for time measurements */
+
+  for (i = job->first; k == 0; i = 0) {
+    s = thp_get(pipe, 0);       /* get the next free batch */
+    if (job->timed) t = tms_clock();
+    for ( ; i < MLP_BLKSIZE; i++) {
+      k = vec_read(bats[s].pats +(size_t)i *(size_t)job->dim,
+                   job->dim, tread);
+      if (k != 0) break;        /* read the next patterns */
+    }                           /* until the batch is full */
+    if (job->timed) job->secs[0][PH_READ] += tms_clock() -t;
+    bats[s].n = i;              /* note the number of patterns */
+    thp_put(pipe, s);           /* and pass the batch on */
+  }                             /* (an empty batch may be passed) */
+  if (k < 0) job->err = k;      /* note a read error */
+  thp_close(pipe);              /* no more batches will follow */
+}  /* rdpats() */
+
+/*--------------------------------------------------------------------*/
+
+static void expats (PIPEJOB *job, MLP *net, int id)
+{                               /* --- execute stage of the pipeline */
+  int    s;                     /* index of current batch */
+  DIMID  i;                     /* loop variable for patterns */
+  double t[3] = { 0, 0, 0 };    /* for time measurements */
+
+  while ((s = thp_get(pipe, 1)) >= 0) {
+    if (job->timed) t[0] = tms_clock();
+    for (i = 0; i < bats[s].n; i++) /* set the inputs of the batch */
+      mlp_inputb(net, i, bats[s].pats +(size_t)i *(size_t)job->dim);
+    if (job->timed) t[1] = tms_clock();
+    mlp_execb(net, NULL, bats[s].n, bats[s].outs);
+    if (job->timed) {           /* sum the busy times of the thread */
+      t[2] = tms_clock();
+      job->secs[id][PH_ENCODE]  += t[1] -t[0];
+      job->secs[id][PH_FORWARD] += t[2] -t[1];
+    }
+    thp_put(pipe, s);           /* execute the (shadow) network */
+  }                             /* and pass the batch on */
+}  /* expats() */
+
+/*--------------------------------------------------------------------*/
+
+static void wrpats (PIPEJOB *job, int id)
+{                               /* --- write stage of the pipeline */
+  int    s;                     /* index of current batch */
+  DIMID  i;                     /* loop variable for patterns */
+  double t = 0;                 /* for time measurements */
+
+  while ((s = thp_get(pipe, 2)) >= 0) {
+    if (job->timed) t = tms_clock();
+    for (i = 0; i < bats[s].n; i++)
+      patout(bats[s].pats +(size_t)i *(size_t)job->dim,
+             bats[s].outs +(size_t)i *(size_t)job->outcnt,
+             job->dim, job->incnt, job->outcnt, &job->sse);
+    job->cnt += bats[s].n;      /* process the patterns in order */
+    if (job->timed) job->secs[id][PH_OUTPUT] += tms_clock() -t;
+    thp_put(pipe, s);           /* and return the batch */
+  }                             /* to the read stage */
+}  /* wrpats() */
+
+/*--------------------------------------------------------------------*/
+
+static void pipeline (void *data, int id)
+{                               /* --- run a stage of the pipeline */
+  PIPEJOB *job = (PIPEJOB*)data;/* pipeline job to execute */
+
+  if      (id == 0)            rdpats(job);
+  else if (id >= job->thcnt-1) wrpats(job, id);
+  else                         expats(job, shds[id-1], id);
+}  /* pipeline() */             /* thread 0 reads, last one writes */
+
+/*--------------------------------------------------------------------*/
+
+static int report (double pats, double wgts)
+{                               /* --- write the timing report */
+  int r;                        /* result of writing the report */
+
+  tms_count(tms, pats, 2*wgts*pats); /* one multiply-add per weight */
+  r = tms_report(tms);          /* write report for the whole run */
+  if ((rep != stdout) && (fclose(rep) != 0)) r = -1;
+  rep = NULL;                   /* close the report file */
+  return r;                     /* return the write result */
+}  /* report() */
+
+/*--------------------------------------------------------------------*/
+
 int main (int argc, char *argv[])
 {                               /* --- main function */
   int     i, k = 0;             /* loop variables, counters */
@@ -259,20 +440,26 @@ int main (int argc, char *argv[])
   CCHAR   *fn_mlp  = NULL;      /* name of neural network file */
   CCHAR   *fn_tab  = NULL;      /* name of input  pattern file */
   CCHAR   *fn_out  = NULL;      /* name of output pattern file */
+  CCHAR   *fn_rep  = NULL;      /* name of timing report  file */
   CCHAR   *recseps = NULL;      /* record  separators */
   CCHAR   *fldseps = NULL;      /* field   separators */
   CCHAR   *blanks  = NULL;      /* blank   characters */
   CCHAR   *comment = NULL;      /* comment characters */
   int     matinp   =  0;        /* flag for numerical matrix input */
+  int     bin      =  0;        /* flag for binary network file */
+  MLPBIN  hdr;                  /* header of binary network file */
   DIMID   dim      = -1;        /* data point/pattern dimension */
   int     mode     = AS_ATT|AS_MARKED; /* table file read  mode */
   int     mout     = AS_ATT;           /* table file write mode */
+  int     thcnt    = 1;         /* number of threads for execution */
+  int     repmode  = TMS_JSON;  /* mode for the timing report */
+  PIPEJOB job;                  /* pipeline job for threads */
   double  sse      = 0.0;       /* (weighted) sum of squared errors */
-  double  *pat;                 /* to traverse the patterns */
-  ATTID   m, c;                 /* number of attributes */
-  TPLID   n, r;                 /* number of data tuples */
+  double  *pat, *blk;           /* to traverse the patterns */
+  ATTID   m;                    /* number of attributes */
+  TPLID   n = 0, r;             /* number of data tuples */
   DIMID   x, o;                 /* number of dimensions/fields */
-  DIMID   p;                    /* number of patterns */
+  DIMID   p = 0, b;             /* number of patterns, block size */
   double  w, u;                 /* weight of data tuples, buffer */
   clock_t t;                    /* for time measurements */
 
@@ -296,6 +483,17 @@ int main (int argc, char *argv[])
     printf("-z#      significant digits for confidence      "
                     "(default: %d)\n", res.dig_conf);
     printf("-x       print extended confidence information\n");
+    printf("-t#      number of threads for execution        "
+                    "(default: %d)\n", thcnt);
+    printf("         (<= 0: one per processor; numeric patterns only; "
+                    "if > 1, patterns\n"
+           "         are read, executed and written in a pipeline)\n");
+    printf("-Q#      file to write a timing report to       "
+                    "(default: none)\n");
+    printf("-K#      timing report mode                     "
+                    "(default: %d)\n", repmode);
+    printf("         (0: JSON, 1: CSV; phase times, patterns "
+                    "and flops per second)\n");
     printf("-a       align fields in output table           "
                     "(default: single separator)\n");
     printf("-w       do not write field names to the output file\n");
@@ -307,7 +505,8 @@ int main (int argc, char *argv[])
                     "(default: \" \\t\\r\")\n");
     printf("-C#      comment characters                     "
                     "(default: \"#\")\n");
-    printf("mlpfile  file to read multilayer perceptron from\n");
+    printf("mlpfile  file to read multilayer perceptron from "
+                    "(text or binary)\n");
     printf("-d       use default header "
                     "(attribute names = field numbers)\n");
     printf("-h       read table header  "
@@ -334,6 +533,9 @@ int main (int argc, char *argv[])
           case 'a': mout   |=  AS_ALIGN;     break;
           case 'w': mout   &= ~AS_ATT;       break;
           case 'x': res.all = -1;            break;
+          case 't': thcnt = (int)strtol(s, &s, 0); break;
+          case 'Q': optarg  = &fn_rep;       break;
+          case 'K': repmode = (int)strtol(s, &s, 0); break;
           case 'r': optarg  = &recseps;      break;
           case 'f': optarg  = &fldseps;      break;
           case 'b': optarg  = &blanks;       break;
@@ -367,15 +569,28 @@ int main (int argc, char *argv[])
     mout |= AS_ALNHDR;          /* set align to header flag */
   if (fn_out) mout |= AS_MARKED|AS_INFO1|AS_RDORD;
   else        mout  = 0;        /* set up the table write mode */
+  if (fn_rep) {                 /* if to write a timing report */
+    if (strcmp(fn_rep, "-") == 0) fn_rep = "";
+    if (*fn_rep) { rep = fopen(fn_rep, "w"); }
+    else         { rep = stdout; fn_rep = "<stdout>"; }
+    if (!rep) error(E_FOPEN, fn_rep);
+    tms = tms_create(PRGNAME, phases, PH_CNT, rep, repmode &TMS_CSV);
+    if (!tms) error(E_NOMEM);   /* create the timing statistics */
+  }                             /* (there are no epochs to report) */
   fputc('\n', stderr);          /* terminate the startup message */
 
   /* --- read multilayer perceptron --- */
+  TMS_BEG(tms, PH_READ);        /* time reading the network */
   scan = scn_create();          /* create a scanner */
   if (!scan) error(E_NOMEM);    /* for the multilayer perceptron */
   t = clock();                  /* start timer, open input file */
   if (scn_open(scan, NULL, fn_mlp) != 0)
     error(E_FOPEN, scn_name(scan));
   fprintf(stderr, "reading %s ... ", scn_name(scan));
+  if (fn_mlp && *fn_mlp) {      /* if not reading from stdin, */
+    bin = mlp_binchk(scn_file(scan), &hdr);  /* check for binary */
+    if (bin < 0) error(E_BINARY, scn_name(scan));
+  }                             /* (skip header and weights) */
   matinp = (scn_first(scan) == T_ID)
         && (strcmp(scn_value(scan), "dom") != 0);
   if (matinp)                   /* if matrix version */
@@ -390,15 +605,19 @@ int main (int argc, char *argv[])
     mlp = mlp_parsex(scan, attmap);
   }                             /* parse the multilayer perceptron */
   if (!mlp || !scn_eof(scan, 1)) error(E_PARSE, scn_name(scan));
+  if (mlp_binwgts(mlp, scn_file(scan), (bin) ? &hdr : NULL) != 0)
+    error(E_BINARY, scn_name(scan));  /* get the binary weights */
   scn_delete(scan, 1);          /* delete the scanner and */
   scan = NULL;                  /* print a log message */
   fprintf(stderr, "[%"DIMID_FMT" unit(s),",   mlp_unitcnt(mlp));
   fprintf(stderr, " %"DIMID_FMT" weight(s)]", mlp_wgtcnt(mlp));
   fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+  TMS_END(tms);                 /* end the reading phase */
   mlp_setup(mlp);               /* set network up for execution */
 
   if (matinp) {                 /* if matrix version */
     /* --- process patterns --- */
+    TMS_BEG(tms, PH_READ);      /* time reading the input file */
     tread = trd_create();       /* create a table reader and */
     if (!tread) error(E_NOMEM); /* set the separator characters */
     trd_allchs(tread, recseps, fldseps, blanks, "", comment);
@@ -419,23 +638,79 @@ int main (int argc, char *argv[])
     o = mlp_outcnt(mlp);        /* and outputs of the network */
     if ((dim != x) && (dim != x+o)){/* check the pattern size */
       free(pat); error(E_PATSIZE, dim); }
-    for (p = 0; k == 0; p++) {  /* pattern read loop */
-      mlp_exec(mlp, pat, NULL); /* execute multilayer perceptron */
-      if (dim > x)              /* and sum the squared errors */
-        sse += mlp_error(mlp, pat +x);
-      if (twrite) {             /* if to write an output table */
-        for (c = 0; c < dim; c++) {
-          twr_printf(twrite, "%.*g", res.dig_pred, pat[c]);
-          twr_fldsep(twrite);   /* print the pattern elements */
-        }                       /* followed by a field separator */
-        for (c = 0; c < o;   c++) {
-          if (c > 0) twr_fldsep(twrite);
-          twr_printf(twrite, "%.*g", res.dig_pred, mlp_output(mlp, c));
-        }                       /* print the values computed */
-        twr_recsep(twrite);     /* by the multilayer perceptron */
-      }                         /* and terminate the record */
-      k = vec_read(pat, dim, tread);
-    }                           /* read the next pattern */
+    blk = (double*)realloc(pat, (size_t)MLP_BLKSIZE*(size_t)dim
+                                *sizeof(double));
+    if (!blk) { free(pat); error(E_NOMEM); }
+    pat = blk;                  /* create a buffer for a block */
+    if (thcnt <= 0) thcnt = thr_cpucnt();  /* get number of threads */
+    if (thcnt > 1) {            /* if to execute in a pipeline */
+      if (thcnt > THR_MAXCNT-2) thcnt = THR_MAXCNT-2;
+      team = thr_create(thcnt+2);  /* create a team of worker threads */
+      if (!team) { free(pat); error(E_THREAD, thcnt+2); }
+      pipe = thp_create(2*thcnt+2, PIPE_STAGES);
+      bats = (BATCH*)malloc((size_t)(2*thcnt+2) *sizeof(BATCH));
+      if (!pipe || !bats) { free(pat); error(E_NOMEM); }
+      bats[0].pats = blk = (double*)malloc((size_t)(2*thcnt+2)
+                         *(size_t)MLP_BLKSIZE *(size_t)(dim+o)
+                         *sizeof(double));
+      if (!blk) { free(bats); bats = NULL; free(pat); error(E_NOMEM); }
+      for (i = 0; i < 2*thcnt+2; i++) {
+        bats[i].n    = 0;       /* organize the batch buffers */
+        bats[i].pats = blk; blk += (size_t)MLP_BLKSIZE *(size_t)dim;
+        bats[i].outs = blk; blk += (size_t)MLP_BLKSIZE *(size_t)o;
+      }                         /* (ring of batches of patterns) */
+      shds[0] = mlp;            /* the network itself serves thread 1 */
+      for (i = 0; i < thcnt; i++) {
+        if (i > 0) shds[i] = mlp_shadow(mlp);
+        if (!shds[i] || (mlp_blksize(shds[i], MLP_BLKSIZE) != 0)) {
+          free(pat); error(E_NOMEM); }
+      }                         /* create shadow networks that share */
+      memcpy(bats[0].pats, pat, (size_t)dim *sizeof(double));
+      job.thcnt  = thcnt+2;     /* the weights, but have their own */
+      job.dim    = dim;         /* buffers, and copy first pattern */
+      job.incnt  = x;           /* initialize the pipeline job */
+      job.outcnt = o;
+      job.first  = 1;
+      job.err    = 0;
+      job.cnt    = 0;
+      job.sse    = 0;
+      job.timed  = (tms != NULL);
+      memset(job.secs, 0, sizeof(job.secs));
+      TMS_END(tms);             /* (the threads time their phases) */
+      thr_run(team, pipeline, &job);
+      k = job.err; sse = job.sse; p = job.cnt;
+      for (i = 0; tms && (i < thcnt+2); i++) {
+        tms_add(tms, PH_READ,    job.secs[i][PH_READ]);
+        tms_add(tms, PH_ENCODE,  job.secs[i][PH_ENCODE]);
+        tms_add(tms, PH_FORWARD, job.secs[i][PH_FORWARD]);
+        tms_add(tms, PH_OUTPUT,  job.secs[i][PH_OUTPUT]);
+      }                         /* sum the busy times of the threads */
+      delthr(); }               /* read, execute and write patterns */
+    else {                      /* if to execute serially */
+      if (mlp_blksize(mlp, MLP_BLKSIZE) != 0) {  /* of patterns */
+        free(pat); error(E_NOMEM); }
+      for (p = 0; k == 0; ) {   /* pattern block read loop */
+        TMS_BEG(tms, PH_READ);  /* (reading is a timed phase) */
+        for (b = 1; b < MLP_BLKSIZE; b++) {
+          k = vec_read(pat +(size_t)b *(size_t)dim, dim, tread);
+          if (k != 0) break;    /* read the next patterns */
+        }                       /* until the block is full */
+        if (k < 0) { free(pat); error(k, TRD_INFO(tread)); }
+        TMS_BEG(tms, PH_ENCODE);
+        for (i = 0; i < b; i++) /* set the inputs of the block */
+          mlp_inputb(mlp, i, pat +(size_t)i *(size_t)dim);
+        TMS_BEG(tms, PH_FORWARD);
+        mlp_execb(mlp, NULL, b, NULL);  /* execute the network */
+        TMS_BEG(tms, PH_OUTPUT);
+        for (i = 0; i < b; i++) /* process the block patterns */
+          patout(pat +(size_t)i *(size_t)dim, &mlp_outputb(mlp, i, 0),
+                 dim, x, o, &sse);
+        p += b;                 /* count the processed patterns */
+        TMS_BEG(tms, PH_READ);  /* read the next pattern */
+        if (k == 0) k = vec_read(pat, dim, tread);
+      }                         /* (the first of the next block) */
+      TMS_END(tms);             /* end the last phase */
+    }
     free(pat);                  /* delete the pattern buffer */
     if (k < 0) error(k, TRD_INFO(tread));
     trd_delete(tread, 1);       /* close the input file and */
@@ -468,6 +743,7 @@ int main (int argc, char *argv[])
     att_setmark(res.att, 0);    /* except the class attribute */
 
     /* --- read table header --- */
+    TMS_BEG(tms, PH_READ);      /* time reading the input files */
     tread = trd_create();       /* create a table reader and */
     if (!tread) error(E_NOMEM); /* set the separator characters */
     trd_allchs(tread, recseps, fldseps, blanks, "", comment);
@@ -489,7 +765,8 @@ int main (int argc, char *argv[])
     if (trd_open(tread, NULL, fn_tab) != 0)
       error(E_FOPEN, trd_name(tread));
     fprintf(stderr, "reading %s ... ", trd_name(tread));
-    if (mout & AS_ALIGN) {      /* if to align the output columns */
+    if ((mout & AS_ALIGN)       /* if to align the output columns */
+    &&  (!fn_tab || !*fn_tab)) {/* and the input cannot be reread */
       table = tab_create("table", attset, tpl_delete);
       if (!table) error(E_NOMEM);  /* read the data table */
       k = tab_read(table, tread, mode);
@@ -516,11 +793,14 @@ int main (int argc, char *argv[])
       mout = AS_INST | (mout & ~AS_ATT);
       m += (res.col_conf ? 2 : 1) +(res.all ? res.cnt : 0);
       for (r = 0; r < n; r++) { /* traverse the tuples */
+        TMS_BEG(tms, PH_ENCODE);
         tpl_toas(tab_tpl(table, r));
         mlp_inputx(mlp, NULL);  /* set the pattern from a tuple */
+        TMS_BEG(tms, PH_FORWARD);
         predict();              /* compute prediction for target */
         u = as_getwgt(attset);  /* get the tuple weight and */
         sse += res.err *u;      /* sum the prediction errors */
+        TMS_BEG(tms, PH_OUTPUT);
         if (as_write(attset, twrite, mout, infout) != 0)
           error(E_FWRITE, twr_name(twrite));
       } }                       /* write the current tuple */
@@ -529,6 +809,21 @@ int main (int argc, char *argv[])
       if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
       if (!fn_out && (att_getmark(res.att) < 0))
         error(E_OUTPUT);        /* check for outp4ut to produce */
+      i = mode; mode = (mode & ~(AS_DFLT|AS_ATT)) | AS_INST;
+      if ((i & AS_ATT) && !(i & AS_DFLT))
+        k = as_read(attset, tread, mode);   /* read the first tuple */
+      if (mout & AS_ALIGN) {    /* if to align the output columns, */
+        while (k == 0)          /* read all tuples to determine */
+          k = as_read(attset, tread, mode); /* the value widths */
+        if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
+        trd_close(tread);       /* close and reopen the input file */
+        if (trd_open(tread, NULL, fn_tab) != 0)
+          error(E_FOPEN, trd_name(tread));
+        k = as_read(attset, tread, i);      /* reread table header */
+        if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
+        if ((i & AS_ATT) && !(i & AS_DFLT))
+          k = as_read(attset, tread, mode);
+      }                         /* read the first tuple again */
       if (fn_out) {             /* if to write an output file */
         twrite = twr_create();       /* create a table writer and */
         if (!twrite) error(E_NOMEM); /* configure the characters */
@@ -541,17 +836,18 @@ int main (int argc, char *argv[])
           error(E_FWRITE, twr_name(twrite));
         mout = AS_INST | (mout & ~AS_ATT);
       }                         /* remove the attribute flag */
-      i = mode; mode = (mode & ~(AS_DFLT|AS_ATT)) | AS_INST;
-      if (i & AS_ATT)           /* if not done yet, read first tuple */
-        k = as_read(attset, tread, mode);
       for (w = 0, n = 0; k == 0; n++) {
+        TMS_BEG(tms, PH_ENCODE);
         mlp_inputx(mlp, NULL);  /* set the pattern from a tuple */
+        TMS_BEG(tms, PH_FORWARD);
         predict();              /* predict target for current tuple */
         w   += u = as_getwgt(attset); /* sum the tuple weights and */
         sse += res.err *u;      /* count the classification errors */
+        TMS_BEG(tms, PH_OUTPUT);
         if (twrite              /* write the current tuple */
         && (as_write(attset, twrite, mout, infout) != 0))
           error(E_FWRITE, twr_name(twrite));
+        TMS_BEG(tms, PH_READ);
         k = as_read(attset, tread, mode);
       }                         /* try to read the next tuple */
       if (k < 0) error(-k, as_errmsg(attset, NULL, 0));
@@ -560,10 +856,12 @@ int main (int argc, char *argv[])
       m = as_attcnt(attset);    /* get the number of attributes */
     }
     if (twrite) {               /* if an output file was written */
+      TMS_BEG(tms, PH_OUTPUT);  /* (closing is part of the output) */
       if (twr_close(twrite) != 0) error(E_FWRITE, twr_name(twrite));
       twr_delete(twrite, 1);    /* close the output file and */
       twrite = NULL;            /* delete the table writer */
     }                           /* print a success message */
+    TMS_END(tms);               /* end the last phase */
     fprintf(stderr, "[%"ATTID_FMT" attribute(s),", m);
     fprintf(stderr, " %"TPLID_FMT, n);
     if (w != (double)n) fprintf(stderr, "/%g", w);
@@ -585,6 +883,11 @@ int main (int argc, char *argv[])
     }
   }                             /* if (matinp) .. else .. */
 
+  /* --- write timing report --- */
+  if (tms && (report((matinp) ? (double)p : (double)n,
+                     (double)mlp_wgtcnt(mlp)) != 0))
+    error(E_FWRITE, fn_rep);    /* write the report for the run */
+
   /* --- clean up --- */
   CLEANUP;                      /* clean up memory and close files */
   SHOWMEM;                      /* show (final) memory usage */
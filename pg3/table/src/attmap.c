@@ -15,6 +15,8 @@
             2015.08.02 function am_mark() added (mark mapped attributes)
             2015.11.30 mode AM_MINUS1 added (for 1-in-(n-1) encoding)
             2016.02.15 function am_clone() added (clone a mapping)
+            2016.05.15 function am_execc() added (columns to vectors)
+            2016.05.16 function am_execs() added (sparse vectors)
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -173,3 +175,90 @@ void am_exec (ATTMAP *map, const TUPLE *tpl, int mode, double *vec)
     }                           /* and skip the set elements */
   }                             /* of the output vector */
 }  /* am_exec() */
+
+/*--------------------------------------------------------------------*/
+
+ATTID am_execs (ATTMAP *map, const TUPLE *tpl, int mode,
+                ATTID *idx, double *vals)
+{                               /* --- execute map to sparse vector */
+  ATTID      k, n = 0;          /* loop variable, number of elements */
+  ATTID      off = 0;           /* offset of the current attribute */
+  VALID      v;                 /* buffer for a nominal value */
+  AMEL       *p;                /* to traverse the map elements */
+  const INST *inst;             /* to traverse the instantiations */
+
+  assert(map && idx && vals);   /* check the function arguments */
+  if (map->outcnt > 0) { k = map->attcnt -1; }
+  else                 { k = map->attcnt; mode &= AM_INPUTS; }
+  p = map->amels;               /* get the number of input attributes */
+  if      (mode & AM_INPUTS) { if (mode & AM_TARGET) k++; }
+  else if (mode & AM_TARGET) { p += k; k = 1; }
+  else return 0;                /* get the attribute range */
+  for ( ; --k >= 0; off += p->cnt, p++) {
+    inst = (tpl) ? tpl_colval(tpl, att_id(p->att)) : att_inst(p->att);
+    if      (p->type == AT_FLT) /* if float attribute, */
+      vals[n] = (double)inst->f;/* store the value directly */
+    else if (p->type == AT_INT) /* if integer attribute, check null */
+      vals[n] = (inst->i <= NV_INT)  ? NAN : (double)inst->i;
+    else if (p->cnt < 2) {      /* if the attribute is binary, */
+      v = inst->n;              /* set the value directly */
+      vals[n] = ((v < 0) || (v > 1)) ? NAN : (double)v *fabs(map->one); }
+    else {                      /* if the attribute is nominal, */
+      v = inst->n;              /* only the set element is stored */
+      if ((v < 0) || (v >= p->cnt)) continue;
+      idx [n]   = off +(ATTID)v;
+      vals[n++] = (map->one < 0) ? -map->one /(double)p->cnt : map->one;
+      continue;                 /* store index and value of the */
+    }                           /* element for the attribute value */
+    idx[n++] = off;             /* for numeric and binary attributes */
+  }                             /* store the single dimension */
+  return n;                     /* return the number of elements */
+}  /* am_execs() */
+
+/*--------------------------------------------------------------------*/
+
+void am_execc (ATTMAP *map, TABCOL *tc, const TPLID *rows, TPLID cnt,
+               int mode, double *vecs, size_t stride)
+{                               /* --- execute map on table columns */
+  ATTID      k;                 /* loop variable for attributes */
+  TPLID      i;                 /* loop variable for rows */
+  VALID      v;                 /* buffer for a nominal value */
+  AMEL       *p;                /* to traverse the map elements */
+  const INST *col;              /* column of the current attribute */
+  double     *vec;              /* to traverse the output vectors */
+  double     one;               /* value for 1-in-n/(n-1) coding */
+
+  assert(map && tc && rows && vecs);  /* check function arguments */
+  if (map->outcnt > 0) { k = map->attcnt -1; }
+  else                 { k = map->attcnt; mode &= AM_INPUTS; }
+  p = map->amels;               /* get the number of input attributes */
+  if      (mode & AM_INPUTS) { if (mode & AM_TARGET) k++; }
+  else if (mode & AM_TARGET) { p += k; k = 1; }
+  else return;                  /* get the attribute range */
+  for ( ; --k >= 0; p++) {      /* traverse the attributes */
+    col = tc_col(tc, att_id(p->att));
+    vec = vecs;                 /* get the column of the attribute */
+    if      (p->type == AT_FLT) { /* if float attribute */
+      for (i = 0; i < cnt; i++, vec += stride)
+        *vec = (double)col[rows[i]].f; }
+    else if (p->type == AT_INT) { /* if integer attribute */
+      for (i = 0; i < cnt; i++, vec += stride)
+        *vec = (col[rows[i]].i <= NV_INT) /* check for a null */
+             ? NAN : (double)col[rows[i]].i; }
+    else if (p->cnt < 2) {      /* if the attribute is binary */
+      one = fabs(map->one);     /* get the value for a one */
+      for (i = 0; i < cnt; i++, vec += stride) {
+        v = col[rows[i]].n;     /* set the value directly */
+        *vec = ((v < 0) || (v > 1)) ? NAN : (double)v *one;
+      } }
+    else {                      /* if the attribute is nominal */
+      one = (map->one < 0) ? -map->one /(double)p->cnt : map->one;
+      for (i = 0; i < cnt; i++, vec += stride) {
+        memset(vec, 0, (size_t)p->cnt *sizeof(double));
+        v = col[rows[i]].n;     /* clear all vector elements */
+        if ((v >= 0) && (v < p->cnt)) vec[v] = one;
+      }                         /* set the corresponding element */
+    }
+    vecs += p->cnt;             /* skip the dimensions */
+  }                             /* of the processed attribute */
+}  /* am_execc() */
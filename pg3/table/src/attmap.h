@@ -9,10 +9,12 @@
             2015.08.02 function am_mark() added (mark mapped attributes)
             2015.11.30 mode AM_MINUS1 added (for 1-in-(n-1) encoding)
             2016.02.15 function am_clone() added (clone a mapping)
+            2016.05.15 function am_execc() added (columns to vectors)
+            2016.05.16 function am_execs() added (sparse vectors)
 ----------------------------------------------------------------------*/
 #ifndef __ATTMAP__
 #define __ATTMAP__
-#include "table.h"
+#include "tabcol.h"
 
 #if ATTID_MAX < VALID_MAX
 #error "attmap requires ATTID_MAX >= VALID_MAX"
@@ -73,6 +75,11 @@ extern ATTID   am_cnt    (ATTMAP *map, ATTID attid);
 
 extern void    am_exec   (ATTMAP *map, const TUPLE *tpl, int mode,
                           double *vec);
+extern void    am_execc  (ATTMAP *map, TABCOL *tc,
+                          const TPLID *rows, TPLID cnt,
+                          int mode, double *vecs, size_t stride);
+extern ATTID   am_execs  (ATTMAP *map, const TUPLE *tpl, int mode,
+                          ATTID *idx, double *vals);
 
 /*----------------------------------------------------------------------
   Preprocessor Definitions
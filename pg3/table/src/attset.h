@@ -48,6 +48,7 @@
             2013.07.26 parameter 'dir' added to function att_valsort()
             2013.08.29 function as_target() added (target detection)
             2015.08.01 function as_attperm() added (permute attributes)
+            2016.05.16 functions att_valmem(), as_valmem() added (memsys)
 ----------------------------------------------------------------------*/
 #ifndef __ATTSET__
 #define __ATTSET__
@@ -70,6 +71,7 @@
 #define SCN_SCAN
 #endif
 #include "scanner.h"
+#include "memsys.h"
 
 #ifdef _MSC_VER
 #ifndef INFINITY
@@ -440,6 +442,7 @@ typedef struct val {            /* --- attribute value --- */
   VALID      id;                /* identifier (index in attribute) */
   size_t     hash;              /* hash value of value name */
   struct val *succ;             /* successor in hash bucket */
+  MEMSYS     *mem;              /* memory system (NULL: heap) */
   char       name[1];           /* value name */
 } VAL;                          /* (attribute value) */
 
@@ -457,6 +460,8 @@ typedef struct att {            /* --- attribute --- */
   VALID  cnt;                   /* number of values in array */
   VAL    **vals;                /* value array (nominal attributes) */
   VAL    **htab;                /* hash table for values */
+  size_t valblk;                /* block size for values (0: heap) */
+  MEMSYS *mem;                  /* memory system for values */
   INST   min, max;              /* minimal and maximal value/id */
   int    attwd[2];              /* attribute name widths */
   int    valwd[2];              /* maximum of value name widths */
@@ -478,6 +483,7 @@ typedef struct attset {         /* --- attribute set --- */
   ATT       **htab;             /* hash table for attributes */
   ATT_DELFN *delfn;             /* attribute deletion function */
   WEIGHT    wgt;                /* weight (of current instantiation) */
+  size_t    valblk;             /* block size for values (0: heap) */
   int       sd2p;               /* significant digits to print */
   ATTID     fldsize;            /* size of field array */
   ATTID     fldcnt;             /* number of fields */
@@ -537,6 +543,7 @@ extern int     att_valcut  (ATT *dst, ATT *src, int mode, ...);
 extern int     att_valcopy (ATT *dst, const ATT *src, int mode, ...);
 extern void    att_valsort (ATT *att, int dir, VAL_CMPFN cmpfn,
                             VALID *map, int mapdir);
+extern void    att_valmem  (ATT *att, size_t blksz);
 
 extern VALID   att_valid   (const ATT *att, const char *name);
 extern CCHAR*  att_valname (const ATT *att, VALID valid);
@@ -563,6 +570,7 @@ extern WEIGHT  as_setwgt   (ATTSET *set, WEIGHT wgt);
 extern WEIGHT  as_getwgt   (const ATTSET *set);
 extern int     as_setsd2p  (ATTSET *set, int sd2p);
 extern int     as_getsd2p  (const ATTSET *set);
+extern void    as_valmem   (ATTSET *set, size_t blksz);
 
 extern int     as_attadd   (ATTSET *set, ATT *att);
 extern int     as_attaddm  (ATTSET *set, ATT **att, ATTID cnt);
@@ -37,6 +37,8 @@
             2013.07.26 parameter 'dir' added to function att_valsort()
             2013.09.03 removed check for new value for int and float
             2015.08.01 function as_attperm() added (permute attributes)
+            2016.05.16 bug in function as_clone() fixed (field counter)
+            2016.05.16 values may be allocated with a memory system
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -140,6 +142,36 @@ static size_t hash (const char *s)
 
 /*--------------------------------------------------------------------*/
 
+static VAL* valalloc (ATT *att, int len)
+{                               /* --- allocate an attribute value */
+  size_t z;                     /* size of the value */
+  VAL    *val;                  /* allocated value */
+
+  z = sizeof(VAL) +(size_t)len *sizeof(char);
+  if (att->valblk <= 0) {       /* if to allocate on the heap */
+    val = (VAL*)malloc(z);      /* allocate memory for a value */
+    if (val) val->mem = NULL;   /* and note that it is on the heap */
+    return val;                 /* return the allocated value */
+  }
+  if (!att->mem) {              /* if there is no memory system yet */
+    att->mem = ms_create(0, att->valblk);
+    if (!att->mem) return NULL; /* create a memory system */
+  }                             /* for values of variable size */
+  val = (VAL*)ms_allocx(att->mem, z);
+  if (val) val->mem = att->mem; /* allocate memory for a value */
+  return val;                   /* and note the memory system */
+}  /* valalloc() */
+
+/*--------------------------------------------------------------------*/
+
+static void valfree (VAL *val)
+{                               /* --- free an attribute value */
+  if (val->mem) ms_free(val->mem, val);
+  else          free(val);      /* return the value memory to */
+}  /* valfree() */              /* its memory system or the heap */
+
+/*--------------------------------------------------------------------*/
+
 static int valcmp (const void *p1, const void *p2, void *data)
 {                               /* --- compare two attribute values */
   return (((VALCMP*)data)->cmpfn)(((const VAL*)p1)->name,
@@ -268,6 +300,8 @@ ATT* att_create (const char *name, int type)
   att->dir      = DIR_IN;       /* initialize the fields */
   att->wgt      = 1.0;          /* (with default values) */
   att->htab     = att->vals = NULL;
+  att->valblk   = 0;            /* (values are allocated */
+  att->mem      = NULL;         /* on the heap by default) */
   att->mark     = 0;
   att->read     = 0;
   att->sd2p     = 6;            /* (set default behavior of %g) */
@@ -306,6 +340,7 @@ ATT* att_clone (const ATT *att)
   assert(att);                  /* check the function arguments */
   clone = att_create(att->name, att->type);
   if (!clone) return NULL;      /* create a new attribute */
+  clone->valblk = att->valblk;  /* copy the value memory mode */
   if (att_valcopy(clone, att, AS_ALL) != 0) {
     att_delete(clone); return NULL; }
   clone->dir  = att->dir;       /* copy all attribute values */
@@ -326,9 +361,10 @@ void att_delete (ATT *att)
   if (att->set)                 /* if there is a containing set, */
     as_attrem(att->set,att->id);/* remove the attribute from it */
   if (att->vals) {              /* if there are attribute values */
-    for (k = 0; k < att->cnt; k++) free(att->vals[k]);
+    for (k = 0; k < att->cnt; k++) valfree(att->vals[k]);
     free(att->vals);            /* traverse and delete the values */
   }                             /* and delete the value array */
+  if (att->mem) ms_delete(att->mem);  /* delete the memory system */
   free(att->name);              /* delete the attribute name */
   free(att);                    /* and the attribute body */
 }  /* att_delete() */
@@ -446,7 +482,7 @@ int att_convert (ATT *att, int type, INST *map)
   else                          /* if no correct new type given or */
     return -1;                  /* no conversion possible, abort */
   if (att->vals) {              /* if there are attribute values */
-    for (k = 0; k < att->cnt; k++) free(att->vals[k]);
+    for (k = 0; k < att->cnt; k++) valfree(att->vals[k]);
     free(att->vals);            /* traverse and delete the values */
     att->htab = att->vals = NULL;   /* and delete the value array */
   }
@@ -562,8 +598,8 @@ int att_valadd (ATT *att, const char *name, INST *inst)
   }                             /* if name already exists, abort */
   if (inst) return -3;          /* if not to extend the domain, abort */
   w   = length(name);           /* get (bounded) value name length */
-  val = (VAL*)malloc(sizeof(VAL) +(size_t)w *sizeof(char));
-  if (!val) return -1;          /* allocate memory for a value */
+  val = valalloc(att, w);       /* allocate memory for a value */
+  if (!val) return -1;          /* (heap or memory system) */
   copy(val->name, name);        /* copy name and set hash value */
   val->hash = h;                /* set value identifier and instance */
   val->id   = att->inst.n = att->max.n = att->cnt;
@@ -591,7 +627,7 @@ void att_valrem (ATT *att, VALID valid)
   /* --- remove all attribute values --- */
   if (valid < 0) {              /* if no value identifier given */
     if (!att->vals) return;     /* if there are no values, abort */
-    for (k = 0; k < att->cnt; k++) free(att->vals[k]);
+    for (k = 0; k < att->cnt; k++) valfree(att->vals[k]);
     free(att->vals);            /* traverse and delete the values */
     att->htab   = att->vals = NULL; /* and delete the value array */
     att->size   =  0;           /* clear the array size */
@@ -607,7 +643,7 @@ void att_valrem (ATT *att, VALID valid)
   p   = att->htab +val->hash % att->size;
   while (*p != val) p = &(*p)->succ;
   *p = val->succ;               /* remove value from hash table */
-  free(val);                    /* and delete the value body */
+  valfree(val);                 /* and delete the value body */
   att->max.n = --att->cnt -1;   /* adapt maximal value identifier */
   for (k = valid; k < att->cnt; k++) {
     att->vals[k] = val = att->vals[k+1];
@@ -723,12 +759,12 @@ int att_valcut (ATT *dst, ATT *src, int mode, ...)
     while (*p != val) p = &(*p)->succ;
     *p = val->succ;             /* remove value from the hash bin */
     if (!dst) {                 /* if there is no destination, */
-      free(val); continue; }    /* simply delete the value */
+      valfree(val); continue; } /* simply delete the value */
     for (h = dst->htab[val->hash % dst->size]; h; h = h->succ)
       if (strcmp(val->name, h->name) == 0)
         break;                  /* search value in destination */
     if (h) {                    /* if value is in destination, */
-      free(val); continue; }    /* simply delete it */
+      valfree(val); continue; } /* simply delete it */
     p = dst->htab +val->hash % dst->size;
     val->succ = *p; *p = val;   /* insert value into hash table */
     dst->vals[dst->cnt] = val;  /* and value array of destination */
@@ -801,14 +837,14 @@ int att_valcopy (ATT *dst, const ATT *src, int mode, ...)
       if (strcmp(val->name, h->name) == 0)
         break;                  /* search value in destination */
     if (h) continue;            /* if value already exists, skip it */
-    *d = (VAL*)malloc(sizeof(VAL) +strlen(val->name) *sizeof(char));
+    *d = valalloc(dst, (int)strlen(val->name));
     if (!*d) break;             /* allocate memory for a new value */
     strcpy((*d)->name, val->name);
     (*d)->hash = val->hash;     /* copy value name and hash value */
     (*d++)->id = n++;           /* and set the value identifier */
   }
   if (off < cnt) {              /* if an error occured */
-    while (--n >= dst->cnt) free(*--d);
+    while (--n >= dst->cnt) valfree(*--d);
     return -1;                  /* delete all copied values */
   }                             /* and abort the function */
 
@@ -851,6 +887,19 @@ void att_valsort (ATT *att, int dir, VAL_CMPFN cmpfn,
 
 /*--------------------------------------------------------------------*/
 
+void att_valmem (ATT *att, size_t blksz)
+{                               /* --- set value memory mode */
+  assert(att);                  /* check the function argument */
+  if (blksz == att->valblk) return;
+  if (att->mem) {               /* if there is a memory system, */
+    ms_delete(att->mem);        /* release it (it is deleted when */
+    att->mem = NULL;            /* its last value is freed), */
+  }                             /* so that a new one is created */
+  att->valblk = blksz;          /* note the new block size */
+}  /* att_valmem() */           /* (0: allocate values on the heap) */
+
+/*--------------------------------------------------------------------*/
+
 int att_valwd (ATT *att, int scform)
 {                               /* --- determine widths of values */
   VALID  k;                     /* loop variable */
@@ -938,6 +987,7 @@ ATTSET* as_create (const char *name, ATT_DELFN delfn)
   set->htab   = set->atts = NULL;
   set->delfn  = delfn;
   set->wgt    = 1.0;
+  set->valblk = 0;              /* (values are allocated on the heap) */
   set->fldcnt = set->fldsize = 0;
   set->flds   = NULL;           /* clear field map */
   set->err    = 0;
@@ -955,6 +1005,7 @@ ATTSET* as_clone (const ATTSET *set)
   assert(set);                  /* check the function argument */
   clone = as_create(set->name, set->delfn);
   if (!clone) return NULL;      /* create a new attribute set */
+  clone->valblk = set->valblk;  /* copy the value memory mode */
   if (as_attcopy(clone, set, AS_ALL) != 0) {
     as_delete(clone); return NULL; }
   clone->sd2p = set->sd2p;      /* copy all attributes and */
@@ -963,6 +1014,8 @@ ATTSET* as_clone (const ATTSET *set)
     clone->flds = (ATTID*)malloc((size_t)set->fldsize *sizeof(ATTID));
     if (!clone->flds) { as_delete(clone); return NULL; }
     memcpy(clone->flds, set->flds, (size_t)set->fldcnt *sizeof(ATTID));
+    clone->fldsize = set->fldsize;
+    clone->fldcnt  = set->fldcnt;
   }                             /* create and copy the field array */
   return clone;                 /* return created clone */
 }  /* as_clone() */
@@ -1059,6 +1112,18 @@ void as_restore (ATTSET *set, ATTID *marks)
 
 /*--------------------------------------------------------------------*/
 
+void as_valmem (ATTSET *set, size_t blksz)
+{                               /* --- set value memory mode */
+  ATTID k;                      /* loop variable */
+
+  assert(set);                  /* check the function argument */
+  set->valblk = blksz;          /* note the block size for new atts. */
+  for (k = set->cnt; --k >= 0;) /* traverse the attributes */
+    att_valmem(set->atts[k], blksz);
+}  /* as_valmem() */            /* and set their memory mode */
+
+/*--------------------------------------------------------------------*/
+
 int as_attadd (ATTSET *set, ATT *att)
 {                               /* --- add one attribute */
   ATT **p, *h;                  /* to traverse the hash bin */
@@ -1076,6 +1141,8 @@ int as_attadd (ATTSET *set, ATT *att)
   set->atts[set->cnt] = att;    /* and attribute array */
   att->id   = set->cnt++;       /* set attribute identifier */
   att->set  = set;              /* and containing attribute set */
+  if ((set->valblk > 0) && (att->valblk <= 0))
+    att_valmem(att, set->valblk);  /* set the value memory mode */
   return 0;                     /* return 'ok' */
 }  /* as_attadd() */
 
@@ -1105,6 +1172,8 @@ int as_attaddm (ATTSET *set, ATT **atts, ATTID cnt)
     set->atts[set->cnt] = att;  /* and attribute array */
     att->id  = set->cnt++;      /* set attribute identifier */
     att->set = set;             /* and containing attribute set */
+    if ((set->valblk > 0) && (att->valblk <= 0))
+      att_valmem(att, set->valblk);   /* set value memory mode */
   }
   return 0;                     /* return 'ok' */
 }  /* as_attaddm() */
@@ -0,0 +1,564 @@
+/*----------------------------------------------------------------------
+  File    : tabcol.c
+  Contents: column-major table management (contiguous columns)
+  Author  : Christian Borgelt
+  History : 2016.05.15 file created
+            2016.05.16 function tc_readp() added (multi-threaded reading)
+            2016.05.16 function tc_tplcut() added (e.g. validation split)
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include "tabcol.h"
+#ifdef TAB_READ
+#include "thread.h"
+#endif
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define BLKSIZE    256          /* column array block size */
+#define CHUNKSIZE  (1 << 20)    /* text chunk size per read thread */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+#ifdef TAB_READ
+
+typedef struct {                /* --- table read worker --- */
+  ATTSET  *attset;              /* clone of the attribute set */
+  TABREAD *trd;                 /* table reader for a text chunk */
+  TABCOL  *tc;                  /* table for the tuples of the chunk */
+  char    *beg, *end;           /* text chunk to parse */
+  int     mode;                 /* read mode (see as_read()) */
+  int     err;                  /* error code of the worker */
+} TCWORK;                       /* (table read worker) */
+
+#endif
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static INST null (TABCOL *tc, ATTID colid)
+{                               /* --- get null value of a column */
+  INST inst;                    /* null value of the column */
+
+  switch (att_type(as_att(tc->attset, colid))) {
+    case AT_FLT: inst.f = NV_FLT; break;
+    case AT_INT: inst.i = NV_INT; break;
+    default    : inst.n = NV_NOM; break;
+  }                             /* get the null value */
+  return inst;                  /* w.r.t. the column type */
+}  /* null() */
+
+/*--------------------------------------------------------------------*/
+
+static void fill (TABCOL *tc, ATTID colid)
+{                               /* --- fill a column with nulls */
+  TPLID i;                      /* loop variable */
+  INST  *col, inst;             /* column to fill, null value */
+
+  inst = null(tc, colid);       /* get the null value of the column */
+  col  = tc->cols[colid];       /* and store it in all rows */
+  for (i = 0; i < tc->cnt; i++) col[i] = inst;
+}  /* fill() */
+
+/*--------------------------------------------------------------------*/
+
+static int addcols (TABCOL *tc)
+{                               /* --- add columns for new attributes */
+  ATTID n;                      /* new number of columns */
+  INST  **cols;                 /* reallocated column array */
+  TUPLE *view;                  /* reallocated tuple view */
+
+  n = as_attcnt(tc->attset);    /* get the number of attributes */
+  if (n <= tc->colcnt) return 0;/* and check for new attributes */
+  cols = (INST**)realloc(tc->cols, (size_t)n *sizeof(INST*));
+  if (!cols) return -1;         /* enlarge the column array */
+  tc->cols = cols;              /* and set the new array */
+  view = (TUPLE*)realloc(tc->view, sizeof(TUPLE)
+                        +(size_t)(n-1) *sizeof(INST));
+  if (!view) return -1;         /* enlarge the tuple view */
+  tc->view = view;              /* and set the new view */
+  for ( ; tc->colcnt < n; tc->colcnt++) {
+    cols[tc->colcnt] = (INST*)malloc((size_t)tc->size *sizeof(INST)
+                                    +sizeof(INST));
+    if (!cols[tc->colcnt]) return -1;
+    fill(tc, tc->colcnt);       /* allocate a new column and */
+  }                             /* fill the existing rows with nulls */
+  return 0;                     /* return 'ok' */
+}  /* addcols() */
+
+/*--------------------------------------------------------------------*/
+
+static int resize (TABCOL *tc, TPLID size)
+{                               /* --- resize the column arrays */
+  ATTID  k;                     /* loop variable */
+  TPLID  n;                     /* current array size */
+  INST   *col;                  /* reallocated column */
+  WEIGHT *wgts;                 /* reallocated weight array */
+  TPLID  *p;                    /* reallocated mark/row array */
+
+  n = tc->size;                 /* get the current array size */
+  if (n >= size) return 0;      /* if arrays are large enough, abort */
+  n += (n > BLKSIZE) ? n >> 1 : BLKSIZE;
+  if (n >  size) size = n;      /* compute the new array size */
+  for (k = 0; k < tc->colcnt; k++) {
+    col = (INST*)realloc(tc->cols[k], (size_t)size *sizeof(INST));
+    if (!col) return -1;        /* traverse and resize the columns */
+    tc->cols[k] = col;          /* (if a later array cannot be */
+  }                             /* resized, the size is not updated */
+  wgts = (WEIGHT*)realloc(tc->wgts, (size_t)size *sizeof(WEIGHT));
+  if (!wgts) return -1;         /* and all arrays are resized again */
+  tc->wgts = wgts;              /* with the next call) */
+  p = (TPLID*)realloc(tc->marks, (size_t)size *sizeof(TPLID));
+  if (!p) return -1;            /* resize the weight, mark, */
+  tc->marks = p;                /* and row arrays */
+  p = (TPLID*)realloc(tc->rows,  (size_t)size *sizeof(TPLID));
+  if (!p) return -1;
+  tc->rows = p;
+  tc->size = size;              /* set the new array size */
+  return 1;                     /* return 'ok' */
+}  /* resize() */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+
+TABCOL* tc_create (ATTSET *attset)
+{                               /* --- create a column-major table */
+  TABCOL *tc;                   /* created table */
+
+  assert(attset);               /* check the function argument */
+  tc = (TABCOL*)malloc(sizeof(TABCOL));
+  if (!tc) return NULL;         /* allocate memory for table body */
+  tc->attset = attset;          /* note the attribute set and */
+  tc->colcnt = 0;               /* initialize the fields */
+  tc->size   = tc->cnt = 0;
+  tc->cols   = NULL; tc->wgts = NULL;
+  tc->marks  = tc->rows = NULL;
+  tc->wgt    = 0.0;
+  tc->view   = (TUPLE*)malloc(sizeof(TUPLE));
+  if (!tc->view || (addcols(tc) != 0)) {
+    tc_delete(tc, 0); return NULL; }
+  tc->view->attset = attset;    /* create the columns and */
+  tc->view->table  = NULL;      /* initialize the tuple view */
+  tc->view->id     = -1;
+  return tc;                    /* return the created table */
+}  /* tc_create() */
+
+/*--------------------------------------------------------------------*/
+
+TABCOL* tc_fromtab (TABLE *tab)
+{                               /* --- create from a (row) table */
+  TPLID  i, n;                  /* loop variable, number of tuples */
+  TABCOL *tc;                   /* created table */
+
+  assert(tab);                  /* check the function argument */
+  tc = tc_create(tab_attset(tab));
+  if (!tc) return NULL;         /* create a column-major table */
+  n  = tab_tplcnt(tab);         /* and allocate the columns */
+  if (resize(tc, n) < 0) { tc_delete(tc, 0); return NULL; }
+  for (i = 0; i < n; i++)       /* copy the tuples of the table */
+    tc_tpladd(tc, tab_tpl(tab, i));
+  return tc;                    /* return the created table */
+}  /* tc_fromtab() */
+
+/*--------------------------------------------------------------------*/
+
+void tc_delete (TABCOL *tc, int delas)
+{                               /* --- delete a column-major table */
+  ATTID k;                      /* loop variable */
+
+  assert(tc);                   /* check the function argument */
+  if (tc->cols) {               /* if there are columns, */
+    for (k = 0; k < tc->colcnt; k++)
+      free(tc->cols[k]);        /* delete the column arrays */
+    free(tc->cols);             /* and the array of columns */
+  }
+  if (tc->rows)  free(tc->rows);    /* delete the row order, */
+  if (tc->marks) free(tc->marks);   /* the tuple marks, */
+  if (tc->wgts)  free(tc->wgts);    /* the tuple weights, */
+  if (tc->view)  free(tc->view);    /* and the tuple view */
+  if (delas) as_delete(tc->attset);
+  free(tc);                     /* delete the table body */
+}  /* tc_delete() */
+
+/*--------------------------------------------------------------------*/
+
+int tc_tpladd (TABCOL *tc, const TUPLE *tpl)
+{                               /* --- add a tuple to a table */
+  ATTID k, n;                   /* loop variable, number of columns */
+  TPLID i;                      /* index of the new row */
+
+  assert(tc);                   /* check the function argument */
+  if ((addcols(tc) != 0)        /* add columns for new attributes */
+  ||  (resize(tc, tc->cnt+1) < 0)) /* and enlarge the columns */
+    return -1;                  /* if necessary */
+  i = tc->cnt;                  /* get the index of the new row */
+  if (tpl) {                    /* if a tuple is given, */
+    n = tpl_colcnt(tpl);        /* copy its columns */
+    if (n > tc->colcnt) n = tc->colcnt;
+    for (k = 0; k < n; k++) tc->cols[k][i] = tpl->cols[k];
+    tc->wgts [i] = tpl->wgt;    /* copy the tuple weight */
+    tc->marks[i] = tpl->mark; } /* and the tuple mark */
+  else {                        /* if no tuple is given */
+    for (k = 0; k < tc->colcnt; k++)
+      tc->cols[k][i] = *att_inst(as_att(tc->attset, k));
+    n = k;                      /* copy the attribute instances */
+    tc->wgts [i] = as_getwgt(tc->attset);
+    tc->marks[i] = 0;           /* copy the instance weight */
+  }                             /* and clear the tuple mark */
+  for ( ; n < tc->colcnt; n++)  /* set missing columns to null */
+    tc->cols[n][i] = null(tc, n);
+  tc->rows[i] = i;              /* append the row to the order */
+  tc->wgt += tc->wgts[i];       /* sum the tuple weight */
+  tc->cnt++;                    /* count the added tuple */
+  return 0;                     /* return 'ok' */
+}  /* tc_tpladd() */
+
+/*--------------------------------------------------------------------*/
+
+TUPLE* tc_tplx (TABCOL *tc, TPLID tplid, TUPLE *tpl)
+{                               /* --- get tuple view of a row */
+  ATTID k;                      /* loop variable */
+  TPLID r;                      /* index of the row */
+
+  assert(tc && tpl && (tplid >= 0) && (tplid < tc->cnt));
+  r = tc->rows[tplid];          /* get the row of the tuple */
+  for (k = 0; k < tc->colcnt; k++)
+    tpl->cols[k] = tc->cols[k][r];
+  tpl->attset = tc->attset;     /* gather the column values */
+  tpl->table  = NULL;           /* and set the tuple fields */
+  tpl->id     = tplid;          /* (the view is not contained */
+  tpl->mark   = tc->marks[r];   /* in a row-based table) */
+  tpl->xwgt   = tpl->wgt = tc->wgts[r];
+  return tpl;                   /* return the filled tuple */
+}  /* tc_tplx() */
+
+/*--------------------------------------------------------------------*/
+
+void tc_toas (TABCOL *tc, TPLID tplid)
+{                               /* --- copy row to attribute set */
+  ATTID k;                      /* loop variable */
+  TPLID r;                      /* index of the row */
+
+  assert(tc && (tplid >= 0) && (tplid < tc->cnt));
+  r = tc->rows[tplid];          /* get the row of the tuple */
+  for (k = 0; k < tc->colcnt; k++)
+    *att_inst(as_att(tc->attset, k)) = tc->cols[k][r];
+  as_setwgt(tc->attset, tc->wgts[r]);
+}  /* tc_toas() */              /* copy the columns and the weight */
+
+/*--------------------------------------------------------------------*/
+
+void tc_shuffle (TABCOL *tc, TPLID off, TPLID cnt, RANDFN randfn)
+{                               /* --- shuffle a table section */
+  TPLID i, r;                   /* tuple index, row buffer */
+  TPLID *p;                     /* to traverse the rows */
+
+  assert(tc && (off >= 0) && randfn);   /* check function arguments */
+  if (cnt > (i = tc->cnt -off)) cnt = i;
+  assert(cnt >= 0);             /* check and adapt number of tuples */
+  for (p = tc->rows +off; --cnt > 0; ) {
+    i = (TPLID)((double)(cnt+1) *randfn());
+    if      (i > cnt) i = cnt;  /* compute a random index in the */
+    else if (i < 0)   i = 0;    /* remaining table section */
+    r = p[i]; p[i] = *p; *p++ = r;
+  }                             /* exchange first and i-th row */
+}  /* tc_shuffle() */           /* (same sequence as tab_shuffle()) */
+
+/*--------------------------------------------------------------------*/
+
+int tc_tplcut (TABCOL *dst, TABCOL *src, TPLID off, TPLID cnt)
+{                               /* --- cut a section out of a table */
+  ATTID k;                      /* loop variable for columns */
+  TPLID i, j, r;                /* loop variables for tuples/rows */
+  TPLID *map;                   /* map from old to new row indices */
+
+  assert(src && (off >= 0) && (off <= src->cnt));
+  if (cnt > (i = src->cnt -off)) cnt = i;
+  if (cnt <= 0) return 0;       /* check and adapt number of tuples */
+  map = (TPLID*)malloc((size_t)src->cnt *sizeof(TPLID));
+  if (!map) return -1;          /* create a row index map */
+  for (i = off; i < off+cnt; i++) {
+    if (dst && (tc_tpladd(dst, tc_tplx(src, i, src->view)) != 0)) {
+      free(map); return -1; }   /* copy the tuples of the section */
+    map[src->rows[i]] = -1;     /* to the destination table and */
+  }                             /* mark their rows as removed */
+  for (i = 0; i < off; i++)     /* mark the rows of the remaining */
+    map[src->rows[i]] = 0;      /* tuples as kept */
+  for (i = off+cnt; i < src->cnt; i++)
+    map[src->rows[i]] = 0;
+  for (src->wgt = 0, r = j = 0; r < src->cnt; r++) {
+    if (map[r] < 0) continue;   /* traverse the kept rows */
+    for (k = 0; k < src->colcnt; k++)
+      src->cols[k][j] = src->cols[k][r];
+    src->wgts [j] = src->wgts [r];
+    src->marks[j] = src->marks[r];
+    src->wgt += src->wgts[j];   /* move the row down and */
+    map[r] = j++;               /* sum the tuple weights */
+  }                             /* (rows keep their relative order) */
+  for (i = 0; i < off; i++)     /* map the rows of the tuples */
+    src->rows[i] = map[src->rows[i]];  /* before the section */
+  for (i = off+cnt; i < src->cnt; i++)
+    src->rows[i-cnt] = map[src->rows[i]];
+  src->cnt -= cnt;              /* and after the section */
+  free(map);                    /* delete the row index map */
+  return 0;                     /* return 'ok' */
+}  /* tc_tplcut() */
+
+/*--------------------------------------------------------------------*/
+#ifdef TAB_READ
+
+int tc_read (TABCOL *tc, TABREAD *trd, int mode, ...)
+{                               /* --- read a table */
+  int     r;                    /* buffer for result */
+  va_list args;                 /* list of variable arguments */
+
+  assert(tc && trd);            /* check the function arguments */
+  va_start(args, mode);         /* start variable argument evaluation */
+  r = tc_vread(tc, trd, mode, &args);             /* read the table */
+  va_end(args);                 /* end variable argument evaluation */
+  return r;                     /* return the read result */
+}  /* tc_read() */
+
+/*--------------------------------------------------------------------*/
+
+int tc_vread (TABCOL *tc, TABREAD *trd, int mode, va_list *args)
+{                               /* --- read a table */
+  int r;                        /* result of read operation */
+
+  assert(tc && trd && args);    /* check the function arguments */
+  r = as_vread(tc->attset, trd, mode, args);
+  if (r < 0) return r;          /* read the first record and */
+  if (r > 0) return 0;          /* check for error and end of file */
+  if ((mode & AS_DFLT)          /* if a tuple has been read, */
+  || !(mode & AS_ATT)) {        /* store the read tuple */
+    if (tc_tpladd(tc, NULL) != 0) return E_NOMEM; }
+  if (mode & TAB_ONE) return 0; /* check for single record reading */
+  mode = (mode & ~(AS_DFLT|AS_ATT|TAB_ONE)) | AS_INST;
+  while (1) {                   /* record read loop */
+    r = as_vread(tc->attset, trd, mode, args);
+    if (r < 0) return r;        /* read the next record and */
+    if (r > 0) return 0;        /* check for error and end of file */
+    if (tc_tpladd(tc, NULL) != 0) return E_NOMEM;
+  }                             /* store the read tuple */
+}  /* tc_vread() */
+
+/*--------------------------------------------------------------------*/
+
+static void parse (void *data, int id)
+{                               /* --- parse a text chunk */
+  TCWORK *w = (TCWORK*)data +id;/* worker of the thread */
+  int    r;                     /* result of read operation */
+
+  w->tc->cnt = 0;               /* remove the tuples */
+  w->tc->wgt = 0;               /* of the previous chunk */
+  trd_memopen(w->trd, w->beg, (size_t)(w->end -w->beg), NULL);
+  while ((r = as_read(w->attset, w->trd, w->mode)) == 0) {
+    if (tc_tpladd(w->tc, NULL) != 0) { r = E_NOMEM; break; } }
+  w->err = (r < 0) ? r : 0;     /* read and store the tuples */
+}  /* parse() */                /* and note a read error */
+
+/*--------------------------------------------------------------------*/
+
+static int merge (TABCOL *tc, TCWORK *w, const VALID *bases)
+{                               /* --- merge the tuples of a chunk */
+  ATTID k;                      /* loop variable for columns */
+  TPLID i, n, off;              /* loop variable, number of tuples */
+  VALID v, m;                   /* value identifiers */
+  VALID *map;                   /* map from local to global ids */
+  ATT   *src, *dst;             /* local and global attribute */
+  INST  *s, *d;                 /* to traverse the columns */
+
+  n = w->tc->cnt;               /* get the number of tuples */
+  if (n <= 0) return 0;         /* and check for an empty chunk */
+  if (resize(tc, tc->cnt +n) < 0) return E_NOMEM;
+  for (m = 0, k = 0; k < tc->colcnt; k++) {
+    v = as_att(w->attset, k)->cnt -bases[k];
+    if (v > m) m = v;           /* determine the maximum number */
+  }                             /* of new values of an attribute */
+  map = (VALID*)malloc((size_t)(m+1) *sizeof(VALID));
+  if (!map) return E_NOMEM;     /* allocate a value map */
+  off = tc->cnt;                /* get the index of the first row */
+  for (k = 0; k < tc->colcnt; k++) {
+    src = as_att(w->attset, k); /* traverse the columns */
+    dst = as_att(tc->attset, k);
+    s = w->tc->cols[k]; d = tc->cols[k] +off;
+    if      (dst->type == AT_INT) { /* if integer attribute */
+      if (src->min.i < dst->min.i) dst->min.i = src->min.i;
+      if (src->max.i > dst->max.i) dst->max.i = src->max.i; }
+    else if (dst->type == AT_FLT) { /* if float attribute */
+      if (src->min.f < dst->min.f) dst->min.f = src->min.f;
+      if (src->max.f > dst->max.f) dst->max.f = src->max.f; }
+    if (dst->type != AT_NOM) {  /* if numeric attribute */
+      if ((dst->valwd[0] > 0) && (src->valwd[0] > dst->valwd[0]))
+        dst->valwd[0] = dst->valwd[1] = src->valwd[0];
+      memcpy(d, s, (size_t)n *sizeof(INST));
+      continue;                 /* merge the value ranges and widths */
+    }                           /* and copy the values */
+    for (m = 0, v = bases[k]; v < src->cnt; v++) {
+      if (att_valadd(dst, att_valname(src, v), NULL) < 0) {
+        free(map); return E_NOMEM; }
+      map[m++] = dst->inst.n;   /* add new values to the global */
+    }                           /* attribute and note their ids */
+    for (i = 0; i < n; i++) {   /* traverse the rows and */
+      v = s[i].n;               /* map the new values */
+      d[i].n = (v >= bases[k]) ? map[v -bases[k]] : v;
+    }                           /* (values that were known at */
+  }                             /* the start keep their ids) */
+  free(map);                    /* delete the value map */
+  memcpy(tc->wgts +off, w->tc->wgts, (size_t)n *sizeof(WEIGHT));
+  for (i = off; i < off +n; i++) {
+    tc->marks[i] = 0;           /* clear the tuple marks, */
+    tc->rows [i] = i;           /* append the rows to the order */
+    tc->wgt += tc->wgts[i];     /* and sum the tuple weights */
+  }
+  tc->cnt += n;                 /* count the added tuples */
+  return 0;                     /* return 'ok' */
+}  /* merge() */
+
+/*--------------------------------------------------------------------*/
+
+static int sync (ATTSET *dst, ATTSET *src, const VALID *bases)
+{                               /* --- synchronize a clone */
+  ATTID k;                      /* loop variable for attributes */
+  VALID v;                      /* loop variable for values */
+  ATT   *s, *d;                 /* to traverse the attributes */
+
+  for (k = 0; k < as_attcnt(src); k++) {
+    s = as_att(src, k);         /* traverse the attributes */
+    d = as_att(dst, k);         /* of the original and the clone */
+    if (s->type != AT_NOM) {    /* if numeric attribute */
+      d->min = s->min; d->max = s->max;
+      d->valwd[0] = s->valwd[0]; d->valwd[1] = s->valwd[1];
+      continue;                 /* copy the value range */
+    }                           /* and the value widths */
+    while (d->cnt > bases[k])   /* remove the values added locally */
+      att_valrem(d, d->cnt-1);  /* and add the global new values */
+    for (v = d->cnt; v < s->cnt; v++)
+      if (att_valadd(d, att_valname(s, v), NULL) < 0) return -1;
+  }                             /* (afterwards the clone has */
+  return 0;                     /* the same values as the original) */
+}  /* sync() */
+
+/*--------------------------------------------------------------------*/
+
+static void report (TABCOL *tc, TABREAD *trd, TCWORK *w)
+{                               /* --- report a read error */
+  trd->rec  += w->trd->rec -1;  /* get the record number and */
+  trd->pos   = w->trd->pos;     /* the field position in the file */
+  trd->delim = w->trd->delim;   /* as well as the last delimiter */
+  trd->len   = trd_len(w->trd); /* and copy the current field */
+  memcpy(trd->field, trd_field(w->trd), trd->len);
+  trd->field[trd->len] = 0;     /* (the text chunk is deleted) */
+  trd->fld   = trd->field;
+  tc->attset->err = w->err;     /* set the error code */
+  tc->attset->trd = trd;        /* and the table reader */
+}  /* report() */               /* (needed by as_errmsg()) */
+
+/*--------------------------------------------------------------------*/
+
+int tc_readp (TABCOL *tc, TABREAD *trd, int mode, int thcnt)
+{                               /* --- read a table with threads */
+  int     i, r, cnt;            /* loop variable, result, threads */
+  int     eof = 0;              /* whether end of input is reached */
+  ATTID   k;                    /* loop variable for attributes */
+  size_t  size, len, lim, n;    /* buffer size, text length */
+  char    *buf, *p, *e;         /* text buffer and chunk boundaries */
+  VALID   *bases = NULL;        /* numbers of values at chunk start */
+  TCWORK  *wrks  = NULL;        /* workers for the threads */
+  THRTEAM *team;                /* team of worker threads */
+
+  assert(tc && trd && !(mode & AS_RANGE));
+  r = tc_read(tc, trd, mode | TAB_ONE);
+  if (r < 0) return r;          /* read the header/first record */
+  if (addcols(tc) != 0) return E_NOMEM;
+  mode = (mode & ~(AS_DFLT|AS_ATT|TAB_ONE)) | AS_INST;
+  team = thr_create(thcnt);     /* create a team of worker threads */
+  if (!team || ((cnt = thr_cnt(team)) <= 1)) {
+    if (team) thr_delete(team); /* if there is only one thread, */
+    return tc_read(tc, trd, mode);    /* read the table serially */
+  }                             /* (also if no threads can be made) */
+  size = (size_t)cnt *CHUNKSIZE;/* get the text buffer size */
+  len  = (size_t)(trd->end -trd->next);
+  if (len > size) size = len;   /* get the buffered characters */
+  buf   = (char*) malloc(size *sizeof(char));
+  bases = (VALID*)malloc((size_t)tc->colcnt *sizeof(VALID));
+  wrks  = (TCWORK*)calloc((size_t)cnt, sizeof(TCWORK));
+  r = (!buf || !bases || !wrks) ? E_NOMEM : 0;
+  for (k = 0; (r == 0) && (k < tc->colcnt); k++)
+    bases[k] = as_att(tc->attset, k)->cnt;
+  for (i = 0; (r == 0) && (i < cnt); i++) {
+    wrks[i].mode   = mode;      /* create the workers: */
+    wrks[i].attset = as_clone(tc->attset);   /* a clone of the */
+    wrks[i].trd    = trd_create();/* attribute set, a table reader */
+    if (!wrks[i].attset || !wrks[i].trd) { r = E_NOMEM; break; }
+    trd_copy(wrks[i].trd, trd); /* with the same character flags */
+    wrks[i].tc = tc_create(wrks[i].attset);
+    if (!wrks[i].tc || (sync(wrks[i].attset, tc->attset, bases) != 0))
+      r = E_NOMEM;              /* and a column-major table */
+  }                             /* for the tuples of a chunk */
+  if (r == 0) {                 /* get the buffered characters */
+    memcpy(buf, trd->next, len); trd->next = trd->end; }
+  while (r == 0) {              /* chunk read loop */
+    if (!eof && (len < size) && trd->file) {
+      n = fread(buf +len, sizeof(char), size -len, trd->file);
+      if (ferror(trd->file)) { r = tc->attset->err = E_FREAD; break; }
+      eof = (n < size -len); len += n; }
+    else if (!trd->file) eof = 1;   /* fill the text buffer */
+    if (len <= 0) break;        /* check for the end of the input */
+    for (lim = len; lim > 0; lim--)   /* find the last record */
+      if (trd_istype(trd, buf[lim-1], TRD_RECSEP)) break;
+    if (eof) lim = len;         /* at the end parse all characters */
+    else if (lim <= 0) {        /* if there is no complete record, */
+      p = (char*)realloc(buf, (size += size) *sizeof(char));
+      if (!p) { r = E_NOMEM; break; }
+      buf = p; continue;        /* enlarge the text buffer */
+    }                           /* and read more characters */
+    for (p = buf, i = 0; i < cnt; i++) {
+      e = buf +(lim /(size_t)cnt) *(size_t)(i+1);
+      if (i >= cnt-1) e = buf +lim;
+      if (e < p)      e = p;    /* get the nominal chunk end */
+      while ((e > buf) && (e < buf +lim)
+      &&     !trd_istype(trd, e[-1], TRD_RECSEP))
+        e++;                    /* move the chunk end after */
+      wrks[i].beg = p;          /* the next record separator */
+      wrks[i].end = p = e;      /* (chunks contain whole records) */
+    }
+    thr_run(team, parse, wrks); /* parse the chunks in parallel */
+    for (i = 0; i < cnt; i++) { /* traverse the chunks in order */
+      if (wrks[i].err < 0) { report(tc, trd, wrks+i);
+        r = wrks[i].err; break; }
+      r = merge(tc, wrks+i, bases);
+      if (r != 0) { tc->attset->err = r; break; }
+      trd->rec += wrks[i].trd->rec -1;
+    }                           /* merge the tuples into the table */
+    if (r != 0) break;          /* and count the records */
+    for (i = 0; i < cnt; i++) { /* synchronize the clones */
+      if (sync(wrks[i].attset, tc->attset, bases) != 0) {
+        r = tc->attset->err = E_NOMEM; break; } }
+    for (k = 0; k < tc->colcnt; k++)
+      bases[k] = as_att(tc->attset, k)->cnt;
+    memmove(buf, buf +lim, len -= lim);
+  }                             /* keep an incomplete last record */
+  for (i = 0; wrks && (i < cnt); i++) {
+    if (wrks[i].tc)     tc_delete(wrks[i].tc, 0);
+    if (wrks[i].attset) as_delete(wrks[i].attset);
+    if (wrks[i].trd)    trd_delete(wrks[i].trd, 0);
+  }                             /* delete the workers */
+  if (wrks)  free(wrks);        /* and the work buffers */
+  if (bases) free(bases);
+  if (buf)   free(buf);
+  thr_delete(team);             /* delete the thread team */
+  return r;                     /* return the read result */
+}  /* tc_readp() */
+
+#endif  /* #ifdef TAB_READ */
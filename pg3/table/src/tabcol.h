@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------
+  File    : tabcol.h
+  Contents: column-major table management (contiguous columns)
+  Author  : Christian Borgelt
+  History : 2016.05.15 file created
+            2016.05.16 function tc_readp() added (multi-threaded reading)
+            2016.05.16 function tc_tplcut() added (e.g. validation split)
+----------------------------------------------------------------------*/
+#ifndef __TABCOL__
+#define __TABCOL__
+#include "table.h"
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- column-major table --- */
+  ATTSET *attset;               /* underlying attribute set */
+  ATTID  colcnt;                /* number of columns */
+  TPLID  size;                  /* size of the column arrays */
+  TPLID  cnt;                   /* number of tuples */
+  INST   **cols;                /* column arrays (one per attribute) */
+  WEIGHT *wgts;                 /* tuple weights */
+  TPLID  *marks;                /* tuple marks */
+  TPLID  *rows;                 /* tuple order (indices of rows) */
+  double wgt;                   /* total tuple weight */
+  TUPLE  *view;                 /* tuple view of a row */
+} TABCOL;                       /* (column-major table) */
+
+/* A column-major table stores the values of each attribute in one  */
+/* contiguous array and the tuple weights and marks in two separate */
+/* arrays, so that a table needs no per tuple memory blocks. Tuples */
+/* are addressed by their position in the tuple order (rows[]), so  */
+/* shuffling a table only permutes an index array. Row access with  */
+/* TUPLE based functions is possible through a tuple view, which is */
+/* filled from the columns by tc_tpl() or tc_tplx().                */
+
+/* tc_tplcut() removes the tuples at positions off to off+cnt-1 of  */
+/* the tuple order from a table and appends them to another table,  */
+/* unless this table is NULL. The columns of the source table are   */
+/* compacted, so the removed tuples release their place. It may be  */
+/* used to split off a random validation set after tc_shuffle().    */
+
+/* tc_readp() reads the table body with several threads: the text   */
+/* is split into chunks at record separators, which are parsed      */
+/* in parallel, each with its own clone of the attribute set. New   */
+/* nominal values are added to the attribute set in chunk order, so */
+/* that value identifiers and tuple order are the same as with      */
+/* tc_read(). Reading value ranges (mode AS_RANGE) is not possible. */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern TABCOL* tc_create  (ATTSET *attset);
+extern TABCOL* tc_fromtab (TABLE *tab);
+extern void    tc_delete  (TABCOL *tc, int delas);
+extern ATTSET* tc_attset  (TABCOL *tc);
+extern ATTID   tc_colcnt  (const TABCOL *tc);
+extern TPLID   tc_tplcnt  (const TABCOL *tc);
+extern double  tc_tplwgt  (const TABCOL *tc);
+
+extern int     tc_tpladd  (TABCOL *tc, const TUPLE *tpl);
+extern TPLID   tc_row     (const TABCOL *tc, TPLID tplid);
+extern INST*   tc_col     (TABCOL *tc, ATTID colid);
+extern INST*   tc_colval  (TABCOL *tc, TPLID tplid, ATTID colid);
+extern WEIGHT  tc_getwgt  (const TABCOL *tc, TPLID tplid);
+extern TPLID   tc_getmark (const TABCOL *tc, TPLID tplid);
+extern TPLID   tc_setmark (TABCOL *tc, TPLID tplid, TPLID mark);
+extern TUPLE*  tc_tpl     (TABCOL *tc, TPLID tplid);
+extern TUPLE*  tc_tplx    (TABCOL *tc, TPLID tplid, TUPLE *tpl);
+extern TUPLE*  tc_buf     (TABCOL *tc);
+extern void    tc_toas    (TABCOL *tc, TPLID tplid);
+extern void    tc_shuffle (TABCOL *tc, TPLID off, TPLID cnt,
+                           RANDFN randfn);
+extern int     tc_tplcut  (TABCOL *dst, TABCOL *src,
+                           TPLID off, TPLID cnt);
+#ifdef TAB_READ
+extern int     tc_read    (TABCOL *tc, TABREAD *trd, int mode, ...);
+extern int     tc_vread   (TABCOL *tc, TABREAD *trd, int mode,
+                           va_list *args);
+extern int     tc_readp   (TABCOL *tc, TABREAD *trd, int mode,
+                           int thcnt);
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define tc_attset(t)       ((t)->attset)
+#define tc_colcnt(t)       ((t)->colcnt)
+#define tc_tplcnt(t)       ((t)->cnt)
+#define tc_tplwgt(t)       ((t)->wgt)
+
+#define tc_row(t,i)        ((t)->rows[i])
+#define tc_col(t,c)        ((t)->cols[c])
+#define tc_colval(t,i,c)   ((t)->cols[c] +(t)->rows[i])
+#define tc_getwgt(t,i)     ((t)->wgts [(t)->rows[i]])
+#define tc_getmark(t,i)    ((t)->marks[(t)->rows[i]])
+#define tc_setmark(t,i,m)  ((t)->marks[(t)->rows[i]] = (m))
+#define tc_tpl(t,i)        tc_tplx(t, i, (t)->view)
+#define tc_buf(t)          ((t)->view)
+
+#endif
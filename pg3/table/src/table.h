@@ -41,12 +41,16 @@
             2013.09.05 return values for tab_reduce() and tab_balance()
             2015.08.01 function tab_colperm() added (permute columns)
             2015.08.05 parameter 'intmul' added to tab_balance()
+            2016.05.16 function tab_reducex() added (hash reduction)
+            2016.05.16 function tab_joinx() added (hash join)
+            2016.05.16 function tab_tplmem() added (memory system)
 ----------------------------------------------------------------------*/
 #ifndef __TABLE__
 #define __TABLE__
 #include <stddef.h>
 #include <stdint.h>
 #include "fntypes.h"
+#include "memsys.h"
 #if defined TAB_READ  && !defined AS_READ
 #define AS_READ
 #endif
@@ -132,12 +136,22 @@
 #define TAB_FULL    0x0001       /* fully expand null values */
 #define TAB_NORM    0x0002       /* normalize one point coverages */
 
+/* --- reduction flags --- */
+#define TAB_SORTED  0x0000       /* sort the reduced table */
+#define TAB_FIRST   0x0001       /* keep order of first occurrences */
+
+/* --- join methods --- */
+#define TAB_AUTO    0x0000       /* choose the join method */
+#define TAB_MERGE   0x0001       /* sort both tables and merge them */
+#define TAB_HASH    0x0002       /* hash the smaller table */
+
 /*----------------------------------------------------------------------
   Type Definitions
 ----------------------------------------------------------------------*/
 typedef struct {                /* --- tuple --- */
   ATTSET       *attset;         /* underlying attribute set */
   struct table *table;          /* containing table (if any) */
+  MEMSYS       *mem;            /* memory system (NULL: heap) */
   TPLID        id;              /* identifier (index in table) */
   TPLID        mark;            /* mark,   e.g. to indicate usage */
   WEIGHT       wgt;             /* weight, e.g. number of occurrences */
@@ -159,8 +173,22 @@ typedef struct table {          /* --- table --- */
   TUPLE        *buf;            /* buffer for a tuple */
   TPL_DELFN    *delfn;          /* tuple deletion function */
   double       wgt;             /* total tuple weight */
+  TPLID        blkcnt;          /* tuples per memory block (0: heap) */
+  MEMSYS       *mem;            /* memory system for tuples */
 } TABLE;                        /* (table) */
 
+/* With tab_tplmem() a table can be set up to allocate the tuples it */
+/* creates itself (e.g. when reading, with tab_tpladd(tab, NULL) or  */
+/* tab_tpladdm(tab, NULL, n), when copying, cloning or joining) from */
+/* a memory system, that is, from blocks of blkcnt tuples each, and  */
+/* to release them all at once when the table is deleted or cleared. */
+/* Every tuple records where its memory comes from, so that tuples   */
+/* created with tpl_create() may still be added, and tuples may be   */
+/* removed from the table or moved to other tables and deleted with  */
+/* tpl_delete() as usual. Bulk release requires tpl_delete() as the  */
+/* tuple deletion function; with another deletion function it is    */
+/* called for each tuple as usual.                                   */
+
 /*----------------------------------------------------------------------
   Tuple Functions
 ----------------------------------------------------------------------*/
@@ -213,6 +241,7 @@ extern TABLE*  tab_create  (const char *name, ATTSET *attset,
 extern TABLE*  tab_clone   (const TABLE *tab, int cloneas);
 extern void    tab_delete  (TABLE *tab, int delas);
 extern int     tab_rename  (TABLE *tab, const char *name);
+extern void    tab_tplmem  (TABLE *tab, TPLID blkcnt);
 extern int     tab_cmp     (const TABLE *tab1, const TABLE *tab2,
                             TPL_CMPFN cmpfn, void *data);
 
@@ -222,6 +251,7 @@ extern ATTID   tab_attcnt  (const TABLE *tab);
 extern TUPLE*  tab_buf     (TABLE *tab);
 
 extern TPLID   tab_reduce  (TABLE *tab);
+extern TPLID   tab_reducex (TABLE *tab, int mode, int thcnt);
 extern int     tab_opc     (TABLE *tab, int mode);
 extern WEIGHT  tab_poss    (TABLE *tab, TUPLE *tpl);
 extern void    tab_possx   (TABLE *tab, TUPLE *tpl, double res[]);
@@ -243,6 +273,9 @@ extern void    tab_fill    (TABLE *tab, TPLID tploff, TPLID tplcnt,
                                         ATTID coloff, ATTID colcnt);
 extern ATTID   tab_join    (TABLE *dst, TABLE *src,
                             ATTID *dcis, ATTID *scis, ATTID cnt);
+extern ATTID   tab_joinx   (TABLE *dst, TABLE *src,
+                            ATTID *dcis, ATTID *scis, ATTID cnt,
+                            int mode);
 #ifdef TAB_READ
 extern CCHAR*  tab_errmsg  (TABLE *tab, char *buf, size_t size);
 extern int     tab_read    (TABLE *tab, TABREAD *trd, int mode, ...);
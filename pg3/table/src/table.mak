@@ -7,6 +7,11 @@
 #           2006.07.20 adapted to Visual Studio 8
 #           2011.01.28 program tsort added (sort a data table)
 #           2011.08.22 external module random added (from util/src)
+#           2016.05.15 module tabcol added (column-major tables)
+#           2016.05.16 module tabcol made dependent on thread
+#           2016.05.16 module tab1t added (table1 with threads)
+#           2016.05.16 program tjbench added (join benchmark)
+#           2016.05.16 external module memsys added (tuples and values)
 #-----------------------------------------------------------------------
 THISDIR  = ..\..\table\src
 UTILDIR  = ..\..\util\src
@@ -21,9 +26,10 @@ INC      = /I $(UTILDIR)
 HDRS     = $(UTILDIR)\fntypes.h  $(UTILDIR)\arrays.h    \
            $(UTILDIR)\scanner.h  $(UTILDIR)\error.h     \
            $(UTILDIR)\tabread.h  $(UTILDIR)\tabwrite.h  \
-           attset.h table.h
+           $(UTILDIR)\memsys.h   attset.h table.h
 OBJS     = $(UTILDIR)\arrays.obj  $(UTILDIR)\escape.obj \
-           $(UTILDIR)\tabread.obj attset1.obj
+           $(UTILDIR)\tabread.obj $(UTILDIR)\memsys.obj \
+           attset1.obj
 OBJS1    = $(OBJS)  $(UTILDIR)\scform.obj  $(UTILDIR)\tabwrite.obj \
            attset2.obj table1.obj table2.obj
 OBJS2    = $(OBJS)  $(UTILDIR)\scanner.obj $(UTILDIR)\tabwrite.obj \
@@ -43,6 +49,7 @@ XMAT_O   = $(UTILDIR)\symtab.obj  $(UTILDIR)\escape.obj \
            $(UTILDIR)\tabread.obj xmat.obj
 SKEL1_O  = $(OBJS1) skel1.obj
 SKEL2_O  = $(OBJS2) skel2.obj
+BENCH_O  = $(OBJS1) $(UTILDIR)\random.obj tjbench.obj
 PRGS     = dom.exe opc.exe tsort.exe tmerge.exe tsplit.exe tjoin.exe \
            tbal.exe tnorm.exe t1inn.exe inulls.exe xmat.exe
 
@@ -90,6 +97,11 @@ skel1.exe:    $(SKEL1_O) table.mak
 skel2.exe:    $(SKEL2_O) table.mak
 	$(LD) $(LDFLAGS) $(SKEL2_O) $(LIBS) /out:$@
 
+bench:        tjbench.exe
+
+tjbench.exe:  $(BENCH_O) table.mak
+	$(LD) $(LDFLAGS) $(BENCH_O) $(LIBS) /out:$@
+
 #-----------------------------------------------------------------------
 # Main Programs
 #-----------------------------------------------------------------------
@@ -136,11 +148,14 @@ skel1.obj:    $(HDRS) table.h io.h skel1.c table.mak
 skel2.obj:    $(HDRS) table.h io.h skel2.c table.mak
 	$(CC) $(CFLAGS) $(INC) skel2.c /Fo$@
 
+tjbench.obj:  $(HDRS) $(UTILDIR)\random.h tjbench.c table.mak
+	$(CC) $(CFLAGS) $(INC) tjbench.c /Fo$@
+
 #-----------------------------------------------------------------------
 # Attribute Set Management
 #-----------------------------------------------------------------------
 attset1.obj:  $(UTILDIR)\fntypes.h  $(UTILDIR)\arrays.h \
-              $(UTILDIR)\scanner.h
+              $(UTILDIR)\scanner.h  $(UTILDIR)\memsys.h
 attset1.obj:  attset.h attset1.c table.mak
 	$(CC) $(CFLAGS) $(INC) attset1.c /Fo$@
 
@@ -164,7 +179,8 @@ attset3.obj:  attset.h attset3.c table.mak
 #-----------------------------------------------------------------------
 # Attribute Map Management
 #-----------------------------------------------------------------------
-attmap.obj:   $(UTILDIR)\fntypes.h $(UTILDIR)\scanner.h attset.h
+attmap.obj:   $(UTILDIR)\fntypes.h $(UTILDIR)\scanner.h attset.h \
+              table.h tabcol.h
 attmap.obj:   attmap.h attmap.c table.mak
 	$(CC) $(CFLAGS) $(INC) attmap.c /Fo$@
 
@@ -172,10 +188,16 @@ attmap.obj:   attmap.h attmap.c table.mak
 # Table Management
 #-----------------------------------------------------------------------
 table1.obj:   $(UTILDIR)\fntypes.h  $(UTILDIR)\arrays.h \
-              $(UTILDIR)\scanner.h  attset.h
+              $(UTILDIR)\scanner.h  $(UTILDIR)\memsys.h attset.h
 table1.obj:   table.h table1.c table.mak
 	$(CC) $(CFLAGS) $(INC) table1.c /Fo$@
 
+tab1t.obj:    $(UTILDIR)\fntypes.h  $(UTILDIR)\arrays.h \
+              $(UTILDIR)\scanner.h  $(UTILDIR)\thread.h \
+              $(UTILDIR)\memsys.h   attset.h
+tab1t.obj:    table.h table1.c table.mak
+	$(CC) $(CFLAGS) $(INC) /D TAB_THREAD table1.c /Fo$@
+
 tab2ro.obj:   $(UTILDIR)\fntypes.h  $(UTILDIR)\scanner.h \
               $(UTILDIR)\tabread.h  attset.h
 tab2ro.obj:   table.h table2.c table.mak
@@ -191,6 +213,12 @@ table3.obj:   $(UTILDIR)\fntypes.h  $(UTILDIR)\scanner.h attset.h
 table3.obj:   table.h table3.c table.mak
 	$(CC) $(CFLAGS) $(INC) table3.c /Fo$@
 
+tabcol.obj:   $(UTILDIR)\fntypes.h  $(UTILDIR)\scanner.h \
+              $(UTILDIR)\tabread.h  $(UTILDIR)\thread.h \
+              attset.h table.h
+tabcol.obj:   tabcol.h tabcol.c table.mak
+	$(CC) $(CFLAGS) $(INC) /D TAB_READ tabcol.c /Fo$@
+
 #-----------------------------------------------------------------------
 # Utility Functions for Visualization Programs
 #-----------------------------------------------------------------------
@@ -222,6 +250,10 @@ $(UTILDIR)\tabread.obj:
 	cd $(UTILDIR)
 	$(MAKE) /f util.mak tabread.obj
 	cd $(THISDIR)
+$(UTILDIR)\memsys.obj:
+	cd $(UTILDIR)
+	$(MAKE) /f util.mak memsys.obj
+	cd $(THISDIR)
 $(UTILDIR)\tabwrite.obj:
 	cd $(UTILDIR)
 	$(MAKE) /f util.mak tabwrite.obj
@@ -245,7 +277,7 @@ install:
 # Clean up
 #-----------------------------------------------------------------------
 localclean:
-	-@erase /Q *~ *.obj *.idb *.pch $(PRGS) skel1 skel2
+	-@erase /Q *~ *.obj *.idb *.pch $(PRGS) skel1 skel2 tjbench.exe
 
 clean:
 	$(MAKE) /f table.mak localclean
@@ -43,6 +43,11 @@
             2013.07.26 parameter 'dir' added to function tab_sort()
             2013.09.05 return values for tab_reduce() and tab_balance()
             2015.08.01 function tab_colperm() added (permute columns)
+            2016.05.16 function tab_reducex() added (hash reduction)
+            2016.05.16 function tab_joinx() added (hash join)
+            2016.05.16 tuples may be allocated with a memory system
+            2016.05.16 null values ordered consistently in tpl_cmp()
+            2016.05.16 null values ordered consistently in joincmp()
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
@@ -53,6 +58,9 @@
 #include <assert.h>
 #include "arrays.h"
 #include "table.h"
+#ifdef TAB_THREAD
+#include "thread.h"
+#endif
 #ifdef STORAGE
 #include "storage.h"
 #endif
@@ -61,6 +69,8 @@
   Preprocessor Definitions
 ----------------------------------------------------------------------*/
 #define BLKSIZE    256          /* tuple array block size */
+#define PARMIN    8192          /* min. number of tuples for threads */
+#define HASHMIN     64          /* min. number of tuples for hash join */
 
 /*----------------------------------------------------------------------
   Type Definitions
@@ -71,8 +81,23 @@ typedef struct {                /* --- join comparison data --- */
   VALID **maps;                 /* maps for nominal values */
   ATTID *mis;                   /* column indices for the map */
   TUPLE **src, **dst;           /* buffers for tuples */
+  TPLID *hbuf;                  /* buffer for hash join */
+  TABLE *tab;                   /* destination (result) table */
+  MEMSYS *mem;                  /* memory system for result tuples */
+  ATTID ncs, ncd, ncr;          /* number of columns in src/dst/res */
+  TPLID rescnt, resvsz;         /* number of tuples in result array */
+  double sum;                   /* total weight of result tuples */
 } JCDATA;                       /* (join comparison data) */
 
+typedef struct {                /* --- hash reduction data --- */
+  TABLE  *tab;                  /* table to reduce */
+  int    cnt;                   /* number of partitions (threads) */
+  size_t *hashes;               /* hash values of the tuples */
+  TPLID  *reps;                 /* representatives of the tuples */
+  TPLID  **htabs;               /* hash tables of the partitions */
+  size_t *sizes;                /* sizes of the hash tables */
+} TRDATA;                       /* (hash reduction data) */
+
 /*----------------------------------------------------------------------
   Tuple Functions
 ----------------------------------------------------------------------*/
@@ -87,6 +112,7 @@ TUPLE* tpl_create (ATTSET *attset, int fromas)
   tpl = (TUPLE*)malloc(sizeof(TUPLE) +(size_t)(n-1) *sizeof(INST));
   if (!tpl) return NULL;        /* allocate memory for a tuple */
   tpl->attset = attset;         /* note the attribute set */
+  tpl->mem    = NULL;           /* (tuple is on the heap) */
   tpl->table  = NULL;           /* clear the reference to a table */
   tpl->id     = -1;             /* and the tuple identifier */
   if (!fromas)                  /* if to create an empty tuple, */
@@ -111,6 +137,7 @@ TUPLE* tpl_clone (const TUPLE *tpl)
   clone = (TUPLE*)malloc(sizeof(TUPLE) +(size_t)(n-1) *sizeof(INST));
   if (!clone) return NULL;      /* allocate memory */
   clone->attset = tpl->attset;  /* note the attribute set */
+  clone->mem    = NULL;         /* (clone is on the heap) */
   clone->table  = NULL;         /* clear the reference to a table */
   clone->id     = -1;           /* and the tuple identifier */
   clone->mark   = tpl->mark;    /* copy the tuple marker, */
@@ -143,8 +170,20 @@ void tpl_delete (TUPLE *tpl)
   assert(tpl);                  /* check the function argument */
   if (tpl->table)               /* remove the tuple from cont. table */
     tab_tplrem(tpl->table, tpl->id);
-  free(tpl);                    /* deallocate the memory */
-}  /* tpl_delete() */
+  if (tpl->mem) ms_free(tpl->mem, tpl);
+  else          free(tpl);      /* deallocate the memory */
+}  /* tpl_delete() */            /* (memory system or heap) */
+
+/*--------------------------------------------------------------------*/
+
+static int fltcmp (DTFLT a, DTFLT b)
+{                               /* --- compare floating point values */
+  if (a < b) return -1;         /* compare the values and */
+  if (a > b) return +1;         /* return the sign of the difference */
+  if (isnan(a)) return (isnan(b)) ?  0 : +1;
+  return               (isnan(b)) ? -1 :  0;
+}  /* fltcmp() */               /* (null values are equal to each */
+                                /* other and follow all other values) */
 
 /*--------------------------------------------------------------------*/
 
@@ -166,8 +205,7 @@ int tpl_cmp (const TUPLE *tpl1, const TUPLE *tpl2, void *data)
     col2 = (tpl2) ? tpl2->cols +i : att_inst(att);
     t    = att_type(att);       /* get the attribute type */
     if      (t == AT_FLT) {     /* floating point instance */
-      if (col1->f < col2->f) return -r;
-      if (col1->f > col2->f) return  r; }
+      if ((t = fltcmp(col1->f, col2->f)) != 0) return t*r; }
     else if (t == AT_INT) {     /* integer instance */
       if (col1->i < col2->i) return -r;
       if (col1->i > col2->i) return  r; }
@@ -199,8 +237,7 @@ int tpl_cmpx (const TUPLE *tpl1, const TUPLE *tpl2, void *data)
     col2 = (tpl2) ? tpl2->cols +*p : att_inst(att);
     t    = att_type(att);       /* get the attribute type */
     if      (t == AT_FLT) {     /* floating point instance */
-      if (col1->f < col2->f) return -r;
-      if (col1->f > col2->f) return  r; }
+      if ((t = fltcmp(col1->f, col2->f)) != 0) return t*r; }
     else if (t == AT_INT) {     /* integer instance */
       if (col1->i < col2->i) return -r;
       if (col1->i > col2->i) return  r; }
@@ -310,7 +347,9 @@ size_t tpl_hash (TUPLE *tpl)
   n = as_attcnt(tpl->attset);   /* get the number of columns */
   for (k = 0; k < n; k++) {     /* traverse the tuple columns */
     if (att_type(as_att(tpl->attset, k)) == AT_FLT) {
-      t = (size_t)(INT_MAX *(frexp(tpl->cols[k].f, &e) -0.5));
+      if (isnan(tpl->cols[k].f)) { t = 0; e = INT_MAX; }
+      else t = (size_t)(ptrdiff_t)(INT_MAX
+                                  *(frexp(tpl->cols[k].f, &e) -0.5));
       h ^= (h << 7) ^ (h << 1) ^ t ^ (size_t)e; }
     else                        /* split into mantissa and exponent */
       h ^= (h << 7) ^ (h << 1) ^ (size_t)tpl->cols[k].i;
@@ -378,6 +417,63 @@ int tab_resize (TABLE *tab, TPLID size)
 
 /*--------------------------------------------------------------------*/
 
+static TUPLE* tplalloc (TABLE *tab, ATTID n)
+{                               /* --- allocate a tuple for a table */
+  size_t z;                     /* size of the tuple */
+  TUPLE  *tpl;                  /* allocated tuple */
+
+  z = sizeof(TUPLE) +(size_t)(n-1) *sizeof(INST);
+  if (tab->blkcnt <= 0) {       /* if to allocate on the heap */
+    tpl = (TUPLE*)malloc(z);    /* allocate memory for a tuple */
+    if (tpl) tpl->mem = NULL;   /* and note that it is on the heap */
+    return tpl;                 /* return the allocated tuple */
+  }
+  if (tab->mem && (ms_objsize(tab->mem) < z)) {
+    ms_delete(tab->mem);        /* if the tuples have grown, release */
+    tab->mem = NULL;            /* the memory system (it is deleted */
+  }                             /* when its last tuple is freed) */
+  if (!tab->mem) {              /* if there is no memory system, */
+    tab->mem = ms_create(z, (size_t)tab->blkcnt);
+    if (!tab->mem) return NULL; /* create a memory system */
+  }                             /* for tuples of the current size */
+  tpl = (TUPLE*)ms_alloc(tab->mem);
+  if (tpl) tpl->mem = tab->mem; /* allocate memory for a tuple */
+  return tpl;                   /* and note the memory system */
+}  /* tplalloc() */
+
+/*--------------------------------------------------------------------*/
+
+static void tplfree (TUPLE *tpl)
+{                               /* --- free the memory of a tuple */
+  if (tpl->mem) ms_free(tpl->mem, tpl);
+  else          free(tpl);      /* return the tuple memory to */
+}  /* tplfree() */              /* its memory system or the heap */
+
+/*--------------------------------------------------------------------*/
+
+static void purge (TABLE *tab)
+{                               /* --- delete all tuples of a table */
+  TPLID  i;                     /* loop variable */
+  size_t n;                     /* number of tuples in memory system */
+  int    bulk = 0;              /* flag for bulk release */
+  TUPLE  **p, *tpl;             /* to traverse the tuples */
+
+  assert(tab);                  /* check the function argument */
+  if (tab->mem && (tab->delfn == tpl_delete)) {
+    for (p = tab->tpls +(i = tab->cnt), n = 0; --i >= 0; )
+      if ((*--p)->mem == tab->mem) n++;
+    bulk = (n >= ms_used(tab->mem));
+  }                             /* check whether all tuples of the */
+  for (p = tab->tpls +(i = tab->cnt); --i >= 0; ) { /* mem. system */
+    tpl = *--p;                 /* are in the table (bulk release) */
+    if (bulk && (tpl->mem == tab->mem)) continue;
+    tpl->table = NULL; tpl->id = -1; tab->delfn(tpl);
+  }                             /* delete tuples not in mem. system */
+  if (bulk) ms_clear(tab->mem); /* release the memory system blocks */
+}  /* purge() */
+
+/*--------------------------------------------------------------------*/
+
 static void restore (TABLE *tab, TPLID rszcnt, TPLID addcnt)
 {                               /* --- restore if expansion failed */
   size_t size;                  /* old size of the tuples */
@@ -387,40 +483,67 @@ static void restore (TABLE *tab, TPLID rszcnt, TPLID addcnt)
   size = (size_t)as_attcnt(tab->attset);
   size = sizeof(TUPLE) +(size-1) *sizeof(INST);
   while (--rszcnt >= 0) {       /* traverse the resized tuples */
-    *p = realloc(*p, size); p++; }
+    if (!(*p)->mem) *p = realloc(*p, size);
+    p++;                        /* (tuples in a memory system */
+  }                             /* keep their larger size) */
   tab->cnt -= addcnt;           /* restore the number of tuples */
   while (--addcnt >= 0)         /* traverse the added tuples */
-    free(*p++);                 /* and delete them */
+    tplfree(*p++);              /* and delete them */
 }  /* restore() */
 
 /*--------------------------------------------------------------------*/
 
 static int expand (TABLE *tab, TPLID tplcnt, ATTID colcnt)
 {                               /* --- expand a table */
-  TPLID  k;                     /* loop variable */
-  size_t size;                  /* new tuple size (with add. columns) */
+  TPLID  k, n;                  /* loop variable, number of tuples */
+  ATTID  m;                     /* number of columns */
+  size_t size, z;               /* new and old tuple size */
   TUPLE  **p, *tpl;             /* to traverse the tuples */
+  MEMSYS *mem = NULL;           /* memory system for expanded tuples */
 
   assert(colcnt >= 0);          /* check the function argument */
-  size = (size_t)(as_attcnt(tab->attset) +colcnt);
-  size = sizeof(TUPLE) +(size-1) *sizeof(INST);
+  m    = as_attcnt(tab->attset);/* get the number of columns */
+  size = sizeof(TUPLE) +(size_t)(m +colcnt-1) *sizeof(INST);
   if (colcnt > 0) {             /* if to add columns (expand tuples) */
+    for (n = k = 0; k < tab->cnt; k++)
+      if (tab->tpls[k]->mem) n++;
+    if (n > 0) {                /* if tuples are in memory systems, */
+      mem = ms_create(size, (size_t)((tab->blkcnt > 0) ? tab->blkcnt:n));
+      if (!mem) return -1;      /* create a new memory system */
+      if (ms_reserve(mem, (size_t)n) != 0) {
+        ms_delete(mem); return -1; }
+    }                           /* reserve memory for these tuples */
     p = tab->tpls;              /* traverse the existing tuples */
-    for (k = 0; k < tab->cnt; k++) {
+    for (k = 0; k < tab->cnt; k++, p++) {
+      if ((*p)->mem) continue;  /* skip tuples in memory systems */
       tpl = (TUPLE*)realloc(*p, size);
-      if (!tpl) { restore(tab, k, 0); return -1; }
-      *p++ = tpl;               /* resize the tuple and */
-    }                           /* set the new tuple */
+      if (!tpl) { restore(tab, k, 0); if (mem) ms_delete(mem);
+                  return -1; }  /* resize the tuple and */
+      *p = tpl;                 /* set the new tuple */
+    }
     tpl = (TUPLE*)realloc(tab->buf, size);
-    if (!tpl) { restore(tab, k, 0); return -1; }
-    tab->buf = tpl;             /* resize the tuple buffer */
-  }                             /* and set the new buffer */
+    if (!tpl) { restore(tab, k, 0); if (mem) ms_delete(mem);
+                return -1; }    /* resize the tuple buffer */
+    tab->buf = tpl;             /* and set the new buffer */
+    if (mem) {                  /* if there is a new memory system */
+      z = sizeof(TUPLE) +(size_t)(m-1) *sizeof(INST);
+      for (p = tab->tpls, k = 0; k < tab->cnt; k++, p++) {
+        if (!(*p)->mem) continue;
+        tpl = (TUPLE*)ms_alloc(mem);  /* (cannot fail, reserved) */
+        memcpy(tpl, *p, z);     /* move the tuple to */
+        tplfree(*p);            /* the new memory system */
+        tpl->mem = mem; *p = tpl;
+      }                         /* replace the memory system */
+      if (tab->mem) ms_delete(tab->mem);
+      tab->mem = mem;           /* (the old one is deleted when */
+    }                           /* its last tuple is freed) */
+  }
   if (tplcnt <= 0) return 0;    /* if no tuples to add, abort */
   if (tab_resize(tab, tab->cnt +tplcnt) < 0) {
     restore(tab, tab->cnt, 0); return -1; }
   p = tab->tpls +tab->cnt;      /* get next field in tuple array */
   for (k = 0; k < tplcnt; k++){ /* traverse the additional tuples */
-    *p++ = tpl = (TUPLE*)malloc(size);
+    *p++ = tpl = tplalloc(tab, m +colcnt);
     if (!tpl) { restore(tab, tab->cnt, k); return -1; }
     tpl->attset = tab->attset;  /* allocate a new tuple */
     tpl->table  = tab;          /* and initialize fields */
@@ -454,6 +577,8 @@ TABLE* tab_create (const char *name, ATTSET *attset, TPL_DELFN delfn)
   tab->tpls   = NULL;
   tab->delfn  = delfn;
   tab->wgt    = 0.0;
+  tab->blkcnt = 0;              /* tuples are allocated on the heap */
+  tab->mem    = NULL;           /* (no memory system by default) */
   return tab;                   /* return the created table */
 }  /* tab_create() */
 
@@ -462,6 +587,7 @@ TABLE* tab_create (const char *name, ATTSET *attset, TPL_DELFN delfn)
 TABLE* tab_clone (const TABLE *tab, int cloneas)
 {                               /* --- clone a table */
   TPLID  k;                     /* loop variable */
+  ATTID  n;                     /* number of columns */
   ATTSET *attset;               /* clone of the attribute set */
   TABLE  *clone;                /* created clone of the table */
   TUPLE  *d; const TUPLE *s;    /* to traverse the tuples */
@@ -471,19 +597,26 @@ TABLE* tab_clone (const TABLE *tab, int cloneas)
   if (!attset) return NULL;     /* get the underlying attribute set */
   clone = tab_create(tab->name, attset, tab->delfn);
   if (!clone) { if (cloneas) as_delete(attset); return NULL; }
+  clone->blkcnt = tab->blkcnt;  /* copy the tuple memory mode */
   if (tab->cnt <= 0)            /* if there are no tuples, */
     return clone;               /* abort the function */
   clone->tpls = (TUPLE**)malloc((size_t)tab->cnt *sizeof(TUPLE*));
   if (!clone->tpls) { tab_delete(clone, cloneas); return NULL; }
   for (k = 0; k < tab->cnt; k++) { /* allocate a tuple array */
     s = tab->tpls[k];           /* traverse the source tuples */
-    d = tpl_clone(s);           /* clone the source tuple */
+    n = as_attcnt(s->attset);   /* get the number of columns */
+    d = tplalloc(clone, n);     /* allocate a tuple for the clone */
     if (!d) break;              /* and check for success */
+    d->attset = s->attset;      /* copy the attribute set, */
+    d->mark   = s->mark;        /* the tuple marker, weight and */
+    d->wgt    = s->wgt;         /* extended weight, and the columns */
+    d->xwgt   = s->xwgt;        /* of the source tuple */
+    memcpy(d->cols, s->cols, (size_t)n *sizeof(INST));
     d->table = clone;           /* set the table reference and */
     clone->tpls[d->id = k] = d; /* add it to the created clone */
   }
   if (k < tab->cnt) {           /* if an error occured */
-    while (--k >= 0) free(clone->tpls[k]);
+    while (--k >= 0) tplfree(clone->tpls[k]);
     tab_delete(clone, cloneas); return NULL;
   }                             /* delete the table and abort */
   clone->size = clone->cnt = k; /* set the number of tuples */
@@ -495,15 +628,12 @@ TABLE* tab_clone (const TABLE *tab, int cloneas)
 
 void tab_delete (TABLE *tab, int delas)
 {                               /* --- delete a table */
-  TPLID i;                      /* loop variable */
-  TUPLE **p;                    /* to traverse the tuples */
-
   assert(tab);                  /* check the function argument */
   if (tab->tpls) {              /* if there are tuples */
-    for (p = tab->tpls +(i = tab->cnt); --i >= 0; ) {
-      (*--p)->table = NULL; (*p)->id = -1; tab->delfn(*p); }
-    free(tab->tpls);            /* delete tuples, array, */
+    purge(tab);                 /* delete tuples, array, */
+    free(tab->tpls);            /* memory system, */
   }                             /* and the attribute set */
+  if (tab->mem) ms_delete(tab->mem);
   if (delas) as_delete(tab->attset);
   free(tab->buf);               /* delete the tuple buffer, */
   free(tab->name);              /* the table name */
@@ -525,6 +655,20 @@ int tab_rename (TABLE *tab, const char *name)
 
 /*--------------------------------------------------------------------*/
 
+void tab_tplmem (TABLE *tab, TPLID blkcnt)
+{                               /* --- set tuple memory mode */
+  assert(tab);                  /* check the function argument */
+  if (blkcnt < 0) blkcnt = 0;   /* check the number of tuples */
+  if (blkcnt == tab->blkcnt) return;
+  if (tab->mem) {               /* if there is a memory system, */
+    ms_delete(tab->mem);        /* release it (it is deleted when */
+    tab->mem = NULL;            /* its last tuple is freed), */
+  }                             /* so that a new one is created */
+  tab->blkcnt = blkcnt;         /* note the new number of tuples */
+}  /* tab_tplmem() */           /* (0: allocate tuples on the heap) */
+
+/*--------------------------------------------------------------------*/
+
 int tab_cmp (const TABLE *tab1, const TABLE *tab2,
              TPL_CMPFN cmpfn, void *data)
 {                               /* --- compare two tables */
@@ -540,15 +684,84 @@ int tab_cmp (const TABLE *tab1, const TABLE *tab2,
 
 /*--------------------------------------------------------------------*/
 
-TPLID tab_reduce (TABLE *tab)
-{                               /* --- reduce a table */
+static int tpl_equal (const TUPLE *tpl1, const TUPLE *tpl2)
+{                               /* --- check tuples for equality */
+  ATTID      i;                 /* loop variable */
+  const INST *col1, *col2;      /* to traverse the tuple columns */
+
+  for (i = as_attcnt(tpl1->attset); --i >= 0; ) {
+    col1 = tpl1->cols +i; col2 = tpl2->cols +i;
+    if (att_type(as_att(tpl1->attset, i)) == AT_FLT) {
+      if ((col1->f != col2->f)  /* compare floating point values */
+      &&  (!isnan(col1->f) || !isnan(col2->f))) return 0; }
+    else {                      /* compare integer/nominal values */
+      if (col1->i != col2->i) return 0; }
+  }                             /* (null values are equal, */
+  return 1;                     /* as with tpl_cmp()) */
+}  /* tpl_equal() */
+
+/*--------------------------------------------------------------------*/
+
+static size_t mix (size_t h)
+{                               /* --- mix the bits of a hash value */
+  h ^= h >> 15; h *= (size_t)0x2c1b3c6dUL;
+  h ^= h >> 12; h *= (size_t)0x297a2d39UL;
+  h ^= h >> 15; return h;       /* (tpl_hash() changes mainly */
+}  /* mix() */                  /* the low bits of the hash value) */
+
+/*--------------------------------------------------------------------*/
+
+static void hashpart (void *data, int id)
+{                               /* --- compute tuple hash values */
+  TRDATA *rd = (TRDATA*)data;   /* hash reduction data */
+  TPLID  i, e;                  /* range of tuples to process */
+
+  i = (TPLID)(((size_t)rd->tab->cnt *(size_t) id)    /(size_t)rd->cnt);
+  e = (TPLID)(((size_t)rd->tab->cnt *(size_t)(id+1)) /(size_t)rd->cnt);
+  for ( ; i < e; i++)           /* traverse the thread's tuples */
+    rd->hashes[i] = mix(tpl_hash(rd->tab->tpls[i]));
+}  /* hashpart() */
+
+/*--------------------------------------------------------------------*/
+
+static void redpart (void *data, int id)
+{                               /* --- reduce a partition of tuples */
+  TRDATA *rd = (TRDATA*)data;   /* hash reduction data */
+  TUPLE  **tpls;                /* tuple array of the table */
+  TPLID  *htab;                 /* hash table of the partition */
+  TPLID  i, r;                  /* loop variable, representative */
+  size_t h, k, m;               /* hash value, bucket index, mask */
+
+  tpls = rd->tab->tpls;         /* get the tuple array */
+  htab = rd->htabs[id];         /* and the partition's hash table */
+  m    = rd->sizes[id] -1;      /* (size is a power of 2) */
+  for (k = 0; k <= m; k++) htab[k] = -1;
+  for (i = 0; i < rd->tab->cnt; i++) {
+    h = rd->hashes[i];          /* traverse the tuples in order */
+    if (h % (size_t)rd->cnt != (size_t)id)
+      continue;                 /* skip tuples of other partitions */
+    for (k = (h /(size_t)rd->cnt) & m; (r = htab[k]) >= 0;
+         k = (k+1) & m)         /* search tuple with linear probing */
+      if ((rd->hashes[r] == h) && tpl_equal(tpls[r], tpls[i]))
+        break;                  /* if an equal tuple is found, */
+    if (r < 0) rd->reps[i] = htab[k] = i;   /* abort the search */
+    else {                      /* if the tuple is new, store it, */
+      rd->reps[i] = r;          /* otherwise note representative */
+      tpls[r]->wgt += tpls[i]->wgt;
+    }                           /* and sum the tuple weights */
+  }                             /* (the first occurrence of a tuple */
+}  /* redpart() */              /* represents all its duplicates) */
+
+/*--------------------------------------------------------------------*/
+
+static TPLID sortred (TABLE *tab)
+{                               /* --- reduce a table by sorting */
   TPLID i;                      /* loop variable */
   TUPLE **d, **s;               /* to traverse the tuples */
 
-  assert(tab);                  /* check the function argument */
-  if (tab->cnt <= 0) return 0;  /* check whether table is empty */
   ptr_qsort(tab->tpls, (size_t)tab->cnt, +1, (CMPFN*)tpl_cmp, NULL);
   d = tab->tpls; s = d+1;       /* sort and traverse the tuple array */
+  (*d)->id = 0;                 /* the first tuple is always kept */
   for (i = tab->cnt, tab->cnt = 1; --i > 0; s++) {
     if (tpl_cmp(*d, *s, NULL) != 0) {
       *++d = *s;                /* if the next tuple differs, keep it */
@@ -562,8 +775,103 @@ TPLID tab_reduce (TABLE *tab)
   }
   tab_resize(tab, 0);           /* try to shrink the tuple array */
   return tab->cnt;              /* return the new number of tuples */
+}  /* sortred() */
+
+/*--------------------------------------------------------------------*/
+
+TPLID tab_reduce (TABLE *tab)
+{                               /* --- reduce a table */
+  return tab_reducex(tab, TAB_SORTED, 1);
 }  /* tab_reduce() */
 
+/*----------------------------------------------------------------------
+Duplicate tuples are found with hash tables (open addressing, linear
+probing), one per partition of the hash values, so that the partitions
+can be processed by different threads (if compiled with TAB_THREAD).
+Each partition is traversed in the order of the tuples, so the first
+occurrence of a tuple receives the weights of its duplicates and the
+reduced table keeps the order of first occurrences (mode TAB_FIRST).
+Only with mode TAB_SORTED the (smaller) reduced table is sorted.
+----------------------------------------------------------------------*/
+
+TPLID tab_reducex (TABLE *tab, int mode, int thcnt)
+{                               /* --- reduce a table (hashing) */
+  int     i;                    /* loop variable for partitions */
+  TPLID   k, n;                 /* loop variable, number of tuples */
+  size_t  z;                    /* total size of the hash tables */
+  TRDATA  rd;                   /* hash reduction data */
+  TUPLE   **d, *tpl;            /* to traverse the tuples */
+  #ifdef TAB_THREAD             /* if to use threads */
+  THRTEAM *team = NULL;         /* team of worker threads */
+  #endif
+
+  assert(tab);                  /* check the function argument */
+  if (tab->cnt <= 0) return 0;  /* check whether table is empty */
+  n = tab->cnt; rd.tab = tab; rd.cnt = 1;
+  #ifdef TAB_THREAD             /* if to use threads */
+  if ((thcnt != 1) && (n >= PARMIN)) {
+    team = thr_create(thcnt);   /* create a team of worker threads */
+    if (team) rd.cnt = thr_cnt(team);
+  }                             /* (one partition per thread) */
+  #endif
+  rd.hashes = (size_t*)malloc((size_t)n *sizeof(size_t));
+  rd.reps   = (TPLID*) malloc((size_t)n *sizeof(TPLID));
+  rd.sizes  = (size_t*)calloc((size_t)rd.cnt, sizeof(size_t));
+  rd.htabs  = (TPLID**)malloc((size_t)rd.cnt *sizeof(TPLID*));
+  if (rd.htabs) rd.htabs[0] = NULL;  /* allocate the arrays */
+  if (rd.hashes && rd.reps && rd.sizes && rd.htabs) {
+    #ifdef TAB_THREAD           /* compute the tuple hash values */
+    if (team) thr_run(team, hashpart, &rd); else
+    #endif
+    hashpart(&rd, 0);           /* (in parallel if possible) */
+    for (k = 0; k < n; k++)     /* count the tuples per partition */
+      rd.sizes[rd.hashes[k] % (size_t)rd.cnt]++;
+    for (z = 0, i = 0; i < rd.cnt; i++) {
+      k = (TPLID)rd.sizes[i];   /* traverse the partitions */
+      for (rd.sizes[i] = 1; rd.sizes[i] < 2*(size_t)k; )
+        rd.sizes[i] <<= 1;      /* compute the hash table sizes */
+      z += rd.sizes[i];         /* (at most half of the buckets */
+    }                           /* of a hash table will be used) */
+    rd.htabs[0] = (TPLID*)malloc(z *sizeof(TPLID));
+  }                             /* allocate the hash tables */
+  if (!rd.htabs || !rd.htabs[0]) {
+    if (rd.htabs)  free(rd.htabs);
+    if (rd.sizes)  free(rd.sizes);
+    if (rd.reps)   free(rd.reps);
+    if (rd.hashes) free(rd.hashes);
+    #ifdef TAB_THREAD           /* if out of memory, */
+    if (team) thr_delete(team); /* reduce the table by sorting */
+    #endif                      /* (needs no additional memory) */
+    return sortred(tab);
+  }
+  for (i = 1; i < rd.cnt; i++)  /* organize the hash tables */
+    rd.htabs[i] = rd.htabs[i-1] +rd.sizes[i-1];
+  #ifdef TAB_THREAD             /* reduce the partitions */
+  if (team) { thr_run(team, redpart, &rd); thr_delete(team); } else
+  #endif
+  redpart(&rd, 0);              /* (in parallel if possible) */
+  d = tab->tpls;                /* traverse the tuple array */
+  for (k = 0; k < n; k++) {     /* (first occurrences are kept) */
+    tpl = tab->tpls[k];         /* get the next tuple */
+    if (rd.reps[k] == k) {      /* if the tuple is a representative, */
+      tpl->id = (TPLID)(d -tab->tpls);  /* keep it in the table */
+      *d++ = tpl; continue;     /* and set its new identifier */
+    }                           /* if the tuple is a duplicate, */
+    tpl->table = NULL;          /* remove the tuple from the table, */
+    tpl->id    = -1;            /* clear the tuple identifier */
+    tab->delfn(tpl);            /* and call the deletion function */
+  }                             /* (the weight has been transferred) */
+  tab->cnt = (TPLID)(d -tab->tpls);
+  free(rd.htabs[0]); free(rd.htabs); free(rd.sizes);
+  free(rd.reps);     free(rd.hashes);
+  if (!(mode & TAB_FIRST)) {    /* if to sort the reduced table */
+    ptr_qsort(tab->tpls, (size_t)tab->cnt, +1, (CMPFN*)tpl_cmp, NULL);
+    for (k = 0; k < tab->cnt; k++) tab->tpls[k]->id = k;
+  }                             /* sort and renumber the tuples */
+  tab_resize(tab, 0);           /* try to shrink the tuple array */
+  return tab->cnt;              /* return the new number of tuples */
+}  /* tab_reducex() */
+
 /*--------------------------------------------------------------------*/
 
 double tab_balance (TABLE *tab, ATTID colid,
@@ -774,6 +1082,7 @@ static int joincmp (const TUPLE *tpl1, const TUPLE *tpl2, JCDATA *jcd)
   CINST *c1, *c2;               /* to traverse the columns to compare */
   VALID **mp;                   /* map for nominal values */
   VALID n1, n2;                 /* nominal values to compare */
+  int   t;                      /* result of float comparison */
 
   p1 = jcd->cis[1]; p2 = jcd->cis[2];
   mp = jcd->maps;               /* get the column index arrays */
@@ -781,14 +1090,15 @@ static int joincmp (const TUPLE *tpl1, const TUPLE *tpl2, JCDATA *jcd)
     c1 = tpl1->cols +*p1++;     /* traverse the column indices */
     c2 = tpl2->cols +*p2++;     /* and get the columns to compare */
     if      (*mp == (void*)-1){ /* if float attribute */
-      if (c1->f < c2->f) return -1;
-      if (c1->f > c2->f) return  1; }
+      if ((t = fltcmp(c1->f, c2->f)) != 0) return t; }
     else if (*mp == NULL) {     /* if integer attribute */
       if (c1->i < c2->i) return -1;
       if (c1->i > c2->i) return  1; }
     else {                      /* if nominal attribute */
-      n1 = (jcd->mis == jcd->cis[1]) ? (*mp)[c1->n] : c1->n;
-      n2 = (jcd->mis == jcd->cis[2]) ? (*mp)[c2->n] : c2->n;
+      n1 = ((jcd->mis == jcd->cis[1]) && !isnone(c1->n))
+         ? (*mp)[c1->n] : c1->n;
+      n2 = ((jcd->mis == jcd->cis[2]) && !isnone(c2->n))
+         ? (*mp)[c2->n] : c2->n;
       if (n1 < n2) return -1;   /* map indices of nominal values, */
       if (n1 > n2) return  1;   /* compare the atttribute values */
     }                           /* and if they differ, abort */
@@ -798,6 +1108,159 @@ static int joincmp (const TUPLE *tpl1, const TUPLE *tpl2, JCDATA *jcd)
 
 /*--------------------------------------------------------------------*/
 
+static size_t joinhash (const TUPLE *tpl, const ATTID *cis, JCDATA *jcd)
+{                               /* --- hash the join columns */
+  ATTID i;                      /* loop variable */
+  CINST *col;                   /* to traverse the join columns */
+  VALID **mp;                   /* map for nominal values */
+  int   e;                      /* binary exponent */
+  size_t h = 0, t;              /* hash value of the tuple, buffer */
+
+  mp = jcd->maps;               /* get the nominal value maps */
+  for (i = 0; i < jcd->cnt; i++, mp++) {
+    col = tpl->cols +cis[i];    /* traverse the join columns */
+    if      (*mp == (void*)-1){ /* if float attribute */
+      if (isnan(col->f)) { t = 0; e = INT_MAX; }
+      else t = (size_t)(ptrdiff_t)(INT_MAX *(frexp(col->f, &e) -0.5));
+      t ^= (size_t)e; }         /* split into mantissa and exponent */
+    else if (*mp == NULL)       /* if integer attribute */
+      t = (size_t)col->i;       /* use the value directly */
+    else                        /* if nominal attribute, map value */
+      t = (size_t)(((cis == jcd->mis) && !isnone(col->n))
+                  ? (*mp)[col->n] : col->n);
+    h ^= (h << 7) ^ (h << 1) ^ t;
+  }                             /* combine the column hash values */
+  return mix(h);                /* return the computed hash value */
+}  /* joinhash() */
+
+/*--------------------------------------------------------------------*/
+
+static int joinadd (JCDATA *jcd, const TUPLE *d, const TUPLE *s)
+{                               /* --- add a joined tuple */
+  ATTID  i;                     /* loop variable */
+  TUPLE  *tpl, **t;             /* created (joined) tuple, buffer */
+  size_t z;                     /* size of the joined tuple */
+  INST   *dc;                   /* to traverse the tuple columns */
+  CINST  *sc;                   /* to traverse the tuple columns */
+  double w;                     /* weight of the joined tuple */
+
+  if (jcd->rescnt >= jcd->resvsz) {   /* if the result array is full */
+    jcd->resvsz += (jcd->resvsz > BLKSIZE) ? jcd->resvsz >> 1 : BLKSIZE;
+    t = (TUPLE**)realloc(jcd->dst, (size_t)jcd->resvsz *sizeof(TUPLE*));
+    if (!t) return -1;          /* resize the result array */
+    jcd->dst = t;               /* and set the new array */
+  }
+  z = sizeof(TUPLE) +(size_t)(jcd->ncr-1) *sizeof(INST);
+  if (jcd->tab->blkcnt <= 0) {  /* if to allocate on the heap */
+    tpl = (TUPLE*)malloc(z);    /* create a new tuple */
+    if (!tpl) return -1; }      /* on the heap */
+  else {                        /* if to use a memory system */
+    if (!jcd->mem) {            /* if there is none yet, create one */
+      jcd->mem = ms_create(z, (size_t)jcd->tab->blkcnt);
+      if (!jcd->mem) return -1; /* (the tuples of the destination */
+    }                           /* are shorter than the joined ones) */
+    tpl = (TUPLE*)ms_alloc(jcd->mem);
+    if (!tpl) return -1;        /* create a new tuple */
+  }                             /* in the memory system */
+  tpl->mem = (jcd->tab->blkcnt > 0) ? jcd->mem : NULL;
+  dc = tpl->cols +jcd->ncr;     /* copy the source columns */
+  for (i = jcd->ncr -jcd->ncd; --i >= 0; )
+    *--dc = s->cols[jcd->cis[0][i]];
+  sc = d->cols +jcd->ncd;       /* copy the destination columns */
+  for (i = jcd->ncd; --i >= 0; ) *--dc = *--sc;
+  jcd->sum += w = (double)s->wgt *(double)d->wgt;
+  tpl->xwgt   = tpl->wgt = (WEIGHT)w;
+  tpl->mark   = d->mark;        /* compute weight of joined tuple */
+  tpl->attset = jcd->tab->attset;  /* and copy other fields from */
+  tpl->table  = jcd->tab;       /* the dest. tuple to the new one */
+  tpl->id     = jcd->rescnt;    /* insert the created tuple */
+  jcd->dst[jcd->rescnt++] = tpl;
+  return 0;                     /* return 'ok' */
+}  /* joinadd() */
+
+/*--------------------------------------------------------------------*/
+
+static int mergejoin (JCDATA *jcd, TABLE *dst, TABLE *src,
+                      ATTID *dcis, ATTID *scis)
+{                               /* --- join tables by sort-merge */
+  TUPLE **d, **s, **r;          /* to traverse the tuples */
+  int   c;                      /* comparison result */
+
+  jcd->src = (TUPLE**)malloc((size_t)(src->cnt +dst->cnt +2)
+                             *sizeof(TUPLE*));
+  if (!jcd->src) return -1;     /* allocate the tuple buffers */
+  memcpy(s = jcd->src, src->tpls, (size_t)src->cnt*sizeof(TUPLE*));
+  s[src->cnt] = NULL;           /* copy source tuples to the buffer */
+  jcd->cis[1] = jcd->cis[2] = scis;   /* and sort the source tuples */
+  ptr_qsort(s, (size_t)src->cnt, +1, (CMPFN*)joincmp, jcd);
+  memcpy(d = s +src->cnt+1, dst->tpls, (size_t)dst->cnt*sizeof(TUPLE*));
+  d[dst->cnt] = NULL;           /* copy dest.  tuples to the buffer */
+  jcd->cis[1] = jcd->cis[2] = dcis;   /* and sort the dest.  tuples */
+  ptr_qsort(d, (size_t)dst->cnt, +1, (CMPFN*)joincmp, jcd);
+  jcd->cis[2] = scis;           /* prepare for join comparisons */
+  while (*d && *s) {            /* while not at end of arrays */
+    c = joincmp(*d, *s, jcd);   /* compare the current tuples */
+    if (c < 0) { d++; continue; }  /* and find next pair */
+    if (c > 0) { s++; continue; }  /* of joinable tuples */
+    r = s;                      /* get the next source tuple */
+    do {                        /* tuple join loop */
+      if (joinadd(jcd, *d, *r) != 0) return -1;
+    } while (*++r               /* while more joins are possible */
+    &&      (joincmp(*d, *r, jcd) == 0));
+    d++;                        /* go to the next tuple */
+  }                             /* in the destination array */
+  return 0;                     /* return 'ok' */
+}  /* mergejoin() */
+
+/*--------------------------------------------------------------------*/
+
+static int hashjoin (JCDATA *jcd, TABLE *dst, TABLE *src,
+                     ATTID *dcis, ATTID *scis)
+{                               /* --- join tables by hashing */
+  TPLID  i, k;                  /* loop variables */
+  TPLID  *heads, *next;         /* hash bucket lists */
+  size_t *hashes, h, m;         /* hash values, bucket mask */
+  TABLE  *bld, *prb;            /* build and probe table */
+  ATTID  *bcis, *pcis;          /* column indices of build/probe */
+  TUPLE  *tpl;                  /* probe tuple */
+
+  if (src->cnt <= dst->cnt) { bld = src; bcis = scis;
+                              prb = dst; pcis = dcis; }
+  else                      { bld = dst; bcis = dcis;
+                              prb = src; pcis = scis; }
+  for (m = 1; m < 2*(size_t)bld->cnt; m <<= 1);
+  jcd->hbuf = (TPLID*)malloc((m +(size_t)bld->cnt) *sizeof(TPLID)
+                            +(size_t)bld->cnt *sizeof(size_t));
+  if (!jcd->hbuf) return -1;    /* allocate the hash table */
+  hashes = (size_t*)jcd->hbuf;  /* (hash values come first */
+  heads  = (TPLID*)(hashes +bld->cnt);  /* for proper alignment) */
+  next   = heads +m--;          /* organize the hash table */
+  for (h = 0; h <= m; h++) heads[h] = -1;
+  for (i = bld->cnt; --i >= 0; ) {
+    hashes[i] = h = joinhash(bld->tpls[i], bcis, jcd);
+    next[i] = heads[h & m];     /* insert the tuples of the */
+    heads[h & m] = i;           /* smaller table in reverse order, */
+  }                             /* so that the lists are in order */
+  jcd->cis[1] = dcis;           /* prepare for join comparisons */
+  jcd->cis[2] = scis;           /* (always destination vs. source) */
+  for (k = 0; k < prb->cnt; k++) {
+    tpl = prb->tpls[k];         /* traverse the larger table */
+    h   = joinhash(tpl, pcis, jcd);
+    for (i = heads[h & m]; i >= 0; i = next[i]) {
+      if (hashes[i] != h) continue;  /* traverse the bucket list */
+      if ((prb == dst) ? (joincmp(tpl, bld->tpls[i], jcd) != 0)
+                       : (joincmp(bld->tpls[i], tpl, jcd) != 0))
+        continue;               /* skip tuples that do not match */
+      if (((prb == dst) ? joinadd(jcd, tpl, bld->tpls[i])
+                        : joinadd(jcd, bld->tpls[i], tpl)) != 0)
+        return -1;              /* add the joined tuple */
+    }                           /* (build the Cartesian product */
+  }                             /* of the matching tuples) */
+  return 0;                     /* return 'ok' */
+}  /* hashjoin() */
+
+/*--------------------------------------------------------------------*/
+
 static void joinclean (JCDATA *jcd)
 {                               /* --- clean up join data */
   ATTID i;                      /* loop variable */
@@ -815,10 +1278,12 @@ static void joinclean (JCDATA *jcd)
 static int joinerr (JCDATA *jcd, TPLID cnt)
 {                               /* --- clean up if join failed */
   if (jcd->dst) {               /* if a (partial) result exists */
-    while (--cnt >= 0) free(jcd->dst[cnt]);
+    while (--cnt >= 0) tplfree(jcd->dst[cnt]);
     free(jcd->dst);             /* delete all result tuples */
   }                             /* and the result array */
-  if (jcd->src) free(jcd->src); /* delete the source tuple buffer */
+  if (jcd->mem)  ms_delete(jcd->mem); /* and their memory system */
+  if (jcd->src)  free(jcd->src);  /* delete the tuple buffer */
+  if (jcd->hbuf) free(jcd->hbuf); /* and the hash table */
   joinclean(jcd);               /* clean up the join data */
   return -1;                    /* return an error code */
 }  /* joinerr() */
@@ -827,20 +1292,31 @@ static int joinerr (JCDATA *jcd, TPLID cnt)
 
 ATTID tab_join (TABLE *dst, TABLE *src,
                 ATTID *dcis, ATTID *scis, ATTID cnt)
+{                               /* --- join two tables */
+  return tab_joinx(dst, src, dcis, scis, cnt, TAB_AUTO);
+}  /* tab_join() */
+
+/*----------------------------------------------------------------------
+With mode TAB_HASH the tuples of the smaller table are entered into
+a hash table (chained buckets, lists in tuple order), which is probed
+with the tuples of the larger table in their order. Hence the joined
+table has the order of the larger table. With mode TAB_MERGE both
+tables are sorted w.r.t. the join columns and then merged, so that
+the joined table is sorted. Mode TAB_AUTO uses a sort-merge only if
+both tables are small (less than HASHMIN tuples), because then the
+hash table costs more than it saves.
+----------------------------------------------------------------------*/
+
+ATTID tab_joinx (TABLE *dst, TABLE *src,
+                 ATTID *dcis, ATTID *scis, ATTID cnt, int mode)
 {                               /* --- join two tables */
   ATTID  i, k, x;               /* loop variables, buffers */
   VALID  n, m, z;               /* (number of) nominal value(s) */
-  ATTID  ncs, ncd, ncr;         /* number of columns in src/dst/res */
-  TPLID  size;                  /* size of the tuple buffer */
-  TPLID  rescnt, resvsz;        /* number of tuples in result array */
-  TUPLE  *tpl;                  /* created (joined) tuple */
-  TUPLE  **d, **s, **r, **t;    /* to traverse the tuples */
-  INST   *dc, *sc;              /* to traverse the tuple columns */
+  ATTID  ncs, ncd;              /* number of columns in src/dst */
   ATT    *da, *sa;              /* to traverse the column attributes */
   ATTID  *cis;                  /* non-join column index array */
   VALID  *map;                  /* to traverse nominal value maps */
   int    c;                     /* comparison result, buffer */
-  double sum, w;                /* (sum of) tuple weight(s) */
   JCDATA jcd;                   /* column data for sorting */
 
   assert(dst && src             /* check the function arguments */
@@ -869,7 +1345,8 @@ ATTID tab_join (TABLE *dst, TABLE *src,
     if (as_attid(dst->attset, att_name(as_att(src->attset, i))) >= 0) {
       free(cis); return i+1; }  /* non-join columns must not exist */
   }                             /* already in the destination table */
-  ncr = ncd +k;                 /* get the number of result columns */
+  jcd.ncs = ncs; jcd.ncd = ncd; /* note the numbers of columns */
+  jcd.ncr = ncd +k;             /* and the number of result columns */
 
   /* --- build maps for nominal values --- */
   jcd.cnt  = cnt;               /* store the number of join columns */
@@ -877,11 +1354,16 @@ ATTID tab_join (TABLE *dst, TABLE *src,
   jcd.maps = (VALID**)calloc((size_t)cnt, sizeof(VALID*));
   if (!jcd.maps) { free(cis); return -1; }
   jcd.src  = jcd.dst = NULL;    /* clear the tuple buffers */
+  jcd.hbuf = NULL;              /* and the hash table */
+  jcd.mem  = NULL;              /* no memory system for results yet */
+  jcd.tab  = dst;               /* note the destination table */
+  jcd.rescnt = jcd.resvsz = 0;  /* initialize the counters */
+  jcd.sum  = 0.0;               /* and the total tuple weight */
   for (i = 0; i < cnt; i++) {   /* traverse the join attributes */
     sa = as_att(src->attset, scis[i]);
     da = as_att(dst->attset, dcis[i]);
     c  = att_type(sa);          /* get and check the column type */
-    if (c != att_type(da)) return -2;
+    if (c != att_type(da)) { joinerr(&jcd, 0); return -2; }
     if (c == AT_FLT) { jcd.maps[i] = (void*)-1; continue; }
     if (c == AT_INT) { jcd.maps[i] = NULL;      continue; }
     n = att_valcnt(sa);         /* get the number of values and */
@@ -890,75 +1372,40 @@ ATTID tab_join (TABLE *dst, TABLE *src,
     if (!map) return joinerr(&jcd, 0);
     for (z = 0; z < n; z++) {   /* traverse the nominal values */
       map[z] = att_valid(da, att_valname(sa, z));
-      if (isnone(map[k])) map[z] = m;
+      if (isnone(map[z])) map[z] = m;
     }                           /* build the value map */
   }                             /* for the source attribute */
 
-  /* --- copy and sort tuple arrays --- */
-  size = src->cnt +dst->cnt;    /* allocate the tuple buffers */
-  jcd.src = (TUPLE**)malloc((size_t)(size+2) *sizeof(TUPLE*));
-  if (!jcd.src) return joinerr(&jcd, 0);
-  memcpy(s = jcd.src,       src->tpls, (size_t)src->cnt*sizeof(TUPLE*));
-  s[src->cnt] = NULL;           /* copy source tuples to the buffer */
-  jcd.cis[1] = jcd.cis[2] = scis;     /* and sort the source tuples */
-  ptr_qsort(s, (size_t)src->cnt, +1, (CMPFN*)joincmp, &jcd);
-  memcpy(d = s +src->cnt+1, dst->tpls, (size_t)dst->cnt*sizeof(TUPLE*));
-  d[dst->cnt] = NULL;           /* copy dest.  tuples to the buffer */
-  jcd.cis[1] = jcd.cis[2] = dcis;     /* and sort the dest.  tuples */
-  ptr_qsort(d, (size_t)dst->cnt, +1, (CMPFN*)joincmp, &jcd);
-
   /* --- join tuples --- */
-  resvsz = rescnt = 0;          /* initialize the counters */
-  sum = 0.0;                    /* and the total tuple weight */
-  jcd.cis[2] = scis;            /* prepare for join comparisons */
-  while (*d && *s) {            /* while not at end of arrays */
-    c = joincmp(*d, *s, &jcd);  /* compare the current tuples */
-    if (c < 0) { d++; continue; }  /* and find next pair */
-    if (c > 0) { s++; continue; }  /* of joinable tuples */
-    r = s;                      /* get the next source tuple */
-    do {                        /* tuple join loop */
-      if (rescnt >= resvsz) {   /* if the result array is full */
-        resvsz += (resvsz > BLKSIZE) ? resvsz >> 1 : BLKSIZE;
-        t = (TUPLE**)realloc(jcd.dst, (size_t)resvsz *sizeof(TUPLE*));
-        if (!t) return joinerr(&jcd, rescnt);
-        jcd.dst = t;            /* resize the result array */
-      }                         /* and set the new array */
-      tpl = (TUPLE*)malloc(sizeof(TUPLE) +(size_t)(ncr-1)*sizeof(INST));
-      if (!tpl) return joinerr(&jcd, rescnt);
-      dc = tpl->cols +ncr;      /* create a new tuple and */
-      sc = (*r)->cols;          /* copy the source columns */
-      for (i = ncs -cnt; --i >= 0; ) *--dc = sc[cis[i]];
-      sc = (*d)->cols +ncd;     /* copy the destination columns */
-      for (i = ncd;      --i >= 0; ) *--dc = *--sc;
-      sum +=    w = (*s)->wgt *(double)(*d)->wgt;
-      tpl->xwgt   = tpl->wgt = (WEIGHT)w;
-      tpl->mark   = (*d)->mark; /* compute weight of joined tuple */
-      tpl->attset = dst->attset;/* and copy other fields from the */
-      tpl->table  = dst;        /* dest. tuple to the created one */
-      tpl->id     = rescnt;
-      jcd.dst[rescnt++] = tpl;  /* insert the created (joined) tuple */
-    } while (*++r               /* while more joins are possible */
-    &&      (joincmp(*d, *r, &jcd) == 0));
-    d++;                        /* go to the next tuple */
-  }                             /* in the destination array */
-  free(jcd.src); jcd.src = NULL;/* delete the source tuple buffer */
+  if (mode == TAB_AUTO)         /* choose the join method */
+    mode = ((src->cnt < HASHMIN) && (dst->cnt < HASHMIN))
+         ? TAB_MERGE : TAB_HASH;
+  if (((mode == TAB_HASH) ? hashjoin (&jcd, dst, src, dcis, scis)
+                          : mergejoin(&jcd, dst, src, dcis, scis)) != 0)
+    return joinerr(&jcd, jcd.rescnt);
+  if (jcd.src)  { free(jcd.src);  jcd.src  = NULL; }
+  if (jcd.hbuf) { free(jcd.hbuf); jcd.hbuf = NULL; }
 
   /* --- replace the destination table --- */
-  for (k = ncr -ncd, i = 0; i < k; i++) {
+  for (k = jcd.ncr -ncd, i = 0; i < k; i++) {
     sa = att_clone(as_att(src->attset, cis[i]));
     if (!sa || (as_attadd(dst->attset, sa) != 0)) {
       as_attcut(NULL, dst->attset, AS_RANGE, ncd, ATTID_MAX);
-      return joinerr(&jcd, rescnt);
+      return joinerr(&jcd, jcd.rescnt);
     }                           /* add the non-join attributes */
   }                             /* to the destination table */
-  tab_tplrem(dst, -1);          /* delete all destination tuples and */
-  dst->size = resvsz;           /* set the created (joined) tuples */
-  dst->cnt  = rescnt;           /* as the new destination tuples */
+  tab_tplrem(dst, -1);          /* delete all destination tuples */
+  if (jcd.mem) {                /* if the joined tuples are in */
+    if (dst->mem) ms_delete(dst->mem);  /* a memory system, */
+    dst->mem = jcd.mem;         /* replace the memory system */
+  }                             /* of the destination table */
+  dst->size = jcd.resvsz;       /* set the created (joined) tuples */
+  dst->cnt  = jcd.rescnt;       /* as the new destination tuples */
   dst->tpls = jcd.dst;          /* (replace the tuple array) */
-  dst->wgt  = sum;              /* set the total tuple weight */
+  dst->wgt  = jcd.sum;          /* set the total tuple weight */
   joinclean(&jcd);              /* clean up the join data */
   return 0;                     /* return 'ok' */
-}  /* tab_join() */
+}  /* tab_joinx() */
 
 /*--------------------------------------------------------------------*/
 #ifndef NDEBUG
@@ -1023,8 +1470,9 @@ void tab_colrem (TABLE *tab, ATTID colid)
   for (p = tab->tpls +(i = tab->cnt); --i >= 0; ) {
     col = (*--p)->cols +colid;  /* traverse tuples and shift columns */
     memmove(col, col+1, (size_t)cnt *sizeof(INST));
-    *p = realloc(*p, size);     /* (try to) shrink the tuple */
-  }                             /* (remove the last column) */
+    if (!(*p)->mem)             /* (try to) shrink the tuple */
+      *p = realloc(*p, size);   /* (remove the last column) */
+  }                             /* (not in a memory system) */
 }  /* tab_colrem() */
 
 /*--------------------------------------------------------------------*/
@@ -1430,9 +1878,12 @@ int tab_tpladd (TABLE *tab, TUPLE *tpl)
     if (tpl->table)             /* remove it from the old table */
       tab_tplrem(tpl->table, tpl->id); }
   else {                        /* if no tuple is given */
-    tpl = tpl_create(tab->attset, 1);
-    if (!tpl) return -1;        /* create a tuple from the */
-  }                             /* underlying attribute set */
+    tpl = tplalloc(tab, as_attcnt(tab->attset));
+    if (!tpl) return -1;        /* allocate a tuple and */
+    tpl->attset = tab->attset;  /* copy the instances of the */
+    tpl_fromas(tpl);            /* underlying attribute set */
+    tpl->xwgt = tpl->wgt;       /* (heap or memory system) */
+  }
   tpl->table = tab;             /* set the table reference */
   tpl->id    = tab->cnt;        /* and the tuple identifier */
   tab->tpls[tab->cnt++] = tpl;  /* insert the tuple into the table */
@@ -1483,11 +1934,10 @@ TUPLE* tab_tplrem (TABLE *tab, TPLID tplid)
   /* --- remove all tuples --- */
   if (tplid < 0) {              /* if no tuple identifier given */
     if (!tab->tpls) return NULL;/* if there are no tuples, abort */
-    for (p = tab->tpls +(tplid = tab->cnt); --tplid >= 0; ) {
-      (*--p)->table = NULL; (*p)->id = -1; tab->delfn(*p); }
-    free(tab->tpls);            /* delete all tuples */
-    tab->tpls = NULL;           /* and the tuple array */
-    tab->cnt  = 0;              /* clear the tuple counter */
+    purge(tab);                 /* delete all tuples */
+    free(tab->tpls);            /* and the tuple array */
+    tab->tpls = NULL;           /* (keep the memory system) */
+    tab->size = tab->cnt = 0;   /* clear the array size and counter */
     tab->wgt  = 0.0;            /* and the total tuple weight */
     return NULL;                /* abort the function */
   }
@@ -1594,7 +2044,9 @@ int tab_tplcopy (TABLE *dst, const TABLE *src, int mode, ...)
   TPLID   n;                    /* loop variables */
   TPLID   off, cnt;             /* range of tuples */
   TUPLE   *tpl, **d;            /* to traverse the tuples */
+  ATTID   k;                    /* number of columns */
   size_t  z;                    /* size of the tuples */
+  MEMSYS  *mem;                 /* memory system of a new tuple */
   double  sum;                  /* sum of the tuple weights */
   va_list args;                 /* list of variable arguments */
 
@@ -1618,7 +2070,8 @@ int tab_tplcopy (TABLE *dst, const TABLE *src, int mode, ...)
   cnt += off;                   /* get end index of tuple range */
 
   /* --- copy source tuples --- */
-  z = sizeof(TUPLE) +(size_t)(as_attcnt(src->attset)-1) *sizeof(INST);
+  k = as_attcnt(src->attset);   /* get the number of columns */
+  z = sizeof(TUPLE) +(size_t)(k-1) *sizeof(INST);
   d = dst->tpls +(n = dst->cnt);/* get tuple size and destination */
   for (sum = 0; off < cnt; off++) {
     tpl = src->tpls[off];       /* traverse the range of tuples */
@@ -1626,14 +2079,16 @@ int tab_tplcopy (TABLE *dst, const TABLE *src, int mode, ...)
     &&  (tpl->mark < 0))        /* and the tuple is not marked */
       continue;                 /* skip this tuple */
     sum += tpl->wgt;            /* sum the tuple weights */
-    *d = (TUPLE*)malloc(z);     /* create a new tuple and */
+    *d = tplalloc(dst, k);      /* create a new tuple and */
     if (!*d) break;             /* store it in the destination */
-    memcpy(*d, tpl, z);         /* copy the source tuple into it */
-    (*d)->table = dst;          /* set the table reference */
+    mem = (*d)->mem;            /* copy the source tuple into it */
+    memcpy(*d, tpl, z);         /* (except the memory system) */
+    (*d)->mem   = mem;          /* set the memory system */
+    (*d)->table = dst;          /* and the table reference */
     (*d++)->id  = n++;          /* and the tuple identifier */
   }
   if (off < cnt) {              /* if an error occurred */
-    while (--n >= dst->cnt) free(*--d);
+    while (--n >= dst->cnt) tplfree(*--d);
     return -1;                  /* delete all copied tuples */
   }                             /* and abort the function */
   dst->cnt  = n;                /* set the new number of tuples */
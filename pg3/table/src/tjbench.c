@@ -0,0 +1,372 @@
+/*----------------------------------------------------------------------
+  File    : tjbench.c
+  Contents: benchmark for table joins and reductions
+            (sort-merge versus hashing)
+  Author  : Christian Borgelt
+  History : 2016.05.16 file created
+            2016.05.16 reductions added (tab_reducex(), null values)
+            2016.05.16 float keys with null values added (option -f)
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include "attset.h"
+#include "table.h"
+#include "random.h"
+#include "error.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define PRGNAME     "tjbench"
+#define DESCRIPTION "benchmark for table joins and reductions"
+#define VERSION     "version 1.0 (2016.05.16)         " \
+                    "(c) 2016        Christian Borgelt"
+
+/* --- error codes --- */
+/* error codes 0 to -5 defined in attset.h */
+#define E_OPTION     (-6)       /* unknown option */
+#define E_OPTARG     (-7)       /* missing option argument */
+#define E_ARGCNT     (-8)       /* wrong number of arguments */
+#define E_TPLCNT     (-9)       /* invalid number of tuples */
+#define E_JOIN      (-10)       /* join failed */
+#define E_DIFFER    (-11)       /* join results differ */
+#define E_REDUCE    (-12)       /* reduction results differ */
+
+#define MAXREPS     64          /* maximal number of repetitions */
+
+#define SEC_SINCE(t)  ((double)(clock()-(t)) /(double)CLOCKS_PER_SEC)
+
+/*----------------------------------------------------------------------
+  Constants
+----------------------------------------------------------------------*/
+static const char *errmsgs[] = {   /* error messages */
+  /* E_NONE      0 */  "no error",
+  /* E_NOMEM    -1 */  "not enough memory",
+  /* E_FOPEN    -2 */  "cannot open file %s",
+  /* E_FREAD    -3 */  "read error on file %s",
+  /* E_FWRITE   -4 */  "write error on file %s",
+  /* E_STDIN    -5 */  "double assignment of standard input",
+  /* E_OPTION   -6 */  "unknown option -%c",
+  /* E_OPTARG   -7 */  "missing option argument",
+  /* E_ARGCNT   -8 */  "wrong number of arguments",
+  /* E_TPLCNT   -9 */  "invalid number of tuples %"TPLID_FMT,
+  /* E_JOIN    -10 */  "join of tables failed (method %s)",
+  /* E_DIFFER  -11 */  "join results differ",
+  /* E_REDUCE  -12 */  "reduction results differ",
+  /*           -13 */  "unknown error",
+};
+
+static const char *mthnames[] = { "merge", "hash",
+                                  "reduce:sorted", "reduce:first" };
+static const int   methods[]  = { TAB_MERGE, TAB_HASH };
+static const int   modes[]    = { TAB_SORTED, TAB_FIRST };
+
+/*----------------------------------------------------------------------
+  Global Variables
+----------------------------------------------------------------------*/
+static CCHAR *prgname;          /* program name for error messages */
+static RNG   *rng     = NULL;   /* random number generator */
+static TABLE *dim     = NULL;   /* dimension table (keys) */
+static TABLE *fact    = NULL;   /* fact table (foreign keys) */
+static TABLE *res[4]  = { NULL, NULL, NULL, NULL };
+static TABLE *red     = NULL;   /* table to reduce */
+static FILE  *out     = NULL;   /* output file */
+
+/*----------------------------------------------------------------------
+  Main Functions
+----------------------------------------------------------------------*/
+
+#ifndef NDEBUG                  /* if debug version */
+  #undef  CLEANUP               /* clean up memory and close files */
+  #define CLEANUP \
+  if (res[3]) tab_delete(res[3], 1); \
+  if (res[2]) tab_delete(res[2], 1); \
+  if (red)    tab_delete(red,    1); \
+  if (res[1]) tab_delete(res[1], 1); \
+  if (res[0]) tab_delete(res[0], 1); \
+  if (fact)   tab_delete(fact,   1); \
+  if (dim)    tab_delete(dim,    1); \
+  if (rng)    rng_delete(rng);       \
+  if (out && (out != stdout)) fclose(out);
+#endif
+
+GENERROR(error, exit)           /* generic error reporting function */
+
+/*--------------------------------------------------------------------*/
+
+static TABLE* create (const char *name, const char *val, int type)
+{                               /* --- create a table for the joins */
+  ATTSET *attset;               /* attribute set of the table */
+  ATT    *att;                  /* to create the attributes */
+  TABLE  *tab;                  /* created table */
+
+  attset = as_create(name, att_delete);
+  if (!attset) return NULL;     /* create an attribute set */
+  att = att_create("key", type);/* add the key attribute */
+  if (att && (as_attadd(attset, att) != 0)) {
+    att_delete(att); att = NULL; }
+  if (att) {                    /* if the key attribute was added, */
+    att = att_create(val, AT_FLT);    /* add a value attribute */
+    if (att && (as_attadd(attset, att) != 0)) {
+      att_delete(att); att = NULL; }
+  }
+  tab = (att) ? tab_create(name, attset, tpl_delete) : NULL;
+  if (!tab) as_delete(attset);  /* create a table and */
+  return tab;                   /* return the created table */
+}  /* create() */
+
+/*--------------------------------------------------------------------*/
+
+static int tpladd (TABLE *tab, DTINT key)
+{                               /* --- add a tuple with a given key */
+                                /* (key < 0: null value) */
+  ATTSET *attset;               /* attribute set of the table */
+  ATT    *att;                  /* key attribute */
+  TUPLE  *tpl;                  /* created tuple */
+  char   buf[32];               /* buffer for nominal value names */
+
+  attset = tab_attset(tab);     /* get the attribute set */
+  att    = as_att(attset, 0);   /* and the key attribute */
+  if      (att_type(att) == AT_FLT)   /* if float key, set it */
+    att_inst(att)->f = (key < 0) ? NV_FLT : (DTFLT)key;
+  else if (att_type(att) == AT_INT)   /* if integer key, set it */
+    att_inst(att)->i = key;
+  else {                        /* if nominal key, */
+    sprintf(buf, "k%"DTINT_FMT, key);   /* create a value name */
+    if (att_valadd(att, buf, NULL) < 0) return -1;
+  }                             /* add it (sets the instance) */
+  att_inst(as_att(attset, 1))->f = (DTFLT)rng_dbl(rng);
+  tpl = tpl_create(attset, 1);  /* create a tuple from the instances */
+  if (!tpl) return -1;          /* and add it to the table */
+  if (tab_tpladd(tab, tpl) != 0) { tpl_delete(tpl); return -1; }
+  return 0;                     /* return 'ok' */
+}  /* tpladd() */
+
+/*--------------------------------------------------------------------*/
+
+static int dblcmp (const void *p1, const void *p2)
+{                               /* --- compare two doubles */
+  double a = *(const double*)p1, b = *(const double*)p2;
+  return (a < b) ? -1 : (a > b) ? +1 : 0;
+}  /* dblcmp() */
+
+/*--------------------------------------------------------------------*/
+
+int main (int argc, char *argv[])
+{                               /* --- main function */
+  int     i, j, k = 0;          /* loop variables, buffers */
+  char    *s;                   /* to traverse options */
+  CCHAR   **optarg = NULL;      /* option argument */
+  CCHAR   *fn_out  = NULL;      /* name of output file */
+  TPLID   dcnt     = 1000;      /* number of keys of dimension table */
+  TPLID   fcnt     = 100000;    /* number of tuples of fact table */
+  TPLID   mult     = 1;         /* number of dimension tuples per key */
+  double  miss     = 0.5;       /* fraction of unmatched fact keys */
+  double  nulls    = 0.2;       /* fraction of null values */
+  int     type     = AT_NOM;    /* type of the key attribute */
+  int     swap     = 0;         /* flag for dimension table as dest. */
+  int     reps     = 5;         /* number of repetitions */
+  long    seed     = (long)time(NULL);  /* seed for random numbers */
+  double  times[4][MAXREPS];    /* execution times of joins etc. */
+  TABLE   *dst, *src;           /* destination and source of joins */
+  TABLE   *tab;                 /* destination clone for a join */
+  TPLID   n, r;                 /* loop variables for tuples */
+  DTINT   m;                    /* range of fact table keys */
+  DTINT   key;                  /* key of a fact table tuple */
+  clock_t t;                    /* for time measurements */
+
+  prgname = argv[0];            /* get program name for error msgs. */
+
+  /* --- print startup/usage message --- */
+  if (argc > 1) {               /* if arguments are given */
+    fprintf(stderr, "%s - %s\n", argv[0], DESCRIPTION);
+    fprintf(stderr, VERSION); } /* print a startup message */
+  else {                        /* if no argument is given */
+    printf("usage: %s [options] outfile\n", argv[0]);
+    printf("%s\n", DESCRIPTION);
+    printf("%s\n", VERSION);
+    printf("-d#      number of keys in dimension table      "
+                    "(default: %"TPLID_FMT")\n", dcnt);
+    printf("-x#      number of dimension tuples per key     "
+                    "(default: %"TPLID_FMT")\n", mult);
+    printf("-n#      number of tuples in fact table         "
+                    "(default: %"TPLID_FMT")\n", fcnt);
+    printf("-u#      fraction of unmatched fact keys        "
+                    "(default: %g)\n", miss);
+    printf("-i       use integer keys                       "
+                    "(default: nominal keys)\n");
+    printf("-f       use float keys (with null values)      "
+                    "(default: nominal keys)\n");
+    printf("-w       join fact table into dimension table   "
+                    "(default: vice versa)\n");
+    printf("-z#      fraction of null keys/values           "
+                    "(default: %g)\n", nulls);
+    printf("-r#      number of repetitions                  "
+                    "(default: %d)\n", reps);
+    printf("-s#      seed for random number generator       "
+                    "(default: time)\n");
+    printf("outfile  file to write the execution times to "
+                    "(\"-\": stdout)\n");
+    return 0;                   /* print a usage message */
+  }                             /* and abort the program */
+
+  /* --- evaluate arguments --- */
+  for (i = 1; i < argc; i++) {  /* traverse arguments */
+    s = argv[i];                /* get option argument */
+    if (optarg) { *optarg = s; optarg = NULL; continue; }
+    if ((*s == '-') && *++s) {  /* -- if argument is an option */
+      while (1) {               /* traverse characters */
+        switch (*s++) {         /* evaluate option */
+          case 'd': dcnt = (TPLID)strtol(s, &s, 0); break;
+          case 'x': mult = (TPLID)strtol(s, &s, 0); break;
+          case 'n': fcnt = (TPLID)strtol(s, &s, 0); break;
+          case 'u': miss =        strtod(s, &s);    break;
+          case 'i': type = AT_INT;                  break;
+          case 'f': type = AT_FLT;                  break;
+          case 'w': swap = 1;                       break;
+          case 'z': nulls =       strtod(s, &s);    break;
+          case 'r': reps = (int)  strtol(s, &s, 0); break;
+          case 's': seed =        strtol(s, &s, 0); break;
+          default : error(E_OPTION, *--s);          break;
+        }                       /* set option variables */
+        if (!*s) break;         /* if at end of string, abort loop */
+        if (optarg) { *optarg = s; optarg = NULL; break; }
+      } }                       /* get option argument */
+    else {                      /* -- if argument is no option */
+      switch (k++) {            /* evaluate non-option */
+        case  0: fn_out = s;      break;
+        default: error(E_ARGCNT); break;
+      }                         /* note filename */
+    }
+  }
+  if (optarg) error(E_OPTARG);  /* check option argument */
+  if (k != 1) error(E_ARGCNT);  /* check the number of arguments */
+  if (dcnt <= 0) error(E_TPLCNT, dcnt);
+  if (fcnt <= 0) error(E_TPLCNT, fcnt);
+  if (mult <= 0) mult = 1;      /* check the table sizes */
+  if ((miss  < 0) || (miss  >= 1)) miss  = 0;
+  if ((nulls < 0) || (nulls >  1)) nulls = 0;
+  if (reps < 1)       reps = 1; /* check the fraction of unmatched */
+  if (reps > MAXREPS) reps = MAXREPS;   /* keys and the number */
+  fputc('\n', stderr);          /* of repetitions */
+
+  /* --- create the tables --- */
+  t = clock();                  /* start the timer */
+  fprintf(stderr, "creating tables ... ");
+  rng = rng_create((unsigned int)seed);
+  if (!rng) error(E_NOMEM);     /* create a random number generator */
+  dim  = create("dim",  "dv", type);
+  fact = create("fact", "fv", type);
+  if (!dim || !fact) error(E_NOMEM);
+  for (r = 0; r < mult; r++)    /* fill the dimension table */
+    for (n = 0; n < dcnt; n++)  /* (keys in ascending order) */
+      if (tpladd(dim, (DTINT)n) != 0) error(E_NOMEM);
+  if (type == AT_FLT)           /* with float keys add a null key */
+    for (r = 0; r < mult; r++)  /* to the dimension table */
+      if (tpladd(dim, -1) != 0) error(E_NOMEM);
+  m = (DTINT)((double)dcnt /(1.0-miss));
+  for (n = 0; n < fcnt; n++) {  /* fill the fact table */
+    key = ((type == AT_FLT) && (rng_dbl(rng) < nulls))
+        ? -1 : (DTINT)(rng_dbl(rng) *m);
+    if (tpladd(fact, key) != 0) error(E_NOMEM);
+  }                             /* (random keys, some unmatched, */
+                                /* some null with float keys) */
+  fprintf(stderr, "[%"TPLID_FMT"+%"TPLID_FMT" tuple(s)]",
+          tab_tplcnt(dim), tab_tplcnt(fact));
+  fprintf(stderr, " done [%.2fs].\n", SEC_SINCE(t));
+
+  /* --- join the tables --- */
+  dst = (swap) ? dim  : fact;   /* get the destination table */
+  src = (swap) ? fact : dim;    /* and the source table */
+  for (i = 0; i < reps; i++) {  /* repeat the joins */
+    for (k = 0; k < 2; k++) {   /* traverse the join methods */
+      tab = tab_clone(dst, 1);  /* clone the destination table */
+      if (!tab) error(E_NOMEM); /* (a join modifies it) */
+      t = clock();              /* natural join of the tables */
+      if (tab_joinx(tab, src, NULL, NULL, -1, methods[k]) != 0) {
+        tab_delete(tab, 1); error(E_JOIN, mthnames[k]); }
+      times[k][i] = SEC_SINCE(t);
+      if (res[k]) tab_delete(res[k], 1);
+      res[k] = tab;             /* note the execution time */
+    }                           /* and the (last) join result */
+  }
+
+  /* --- check the join results --- */
+  if ((tab_tplcnt(res[0]) != tab_tplcnt(res[1]))
+  ||  (tab_tplwgt(res[0]) != tab_tplwgt(res[1])))
+    error(E_DIFFER);            /* compare sizes and weights */
+  for (k = 0; k < 2; k++)       /* sort the join results */
+    tab_sort(res[k], 0, TPLID_MAX, +1, tpl_cmp, NULL);
+  if (tab_cmp(res[0], res[1], tpl_cmp, NULL) != 0)
+    error(E_DIFFER);            /* compare the tuples */
+
+  /* --- reduce the fact table --- */
+  red = tab_clone(fact, 1);     /* clone the fact table and replace */
+  if (!red) error(E_NOMEM);     /* its values by a few distinct ones */
+  for (n = 0; n < tab_tplcnt(red); n++) {
+    j = (int)(rng_dbl(rng) *4); /* (quarters and null values) */
+    tpl_colval(tab_tpl(red, n), 1)->f = (rng_dbl(rng) < nulls)
+                                      ? NV_FLT : (DTFLT)(0.25*j);
+  }                             /* (duplicate tuples are folded) */
+  for (i = 0; i < reps; i++) {  /* repeat the reductions */
+    for (k = 0; k < 2; k++) {   /* traverse the reduction modes */
+      tab = tab_clone(red, 1);  /* clone the table to reduce */
+      if (!tab) error(E_NOMEM); /* (a reduction modifies it) */
+      t = clock();              /* reduce the table */
+      tab_reducex(tab, modes[k], 1);
+      times[2+k][i] = SEC_SINCE(t);
+      if (res[2+k]) tab_delete(res[2+k], 1);
+      res[2+k] = tab;           /* note the execution time */
+    }                           /* and the (last) reduction result */
+  }
+
+  /* --- check the reduction results --- */
+  if ((tab_tplcnt(res[2]) != tab_tplcnt(res[3]))
+  ||  (tab_tplwgt(res[2]) != tab_tplwgt(res[3]))
+  ||  (tab_tplwgt(res[2]) != tab_tplwgt(red)))
+    error(E_REDUCE);            /* compare sizes and weights */
+  tab_sort(res[3], 0, TPLID_MAX, +1, tpl_cmp, NULL);
+  if (tab_cmp(res[2], res[3], tpl_cmp, NULL) != 0)
+    error(E_REDUCE);            /* compare the tuples */
+  for (n = 1; n < tab_tplcnt(res[2]); n++)
+    if (tpl_cmp(tab_tpl(res[2], n-1), tab_tpl(res[2], n), NULL) >= 0)
+      error(E_REDUCE);          /* check for remaining duplicates */
+
+  /* --- write the execution times --- */
+  if (strcmp(fn_out, "-") == 0) fn_out = "";
+  out = (*fn_out) ? fopen(fn_out, "w") : stdout;
+  if (!out) error(E_FOPEN, fn_out);
+  fprintf(out, "method         tuples       min [s]  median [s]\n");
+  for (k = 0; k < 4; k++) {     /* traverse the methods */
+    qsort(times[k], (size_t)reps, sizeof(double), dblcmp);
+    fprintf(out, "%-13s  %-11"TPLID_FMT"  %7.3f  %10.3f\n",
+            mthnames[k], tab_tplcnt(res[k]),
+            times[k][0], times[k][reps/2]);
+  }                             /* print minimum and median time */
+  if (fflush(out) != 0) error(E_FWRITE, fn_out);
+  if (out != stdout) fclose(out);
+  out = NULL;                   /* close the output file */
+
+  /* --- clean up --- */
+  #ifndef NDEBUG                /* if this is a debug version */
+  tab_delete(res[3], 1);        /* delete the reduction results */
+  tab_delete(res[2], 1);        /* and the reduced table */
+  tab_delete(red,    1);
+  tab_delete(res[1], 1);        /* delete the join results */
+  tab_delete(res[0], 1);        /* and the input tables */
+  tab_delete(fact,   1);
+  tab_delete(dim,    1);
+  rng_delete(rng);              /* delete the random number generator */
+  #endif
+  #ifdef STORAGE                /* if storage debugging */
+  showmem("at end of program"); /* check memory usage */
+  #endif
+  return 0;                     /* return 'ok' */
+}  /* main() */
@@ -0,0 +1,197 @@
+/*----------------------------------------------------------------------
+  File    : memsys.c
+  Contents: memory management system for objects of equal size
+  Author  : Christian Borgelt
+  History : 2004.12.10 file created
+            2016.05.16 objects of variable size added (bump allocation)
+            2016.05.16 functions ms_reserve() and ms_clear() added
+            2016.05.16 deletion deferred while objects are still used
+----------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <assert.h>
+#include "memsys.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef union {                 /* --- alignment of objects --- */
+  void   *p;                    /* pointer (also list link) */
+  double d;                     /* floating point number */
+  long   l;                     /* integer number */
+  size_t z;                     /* size/counter */
+} ALIGN;                        /* (alignment of objects) */
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define HDRSIZE     sizeof(ALIGN)   /* size of a block header */
+#define ROUND(n)    ((((n) +sizeof(ALIGN)-1) /sizeof(ALIGN)) \
+                                             *sizeof(ALIGN))
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static char* newblk (MEMSYS *ms, size_t size)
+{                               /* --- allocate a new memory block */
+  void **blk;                   /* new memory block */
+
+  blk = (void**)malloc(HDRSIZE +size);
+  if (!blk) return NULL;        /* allocate a new block and */
+  *blk = ms->list;              /* add it to the block list */
+  ms->list   = blk;             /* (the first field of each block */
+  ms->bytes += HDRSIZE +size;   /* is the link to the next block) */
+  return (char*)blk +HDRSIZE;   /* return the usable memory */
+}  /* newblk() */
+
+/*--------------------------------------------------------------------*/
+
+static void release (MEMSYS *ms)
+{                               /* --- release all memory blocks */
+  void **blk;                   /* to traverse the memory blocks */
+
+  while (ms->list) {            /* while there is another block */
+    blk = (void**)ms->list;     /* note the current block, */
+    ms->list = *blk;            /* remove it from the list */
+    free(blk);                  /* and delete it */
+  }
+  ms->free  = NULL;             /* clear the free list */
+  ms->next  = ms->end = NULL;   /* and the current block */
+  ms->used  = ms->nfree = 0;    /* clear the object counters */
+  ms->bytes = 0;                /* and the memory size */
+}  /* release() */
+
+/*----------------------------------------------------------------------
+  Main Functions
+----------------------------------------------------------------------*/
+
+MEMSYS* ms_create (size_t size, size_t cnt)
+{                               /* --- create a memory system */
+  MEMSYS *ms;                   /* created memory management system */
+
+  assert(cnt > 0);              /* check the function arguments */
+  ms = (MEMSYS*)malloc(sizeof(MEMSYS));
+  if (!ms) return NULL;         /* create the base structure */
+  if (size > 0) {               /* if objects of equal size */
+    if (size < sizeof(void*)) size = sizeof(void*);
+    ms->size   = ROUND(size);   /* objects must hold a list link */
+    ms->mbsize = ms->size *cnt; }
+  else {                        /* if objects of variable size */
+    ms->size   = 0;             /* (bump allocation from blocks */
+    ms->mbsize = ROUND(cnt);    /* of the given number of bytes) */
+  }
+  ms->cnt   = cnt;              /* note the number of objects/bytes */
+  ms->used  = ms->umax  = 0;    /* initialize the object counters */
+  ms->bytes = ms->nfree = 0;    /* and the memory size */
+  ms->free  = ms->list  = NULL; /* no blocks are allocated yet */
+  ms->next  = ms->end   = NULL; /* (blocks are allocated on demand) */
+  ms->dead  = 0;                /* clear the deletion flag */
+  return ms;                    /* return the created memory system */
+}  /* ms_create() */
+
+/*--------------------------------------------------------------------*/
+
+void ms_delete (MEMSYS *ms)
+{                               /* --- delete a memory system */
+  assert(ms && !ms->dead);      /* check the function argument */
+  if (ms->used > 0) {           /* if there are objects in use, */
+    ms->dead = -1; return; }    /* only mark the system as deleted */
+  release(ms);                  /* release all memory blocks */
+  free(ms);                     /* and delete the base structure */
+}  /* ms_delete() */
+
+/*--------------------------------------------------------------------*/
+
+void ms_clear (MEMSYS *ms)
+{                               /* --- clear a memory system */
+  assert(ms && !ms->dead);      /* check the function argument */
+  release(ms);                  /* release all memory blocks */
+}  /* ms_clear() */             /* (all objects become invalid) */
+
+/*--------------------------------------------------------------------*/
+
+int ms_reserve (MEMSYS *ms, size_t cnt)
+{                               /* --- reserve memory for objects */
+  size_t n;                     /* number of available objects */
+  size_t i;                     /* loop variable */
+  char   *p;                    /* new memory block */
+
+  assert(ms && (ms->size > 0)); /* check the function argument */
+  n = ms->nfree;                /* get the number of free objects */
+  if (ms->next) n += (size_t)(ms->end -ms->next) /ms->size;
+  while (n < cnt) {             /* while more objects are needed */
+    p = newblk(ms, ms->mbsize); /* allocate a new memory block */
+    if (!p) return -1;          /* and add its objects to the */
+    for (i = ms->cnt; i > 0; i--) {       /* list of free objects */
+      *(void**)p = ms->free; ms->free = p; p += ms->size; }
+    ms->nfree += ms->cnt;       /* count the new free objects */
+    n         += ms->cnt;       /* and the available objects */
+  }                             /* (ms_alloc() cannot fail for */
+  return 0;                     /* the next cnt objects) */
+}  /* ms_reserve() */
+
+/*--------------------------------------------------------------------*/
+
+void* ms_alloc (MEMSYS *ms)
+{                               /* --- allocate an object */
+  void *obj;                    /* allocated object */
+
+  assert(ms && (ms->size > 0) && !ms->dead);
+  if (ms->free) {               /* if there is a free object, */
+    obj = ms->free;             /* take it from the free list */
+    ms->free = *(void**)obj;
+    ms->nfree--; }
+  else {                        /* if there is no free object */
+    if (!ms->next || ((size_t)(ms->end -ms->next) < ms->size)) {
+      ms->next = newblk(ms, ms->mbsize);
+      if (!ms->next) { ms->end = NULL; return NULL; }
+      ms->end  = ms->next +ms->mbsize;
+    }                           /* get a new block if necessary */
+    obj = ms->next;             /* take the next unused object */
+    ms->next += ms->size;       /* from the current block */
+  }
+  if (++ms->used > ms->umax)    /* count the object and */
+    ms->umax = ms->used;        /* update the maximum */
+  return obj;                   /* return the allocated object */
+}  /* ms_alloc() */
+
+/*--------------------------------------------------------------------*/
+
+void* ms_allocx (MEMSYS *ms, size_t size)
+{                               /* --- allocate an object */
+  void *obj;                    /* allocated object */
+
+  assert(ms && (ms->size == 0) && !ms->dead);
+  size = ROUND((size > 0) ? size : 1);
+  if (size > ms->mbsize) {      /* if the object exceeds a block, */
+    obj = newblk(ms, size);     /* allocate a block of its own */
+    if (!obj) return NULL; }    /* (current block stays unchanged) */
+  else {                        /* if the object fits into a block */
+    if (!ms->next || ((size_t)(ms->end -ms->next) < size)) {
+      ms->next = newblk(ms, ms->mbsize);
+      if (!ms->next) { ms->end = NULL; return NULL; }
+      ms->end  = ms->next +ms->mbsize;
+    }                           /* get a new block if necessary */
+    obj = ms->next;             /* take the next unused bytes */
+    ms->next += size;           /* from the current block */
+  }
+  if (++ms->used > ms->umax)    /* count the object and */
+    ms->umax = ms->used;        /* update the maximum */
+  return obj;                   /* return the allocated object */
+}  /* ms_allocx() */
+
+/*--------------------------------------------------------------------*/
+
+void ms_free (MEMSYS *ms, void *obj)
+{                               /* --- free an object */
+  assert(ms && obj && (ms->used > 0));  /* check function arguments */
+  if (ms->size > 0) {           /* if objects of equal size, */
+    *(void**)obj = ms->free;    /* add the object to the free list */
+    ms->free = obj; ms->nfree++;/* (memory of objects of variable */
+  }                             /* size is not reused) */
+  if ((--ms->used <= 0) && ms->dead) {
+    release(ms); free(ms); }    /* if the deletion is pending and */
+}  /* ms_free() */               /* this was the last object, delete */
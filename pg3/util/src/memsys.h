@@ -0,0 +1,73 @@
+/*----------------------------------------------------------------------
+  File    : memsys.h
+  Contents: memory management system for objects of equal size
+  Author  : Christian Borgelt
+  History : 2004.12.10 file created
+            2016.05.16 objects of variable size added (bump allocation)
+            2016.05.16 functions ms_reserve() and ms_clear() added
+            2016.05.16 deletion deferred while objects are still used
+----------------------------------------------------------------------*/
+#ifndef __MEMSYS__
+#define __MEMSYS__
+#include <stddef.h>
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- memory management system --- */
+  size_t size;                  /* size of an object (0: variable) */
+  size_t cnt;                   /* number of objects/bytes per block */
+  size_t mbsize;                /* size of a memory block (payload) */
+  size_t used;                  /* number of used objects */
+  size_t umax;                  /* maximum number of used objects */
+  size_t bytes;                 /* total size of allocated blocks */
+  size_t nfree;                 /* number of objects in free list */
+  void   *free;                 /* list of free objects */
+  char   *next;                 /* next unused byte in current block */
+  char   *end;                  /* end of the current block */
+  void   *list;                 /* list of allocated blocks */
+  int    dead;                  /* flag for a pending deletion */
+} MEMSYS;                       /* (memory management system) */
+
+/* A memory management system allocates objects from large blocks, */
+/* so that only one call of malloc() is needed per block and all    */
+/* objects can be released at once. Objects of equal size (size > 0 */
+/* in ms_create()) are allocated with ms_alloc(); freed objects are */
+/* collected in a list and reused. Objects of variable size (size 0 */
+/* in ms_create(), cnt is then the block size in bytes) are         */
+/* allocated with ms_allocx(); the memory of freed objects of this  */
+/* kind is not reused before ms_clear() is called.                  */
+
+/* ms_delete() releases the memory only if no objects are in use.   */
+/* Otherwise the deletion is deferred and the memory is released    */
+/* when the last object is freed with ms_free(). Hence objects may  */
+/* outlive the structure that created the memory system, as long as */
+/* they are freed eventually. After a deferred deletion the memory  */
+/* system must not be used for anything but ms_free().              */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern MEMSYS* ms_create  (size_t size, size_t cnt);
+extern void    ms_delete  (MEMSYS *ms);
+extern void    ms_clear   (MEMSYS *ms);
+extern int     ms_reserve (MEMSYS *ms, size_t cnt);
+extern void*   ms_alloc   (MEMSYS *ms);
+extern void*   ms_allocx  (MEMSYS *ms, size_t size);
+extern void    ms_free    (MEMSYS *ms, void *obj);
+extern size_t  ms_objsize (const MEMSYS *ms);
+extern size_t  ms_blkcnt  (const MEMSYS *ms);
+extern size_t  ms_used    (const MEMSYS *ms);
+extern size_t  ms_umax    (const MEMSYS *ms);
+extern size_t  ms_bytes   (const MEMSYS *ms);
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define ms_objsize(m)      ((m)->size)
+#define ms_blkcnt(m)       ((m)->cnt)
+#define ms_used(m)         ((m)->used)
+#define ms_umax(m)         ((m)->umax)
+#define ms_bytes(m)        ((m)->bytes)
+
+#endif
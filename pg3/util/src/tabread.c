@@ -27,9 +27,12 @@
             2011.03.20 order of arguments of trd_istype() changed
             2013.03.20 record and position type changed to size_t
             2013.10.15 check of ferror() added to trd_close()
+            2016.05.14 fields returned directly from the read buffer
+            2016.05.16 function trd_memopen() added (read from memory)
 ----------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include "tabread.h"
 #include "escape.h"
@@ -56,10 +59,57 @@
 #define isnull(c)     trd_istype(trd, c, TRD_NULL)
 #define iscomment(c)  trd_istype(trd, c, TRD_COMMENT)
 
+/* --- fast field scanning --- */
+/* If there are at most TRD_MAXSEP separator characters, the end of a */
+/* field is searched eight bytes at a time: a byte of the word w that */
+/* equals c is zero in x = w ^ (c*ONES) and (x -ONES) & ~x & HIGHS is */
+/* nonzero iff x contains a zero byte. (Bytes above the first zero    */
+/* byte may be flagged falsely, so the word is then checked bytewise.)*/
+/* If the field is completely contained in the read buffer, it is not */
+/* copied, but terminated and returned in the buffer.                 */
+#define ONES          UINT64_C(0x0101010101010101)
+#define HIGHS         UINT64_C(0x8080808080808080)
+
 #define GETC(t,c,d) \
   if ((c = trd_getc(t)) < 0) { (t)->last = EOF; \
     return (t)->delim = (c <= TRD_ERR) ? TRD_ERR : (d); }
 
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static void setseps (TABREAD *trd)
+{                               /* --- collect separator characters */
+  int c;                        /* loop variable for characters */
+
+  trd->sepcnt = 0;              /* traverse the characters */
+  for (c = 0; c < 256; c++) {   /* and collect the separators */
+    if (!issep(c)) continue;    /* (field and record separators) */
+    if (trd->sepcnt >= TRD_MAXSEP) { trd->sepcnt = 0; return; }
+    trd->seps[trd->sepcnt++] = (char)c;
+  }                             /* if there are too many separators, */
+}  /* setseps() */              /* the fast scan is not used */
+
+/*--------------------------------------------------------------------*/
+
+static char* findsep (TABREAD *trd, char *s, char *e)
+{                               /* --- find the next separator */
+  int      i;                   /* loop variable for separators */
+  uint64_t w, x, m;             /* buffer word, comparison, matches */
+  uint64_t c[TRD_MAXSEP];       /* separators replicated to words */
+
+  for (i = 0; i < trd->sepcnt; i++)
+    c[i] = (uint64_t)(unsigned char)trd->seps[i] *ONES;
+  for ( ; e -s >= 8; s += 8) {  /* traverse the buffer in words */
+    memcpy(&w, s, sizeof(w));   /* get the next eight bytes */
+    for (m = 0, i = 0; i < trd->sepcnt; i++) {
+      x = w ^ c[i]; m |= (x -ONES) & ~x & HIGHS; }
+    if (m) break;               /* check for a separator byte */
+  }                             /* (search bytewise from there) */
+  while ((s < e) && !issep(*s)) s++;
+  return s;                     /* return the separator position */
+}  /* findsep() */               /* (or the end of the buffer) */
+
 /*----------------------------------------------------------------------
   Functions
 ----------------------------------------------------------------------*/
@@ -76,7 +126,8 @@ TABREAD* trd_create (void)
   trd->next  = trd->end  = trd->buf;
   trd->rec   = 1;               /* current record is the first */
   trd->pos   = 0;               /* position is before first field */
-  trd->field[trd->len = 0] = 0; /* current field is empty */
+  trd->fld   = trd->field;      /* current field is empty */
+  trd->field[trd->len = 0] = 0;
   memset(trd->flags, 0, sizeof(trd->flags));
   trd->flags['\n'] = TRD_RECSEP;
   trd->flags['\t'] = trd->flags[' '] = TRD_BLANK|TRD_FLDSEP;
@@ -84,7 +135,8 @@ TABREAD* trd_create (void)
   trd->flags[',' ] = TRD_FLDSEP;
   trd->flags['?' ] = trd->flags['*'] = TRD_NULL;
   trd->flags['#' ] = TRD_COMMENT;
-  return trd;                   /* set default character flags */
+  setseps(trd);                 /* set default character flags */
+  return trd;                   /* and collect the separators */
 }  /* trd_create() */           /* return created table reader */
 
 /*--------------------------------------------------------------------*/
@@ -119,12 +171,30 @@ int trd_open (TABREAD *trd, FILE *file, const char *name)
   trd->next  = trd->end  = trd->buf;
   trd->rec   = 1;               /* current record is the first */
   trd->pos   = 0;               /* position is before first field */
-  trd->field[trd->len = 0] = 0; /* current field is empty */
+  trd->fld   = trd->field;      /* current field is empty */
+  trd->field[trd->len = 0] = 0;
   return 0;                     /* return 'ok' */
 }  /* trd_open() */
 
 /*--------------------------------------------------------------------*/
 
+int trd_memopen (TABREAD *trd, char *buf, size_t n, const char *name)
+{                               /* --- open a memory block */
+  assert(trd && (buf || (n <= 0)));  /* check the function arguments */
+  trd->file  = NULL;            /* there is no input file */
+  trd->name  = (name) ? name : "<memory>";
+  trd->delim = trd->last = TRD_EOF;
+  trd->next  = buf;             /* read the characters directly */
+  trd->end   = buf +n;          /* from the given memory block */
+  trd->rec   = 1;               /* current record is the first */
+  trd->pos   = 0;               /* position is before first field */
+  trd->fld   = trd->field;      /* current field is empty */
+  trd->field[trd->len = 0] = 0;
+  return 0;                     /* return 'ok' */
+}  /* trd_memopen() */          /* (the memory block is modified, */
+                                /* as fields are terminated in it) */
+/*--------------------------------------------------------------------*/
+
 int trd_close (TABREAD *trd)
 {                               /* --- close the current file */
   int r;                        /* result of fclose() */
@@ -152,6 +222,8 @@ void trd_chars (TABREAD *trd, int type, const char *chars)
   type &= ~TRD_ADD;             /* remove the flag for adding */
   for (s = (char*)chars; *s; )  /* set the character flags */
     trd->flags[esc_decode(s, &s)] |= type;
+  if (type & (TRD_RECSEP|TRD_FLDSEP))
+    setseps(trd);               /* collect the separator characters */
 }  /* trd_chars() */
 
 /*--------------------------------------------------------------------*/
@@ -172,9 +244,12 @@ void trd_allchs (TABREAD *trd,        const char *recseps,
 
 int trd_getc (TABREAD *trd)
 {                               /* --- get the next character */
-  assert(trd && trd->file);     /* check the function arguments */
+  size_t n;                     /* number of characters read */
+
+  assert(trd);                  /* check the function arguments */
   if (trd->next >= trd->end) {  /* if no more characters available */
-    size_t n = fread(trd->buf, sizeof(char), TRD_BUFSIZE, trd->file);
+    if (!trd->file) return TRD_EOF;   /* (end of a memory block) */
+    n = fread(trd->buf, sizeof(char), TRD_BUFSIZE, trd->file);
     if (n <= 0) return ferror(trd->file) ? TRD_ERR : TRD_EOF;
     trd->next = trd->buf;       /* read a new block from the file */
     trd->end  = trd->buf +n;    /* set pointer to next character */
@@ -187,7 +262,8 @@ int trd_getc (TABREAD *trd)
 int trd_ungetc (TABREAD *trd, int c)
 {                               /* --- push back a character */
   assert(trd);                  /* check the function arguments */
-  return (trd->next > trd->buf) ? *--trd->next = (char)c : EOF;
+  return (!trd->file || (trd->next > trd->buf))
+       ? *--trd->next = (char)c : EOF;
 }  /* trd_ungetc() */
 
 /*--------------------------------------------------------------------*/
@@ -198,9 +274,10 @@ int trd_read (TABREAD *trd)
   char *p, *e;                  /* to traverse the field */
 
   /* --- initialize --- */
-  assert(trd && trd->file);     /* check the function arguments */
+  assert(trd);                  /* check the function arguments */
   trd->pos = (trd->delim == TRD_FLD) ? trd->pos+1 : 1;
-  trd->field[trd->len = 0] = 0; /* clear the current field */
+  trd->fld = trd->field;        /* clear the current field */
+  trd->field[trd->len = 0] = 0;
   GETC(trd, c, TRD_EOF);        /* get the first character */
 
   /* --- skip comment records --- */
@@ -227,25 +304,35 @@ int trd_read (TABREAD *trd)
   /* be read before the end of file/input is encountered.         */
 
   /* --- read the field --- */
-  p = trd->field; e = p +TRD_MAXLEN;
-  while (1) {                   /* field read loop */
-    if (p < e) *p++ = (char)c;  /* append the last character */
-    c = trd_getc(trd);          /* and get the next character */
-    if (c < 0)    { d = (c <= TRD_ERR) ? TRD_ERR : TRD_REC; break; }
-    if (issep(c)) { d = (isfldsep(c))  ? TRD_FLD : TRD_REC; break; }
-  }                             /* while character is no separator */
+  p = trd->next -1;             /* get the field start in the buffer */
+  if ((trd->sepcnt > 0)         /* if fast scanning is possible and */
+  &&  ((e = findsep(trd, trd->next, trd->end)) < trd->end)) {
+    c = (unsigned char)*e;      /* the field ends in the buffer, */
+    trd->next = e+1;            /* consume the separator */
+    d = (isfldsep(c)) ? TRD_FLD : TRD_REC;
+    trd->fld = p;               /* use the field in the buffer */
+    p = (e -p > TRD_MAXLEN) ? p +TRD_MAXLEN : e; }
+  else {                        /* if the field must be copied */
+    p = trd->field; e = p +TRD_MAXLEN;
+    while (1) {                 /* field read loop */
+      if (p < e) *p++ = (char)c;/* append the last character */
+      c = trd_getc(trd);        /* and get the next character */
+      if (c < 0)    { d = (c <= TRD_ERR) ? TRD_ERR : TRD_REC; break; }
+      if (issep(c)) { d = (isfldsep(c))  ? TRD_FLD : TRD_REC; break; }
+    }                           /* while character is no separator */
+  }
   trd->last = c;                /* store the last character read */
 
   /* --- remove trailing blanks --- */
   while (isblank(*--p));        /* skip blank characters at the end */
   *++p = '\0';                  /* and terminate the current field */
-  trd->len = (size_t)(p -trd->field); /* store number of characters */
+  trd->len = (size_t)(p -trd->fld);   /* store number of characters */
 
   /* --- check for a null value --- */
-  while (--p >= trd->field)     /* check for only null value chars. */
+  while (--p >= trd->fld)       /* check for only null value chars. */
     if (!isnull((unsigned char)*p)) break;
-  if (p < trd->field)           /* clear field if null value */
-    trd->field[trd->len = 0] = 0;
+  if (p < trd->fld)             /* clear field if null value */
+    trd->fld[trd->len = 0] = 0;
 
   /* --- check for end of line --- */
   if (d != TRD_FLD) {           /* if not at a field separator */
@@ -256,7 +343,10 @@ int trd_read (TABREAD *trd)
   /* --- skip trailing blanks --- */
   while (isblank(c)) {          /* while character is blank, */
     trd->last = c;              /* note the last character */
-    GETC(trd, c, TRD_REC);      /* and get the next character */
+    if ((trd->next >= trd->end) /* if the buffer will be refilled, */
+    &&  (trd->fld  != trd->field)) {   /* copy the field from it */
+      memcpy(trd->field, trd->fld, trd->len+1); trd->fld = trd->field; }
+    GETC(trd, c, TRD_REC);      /* get the next character */
   }
   if (isrecsep(c)) {            /* check for a record separator */
     trd->last = c; trd->rec++; return trd->delim = TRD_REC; }
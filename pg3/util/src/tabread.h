@@ -21,6 +21,8 @@
             2010.10.13 name of input file added, error info. simplified
             2011.03.20 order of arguments of trd_istype() changed
             2013.03.20 record and position type changed to size_t
+            2016.05.14 fields returned directly from the read buffer
+            2016.05.16 function trd_memopen() added (read from memory)
 ----------------------------------------------------------------------*/
 #ifndef __TABREAD__
 #define __TABREAD__
@@ -51,6 +53,8 @@
 /* --- buffer size --- */
 #define TRD_BUFSIZE  65536      /* size of internal read buffer */
 #define TRD_MAXLEN    1024      /* maximum length of a field */
+#define TRD_MAXSEP       8      /* maximum number of separators */
+                                /* for the fast scanning of fields */
 
 #define TRD_FPOS(r)  trd_name(r), trd_rec(r), trd_pos(r)
 #define TRD_INFO(r)  trd_name(r), trd_rec(r), trd_pos(r), trd_field(r)
@@ -59,7 +63,7 @@
   Type Definitions
 ----------------------------------------------------------------------*/
 typedef struct {                /* --- table reader --- */
-  FILE   *file;                 /* file to read from */
+  FILE   *file;                 /* file to read from (or NULL) */
   CCHAR  *name;                 /* name of the input file */
   int    last;                  /* last character read */
   int    delim;                 /* last delimiter read */
@@ -69,7 +73,10 @@ typedef struct {                /* --- table reader --- */
   char   *next;                 /* next character to read */
   char   *end;                  /* current end of the buffer */
   int    flags[256];            /* character flags */
-  char   field[TRD_MAXLEN+4];   /* current field */
+  int    sepcnt;                /* number of separator characters */
+  char   seps [TRD_MAXSEP];     /* separator characters (fast scan) */
+  char   *fld;                  /* current field (buffer or field) */
+  char   field[TRD_MAXLEN+4];   /* current field (if copied) */
   char   buf  [TRD_BUFSIZE];    /* read buffer */
 } TABREAD;                      /* (table reader) */
 
@@ -79,6 +86,8 @@ typedef struct {                /* --- table reader --- */
 extern TABREAD* trd_create (void);
 extern int      trd_delete (TABREAD *trd, int close);
 extern int      trd_open   (TABREAD *trd, FILE *file, CCHAR *name);
+extern int      trd_memopen(TABREAD *trd, char *buf, size_t n,
+                            CCHAR *name);
 extern int      trd_close  (TABREAD *trd);
 extern FILE*    trd_file   (TABREAD *trd);
 extern CCHAR*   trd_name   (TABREAD *trd);
@@ -108,12 +117,15 @@ extern size_t   trd_pos    (TABREAD *trd);
 #define trd_file(r)        ((r)->file)
 #define trd_name(r)        ((r)->name)
 
-#define trd_copy(d,s)      memcpy((d)->flags, (s)->flags, \
-                                       sizeof((s)->flags))
+#define trd_copy(d,s)      (memcpy((d)->flags, (s)->flags, \
+                                       sizeof((s)->flags)), \
+                            memcpy((d)->seps,  (s)->seps,  \
+                                       sizeof((s)->seps)),  \
+                            (d)->sepcnt = (s)->sepcnt)
 #define trd_istype(r,c,t)  ((r)->flags[(unsigned char)(c)] & (t))
 #define trd_type(r,c)      ((r)->flags[(unsigned char)(c)])
 
-#define trd_field(r)       ((r)->field)
+#define trd_field(r)       ((r)->fld)
 #define trd_len(r)         ((r)->len)
 #define trd_last(r)        ((r)->last)
 #define trd_delim(r)       ((r)->delim)
@@ -0,0 +1,340 @@
+/*----------------------------------------------------------------------
+  File    : thread.c
+  Contents: simple thread team management (fork/join parallelism)
+  Author  : Christian Borgelt
+  History : 2016.05.06 file created
+            2016.05.13 pipelines of processing stages added
+            2016.05.16 functions thr_start() and thr_wait() added
+            2016.05.16 slot sequence numbers checked in thp_get()
+----------------------------------------------------------------------*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L /* needed for sysconf() */
+#endif
+#include <stdlib.h>
+#include <assert.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+#include "thread.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#ifdef _WIN32                   /* if Microsoft Windows system */
+#define THREAD          HANDLE  /* thread handle */
+#define MUTEX           CRITICAL_SECTION
+#define COND            CONDITION_VARIABLE
+#define WORKERDEF(n,p)  DWORD WINAPI n (LPVOID p)
+#define THR_OK          0       /* return value of worker function */
+#define thrd_create(t,w,p) \
+  (((*(t) = CreateThread(NULL, 0, w, p, 0, NULL)) != NULL) ? 0 : -1)
+#define thrd_join(t)    (WaitForSingleObject(t, INFINITE), \
+                         CloseHandle(t))
+#define mutex_init(m)   InitializeCriticalSection(m)
+#define mutex_free(m)   DeleteCriticalSection(m)
+#define mutex_lock(m)   EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c)    InitializeConditionVariable(c)
+#define cond_free(c)    ((void)0)
+#define cond_wait(c,m)  SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c)  WakeConditionVariable(c)
+#define cond_bcast(c)   WakeAllConditionVariable(c)
+#else                           /* if Linux/Unix system */
+#define THREAD          pthread_t
+#define MUTEX           pthread_mutex_t
+#define COND            pthread_cond_t
+#define WORKERDEF(n,p)  void* n (void* p)
+#define THR_OK          NULL    /* return value of worker function */
+#define thrd_create(t,w,p)  pthread_create(t, NULL, w, p)
+#define thrd_join(t)    pthread_join(t, NULL)
+#define mutex_init(m)   pthread_mutex_init(m, NULL)
+#define mutex_free(m)   pthread_mutex_destroy(m)
+#define mutex_lock(m)   pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c)    pthread_cond_init(c, NULL)
+#define cond_free(c)    pthread_cond_destroy(c)
+#define cond_wait(c,m)  pthread_cond_wait(c, m)
+#define cond_signal(c)  pthread_cond_signal(c)
+#define cond_bcast(c)   pthread_cond_broadcast(c)
+#endif
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- worker thread --- */
+  THRTEAM  *team;               /* team the worker belongs to */
+  int      id;                  /* identifier of the worker */
+  THREAD   thread;              /* handle of the thread */
+} WORKER;                       /* (worker thread) */
+
+struct thrteam {                /* --- team of worker threads --- */
+  int      cnt;                 /* number of threads (incl. caller) */
+  int      busy;                /* number of busy worker threads */
+  int      quit;                /* flag for termination of workers */
+  unsigned gen;                 /* generation (job) counter */
+  THRFN    *fn;                 /* function to execute */
+  void     *data;               /* data to pass to the function */
+  MUTEX    mutex;               /* mutex for the team state */
+  COND     start;               /* condition for start of a job */
+  COND     done;                /* condition for end   of a job */
+  WORKER   workers[1];          /* worker threads (index 0: caller) */
+};
+
+/* A pipeline is a ring of slots (e.g. buffers for batches of records)  */
+/* that pass through a fixed sequence of processing stages. Each stage */
+/* is handed the slots in the order in which they entered the pipeline */
+/* and a slot becomes available to a stage only after the preceding    */
+/* stage put it back, so several threads may work on the same stage    */
+/* without changing the order in which later stages see the slots.     */
+/* Each slot also records the sequence number of the data it holds, so  */
+/* that a stage cannot take a slot that is still being processed for   */
+/* the previous round of the ring (with several threads per stage).    */
+
+struct thrpipe {                /* --- pipeline of processing stages */
+  int      size;                /* number of slots in the ring */
+  int      stgcnt;              /* number of processing stages */
+  int      closed;              /* whether no more slots will enter */
+  size_t   end;                 /* number of slots that entered */
+  size_t   *next;               /* next slot sequence number per stage */
+  size_t   *seqs;               /* sequence number held by each slot */
+  int      *stages;             /* next stage to process each slot */
+  MUTEX    mutex;               /* mutex for the pipeline state */
+  COND     cond;                /* condition for a change of state */
+};
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static WORKERDEF(worker, p)
+{                               /* --- worker thread function */
+  WORKER   *w = (WORKER*)p;     /* the worker thread to run */
+  THRTEAM  *team = w->team;     /* the team of the worker */
+  unsigned gen  = 0;            /* last executed job generation */
+  THRFN    *fn;                 /* function to execute */
+  void     *data;               /* data to pass to the function */
+
+  mutex_lock(&team->mutex);     /* lock the team state */
+  while (1) {                   /* job execution loop */
+    while (!team->quit && (team->gen == gen))
+      cond_wait(&team->start, &team->mutex);
+    if (team->quit) break;      /* wait for a new job or termination */
+    gen = team->gen; fn = team->fn; data = team->data;
+    mutex_unlock(&team->mutex); /* get the job and */
+    fn(data, w->id);            /* execute the job function */
+    mutex_lock(&team->mutex);   /* count the finished worker */
+    if (--team->busy <= 0) cond_signal(&team->done);
+  }                             /* signal the end of the job */
+  mutex_unlock(&team->mutex);   /* unlock the team state */
+  return THR_OK;                /* and terminate the thread */
+}  /* worker() */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+
+int thr_cpucnt (void)
+{                               /* --- get the number of processors */
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  SYSTEM_INFO sysinfo;          /* system information structure */
+  GetSystemInfo(&sysinfo);      /* get the system information */
+  return (int)sysinfo.dwNumberOfProcessors;
+  #else                         /* if Linux/Unix system */
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n < 1) ? 1 : (n > THR_MAXCNT) ? THR_MAXCNT : (int)n;
+  #endif                        /* get the number of online procs. */
+}  /* thr_cpucnt() */
+
+/*--------------------------------------------------------------------*/
+
+THRTEAM* thr_create (int cnt)
+{                               /* --- create a team of threads */
+  int     i;                    /* loop variable */
+  THRTEAM *team;                /* created thread team */
+
+  if (cnt <= 0) cnt = thr_cpucnt();  /* use all processors by default */
+  if (cnt > THR_MAXCNT) cnt = THR_MAXCNT;
+  team = (THRTEAM*)malloc(sizeof(THRTEAM)
+                         +(size_t)(cnt-1) *sizeof(WORKER));
+  if (!team) return NULL;       /* allocate the base structure */
+  team->cnt  = cnt;             /* note the number of threads */
+  team->busy = team->quit = 0;  /* and initialize the fields */
+  team->gen  = 0;
+  team->fn   = NULL; team->data = NULL;
+  mutex_init(&team->mutex);     /* create the synchronization objects */
+  cond_init(&team->start);
+  cond_init(&team->done);
+  for (i = 0; i < cnt; i++) {   /* initialize the workers */
+    team->workers[i].team = team;
+    team->workers[i].id   = i;  /* (worker 0 is the calling thread, */
+  }                             /* so no thread is created for it) */
+  for (i = 1; i < cnt; i++) {   /* start the worker threads */
+    if (thrd_create(&team->workers[i].thread, worker,
+                    team->workers+i) != 0) break;
+  }
+  if (i < cnt) {                /* if a thread could not be created */
+    team->cnt = i; thr_delete(team); return NULL; }
+  return team;                  /* return the created team */
+}  /* thr_create() */
+
+/*--------------------------------------------------------------------*/
+
+void thr_delete (THRTEAM *team)
+{                               /* --- delete a team of threads */
+  int i;                        /* loop variable */
+
+  assert(team);                 /* check the function argument */
+  mutex_lock(&team->mutex);     /* set the termination flag */
+  team->quit = 1;               /* and wake up all workers */
+  cond_bcast(&team->start);
+  mutex_unlock(&team->mutex);
+  for (i = 1; i < team->cnt; i++)
+    thrd_join(team->workers[i].thread);
+  cond_free(&team->done);       /* wait for the threads to terminate */
+  cond_free(&team->start);      /* and delete the synch. objects */
+  mutex_free(&team->mutex);
+  free(team);                   /* delete the base structure */
+}  /* thr_delete() */
+
+/*--------------------------------------------------------------------*/
+
+int thr_cnt (const THRTEAM *team)
+{ return team->cnt; }
+
+/*--------------------------------------------------------------------*/
+
+void thr_run (THRTEAM *team, THRFN *fn, void *data)
+{                               /* --- run a function on all threads */
+  assert(team && fn);           /* check the function arguments */
+  if (team->cnt <= 1) { fn(data, 0); return; }
+  mutex_lock(&team->mutex);     /* lock the team state */
+  team->fn   = fn;              /* note the job function and data */
+  team->data = data;            /* and start a new job generation */
+  team->busy = team->cnt-1;     /* (all workers will execute it) */
+  team->gen++;
+  cond_bcast(&team->start);     /* wake up the worker threads */
+  mutex_unlock(&team->mutex);
+  fn(data, 0);                  /* execute the job for thread 0 */
+  mutex_lock(&team->mutex);     /* wait for the workers to finish */
+  while (team->busy > 0) cond_wait(&team->done, &team->mutex);
+  mutex_unlock(&team->mutex);   /* unlock the team state */
+}  /* thr_run() */
+
+/*--------------------------------------------------------------------*/
+
+void thr_start (THRTEAM *team, THRFN *fn, void *data)
+{                               /* --- start a function on workers */
+  assert(team && fn);           /* check the function arguments */
+  if (team->cnt <= 1) { fn(data, 0); return; }
+  mutex_lock(&team->mutex);     /* lock the team state */
+  team->fn   = fn;              /* note the job function and data */
+  team->data = data;            /* and start a new job generation */
+  team->busy = team->cnt-1;     /* (only the workers execute it, */
+  team->gen++;                  /* the caller continues its work) */
+  cond_bcast(&team->start);     /* wake up the worker threads */
+  mutex_unlock(&team->mutex);   /* unlock the team state */
+}  /* thr_start() */
+
+/*--------------------------------------------------------------------*/
+
+void thr_wait (THRTEAM *team)
+{                               /* --- wait for the workers to finish */
+  assert(team);                 /* check the function argument */
+  if (team->cnt <= 1) return;   /* (job was executed by thr_start()) */
+  mutex_lock(&team->mutex);     /* wait for the workers to finish */
+  while (team->busy > 0) cond_wait(&team->done, &team->mutex);
+  mutex_unlock(&team->mutex);   /* unlock the team state */
+}  /* thr_wait() */
+
+/*--------------------------------------------------------------------*/
+
+THRPIPE* thp_create (int size, int stgcnt)
+{                               /* --- create a pipeline */
+  THRPIPE *pipe;                /* created pipeline */
+  int     i;                    /* loop variable */
+
+  assert((size > 0) && (stgcnt > 0)); /* check the function arguments */
+  pipe = (THRPIPE*)malloc(sizeof(THRPIPE));
+  if (!pipe) return NULL;       /* allocate the base structure */
+  pipe->next = (size_t*)calloc((size_t)stgcnt +(size_t)size,
+                               sizeof(size_t));
+  if (!pipe->next) { free(pipe); return NULL; }
+  pipe->seqs = pipe->next +stgcnt;
+  for (i = 0; i < size; i++)    /* slot i first holds the slot */
+    pipe->seqs[i] = (size_t)i;  /* with sequence number i */
+  pipe->stages = (int*)calloc((size_t)size, sizeof(int));
+  if (!pipe->stages) { free(pipe->next); free(pipe); return NULL; }
+  pipe->size   = size;          /* allocate the state arrays */
+  pipe->stgcnt = stgcnt;        /* (all slots wait for stage 0) */
+  pipe->closed = 0;             /* and initialize the fields */
+  pipe->end    = 0;
+  mutex_init(&pipe->mutex);     /* create the synchronization objects */
+  cond_init(&pipe->cond);
+  return pipe;                  /* return the created pipeline */
+}  /* thp_create() */
+
+/*--------------------------------------------------------------------*/
+
+void thp_delete (THRPIPE *pipe)
+{                               /* --- delete a pipeline */
+  assert(pipe);                 /* check the function argument */
+  cond_free(&pipe->cond);       /* delete the synchronization objects */
+  mutex_free(&pipe->mutex);
+  free(pipe->stages);           /* delete the state arrays */
+  free(pipe->next);             /* (incl. the sequence numbers) */
+  free(pipe);
+}  /* thp_delete() */
+
+/*--------------------------------------------------------------------*/
+
+int thp_get (THRPIPE *pipe, int stage)
+{                               /* --- get next slot for a stage */
+  size_t seq;                   /* sequence number of next slot */
+  int    slot;                  /* index of next slot */
+
+  assert(pipe && (stage >= 0) && (stage < pipe->stgcnt));
+  mutex_lock(&pipe->mutex);     /* lock the pipeline state */
+  while (1) {                   /* wait for the next slot */
+    seq = pipe->next[stage];    /* get the next sequence number */
+    if (pipe->closed && (seq >= pipe->end)) {
+      slot = -1; break; }       /* check for the end of the data */
+    slot = (int)(seq % (size_t)pipe->size);
+    if ((pipe->seqs[slot] == seq) && (pipe->stages[slot] == stage)) {
+      pipe->next[stage] = seq+1; break; }
+    cond_wait(&pipe->cond, &pipe->mutex);
+  }                             /* if the slot is ready, take it */
+  mutex_unlock(&pipe->mutex);   /* unlock the pipeline state */
+  return slot;                  /* return the slot index */
+}  /* thp_get() */               /* (or -1 if the pipeline is empty) */
+
+/*--------------------------------------------------------------------*/
+
+void thp_put (THRPIPE *pipe, int slot)
+{                               /* --- pass a slot to the next stage */
+  assert(pipe && (slot >= 0) && (slot < pipe->size));
+  mutex_lock(&pipe->mutex);     /* lock the pipeline state */
+  if (++pipe->stages[slot] >= pipe->stgcnt) {
+    pipe->stages[slot] = 0;     /* advance the stage of the slot */
+    pipe->seqs[slot] += (size_t)pipe->size;
+  }                             /* (after the last stage the slot */
+  cond_bcast(&pipe->cond);      /* is free again for stage 0 and */
+  mutex_unlock(&pipe->mutex);   /* takes the sequence number of the */
+}  /* thp_put() */              /* next round) and wake up threads */
+
+/*--------------------------------------------------------------------*/
+
+void thp_close (THRPIPE *pipe)
+{                               /* --- close a pipeline */
+  assert(pipe);                 /* check the function argument */
+  mutex_lock(&pipe->mutex);     /* lock the pipeline state */
+  pipe->closed = 1;             /* note that no more slots enter */
+  pipe->end    = pipe->next[0]; /* and how many slots entered */
+  cond_bcast(&pipe->cond);      /* wake up waiting threads */
+  mutex_unlock(&pipe->mutex);   /* unlock the pipeline state */
+}  /* thp_close() */
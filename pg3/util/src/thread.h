@@ -0,0 +1,42 @@
+/*----------------------------------------------------------------------
+  File    : thread.h
+  Contents: simple thread team management (fork/join parallelism)
+  Author  : Christian Borgelt
+  History : 2016.05.06 file created
+            2016.05.13 pipelines of processing stages added
+            2016.05.16 functions thr_start() and thr_wait() added
+----------------------------------------------------------------------*/
+#ifndef __THREAD__
+#define __THREAD__
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define THR_MAXCNT    256       /* maximum number of threads */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef void THRFN (void *data, int id);
+                                /* function executed by each thread */
+typedef struct thrteam THRTEAM; /* (team of worker threads) */
+typedef struct thrpipe THRPIPE; /* (pipeline of processing stages) */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern int      thr_cpucnt (void);
+extern THRTEAM* thr_create (int cnt);
+extern void     thr_delete (THRTEAM *team);
+extern int      thr_cnt    (const THRTEAM *team);
+extern void     thr_run    (THRTEAM *team, THRFN *fn, void *data);
+extern void     thr_start  (THRTEAM *team, THRFN *fn, void *data);
+extern void     thr_wait   (THRTEAM *team);
+
+extern THRPIPE* thp_create (int size, int stgcnt);
+extern void     thp_delete (THRPIPE *pipe);
+extern int      thp_get    (THRPIPE *pipe, int stage);
+extern void     thp_put    (THRPIPE *pipe, int slot);
+extern void     thp_close  (THRPIPE *pipe);
+
+#endif
@@ -0,0 +1,221 @@
+/*----------------------------------------------------------------------
+  File    : tmstat.c
+  Contents: phase timing and throughput statistics (run reports)
+  Author  : Christian Borgelt
+  History : 2016.05.16 file created
+----------------------------------------------------------------------*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L /* needed for clock_gettime() */
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "tmstat.h"
+#ifdef STORAGE
+#include "storage.h"
+#endif
+
+/*----------------------------------------------------------------------
+  Auxiliary Functions
+----------------------------------------------------------------------*/
+
+static void fold (TMSTAT *tms)
+{                               /* --- fold interval into totals */
+  int    i;                     /* loop variable */
+  double t;                     /* current time */
+
+  tms_end(tms);                 /* end the current phase */
+  t = tms_clock();              /* and the current interval */
+  tms->curr.secs   = t -tms->mark;
+  tms->mark        = t;         /* get the interval time */
+  tms->total.secs  += tms->curr.secs;
+  tms->total.pats  += tms->curr.pats;
+  tms->total.flops += tms->curr.flops;
+  if (tms->curr.pats > 0)       /* sum the times of the intervals */
+    tms->psecs += tms->curr.secs;         /* with patterns */
+  for (i = 0; i < tms->cnt; i++) {
+    tms->total.phsecs[i] += tms->curr.phsecs[i];
+    tms->total.calls [i] += tms->curr.calls [i];
+  }                             /* add the counters to the totals */
+}  /* fold() */
+
+/*--------------------------------------------------------------------*/
+
+static void clear (TMSCNT *cnt)
+{                               /* --- clear interval counters */
+  memset(cnt, 0, sizeof(TMSCNT));
+}  /* clear() */
+
+/*--------------------------------------------------------------------*/
+
+static int record (TMSTAT *tms, const TMSCNT *cnt,
+                   const char *type, long epoch, double psecs)
+{                               /* --- write a report record */
+  int    i;                     /* loop variable */
+  double pps, fps;              /* patterns and flops per second */
+
+  pps = (psecs > 0) ? cnt->pats  /psecs : 0;
+  fps = (psecs > 0) ? cnt->flops /psecs : 0;
+  if (tms->mode & TMS_CSV) {    /* if to write CSV records */
+    if (tms->recs <= 0) {       /* if this is the first record */
+      fputs("program,record,epoch,secs,patterns,patterns_per_sec,"
+            "flops,flops_per_sec", tms->out);
+      for (i = 0; i < tms->cnt; i++)
+        fprintf(tms->out, ",%s_secs", tms->names[i]);
+      fputc('\n', tms->out);    /* write a header with the */
+    }                           /* names of the fields */
+    fprintf(tms->out, "%s,%s,%ld,%.6g,%.0f,%.6g,%.6g,%.6g",
+            tms->prog, type, epoch, cnt->secs,
+            cnt->pats, pps, cnt->flops, fps);
+    for (i = 0; i < tms->cnt; i++)
+      fprintf(tms->out, ",%.6g", cnt->phsecs[i]);
+    fputc('\n', tms->out); }    /* write the phase times */
+  else {                        /* if to write JSON objects */
+    fprintf(tms->out, "{\"program\": \"%s\", \"record\": \"%s\", "
+            "\"epoch\": %ld, \"secs\": %.6g, \"patterns\": %.0f, "
+            "\"patterns_per_sec\": %.6g, \"flops\": %.6g, "
+            "\"flops_per_sec\": %.6g, \"phases\": {",
+            tms->prog, type, epoch, cnt->secs,
+            cnt->pats, pps, cnt->flops, fps);
+    for (i = 0; i < tms->cnt; i++)
+      fprintf(tms->out, "%s\"%s\": %.6g", (i > 0) ? ", " : "",
+              tms->names[i], cnt->phsecs[i]);
+    fputs("}}\n", tms->out);    /* write the phase times */
+  }                             /* as a nested object */
+  tms->recs++;                  /* count the written record */
+  return ferror(tms->out) ? -1 : 0;
+}  /* record() */
+
+/*----------------------------------------------------------------------
+  Main Functions
+----------------------------------------------------------------------*/
+
+double tms_clock (void)
+{                               /* --- get wall clock time */
+  #ifdef _WIN32                 /* if Microsoft Windows system */
+  LARGE_INTEGER f, c;           /* frequency and counter */
+  QueryPerformanceFrequency(&f);
+  QueryPerformanceCounter(&c);  /* get the performance counter */
+  return (double)c.QuadPart /(double)f.QuadPart;
+  #else                         /* if Linux/Unix system */
+  struct timespec ts;           /* current time */
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec +1e-9 *(double)ts.tv_nsec;
+  #endif                        /* get a monotonic clock */
+}  /* tms_clock() */
+
+/*--------------------------------------------------------------------*/
+
+TMSTAT* tms_create (const char *prog, const char *const *names,
+                    int cnt, FILE *out, int mode)
+{                               /* --- create timing statistics */
+  TMSTAT *tms;                  /* created timing statistics */
+
+  assert(prog && names && out   /* check the function arguments */
+  &&    (cnt >= 0) && (cnt <= TMS_MAXPHASE));
+  tms = (TMSTAT*)malloc(sizeof(TMSTAT));
+  if (!tms) return NULL;        /* allocate the base structure */
+  tms->prog   = prog;           /* note the program name, */
+  tms->names  = names;          /* the names of the phases */
+  tms->cnt    = cnt;            /* and the number of phases */
+  tms->mode   = mode;           /* note the report mode */
+  tms->out    = out;            /* and the output file */
+  tms->recs   = tms->epochs = 0;/* initialize the counters */
+  tms->cur    = -1;             /* no phase is timed yet */
+  tms->beg    = tms->mark = tms_clock();
+  tms->psecs  = 0;              /* start the first interval */
+  clear(&tms->curr);            /* clear the interval */
+  clear(&tms->total);           /* and the total counters */
+  return tms;                   /* return the created statistics */
+}  /* tms_create() */
+
+/*--------------------------------------------------------------------*/
+
+void tms_delete (TMSTAT *tms)
+{                               /* --- delete timing statistics */
+  assert(tms);                  /* check the function argument */
+  free(tms);                    /* delete the base structure */
+}  /* tms_delete() */           /* (output file is not closed) */
+
+/*--------------------------------------------------------------------*/
+
+void tms_beg (TMSTAT *tms, int phase)
+{                               /* --- enter a phase */
+  double t;                     /* current time */
+
+  assert(tms && (phase >= 0) && (phase < tms->cnt));
+  t = tms_clock();              /* get the current time */
+  if (tms->cur >= 0)            /* if a phase is timed, end it */
+    tms->curr.phsecs[tms->cur] += t -tms->beg;
+  tms->curr.calls[phase] += 1;  /* count the entry into the phase */
+  tms->cur = phase;             /* and note the new phase */
+  tms->beg = t;                 /* and its start time */
+}  /* tms_beg() */
+
+/*--------------------------------------------------------------------*/
+
+void tms_end (TMSTAT *tms)
+{                               /* --- leave the current phase */
+  assert(tms);                  /* check the function argument */
+  if (tms->cur < 0) return;     /* check for a timed phase */
+  tms->curr.phsecs[tms->cur] += tms_clock() -tms->beg;
+  tms->cur = -1;                /* add the time of the phase */
+}  /* tms_end() */              /* and clear the current phase */
+
+/*--------------------------------------------------------------------*/
+
+void tms_add (TMSTAT *tms, int phase, double secs)
+{                               /* --- add time measured elsewhere */
+  assert(tms && (phase >= 0) && (phase < tms->cnt));
+  tms->curr.phsecs[phase] += secs;
+}  /* tms_add() */
+
+/*--------------------------------------------------------------------*/
+
+void tms_count (TMSTAT *tms, double pats, double flops)
+{                               /* --- count patterns and flops */
+  assert(tms);                  /* check the function argument */
+  tms->curr.pats  += pats;      /* add the processed patterns */
+  tms->curr.flops += flops;     /* and floating point operations */
+}  /* tms_count() */
+
+/*--------------------------------------------------------------------*/
+
+void tms_mark (TMSTAT *tms)
+{                               /* --- close an interval */
+  assert(tms);                  /* check the function argument */
+  fold(tms);                    /* fold the interval into the totals */
+  clear(&tms->curr);            /* and start a new interval */
+}  /* tms_mark() */
+
+/*--------------------------------------------------------------------*/
+
+int tms_epoch (TMSTAT *tms)
+{                               /* --- close an epoch */
+  int r = 0;                    /* result of writing the report */
+
+  assert(tms);                  /* check the function argument */
+  fold(tms);                    /* fold the epoch into the totals */
+  tms->epochs++;                /* and count the completed epoch */
+  if (tms->mode & TMS_EPOCH)    /* if to report each epoch */
+    r = record(tms, &tms->curr, "epoch", tms->epochs, tms->curr.secs);
+  clear(&tms->curr);            /* start a new interval */
+  return r;                     /* return the write result */
+}  /* tms_epoch() */
+
+/*--------------------------------------------------------------------*/
+
+int tms_report (TMSTAT *tms)
+{                               /* --- write the final report */
+  assert(tms);                  /* check the function argument */
+  fold(tms);                    /* fold the interval into the totals */
+  clear(&tms->curr);            /* and start a new interval */
+  if (record(tms, &tms->total, "total", tms->epochs, tms->psecs) != 0)
+    return -1;                  /* write a report for the whole run */
+  return fflush(tms->out);      /* and flush the output file */
+}  /* tms_report() */
@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------
+  File    : tmstat.h
+  Contents: phase timing and throughput statistics (run reports)
+  Author  : Christian Borgelt
+  History : 2016.05.16 file created
+----------------------------------------------------------------------*/
+#ifndef __TMSTAT__
+#define __TMSTAT__
+#include <stdio.h>
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define TMS_MAXPHASE  16        /* maximum number of phases */
+
+/* --- report modes --- */
+#define TMS_JSON      0x0000    /* write reports as JSON objects */
+#define TMS_CSV       0x0001    /* write reports as CSV records */
+#define TMS_EPOCH     0x0002    /* write a report for each epoch */
+
+/*----------------------------------------------------------------------
+  Type Definitions
+----------------------------------------------------------------------*/
+typedef struct {                /* --- timing/throughput counters --- */
+  double     secs;              /* wall clock time in seconds */
+  double     pats;              /* number of processed patterns */
+  double     flops;             /* number of floating point ops. */
+  double     phsecs[TMS_MAXPHASE];  /* times spent in the phases */
+  double     calls [TMS_MAXPHASE];  /* number of entries into phases */
+} TMSCNT;                       /* (timing/throughput counters) */
+
+typedef struct {                /* --- timing statistics --- */
+  const char *prog;             /* name of the timed program */
+  const char *const *names;     /* names of the phases */
+  int        cnt;               /* number of phases */
+  int        mode;              /* report mode (e.g. TMS_CSV) */
+  FILE       *out;              /* file to write the reports to */
+  long       recs;              /* number of written records */
+  long       epochs;            /* number of completed epochs */
+  int        cur;               /* current phase (-1 if none) */
+  double     beg;               /* start time of the current phase */
+  double     mark;              /* start time of current interval */
+  double     psecs;             /* time of intervals with patterns */
+  TMSCNT     curr;              /* counters of the current interval */
+  TMSCNT     total;             /* counters of the whole run */
+} TMSTAT;                       /* (timing statistics) */
+
+/* The time of a run is divided into intervals, which are closed    */
+/* with tms_epoch() (an epoch of training) or tms_mark() (any other */
+/* part of a run, e.g. reading the input files). Within an interval */
+/* the time is attributed to the phase that was entered last with   */
+/* tms_beg(), until tms_end() is called or another phase is entered */
+/* (only one clock query per phase change). Times of phases that    */
+/* are executed by several threads may be measured by the threads   */
+/* themselves and added with tms_add(); these are busy times summed */
+/* over the threads and may exceed the wall clock time.             */
+
+/* A report contains the wall clock time, the number of patterns    */
+/* and floating point operations (as given to tms_count()), the     */
+/* resulting throughputs and the time spent in each phase. A report */
+/* for the whole run is written by tms_report(), with TMS_EPOCH an  */
+/* additional report is written for each epoch. JSON reports are    */
+/* written one object per line, CSV reports start with a header.    */
+
+/*----------------------------------------------------------------------
+  Functions
+----------------------------------------------------------------------*/
+extern double  tms_clock  (void);
+extern TMSTAT* tms_create (const char *prog, const char *const *names,
+                           int cnt, FILE *out, int mode);
+extern void    tms_delete (TMSTAT *tms);
+extern void    tms_beg    (TMSTAT *tms, int phase);
+extern void    tms_end    (TMSTAT *tms);
+extern void    tms_add    (TMSTAT *tms, int phase, double secs);
+extern void    tms_count  (TMSTAT *tms, double pats, double flops);
+extern double  tms_calls  (const TMSTAT *tms, int phase);
+extern double  tms_pats   (const TMSTAT *tms);
+extern void    tms_mark   (TMSTAT *tms);
+extern int     tms_epoch  (TMSTAT *tms);
+extern int     tms_report (TMSTAT *tms);
+
+/*----------------------------------------------------------------------
+  Preprocessor Definitions
+----------------------------------------------------------------------*/
+#define tms_calls(s,p)     ((s)->curr.calls[p])
+#define tms_pats(s)        ((s)->curr.pats)
+
+#define TMS_BEG(s,p)       ((s) ? tms_beg(s,p) : (void)0)
+#define TMS_END(s)         ((s) ? tms_end(s)   : (void)0)
+
+#endif
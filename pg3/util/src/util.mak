@@ -11,6 +11,8 @@
 #           2008.08.18 adapted to main functions of arrays and lists
 #           2008.08.22 module escape added, test program tsctest added
 #           2016.04.20 completed dependencies on header files
+#           2016.05.06 module thread added
+#           2016.05.16 module tmstat added (phase timing)
 #-----------------------------------------------------------------------
 THISDIR = ../../util/src
 
@@ -128,6 +130,18 @@ params.obj:   params.h params.c util.mak
 sigint.obj:   sigint.h sigint.c util.mak
 	$(CC) $(CFLAGS) sigint.c /Fo$@
 
+#-----------------------------------------------------------------------
+# Thread Team Management
+#-----------------------------------------------------------------------
+thread.obj:   thread.h thread.c util.mak
+	$(CC) $(CFLAGS) thread.c /Fo$@
+
+#-----------------------------------------------------------------------
+# Phase Timing Statistics
+#-----------------------------------------------------------------------
+tmstat.obj:   tmstat.h tmstat.c util.mak
+	$(CC) $(CFLAGS) tmstat.c /Fo$@
+
 #-----------------------------------------------------------------------
 # Clean up
 #-----------------------------------------------------------------------